@@ -70,14 +70,15 @@
 /*          GLOBAL VARIABLES         */
 /* ********************************* */
 
-/** Stores potential error messages. */
-extern std::string tiledb_ar_errmsg;
+/** Stores potential error messages of the calling thread. */
+extern thread_local std::string tiledb_ar_errmsg;
 
 
 
 class ArrayReadState;
 class ArraySortedReadState;
 class ArraySortedWriteState;
+class ConsolidationPlan;
 class Fragment;
 
 
@@ -303,6 +304,25 @@ class Array {
       size_t *buffer_sizes,
       size_t buffer_size);
 
+  /**
+   * Consolidates a batch of fragments into a new single one, focusing on a
+   * specific attribute. Unlike the overload above, the attribute is read
+   * through its own read state and buffers, so that several attributes can be
+   * consolidated concurrently into the same new fragment.
+   *
+   * @param new_fragment The new consolidated fragment object.
+   * @param attribute_id The id of the target attribute.
+   * @param buffer_size The size of the buffers for reading/writing the attribute.
+   * @param consolidation_plan The merged read rounds of the batch to replay,
+   *     or NULL to merge the fragments for this attribute.
+   * @return TILEDB_AR_OK for success and TILEDB_AR_ERR for error.
+   */
+  int consolidate(
+      Fragment* new_fragment,
+      int attribute_id,
+      size_t buffer_size,
+      const ConsolidationPlan* consolidation_plan) const;
+
   /**
    * Finalizes the array, properly freeing up memory space.
    *
@@ -536,9 +556,17 @@ class Array {
   std::vector<int> attribute_ids_;
   /** Configuration parameters. */
   const StorageManagerConfig* config_;
-  /** Fragment names at initialization for consolidation */
+  /**
+   * Fragment names at initialization for consolidation, or all the fragment
+   * names in read mode.
+   */
   std::vector<std::string> fragment_names_;
-  /** The array fragments. */
+  /** The book-keeping of all the fragments in read mode. */
+  std::vector<BookKeeping*> book_keeping_;
+  /**
+   * The array fragments. In read mode, only the fragments whose non-empty
+   * domain overlaps the subarray are opened.
+   */
   std::vector<Fragment*> fragments_;
   /** 
    * The array mode. It must be one of the following:
@@ -623,6 +651,27 @@ class Array {
    */
   std::string new_fragment_name() const;
 
+  /**
+   * Merges the fragments of the batch being consolidated once for all the
+   * attributes, focusing on the **sparse** array case.
+   *
+   * @return The consolidation plan, or NULL on error.
+   */
+  ConsolidationPlan* compute_consolidation_plan();
+
+  /**
+   * Creates an array object that reads a single attribute of the fragments
+   * being consolidated. It opens its own fragments on the book-keeping of the
+   * fragments of this array.
+   *
+   * @param attribute_id The id of the attribute to read.
+   * @param consolidation_plan The merged read rounds to replay, or NULL.
+   * @return The new array object, or NULL on error.
+   */
+  Array* consolidation_reader(
+      int attribute_id,
+      const ConsolidationPlan* consolidation_plan) const;
+
   /**
    * Opens the existing fragments.
    *
@@ -633,6 +682,26 @@ class Array {
   int open_fragments(
       const std::vector<std::string>& fragment_names,
       const std::vector<BookKeeping*>& book_keeping);
+
+  /**
+   * Opens the fragments whose non-empty domain overlaps the current subarray
+   * and closes the rest. The fragments that remain open have their read state
+   * reset.
+   *
+   * @return TILEDB_AR_OK for success and TILEDB_AR_ERR for error.
+   */
+  int select_fragments();
+
+  /**
+   * Checks if the non-empty domain of a fragment overlaps the current
+   * subarray.
+   *
+   * @template T The type of the coordinates.
+   * @param book_keeping The book-keeping of the fragment.
+   * @return True if the fragment overlaps the subarray.
+   */
+  template<class T>
+  bool fragment_overlaps_subarray(const BookKeeping* book_keeping) const;
 };
 
 #endif
@@ -60,8 +60,8 @@
 /*          GLOBAL VARIABLES         */
 /* ********************************* */
 
-/** Stores potential error messages. */
-extern std::string tiledb_ait_errmsg;
+/** Stores potential error messages of the calling thread. */
+extern thread_local std::string tiledb_ait_errmsg;
 
 
 
@@ -35,9 +35,11 @@
 
 #include "array.h"
 #include "array_schema.h"
+#include "thread_pool.h"
 #define __STDC_FORMAT_MACROS
 #include <cstring>
 #include <inttypes.h>
+#include <memory>
 #include <queue>
 #include <vector>
 
@@ -67,13 +69,14 @@
 /*          GLOBAL VARIABLES         */
 /* ********************************* */
 
-/** Stores potential error messages. */
-extern std::string tiledb_ars_errmsg;
+/** Stores potential error messages of the calling thread. */
+extern thread_local std::string tiledb_ars_errmsg;
 
 
 
 
 class Array;
+class ConsolidationPlan;
 class ReadState;
 
 /** Stores the state necessary when reading cells from the array fragments. */
@@ -83,6 +86,12 @@ class ArrayReadState {
   /*           TYPE DEFINITIONS        */
   /* ********************************* */
 
+  /** 
+   * Arena holding the cell ranges of a read round, which are released
+   * together at the start of the next read round. 
+   */
+  class CellRangeArena;
+
   /** 
    * Class of fragment cell range objects used in the priority queue algorithm. 
    */
@@ -96,6 +105,13 @@ class ArrayReadState {
   template<class T>
   class SmallerPQFragmentCellRange;
 
+  /** 
+   * Tournament tree of fragment cell range objects, which replaces the
+   * priority queue when many fragments are merged. 
+   */
+  template<class T>
+  class PQFragmentCellRangeTree;
+
   /** A cell position pair [first, second]. */
   typedef std::pair<int64_t, int64_t> CellPosRange;
 
@@ -131,8 +147,13 @@ class ArrayReadState {
    * Constructor.
    *
    * @param array The array this array read state belongs to.
+   * @param consolidation_plan The precomputed read rounds to replay instead of
+   *     merging the fragments, NULL to merge them. Applicable only to the
+   *     **sparse** array case.
    */
-  ArrayReadState(const Array* array);
+  ArrayReadState(
+      const Array* array,
+      const ConsolidationPlan* consolidation_plan = NULL);
 
   /** Destructor. */
   ~ArrayReadState();
@@ -184,6 +205,23 @@ class ArrayReadState {
 
 
 
+  /* ********************************* */
+  /*             MUTATORS              */
+  /* ********************************* */
+
+  /**
+   * Merges the fragments of a **sparse** array, appending the cell position
+   * ranges of every read round to a consolidation plan without copying any
+   * cells. The array read state cannot be used for reads afterwards.
+   *
+   * @param consolidation_plan The consolidation plan.
+   * @return TILEDB_ARS_OK for success and TILEDB_ARS_ERR for error.
+   */
+  int compute_consolidation_plan(ConsolidationPlan* consolidation_plan);
+
+
+
+
  private:
   /* ********************************* */
   /*         PRIVATE ATTRIBUTES        */
@@ -195,8 +233,14 @@ class ArrayReadState {
   const ArraySchema* array_schema_;
   /** The number of array attributes. */
   int attribute_num_;
+  /** Holds the cell ranges of the current read round. */
+  CellRangeArena* cell_range_arena_;
   /** The size of the array coordinates. */
   size_t coords_size_;
+  /** The read rounds replayed instead of merging the fragments, or NULL. */
+  const ConsolidationPlan* consolidation_plan_;
+  /** The next read round of the consolidation plan. */
+  int64_t consolidation_plan_round_;
   /** Indicates whether the read operation for this query is done. */
   bool done_;
   /** State per attribute indicating the number of empty cells written. */
@@ -214,15 +258,41 @@ class ArrayReadState {
   int fragment_num_;
   /** Stores the read state of each fragment. */
   std::vector<ReadState*> fragment_read_states_;
+  /**
+   * The number of sparse fragments whose cell ranges are computed
+   * concurrently, 1 if computed one by one.
+   */
+  int fragment_threads_;
+  /**
+   * The workers computing the cell ranges of sparse fragments concurrently,
+   * started once per query as the cell ranges are computed for every read
+   * round.
+   */
+  std::unique_ptr<ThreadPool> fragment_thread_pool_;
+  /**
+   * The minimum number of fragments with cell ranges in a read round that are
+   * merged with a tournament tree instead of a heap.
+   */
+  int merge_tree_min_fragments_;
   /**
    * The minimum bounding coordinates end point. Applicable only to the 
    * **sparse** array case.
    */
   void* min_bounding_coords_end_;
-  /** Indicates overflow for each attribute. */
-  std::vector<bool> overflow_;
+  /**
+   * Indicates overflow for each attribute. Not a vector of bools, so that
+   * different attributes may be read concurrently.
+   */
+  std::vector<char> overflow_;
   /** Indicates whether the current read round is done for each attribute. */
-  std::vector<bool> read_round_done_;
+  std::vector<char> read_round_done_;
+  /** The number of attributes read concurrently, 1 if read one by one. */
+  int read_threads_;
+  /**
+   * The workers reading attributes concurrently, started once per query as
+   * the attributes are read concurrently in every read round.
+   */
+  std::unique_ptr<ThreadPool> read_thread_pool_;
   /** The current tile coordinates of the query subarray. */
   void* subarray_tile_coords_;
   /** The tile domain of the query subarray. */
@@ -238,6 +308,17 @@ class ArrayReadState {
   /** Cleans fragment cell positions that are processed by all attributes. */
   void clean_up_processed_fragment_cell_pos_ranges();
 
+  /**
+   * Appends the cell position ranges of every read round to a consolidation
+   * plan, focusing on the **sparse** array case.
+   *
+   * @tparam T The coordinates type.
+   * @param consolidation_plan The consolidation plan.
+   * @return TILEDB_ARS_OK on success and TILEDB_ARS_ERR on error.
+   */
+  template<class T>
+  int compute_consolidation_plan(ConsolidationPlan* consolidation_plan);
+
   /**
    * Computes the cell position ranges that must be copied from each fragment to
    * the user buffers for the current read round. The cell positions are 
@@ -507,6 +588,14 @@ class ArrayReadState {
   template<class T>
   int get_next_fragment_cell_ranges_dense();
 
+  /**
+   * Gets the fragment cell position ranges of the next read round from the
+   * consolidation plan.
+   *
+   * @return TILEDB_ARS_OK on success and TILEDB_ARS_ERR on error.
+   */
+  int get_next_fragment_cell_ranges_plan();
+
   /**
    * Gets the next fragment cell ranges that are relevant in the current read
    * round, focusing on the sparse case.
@@ -546,6 +635,14 @@ class ArrayReadState {
   template<class T>
   void get_next_subarray_tile_coords();
 
+  /**
+   * Computes the cell position ranges of the next read round, invoking the
+   * proper function for the array and coordinates type.
+   *
+   * @return TILEDB_ARS_OK on success and TILEDB_ARS_ERR on error.
+   */
+  int get_next_fragment_cell_ranges();
+
   /**
    * Initializes the tile coordinates falling in the query subarray. Applicable
    * only to the **dense** array case.
@@ -556,6 +653,23 @@ class ArrayReadState {
   template<class T>
   void init_subarray_tile_coords();
 
+  /**
+   * Performs a read operation reading the attributes concurrently. Each
+   * attribute copies the read rounds computed so far on its own thread, and
+   * the next read round is computed on the calling thread once all attributes
+   * without an overflow are done with them. The attributes hence see the same
+   * read rounds as when read one by one.
+   *
+   * @param buffers See read().
+   * @param buffer_sizes See read().
+   * @param skip_counts See read().
+   * @return TILEDB_ARS_OK for success and TILEDB_ARS_ERR for error.
+   */
+  int read_concurrently(
+      void** buffers,
+      size_t* buffer_sizes,
+      size_t* skip_counts);
+
   /**
    * Performs a read operation in a **dense** array.
    * 
@@ -723,10 +837,31 @@ class ArrayReadState {
       size_t& buffer_var_size,
       size_t& skip_count_var);
 
+  /**
+   * Cuts and sorts the relevant cell ranges for the current read run with the
+   * heap algorithm, on the input priority queue of fragment cell ranges.
+   *
+   * @tparam T The coordinates type.
+   * @tparam PQ The priority queue type, either a std::priority_queue or a
+   *     PQFragmentCellRangeTree.
+   * @param pq The empty priority queue.
+   * @param unsorted_fragment_cell_ranges The unsorted fragment cell ranges.
+   * @param fragment_cell_ranges The sorted fragment cell ranges output by
+   *     the function as a result.
+   * @return TILEDB_ARS_OK on success and TILEDB_ARS_ERR on error.
+   */
+  template<class T, class PQ>
+  int merge_fragment_cell_ranges(
+      PQ& pq,
+      std::vector<FragmentCellRanges>& unsorted_fragment_cell_ranges,
+      FragmentCellRanges& fragment_cell_ranges);
+
   /**
    * Uses the heap algorithm to cut and sort the relevant cell ranges for
-   * the current read run. The function properly cleans up the input
-   * unsorted fragment cell ranges.
+   * the current read run. The cell ranges of the input and of the result are
+   * held by the cell range arena until the next call, which releases the
+   * cell ranges of the previous read run. The priority queue is a tournament
+   * tree if enough fragments have cell ranges, and a binary heap otherwise.
    *
    * @tparam T The coordinates type.
    * @param unsorted_fragment_cell_ranges The unsorted fragment cell ranges.
@@ -737,12 +872,53 @@ class ArrayReadState {
   template<class T>
   int sort_fragment_cell_ranges(
       std::vector<FragmentCellRanges>& unsorted_fragment_cell_ranges,
-      FragmentCellRanges& fragment_cell_ranges) const;
+      FragmentCellRanges& fragment_cell_ranges);
 };
 
 
 
 
+/**
+ * Arena of the cell ranges of a read round. The cell ranges created by the
+ * priority queue algorithm are carved out of chunks of memory, and the cell
+ * ranges computed by the fragment read states are adopted by the arena. All
+ * are released at once on reset, which keeps the chunks for the next round.
+ */
+class ArrayReadState::CellRangeArena {
+ public:
+  /**
+   * Constructor.
+   *
+   * @param cell_range_size The size of a cell range, i.e., of a pair of
+   *     coordinates.
+   */
+  CellRangeArena(size_t cell_range_size);
+
+  /** Destructor. */
+  ~CellRangeArena();
+
+  /** Adopts a cell range allocated with malloc, freed on reset. */
+  void adopt(void* cell_range);
+
+  /** Returns a new cell range, valid until reset. */
+  void* allocate();
+
+  /** Releases all cell ranges. */
+  void reset();
+
+ private:
+  /** The size of a cell range. */
+  size_t cell_range_size_;
+  /** The chunks the cell ranges are allocated from. */
+  std::vector<char*> chunks_;
+  /** The chunk the next cell range is allocated from. */
+  size_t chunk_;
+  /** The offset in the current chunk of the next cell range. */
+  size_t chunk_offset_;
+  /** The adopted cell ranges. */
+  std::vector<void*> malloced_;
+};
+
 /** 
  * Class of fragment cell range objects used in the priority queue algorithm. 
  */
@@ -754,10 +930,12 @@ class ArrayReadState::PQFragmentCellRange {
     *
     * @param array_schema The schema of the array.
     * @param fragment_read_states The read states of all fragments in the array.
+    * @param cell_range_arena The arena new cell ranges are allocated from.
     */
    PQFragmentCellRange(
        const ArraySchema* array_schema,
-       const std::vector<ReadState*>* fragment_read_states);
+       const std::vector<ReadState*>* fragment_read_states,
+       CellRangeArena* cell_range_arena);
 
    /** Returns true if the fragment the range belongs to is dense. */
    bool dense() const;
@@ -841,6 +1019,8 @@ class ArrayReadState::PQFragmentCellRange {
  private:
    /** The array schema. */
    const ArraySchema* array_schema_;
+   /** The arena new cell ranges are allocated from. */
+   CellRangeArena* cell_range_arena_;
    /** Size of coordinates. */
    size_t coords_size_;
    /** Dimension number. */
@@ -875,4 +1055,74 @@ class ArrayReadState::SmallerPQFragmentCellRange {
   const ArraySchema* array_schema_;
 };
 
+/**
+ * Tournament tree of fragment cell ranges with the interface of the priority
+ * queue of SmallerPQFragmentCellRange, whose top is the same range. The
+ * ranges are the leaves and each internal node holds the winner of its
+ * subtree, so a push or pop replays the matches on the path of a single leaf
+ * only. A fragment may have several ranges in the queue, so the leaves are
+ * not bound to fragments and the tree grows when all leaves are taken. The
+ * matches compare the coordinates with loops specialized per cell order.
+ */
+template<class T>
+class ArrayReadState::PQFragmentCellRangeTree {
+ public:
+  /**
+   * Constructor.
+   *
+   * @param array_schema The schema of the array.
+   * @param fragment_num The number of fragments merged, which sizes the tree.
+   */
+  PQFragmentCellRangeTree(const ArraySchema* array_schema, int fragment_num);
+
+  /** Returns true if there are no ranges in the tree. */
+  bool empty() const;
+
+  /** Removes the first range. */
+  void pop();
+
+  /** Inserts a range. */
+  void push(PQFragmentCellRange<T>* fcr);
+
+  /** Returns the first range. */
+  PQFragmentCellRange<T>* top() const;
+
+ private:
+  /** The array schema. */
+  const ArraySchema* array_schema_;
+  /** The cell order. */
+  int cell_order_;
+  /** Dimension number. */
+  int dim_num_;
+  /** The leaves not holding a range. */
+  std::vector<int> free_leaves_;
+  /** The range of each leaf, NULL if the leaf is free. */
+  std::vector<PQFragmentCellRange<T>*> leaves_;
+  /** The number of ranges in the tree. */
+  int size_;
+  /**
+   * The winning leaf of the subtree of each internal node, -1 if all its
+   * leaves are free. Node 1 is the root and node n has children 2n and 2n+1,
+   * while the leaves are the nodes from leaves_.size() onwards.
+   */
+  std::vector<int> winners_;
+
+  /** Doubles the number of leaves and replays all the matches. */
+  void grow();
+
+  /** Returns the winner of a match between two leaves, -1 if both free. */
+  int play(int leaf_a, int leaf_b) const;
+
+  /** Returns true if range a comes before range b. */
+  bool precedes(
+      const PQFragmentCellRange<T>* a,
+      const PQFragmentCellRange<T>* b) const;
+
+  /** Replays the matches on the path from a leaf to the root. */
+  void replay(int leaf);
+
+  /** Returns the winning leaf of a node, -1 if all its leaves are free. */
+  int winner(int node) const;
+};
+
 #endif
@@ -79,8 +79,8 @@
 /*          GLOBAL VARIABLES         */
 /* ********************************* */
 
-/** Stores potential error messages. */
-extern std::string tiledb_as_errmsg;
+/** Stores potential error messages of the calling thread. */
+extern thread_local std::string tiledb_as_errmsg;
 
 /** Compression fields are stored as 1 byte in the schema, the last 4 least significant digits
   * denote the main compression type, the next 2 denote pre compression filters and the leading 2 digits
@@ -62,8 +62,8 @@
 /*          GLOBAL VARIABLES         */
 /* ********************************* */
 
-/** Stores potential error messages. */
-extern std::string tiledb_asrs_errmsg;
+/** Stores potential error messages of the calling thread. */
+extern thread_local std::string tiledb_asrs_errmsg;
 
 
 class Array;
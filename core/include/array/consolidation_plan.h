@@ -0,0 +1,180 @@
+/**
+ * @file   consolidation_plan.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2026 Omics Data Automation, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file defines class ConsolidationPlan.
+ */
+
+#ifndef __CONSOLIDATION_PLAN_H__
+#define __CONSOLIDATION_PLAN_H__
+
+#include "array_read_state.h"
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+
+
+
+/* ********************************* */
+/*             CONSTANTS             */
+/* ********************************* */
+
+/**@{*/
+/** Return code. */
+#define TILEDB_CP_OK                                 0
+#define TILEDB_CP_ERR                               -1
+/**@}*/
+
+/** Default error message. */
+#define TILEDB_CP_ERRMSG std::string("[TileDB::ConsolidationPlan] Error: ")
+
+
+
+
+/* ********************************* */
+/*          GLOBAL VARIABLES         */
+/* ********************************* */
+
+/** Stores potential error messages of the calling thread. */
+extern thread_local std::string tiledb_cp_errmsg;
+
+
+
+
+/**
+ * The fragment cell position ranges of all the read rounds over a batch of
+ * sparse fragments being consolidated. The k-way merge of the fragment
+ * coordinates is computed once per batch into the plan, and every attribute
+ * then replays the plan instead of merging the coordinates again. Rounds are
+ * kept in memory up to a budget, the following rounds are spilled to an
+ * unlinked temporary file. The plan is read-only once computed, so it may be
+ * replayed by several attributes concurrently.
+ */
+class ConsolidationPlan {
+ public:
+  /* ********************************* */
+  /*           TYPE DEFINITIONS        */
+  /* ********************************* */
+
+  /** A vector of fragment cell position ranges. */
+  typedef ArrayReadState::FragmentCellPosRanges FragmentCellPosRanges;
+
+
+
+
+  /* ********************************* */
+  /*     CONSTRUCTORS & DESTRUCTORS    */
+  /* ********************************* */
+
+  /**
+   * Constructor.
+   *
+   * @param memory_size The maximum number of bytes of cell position ranges
+   *     kept in memory.
+   */
+  ConsolidationPlan(size_t memory_size);
+
+  /** Destructor. */
+  ~ConsolidationPlan();
+
+
+
+
+  /* ********************************* */
+  /*             ACCESSORS             */
+  /* ********************************* */
+
+  /**
+   * Retrieves the fragment cell position ranges of a read round.
+   *
+   * @param round The read round.
+   * @param fragment_cell_pos_ranges The ranges of the read round.
+   * @return TILEDB_CP_OK for success and TILEDB_CP_ERR for error.
+   */
+  int get(
+      int64_t round,
+      FragmentCellPosRanges& fragment_cell_pos_ranges) const;
+
+  /** Returns the number of read rounds in the plan. */
+  int64_t round_num() const;
+
+  /** Returns true if some read rounds were spilled to disk. */
+  bool spilled() const;
+
+
+
+
+  /* ********************************* */
+  /*             MUTATORS              */
+  /* ********************************* */
+
+  /**
+   * Appends the next read round to the plan.
+   *
+   * @param fragment_cell_pos_ranges The ranges of the read round, which are
+   *     owned by the plan after the call.
+   * @return TILEDB_CP_OK for success and TILEDB_CP_ERR for error.
+   */
+  int append(FragmentCellPosRanges* fragment_cell_pos_ranges);
+
+ private:
+  /* ********************************* */
+  /*         PRIVATE ATTRIBUTES        */
+  /* ********************************* */
+
+  /** The maximum number of bytes of cell position ranges kept in memory. */
+  size_t memory_size_;
+  /** The number of bytes of cell position ranges kept in memory. */
+  size_t memory_used_;
+  /** The read rounds kept in memory, which come before the spilled ones. */
+  std::vector<FragmentCellPosRanges*> rounds_;
+  /** The file offset and number of ranges of each spilled read round. */
+  std::vector<std::pair<off_t, size_t>> spilled_rounds_;
+  /** The descriptor of the spill file, -1 if nothing was spilled. */
+  int spill_fd_;
+  /** The size of the spill file. */
+  off_t spill_size_;
+
+
+
+
+  /* ********************************* */
+  /*           PRIVATE METHODS         */
+  /* ********************************* */
+
+  /**
+   * Creates the spill file in TMPDIR. The file is unlinked right away, so it
+   * is removed once closed even if the process exits abruptly.
+   *
+   * @return TILEDB_CP_OK for success and TILEDB_CP_ERR for error.
+   */
+  int create_spill_file();
+};
+
+#endif
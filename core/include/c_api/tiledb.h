@@ -106,6 +106,9 @@ typedef struct TileDB_Config {
    *      TileDB will use standard OS read.
    *    - TILEDB_IO_MPI
    *      TileDB will use MPI-IO read. 
+   *    - TILEDB_IO_URING
+   *      TileDB will use io_uring to read batches of tiles, falls back to
+   *      standard OS read if io_uring is not available.
    */
   int read_method_;
   /** 
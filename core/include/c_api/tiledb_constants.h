@@ -70,6 +70,7 @@
 #define TILEDB_IO_MMAP                              0
 #define TILEDB_IO_READ                              1
 #define TILEDB_IO_MPI                               2
+#define TILEDB_IO_URING                             3
 #define TILEDB_IO_WRITE                             0
 /**@}*/
 
@@ -192,6 +193,7 @@
 #define TILEDB_METADATA_SCHEMA_FILENAME   "__metadata_schema.tdb"
 #define TILEDB_BOOK_KEEPING_FILENAME             "__book_keeping"
 #define TILEDB_FRAGMENT_FILENAME          "__tiledb_fragment.tdb"
+#define TILEDB_FRAGMENT_MANIFEST_FILENAME "__tiledb_fragments.tdb"
 #define TILEDB_GROUP_FILENAME                "__tiledb_group.tdb"
 #define TILEDB_WORKSPACE_FILENAME        "__tiledb_workspace.tdb"
 /**@}*/
@@ -61,8 +61,8 @@
 /*          GLOBAL VARIABLES         */
 /* ********************************* */
 
-/** Stores potential error messages. */
-extern std::string tiledb_cd_errmsg;
+/** Stores potential error messages of the calling thread. */
+extern thread_local std::string tiledb_cd_errmsg;
 
 /** Stores the state necessary when writing cells to a fragment. */
 class Codec {
@@ -47,6 +47,8 @@ ZSTD_EXTERN_DECL char *(*ZSTD_getErrorName)(size_t);
 ZSTD_EXTERN_DECL int(*ZSTD_maxCLevel)(void);
 ZSTD_EXTERN_DECL size_t(*ZSTD_compress)(void *, size_t, const void *, size_t, int);
 ZSTD_EXTERN_DECL size_t(*ZSTD_decompress)(void *, size_t, const void *, size_t);
+ZSTD_EXTERN_DECL unsigned long long(*ZSTD_getFrameContentSize)(const void *, size_t);
+ZSTD_EXTERN_DECL size_t(*ZSTD_findFrameCompressedSize)(const void *, size_t);
 
 ZSTD_EXTERN_DECL char *(*ZSTD_createCCtx)(void);
 ZSTD_EXTERN_DECL size_t(*ZSTD_freeCCtx)(char *);
@@ -72,6 +74,8 @@ class CodecZStandard : public Codec {
           BIND_SYMBOL(dl_handle, ZSTD_maxCLevel, "ZSTD_maxCLevel", (int(*)(void)));
           BIND_SYMBOL(dl_handle, ZSTD_compress, "ZSTD_compress", (size_t(*)(void *, size_t, const void *, size_t, int)));
           BIND_SYMBOL(dl_handle, ZSTD_decompress, "ZSTD_decompress", (size_t(*)(void *, size_t, const void *, size_t)));
+          BIND_SYMBOL(dl_handle, ZSTD_getFrameContentSize, "ZSTD_getFrameContentSize", (unsigned long long(*)(const void *, size_t)));
+          BIND_SYMBOL(dl_handle, ZSTD_findFrameCompressedSize, "ZSTD_findFrameCompressedSize", (size_t(*)(const void *, size_t)));
 
           BIND_SYMBOL(dl_handle, ZSTD_createCCtx, "ZSTD_createCCtx", (char*(*)(void)));
           BIND_SYMBOL(dl_handle, ZSTD_freeCCtx, "ZSTD_freeCCtx", (size_t(*)(char*)));
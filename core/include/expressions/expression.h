@@ -43,8 +43,8 @@
 /*          GLOBAL VARIABLES         */
 /* ********************************* */
 
-/** Stores potential error messages. */
-extern std::string tiledb_expr_errmsg;
+/** Stores potential error messages of the calling thread. */
+extern thread_local std::string tiledb_expr_errmsg;
 
 
 /* ********************************* */
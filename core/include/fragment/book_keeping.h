@@ -34,9 +34,13 @@
 #define __BOOK_KEEPING_H__
 
 #include "array_schema.h"
+#include "mbr_index.h"
 #include "storage_buffer.h"
 #include "storage_fs.h"
 #include "tiledb_constants.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <zlib.h>
 
@@ -47,6 +51,9 @@
 /*             CONSTANTS             */
 /* ********************************* */
 
+/** Magic bytes at the start of an uncompressed version 2 book-keeping file. */
+#define TILEDB_BK_V2_MAGIC "TDBBKV2"
+
 /**@{*/
 /** Return code. */
 #define TILEDB_BK_OK          0
@@ -63,8 +70,82 @@
 /*          GLOBAL VARIABLES         */
 /* ********************************* */
 
-/** Stores potential error messages. */
-extern std::string tiledb_bk_errmsg;
+/** Stores potential error messages of the calling thread. */
+extern thread_local std::string tiledb_bk_errmsg;
+
+
+
+
+/**
+ * Read-only view of fixed-size per-tile records, e.g. the MBRs or the bounding
+ * coordinates, that are stored back to back in a single buffer. Indexing
+ * returns a pointer to the record of the tile.
+ */
+class TileRecordsView {
+ public:
+  TileRecordsView(const char* data, size_t record_size, int64_t record_num)
+      : data_(data), record_size_(record_size), record_num_(record_num) {
+  }
+
+  const void* operator[](int64_t i) const {
+    return data_ + i*record_size_;
+  }
+
+  /** Returns the records, stored back to back. */
+  const void* data() const {
+    return data_;
+  }
+
+  bool empty() const {
+    return record_num_ == 0;
+  }
+
+  /** Returns the number of records. */
+  int64_t size() const {
+    return record_num_;
+  }
+
+ private:
+  const char* data_;
+  size_t record_size_;
+  int64_t record_num_;
+};
+
+/**
+ * Read-only view of an array of per-tile values, e.g. the tile offsets of an
+ * attribute.
+ */
+template<class T>
+class TileValuesView {
+ public:
+  TileValuesView(const T* data, int64_t size)
+      : data_(data), size_(size) {
+  }
+
+  const T& operator[](int64_t i) const {
+    return data_[i];
+  }
+
+  const T* begin() const {
+    return data_;
+  }
+
+  const T* end() const {
+    return data_ + size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  int64_t size() const {
+    return size_;
+  }
+
+ private:
+  const T* data_;
+  int64_t size_;
+};
 
 
 
@@ -101,7 +182,7 @@ class BookKeeping {
   /* ********************************* */
 
   /** Returns the bounding coordinates. */
-  const std::vector<void*>& bounding_coords() const; 
+  TileRecordsView bounding_coords() const; 
 
   /** Returns the number of cells in the tile at the input position. */
   int64_t cell_num(int64_t tile_pos) const;
@@ -119,7 +200,34 @@ class BookKeeping {
   int64_t last_tile_cell_num() const;
 
   /** Returns the MBRs. */
-  const std::vector<void*>& mbrs() const; 
+  TileRecordsView mbrs() const; 
+
+  /**
+   * Returns the MBRs in dimension-major order, i.e. the lower bounds of all
+   * the MBRs along the first dimension, then their upper bounds along the
+   * first dimension, and so on for the rest of the dimensions. Scans over the
+   * MBRs can then be vectorized. The layout is built on first use.
+   */
+  const void* mbrs_dim_major() const;
+
+  /**
+   * Returns an R-tree over the MBRs for looking up the tiles that overlap a
+   * subarray, built on first use. Applicable only to sparse fragments.
+   */
+  const MBRIndex* mbr_index() const;
+
+  /**
+   * Returns the bounding box of all the MBRs, in the same layout as an MBR,
+   * computed on first use. Tighter than the non-empty domain for sparse
+   * fragments written without a subarray. NULL if there are no MBRs.
+   */
+  const void* mbrs_bounds() const;
+
+  /**
+   * Returns the approximate number of bytes held by the loaded book-keeping,
+   * including the attributes and the MBR layouts loaded or built on first use.
+   */
+  size_t memory_size() const;
 
   /** Returns the non-empty domain in which the fragment is constrained. */
   const void* non_empty_domain() const;
@@ -130,14 +238,20 @@ class BookKeeping {
   /** Returns the number of tiles in the fragment. */
   int64_t tile_num() const;
 
-  /** Returns the tile offsets. */
-  const std::vector<std::vector<off_t> >& tile_offsets() const;
+  /** Returns the tile offsets of the input attribute. */
+  TileValuesView<off_t> tile_offsets(int attribute_id) const;
+
+  /** Returns the variable tile offsets of the input attribute. */
+  TileValuesView<off_t> tile_var_offsets(int attribute_id) const;
 
-  /** Returns the variable tile offsets. */
-  const std::vector<std::vector<off_t> >& tile_var_offsets() const;
+  /** Returns the variable tile sizes of the input attribute. */
+  TileValuesView<size_t> tile_var_sizes(int attribute_id) const;
 
-  /** Returns the variable tile sizes. */
-  const std::vector<std::vector<size_t> >& tile_var_sizes() const;
+  /**
+   * Returns true if the book-keeping was loaded from an uncompressed version 2
+   * file and is used in place.
+   */
+  bool v2() const;
 
   /** Returns true if the array is in write mode. */
   bool write_mode() const;
@@ -214,13 +328,39 @@ class BookKeeping {
   int init(const void* non_empty_domain);
 
   /**
-   * Loads the book-keeping structures from the disk.
+   * Loads the book-keeping structures from the disk. Uncompressed version 2
+   * files are preferred if they exist, they are memory mapped on PosixFS and
+   * used in place.
    * @param fs The Storage File System class.
    *
    * @return TILEDB_BK_OK for success, and TILEDB_OK_ERR for error.
    */
   int load(StorageFS *fs);
 
+  /**
+   * Loads the book-keeping structures from the disk, but only the tile
+   * offsets, variable tile offsets and variable tile sizes of the input
+   * attributes. The sections of the rest of the attributes are indexed and
+   * can be loaded later with load_attributes().
+   * @param fs The Storage File System class.
+   * @param attribute_ids The ids of the attributes to load, the coordinates
+   *     are always loaded.
+   *
+   * @return TILEDB_BK_OK for success, and TILEDB_OK_ERR for error.
+   */
+  int load(StorageFS *fs, const std::vector<int>& attribute_ids);
+
+  /**
+   * Loads the tile offsets, variable tile offsets and variable tile sizes of
+   * the input attributes that have not been loaded yet. Safe to call
+   * concurrently with reads of the attributes already loaded.
+   * @param fs The Storage File System class.
+   * @param attribute_ids The ids of the attributes to load.
+   *
+   * @return TILEDB_BK_OK for success, and TILEDB_OK_ERR for error.
+   */
+  int load_attributes(StorageFS *fs, const std::vector<int>& attribute_ids);
+
   /**
    * Simply sets the number of cells for the last tile.
    *
@@ -250,8 +390,8 @@ class BookKeeping {
 
   /** The array schema */
   const ArraySchema* array_schema_;
-  /** The first and last coordinates of each tile. */
-  std::vector<void*> bounding_coords_;
+  /** The first and last coordinates of each tile, stored back to back. */
+  std::vector<char> bounding_coords_;
   /** True if the fragment is dense, and false if it is sparse. */
   bool dense_;
   /**
@@ -265,8 +405,22 @@ class BookKeeping {
   std::string fragment_name_;
   /** Number of cells in the last tile (meaningful only in the sparse case). */
   int64_t last_tile_cell_num_;
-  /** The MBRs (applicable only to the sparse case with irregular tiles). */
-  std::vector<void*> mbrs_;
+  /**
+   * The MBRs (applicable only to the sparse case with irregular tiles), stored
+   * back to back.
+   */
+  std::vector<char> mbrs_;
+  /** The MBRs in dimension-major order, see mbrs_dim_major(). */
+  mutable std::vector<char> mbrs_dim_major_;
+  mutable std::once_flag mbrs_dim_major_once_;
+  /** The R-tree over the MBRs, see mbr_index(). */
+  mutable std::unique_ptr<MBRIndex> mbr_index_;
+  mutable std::once_flag mbr_index_once_;
+  /** The bounding box of the MBRs, see mbrs_bounds(). */
+  mutable std::vector<char> mbrs_bounds_;
+  mutable std::once_flag mbrs_bounds_once_;
+  /** The number of bytes held by the MBR layouts built so far. */
+  mutable std::atomic<size_t> lazy_memory_size_{0};
   /** The mode in which the fragment was initialized. */
   int mode_;
   /** The offsets of the next tile for each attribute. */
@@ -294,11 +448,93 @@ class BookKeeping {
    */
   std::vector<std::vector<size_t> > tile_var_sizes_;
 
+  /**
+   * The contents of a version 2 book-keeping file, either memory mapped or
+   * read into v2_buffer_, NULL if the book-keeping was not loaded from one.
+   */
+  const char* v2_data_ = NULL;
+  size_t v2_size_ = 0;
+  bool v2_mapped_ = false;
+  std::vector<char> v2_buffer_;
+  /**
+   * The (offset, length) in bytes of each section of the uncompressed
+   * book-keeping, numbered as in version 2 files. Also indexes the decompressed
+   * contents of compressed book-keeping files, so that the sections of an
+   * attribute can be loaded on demand.
+   */
+  std::vector<std::pair<int64_t, int64_t>> sections_;
+  /** True for the attributes whose tile offsets and sizes are loaded. */
+  std::vector<bool> attribute_loaded_;
+  /** Serializes the loading of attributes on demand with memory_size(). */
+  mutable std::mutex attribute_mtx_;
+
 
   /* ********************************* */
   /*           PRIVATE METHODS         */
   /* ********************************* */
 
+  /**
+   * Counts size bytes built on first use in memory_size() and updates the
+   * size of the cache entry of the book-keeping, if it is cached.
+   */
+  void add_lazy_memory_size(size_t size) const;
+
+  /**
+   * Loads the input attributes, which must not be loaded yet, with
+   * attribute_mtx_ held.
+   */
+  int load_missing_attributes(StorageFS *fs, const std::vector<int>& to_load);
+
+  /** Computes the bounding box of the MBRs into mbrs_bounds_. */
+  template<class T>
+  void compute_mbrs_bounds() const;
+
+  /**
+   * Writes the book-keeping to an uncompressed version 2 file with a header,
+   * a table of section offsets and the sections as raw arrays aligned to 8
+   * bytes.
+   * @return TILEDB_BK_OK on success and TILEDB_BK_ERR on error.
+   */
+  int finalize_v2(StorageFS *fs);
+
+  /**
+   * Loads the book-keeping from an uncompressed version 2 file.
+   * @return TILEDB_BK_OK on success and TILEDB_BK_ERR on error.
+   */
+  int load_v2(StorageFS *fs, const std::string& filename);
+
+  /** Returns a pointer to the start of a section of the version 2 file. */
+  const char* v2_section(int section) const {
+    return v2_data_ + sections_[section].first;
+  }
+
+  /** Returns the number of elements of the given size in a section. */
+  int64_t v2_section_num(int section, size_t element_size) const {
+    return sections_[section].second / element_size;
+  }
+
+  /**
+   * Indexes the tile offsets, variable tile offsets and variable tile sizes
+   * sections of all the attributes in the decompressed book-keeping buffer,
+   * and loads the cell number of the last tile that follows them.
+   * @return TILEDB_BK_OK on success and TILEDB_BK_ERR on error.
+   */
+  int index_sections();
+
+  /**
+   * Loads the indexed sections of the input attributes from the book-keeping
+   * buffer if it is open, or from the version 2 file otherwise.
+   * @return TILEDB_BK_OK on success and TILEDB_BK_ERR on error.
+   */
+  int load_attribute_sections(StorageFS *fs, const std::vector<int>& attribute_ids);
+
+  /**
+   * Opens the book-keeping buffer for reading the compressed book-keeping file,
+   * using the locally cached copy if there is one for cloud filesystems.
+   * @param posix_fs Filesystem of the locally cached copy, must outlive the buffer.
+   */
+  void open_buffer(StorageFS *fs, PosixFS *posix_fs);
+
   /**
    * Writes the bounding coordinates to the book-keeping buffer.
    * @return TILEDB_BK_OK on success and TILEDB_BK_ERR on error.
@@ -347,12 +583,6 @@ class BookKeeping {
    */
   int load_bounding_coords();
 
-  /**
-   * Loads the cell number of the last tile from the book-keeping buffer
-   * @return TILEDB_BK_OK on success and TILEDB_BK_ERR on error.
-   */
-  int load_last_tile_cell_num();
-
   /**
    * Loads the MBRs from the book-keeping buffer.
    * @return TILEDB_BK_OK on success and TILEDB_BK_ERR on error.
@@ -364,24 +594,6 @@ class BookKeeping {
    * @return TILEDB_BK_OK on success and TILEDB_BK_ERR on error.
    */
   int load_non_empty_domain();
-
-  /**
-   * Loads the tile offsets from the book-keeping buffer.
-   * @return TILEDB_BK_OK on success and TILEDB_BK_ERR on error.
-   */
-  int load_tile_offsets();
-
-  /**
-   * Loads the variable tile offsets from the book-keeping buffer.
-   * @return TILEDB_BK_OK on success and TILEDB_BK_ERR on error.
-   */
-  int load_tile_var_offsets();
-
-  /**
-   * Loads the variable tile sizes from the book-keeping buffer.
-   * @return TILEDB_BK_OK on success and TILEDB_BK_ERR on error.
-   */
-  int load_tile_var_sizes();
 };
 
 #endif
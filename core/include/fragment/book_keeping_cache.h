@@ -0,0 +1,124 @@
+/**
+ * @file   book_keeping_cache.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2026 Omics Data Automation, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Process-wide cache of the book-keeping of fragments opened for reads.
+ */
+
+#ifndef __BOOK_KEEPING_CACHE_H__
+#define __BOOK_KEEPING_CACHE_H__
+
+#include "book_keeping.h"
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/**
+ * Fragments are immutable once written and their directory names are unique, so the
+ * book-keeping of a fragment loaded for reads can be reused by every later open of the
+ * array in the process, from any TileDB context, for as long as a fragment with that
+ * name exists. Entries are keyed by the fragment directory and are dropped least
+ * recently used first once their total size exceeds the limit set with
+ * TILEDB_BOOKKEEPING_CACHE_SIZE. Book-keeping structures are reference counted, open
+ * arrays keep using entries that have been evicted.
+ */
+class BookKeepingCache {
+ public:
+  /**
+   * Returns the cache shared by all the StorageManagers of the process, sized
+   * with TILEDB_BOOKKEEPING_CACHE_SIZE when first used.
+   */
+  static BookKeepingCache& instance();
+
+  /**
+   * Returns the cached book-keeping of the fragment, or an empty pointer if it is not
+   * cached.
+   */
+  std::shared_ptr<BookKeeping> get(const std::string& fragment_name);
+
+  /**
+   * Adds the book-keeping of the fragment to the cache and evicts entries if
+   * needed. Book-keeping larger than the cache size limit is not cached.
+   */
+  void put(const std::string& fragment_name, const std::shared_ptr<BookKeeping>& book_keeping);
+
+  /**
+   * Updates the size of the entry of the fragment after its book-keeping has
+   * loaded attributes or built MBR layouts on first use, and evicts entries if
+   * needed. Does nothing if book_keeping is not the cached one.
+   */
+  void recharge(const std::string& fragment_name, const BookKeeping* book_keeping);
+
+  /** Drops the entry of the fragment dir and of all the fragments found under dir. */
+  void invalidate(const std::string& dir);
+
+  /** Drops all the entries. */
+  void clear();
+
+  /** Sets the size limit in bytes, 0 disables the cache. */
+  void set_max_size(size_t max_size);
+
+  size_t max_size();
+
+  /** Number of bytes of book-keeping currently cached. */
+  size_t size();
+
+  /** Number of book-keeping lookups served from the cache. */
+  size_t hits();
+
+  /** Number of book-keeping lookups that were not found in the cache. */
+  size_t misses();
+
+ private:
+  typedef struct cache_entry_t {
+    std::shared_ptr<BookKeeping> book_keeping_;
+    size_t size_;
+    std::list<std::string>::iterator lru_it_;
+  } cache_entry_t;
+
+  BookKeepingCache();
+
+  std::mutex mtx_;
+  // Fragment names, most recently used first. The map is ordered so all the fragments
+  // of an array can be found by their common prefix.
+  std::list<std::string> lru_;
+  std::map<std::string, cache_entry_t> entries_;
+  size_t max_size_ = 0;
+  size_t size_ = 0;
+  size_t hits_ = 0;
+  size_t misses_ = 0;
+
+  // Called with mtx_ held
+  void erase(std::map<std::string, cache_entry_t>::iterator it);
+  void evict();
+};
+
+#endif /* __BOOK_KEEPING_CACHE_H__ */
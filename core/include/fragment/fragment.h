@@ -64,8 +64,8 @@
 /*          GLOBAL VARIABLES         */
 /* ********************************* */
 
-/** Stores potential error messages. */
-extern std::string tiledb_fg_errmsg;
+/** Stores potential error messages of the calling thread. */
+extern thread_local std::string tiledb_fg_errmsg;
 
 
 
@@ -236,6 +236,22 @@ class Fragment {
    */
   int write(const void** buffers, const size_t* buffer_sizes);
 
+  /**
+   * Performs a write operation for a single attribute in a fragment opened in
+   * TILEDB_ARRAY_WRITE mode, with the cell values respecting the cell order on
+   * the disk. Different attributes may be written concurrently.
+   *
+   * @param attribute_id The id of the attribute to write.
+   * @param buffers The buffer of the attribute, or two buffers for a
+   *     variable-sized attribute as in Fragment::write().
+   * @param buffer_sizes The sizes (in bytes) of the input buffers.
+   * @return TILEDB_FG_OK for success and TILEDB_FG_ERR for error.
+   */
+  int write_attribute(
+      int attribute_id,
+      const void** buffers,
+      const size_t* buffer_sizes);
+
  private:
   /* ********************************* */
   /*        PRIVATE ATTRIBUTES         */
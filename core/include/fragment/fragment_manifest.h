@@ -0,0 +1,233 @@
+/**
+ * @file   fragment_manifest.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2026 Omics Data Automation, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file defines class FragmentManifest.
+ */
+
+#ifndef __FRAGMENT_MANIFEST_H__
+#define __FRAGMENT_MANIFEST_H__
+
+#include "storage_fs.h"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+
+
+/* ********************************* */
+/*             CONSTANTS             */
+/* ********************************* */
+
+/** Magic bytes at the start of a fragment manifest file. */
+#define TILEDB_FM_MAGIC "TDBFMV1"
+
+/** Lock file serializing the updates of a manifest across processes. */
+#define TILEDB_FM_LOCK_FILENAME ".__tiledb_fragments_lock"
+
+/**@{*/
+/** Return code. */
+#define TILEDB_FM_OK          0
+#define TILEDB_FM_ERR        -1
+/**@}*/
+
+/** Default error message. */
+#define TILEDB_FM_ERRMSG std::string("[TileDB::FragmentManifest] Error: ")
+
+
+
+
+/* ********************************* */
+/*          GLOBAL VARIABLES         */
+/* ********************************* */
+
+/** Stores potential error messages of the calling thread. */
+extern thread_local std::string tiledb_fm_errmsg;
+
+
+
+
+/**
+ * Lists the committed fragments of an array in a single file in the array
+ * directory, so arrays can be opened without listing the array directory and
+ * checking every fragment directory for its fragment file, i.e. one LIST and a
+ * HEAD per fragment on object stores. The manifest is created on the first
+ * fragment commit with TILEDB_FRAGMENT_MANIFEST set, and from then on it is
+ * updated by every fragment commit and consolidation. Updates replace the whole
+ * file, through a temporary file and a rename on filesystems that support it,
+ * and are serialized across processes with a file lock where locking is
+ * supported. Elsewhere concurrent updates may lose an entry, so the manifest is
+ * reconciled with a listing of the array directory, which only costs a HEAD for
+ * the fragments missing from the manifest. Arrays without a manifest, or with
+ * one that cannot be read, are opened by listing the array directory.
+ */
+class FragmentManifest {
+ public:
+  typedef struct entry_t {
+    /** The fragment directory, relative to the array directory. */
+    std::string name_;
+    /** The timestamp of the fragment, from its name. */
+    int64_t timestamp_;
+    /** True if the fragment is dense. */
+    bool dense_;
+    /** The non-empty domain of the fragment, empty if not known. */
+    std::vector<char> non_empty_domain_;
+  } entry_t;
+
+  /* ********************************* */
+  /*     CONSTRUCTORS & DESTRUCTORS    */
+  /* ********************************* */
+
+  /**
+   * Constructor.
+   *
+   * @param fs The filesystem of the array.
+   * @param array_dir The real array directory.
+   */
+  FragmentManifest(StorageFS* fs, const std::string& array_dir);
+
+  /* ********************************* */
+  /*             ACCESSORS             */
+  /* ********************************* */
+
+  /** Returns the fragments in the order they were committed. */
+  const std::vector<entry_t>& entries() const;
+
+  /* ********************************* */
+  /*             MUTATORS              */
+  /* ********************************* */
+
+  /**
+   * Loads the manifest of the array.
+   *
+   * @return True if the array has a valid manifest.
+   */
+  bool load();
+
+  /**
+   * Reconciles the loaded manifest with the fragment directories listed in the
+   * array directory. Committed fragments missing from the manifest are added
+   * and fragments whose directories are gone are dropped. Only the directories
+   * not in the manifest are checked for their fragment file.
+   */
+  void reconcile();
+
+  /**
+   * Adds a committed fragment to the manifest of its array, creating the
+   * manifest if TILEDB_FRAGMENT_MANIFEST is set.
+   *
+   * @param fs The filesystem of the array.
+   * @param fragment_dir The real fragment directory.
+   * @param dense True if the fragment is dense.
+   * @param non_empty_domain The non-empty domain of the fragment.
+   * @param domain_size The size of the non-empty domain in bytes.
+   * @return TILEDB_FM_OK for success and TILEDB_FM_ERR for error.
+   */
+  static int add_fragment(
+      StorageFS* fs,
+      const std::string& fragment_dir,
+      bool dense,
+      const void* non_empty_domain,
+      size_t domain_size);
+
+  /**
+   * Removes fragments of an array from its manifest, if it has one.
+   *
+   * @param fs The filesystem of the array.
+   * @param array_dir The real array directory.
+   * @param fragment_dirs The real fragment directories.
+   * @return TILEDB_FM_OK for success and TILEDB_FM_ERR for error.
+   */
+  static int remove_fragments(
+      StorageFS* fs,
+      const std::string& array_dir,
+      const std::vector<std::string>& fragment_dirs);
+
+  /**
+   * Deletes the manifest of an array, if it has one.
+   *
+   * @param fs The filesystem of the array.
+   * @param array_dir The real array directory.
+   * @return TILEDB_FM_OK for success and TILEDB_FM_ERR for error.
+   */
+  static int remove(StorageFS* fs, const std::string& array_dir);
+
+ private:
+  /* ********************************* */
+  /*         PRIVATE ATTRIBUTES        */
+  /* ********************************* */
+
+  /** The real array directory. */
+  std::string array_dir_;
+  /** The fragments in the order they were committed. */
+  std::vector<entry_t> entries_;
+  /** The path of the manifest file. */
+  std::string filename_;
+  /** The filesystem of the array. */
+  StorageFS* fs_;
+  /** Serializes the updates of manifests in the process. */
+  static std::mutex update_mtx_;
+
+  /* ********************************* */
+  /*          PRIVATE METHODS          */
+  /* ********************************* */
+
+  /**
+   * Builds the manifest from the fragment directories found in the array
+   * directory. Their non-empty domains are not known.
+   */
+  void scan();
+
+  /**
+   * Takes the exclusive lock on the manifest of an array, if the filesystem
+   * supports locking.
+   *
+   * @param fs The filesystem of the array.
+   * @param array_dir The real array directory.
+   * @param fd The descriptor of the lock file, -1 if no lock was taken.
+   * @return TILEDB_FM_OK for success and TILEDB_FM_ERR for error.
+   */
+  static int lock(StorageFS* fs, const std::string& array_dir, int& fd);
+
+  /** Releases the lock taken with lock(). */
+  static void unlock(int fd);
+
+  /** Returns a manifest entry for a fragment directory found in the listing. */
+  entry_t scan_entry(const std::string& fragment_dir);
+
+  /**
+   * Stores the manifest, replacing the existing file.
+   *
+   * @return TILEDB_FM_OK for success and TILEDB_FM_ERR for error.
+   */
+  int store();
+};
+
+#endif /* __FRAGMENT_MANIFEST_H__ */
@@ -0,0 +1,127 @@
+/**
+ * @file   mbr_index.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2026 Omics Data Automation, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * R-tree over the MBRs of the tiles of a sparse fragment.
+ */
+
+#ifndef __MBR_INDEX_H__
+#define __MBR_INDEX_H__
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+/** Number of children of each node of the MBR index. */
+#define TILEDB_MBR_INDEX_FANOUT 16
+
+/**
+ * Packed R-tree over the MBRs of a sparse fragment. The tiles of a fragment
+ * follow the global cell order, so consecutive tiles are close to each other
+ * and are grouped bottom-up into nodes of TILEDB_MBR_INDEX_FANOUT children
+ * without sorting. The leaves are the MBRs themselves, only the bounding boxes
+ * of the inner nodes are stored. Looking up the tiles that overlap a subarray
+ * then takes logarithmic time in the number of tiles plus the number of
+ * overlapping tiles.
+ */
+class MBRIndex {
+ public:
+  /**
+   * Builds the index.
+   *
+   * @param coords_type The type of the coordinates.
+   * @param dim_num The number of dimensions.
+   * @param mbrs The MBRs stored back to back, which must outlive the index.
+   * @param mbr_num The number of MBRs.
+   */
+  MBRIndex(int coords_type, int dim_num, const void* mbrs, int64_t mbr_num);
+
+  /** Returns the approximate number of bytes held by the index. */
+  size_t memory_size() const;
+
+  /**
+   * Appends the positions of the tiles that overlap the input subarray to
+   * tiles, in ascending order.
+   *
+   * @template T The type of the coordinates.
+   * @param subarray The subarray.
+   * @param first The first tile position to consider.
+   * @param last The last tile position to consider.
+   * @param tiles The positions of the overlapping tiles.
+   */
+  template<class T>
+  void query(
+      const T* subarray,
+      int64_t first,
+      int64_t last,
+      std::vector<int64_t>& tiles) const;
+
+  /**
+   * Checks if the input subarray overlaps the top level of the index. This is
+   * a quick test that may report overlaps with the gaps between tiles.
+   *
+   * @template T The type of the coordinates.
+   * @param subarray The subarray.
+   * @return True if the subarray may overlap some tile.
+   */
+  template<class T>
+  bool overlaps(const T* subarray) const;
+
+ private:
+  /** The number of dimensions. */
+  int dim_num_;
+  /** The bounding boxes of the nodes of each level, starting from the lowest. */
+  std::vector<std::vector<char>> levels_;
+  /** The number of nodes of each level. */
+  std::vector<int64_t> level_node_num_;
+  /** The MBRs, i.e. the leaves. */
+  const void* mbrs_;
+  /** The number of MBRs. */
+  int64_t mbr_num_;
+
+  /** Builds the inner levels of the index. */
+  template<class T>
+  void build();
+
+  /**
+   * Looks up the overlapping tiles under the nodes [begin, end) of a level,
+   * where level -1 stands for the MBRs.
+   */
+  template<class T>
+  void query(
+      int level,
+      int64_t begin,
+      int64_t end,
+      int64_t span,
+      const T* subarray,
+      int64_t first,
+      int64_t last,
+      std::vector<int64_t>& tiles) const;
+};
+
+#endif
@@ -38,6 +38,9 @@
 #include "codec.h"
 #include "fragment.h"
 #include "storage_buffer.h"
+#include "tile_cache.h"
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
 
@@ -64,8 +67,8 @@
 /*          GLOBAL VARIABLES         */
 /* ********************************* */
 
-/** Stores potential error messages. */
-extern std::string tiledb_rs_errmsg;
+/** Stores potential error messages of the calling thread. */
+extern thread_local std::string tiledb_rs_errmsg;
 
 
 
@@ -191,6 +194,15 @@ class ReadState {
    */
   void reset_overflow();
 
+  /**
+   * Computes the tiles overlapping the query subarray if tiles are gathered
+   * and they are not up to date. Invoked before the attributes of the fragment
+   * are read concurrently, so that they are not computed by several threads.
+   *
+   * @return void.
+   */
+  void prepare_gathered_reads();
+
 
 
 
@@ -420,6 +432,33 @@ class ReadState {
   /** Cache attribute filesizes for fragment */
   std::vector<ssize_t> file_size_;
   std::vector<ssize_t> file_var_size_;
+
+  /**
+   * Compressed tiles fetched together with a single vectored read, keyed by their
+   * file offset to their offset in data_ and their size.
+   */
+  typedef struct gathered_tiles_t {
+    std::vector<char> data_;
+    std::unordered_map<off_t, std::pair<size_t, size_t>> tiles_;
+  } gathered_tiles_t;
+
+  /**
+   * Gathered tiles per attribute+coords and per variable attribute. Applicable
+   * only to **sparse** fragments when TILEDB_READ_GATHER_SIZE is set.
+   */
+  std::vector<gathered_tiles_t> gathered_tiles_;
+  std::vector<gathered_tiles_t> gathered_var_tiles_;
+  /** Maximum number of bytes of compressed tiles gathered in one read, 0 disables gathering. */
+  size_t gather_size_;
+  /** The positions of the tiles whose MBRs overlap the query subarray. */
+  std::vector<int64_t> overlapping_tiles_;
+  /** True if overlapping_tiles_ is up to date with the query subarray. */
+  bool overlapping_tiles_computed_;
+  /**
+   * Minimum number of tiles in the tile search range for the overlapping tiles
+   * to be looked up with the MBR index instead of a scan.
+   */
+  int64_t mbr_index_min_tiles_;
   
   /** Compression per attribute */
   std::vector<Codec *> codec_;
@@ -441,10 +480,10 @@ class ReadState {
   std::vector<void*> map_addr_;
   /** The corresponding lengths of the buffers in map_addr_. */
   std::vector<size_t> map_addr_lengths_;
-  /** A buffer mapping a compressed tile from disk. */
-  void* map_addr_compressed_;
-  /** The corresponding length of the map_addr_compressed_ buffer. */
-  size_t map_addr_compressed_length_;
+  /** A buffer for each attribute used by mmap for mapping a compressed tile. */
+  std::vector<void*> map_addr_compressed_;
+  /** The corresponding lengths of the buffers in map_addr_compressed_. */
+  std::vector<size_t> map_addr_compressed_lengths_;
   /** 
    * A buffer for each attribute used by mmap for mapping a variable tile from
    * disk. 
@@ -462,8 +501,11 @@ class ReadState {
    *    - 3: Partial overlap contig
    */
   int mbr_tile_overlap_;
-  /** Indicates buffer overflow for each attribute. */ 
-  std::vector<bool> overflow_;
+  /**
+   * Indicates buffer overflow for each attribute. Not a vector of bools, so
+   * that different attributes may be read concurrently.
+   */
+  std::vector<char> overflow_;
   /**
    * The type of overlap of the current search tile with the query subarray
    * is full or not. It can be one of the following:
@@ -482,10 +524,13 @@ class ReadState {
    * in the current overlapping tile.
    */
   bool subarray_area_covered_;
-  /** Internal buffer used in the case of compression. */
-  void* tile_compressed_;
-  /** Allocated size for internal buffer used in the case of compression. */
-  size_t tile_compressed_allocated_size_;
+  /**
+   * Internal buffers used in the case of compression, one per attribute plus
+   * two for coordinates like tiles_.
+   */
+  std::vector<void*> tile_compressed_;
+  /** Allocated sizes for the internal buffers used in the case of compression. */
+  std::vector<size_t> tile_compressed_allocated_size_;
   /** File offset for each attribute tile. */
   std::vector<off_t> tiles_file_offsets_;
   /** File offset for each variable-sized attribute tile. */
@@ -512,10 +557,19 @@ class ReadState {
   std::vector<size_t> tiles_var_offsets_;
   /** Sizes of tiles_var_ (one per attribute). */
   std::vector<size_t> tiles_var_sizes_;
+  /** True if decompressed tiles are shared through the process-wide tile cache. */
+  bool use_tile_cache_;
+  /**
+   * The cached tiles that tiles_ point to, which are pinned while they are
+   * read. A tile buffer is owned by the read state if its entry is empty.
+   */
+  std::vector<std::shared_ptr<TileCache::Tile>> cached_tiles_;
+  /** The cached tiles that tiles_var_ point to. */
+  std::vector<std::shared_ptr<TileCache::Tile>> cached_tiles_var_;
   /** Temporary coordinates. */
   void* tmp_coords_;
-  /** Temporary offset. */
-  size_t tmp_offset_;
+  /** Temporary offsets (one per attribute). */
+  std::vector<size_t> tmp_offset_;
 
 
 
@@ -546,6 +600,49 @@ class ReadState {
    */
   int read_segment(int attribute_id, bool is_var, off_t offset, void *segment, size_t length);
 
+  /**
+   * Reads a compressed tile from the gathered tiles of the attribute. On a miss,
+   * the tile is gathered along with the following tiles overlapping the query
+   * subarray upto gather_size_ bytes with a single vectored read.
+   *
+   * @param attribute_id The id of the attribute, attribute_num_ for coordinates.
+   * @param is_var Boolean to specify whether the attribute is var.
+   * @param offset The offset at which the tile starts in the file.
+   * @param tile Pointer to preallocated tile buffer.
+   * @param tile_size The compressed tile size.
+   * @return TILEDB_RS_OK on success and TILEDB_RS_ERR on error.
+   */
+  int read_tile_gathered(int attribute_id, bool is_var, off_t offset, void *tile, size_t tile_size);
+
+  /**
+   * Fetches the compressed tile starting at offset and the following overlapping
+   * tiles of the attribute file into the gathered tiles.
+   *
+   * @param attribute_id The id of the attribute, attribute_num_ for coordinates.
+   * @param is_var Boolean to specify whether the attribute is var.
+   * @param offset The offset at which the first tile starts in the file.
+   * @return TILEDB_RS_OK on success and TILEDB_RS_ERR on error.
+   */
+  int gather_tiles(int attribute_id, bool is_var, off_t offset);
+
+  /**
+   * Computes the positions of the tiles in the tile search range whose MBRs
+   * overlap the query subarray.
+   *
+   * @return void
+   */
+  void compute_overlapping_tiles();
+
+  /**
+   * Computes the positions of the tiles in the tile search range whose MBRs
+   * overlap the query subarray.
+   *
+   * @tparam T The coordinates type.
+   * @return void
+   */
+  template<class T>
+  void compute_overlapping_tiles();
+
   /**
    * Compares input coordinates to coordinates from the search tile.
    *
@@ -800,6 +897,39 @@ class ReadState {
       size_t tile_size);
 #endif
 
+  /**
+   * Sets the tile of an attribute to the decompressed tile found in the tile
+   * cache, pinning it until another tile is prepared for the attribute.
+   *
+   * @param attribute_id The id of the attribute the tile is prepared for.
+   * @param tile_i The tile position on the disk.
+   * @param var True for the tile with the variable-sized cell values.
+   * @return True if the tile was found in the tile cache.
+   */
+  bool get_cached_tile(int attribute_id, int64_t tile_i, bool var);
+
+  /**
+   * Adds the decompressed tile of an attribute to the tile cache, which takes
+   * over the tile buffer.
+   *
+   * @param attribute_id The id of the attribute the tile was prepared for.
+   * @param tile_i The tile position on the disk.
+   * @param var True for the tile with the variable-sized cell values.
+   * @param size The allocated size of the tile buffer.
+   * @return void
+   */
+  void put_cached_tile(int attribute_id, int64_t tile_i, bool var, size_t size);
+
+  /**
+   * Unpins the cached tile of an attribute, if any, so that the next tile is
+   * decompressed into a buffer owned by the read state.
+   *
+   * @param attribute_id The id of the attribute.
+   * @param var True for the tile with the variable-sized cell values.
+   * @return void
+   */
+  void release_cached_tile(int attribute_id, bool var);
+
   /**
    * Prepares a tile from the disk for reading for an attribute.    
    *
@@ -0,0 +1,161 @@
+/**
+ * @file   tile_cache.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2026 Omics Data Automation, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Process-wide cache of decompressed tiles of fragments opened for reads.
+ */
+
+#ifndef __TILE_CACHE_H__
+#define __TILE_CACHE_H__
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/** Number of independently locked shards of the tile cache. */
+#define TILEDB_TILE_CACHE_SHARDS 16
+
+/**
+ * Fragments are immutable once written, so a tile decompressed by a read can be
+ * reused by every later read of that tile in the process, e.g. by overlapping
+ * subarrays, iterators resetting their subarray or other threads reading the same
+ * array. Entries are keyed by fragment directory, attribute, tile position and
+ * whether the tile holds the values of a variable-sized attribute rather than its
+ * offsets. They are dropped least recently used first once their total size exceeds
+ * the limit set with TILEDB_TILE_CACHE_SIZE. The cache is split in
+ * TILEDB_TILE_CACHE_SHARDS shards that are locked independently, each holding up to
+ * an equal share of the limit. Tiles are reference counted, a read pins the tile it
+ * copies cells from, so evicting the tile does not free it while in use.
+ */
+class TileCache {
+ public:
+  /** A decompressed tile, the buffer is freed with the tile. */
+  class Tile {
+   public:
+    Tile(void* data, size_t size) : data_(data), size_(size) {}
+    ~Tile() { free(data_); }
+    Tile(const Tile&) = delete;
+    Tile& operator=(const Tile&) = delete;
+
+    /** The tile buffer, which must not be modified once the tile is cached. */
+    void* data() const { return data_; }
+    /** The allocated size of the tile buffer. */
+    size_t size() const { return size_; }
+
+   private:
+    void* data_;
+    size_t size_;
+  };
+
+  /**
+   * Returns the cache shared by all the reads of the process, sized with
+   * TILEDB_TILE_CACHE_SIZE when first used.
+   */
+  static TileCache& instance();
+
+  /** Returns the cached tile, or an empty pointer if it is not cached. */
+  std::shared_ptr<Tile> get(const std::string& fragment_name, int attribute_id, int64_t tile_i, bool var);
+
+  /**
+   * Adds the tile to the cache and evicts entries of its shard if needed. Tiles
+   * larger than the share of the cache size limit of a shard are not cached.
+   */
+  void put(const std::string& fragment_name, int attribute_id, int64_t tile_i, bool var,
+           const std::shared_ptr<Tile>& tile);
+
+  /** Drops the tiles of the fragment dir and of all the fragments found under dir. */
+  void invalidate(const std::string& dir);
+
+  /** Drops all the entries. */
+  void clear();
+
+  /** Sets the size limit in bytes, 0 disables the cache. */
+  void set_max_size(size_t max_size);
+
+  size_t max_size();
+
+  /** Number of bytes of tiles currently cached. */
+  size_t size();
+
+  /** Number of tile lookups served from the cache. */
+  size_t hits();
+
+  /** Number of tile lookups that were not found in the cache. */
+  size_t misses();
+
+ private:
+  typedef struct tile_key_t {
+    std::string fragment_name_;
+    int attribute_id_;
+    int64_t tile_i_;
+    bool var_;
+
+    bool operator==(const tile_key_t& other) const {
+      return tile_i_ == other.tile_i_ && attribute_id_ == other.attribute_id_ &&
+             var_ == other.var_ && fragment_name_ == other.fragment_name_;
+    }
+  } tile_key_t;
+
+  struct tile_key_hash_t {
+    size_t operator()(const tile_key_t& key) const;
+  };
+
+  typedef struct cache_entry_t {
+    std::shared_ptr<Tile> tile_;
+    std::list<tile_key_t>::iterator lru_it_;
+  } cache_entry_t;
+
+  typedef struct shard_t {
+    std::mutex mtx_;
+    // Tile keys, most recently used first
+    std::list<tile_key_t> lru_;
+    std::unordered_map<tile_key_t, cache_entry_t, tile_key_hash_t> entries_;
+    size_t size_ = 0;
+  } shard_t;
+
+  TileCache();
+
+  std::array<shard_t, TILEDB_TILE_CACHE_SHARDS> shards_;
+  std::atomic<size_t> max_size_{0};
+  std::atomic<size_t> hits_{0};
+  std::atomic<size_t> misses_{0};
+
+  shard_t& shard(const tile_key_t& key);
+
+  // Called with the shard mutex held
+  void erase(shard_t& shard, std::unordered_map<tile_key_t, cache_entry_t, tile_key_hash_t>::iterator it);
+  void evict(shard_t& shard);
+};
+
+#endif /* __TILE_CACHE_H__ */
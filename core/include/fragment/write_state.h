@@ -37,6 +37,7 @@
 #include "codec.h"
 #include "fragment.h"
 #include "storage_buffer.h"
+#include <mutex>
 #include <vector>
 #include <iostream>
 
@@ -61,8 +62,8 @@
 /*          GLOBAL VARIABLES         */
 /* ********************************* */
 
-/** Stores potential error messages. */
-extern std::string tiledb_ws_errmsg;
+/** Stores potential error messages of the calling thread. */
+extern thread_local std::string tiledb_ws_errmsg;
 
 
 
@@ -157,6 +158,22 @@ class WriteState {
       const void** buffers, 
       const size_t* buffer_sizes);
 
+  /**
+   * Performs a write operation for a single attribute in TILEDB_ARRAY_WRITE
+   * mode. The attribute state is independent of the other attributes, so
+   * different attributes may be written concurrently.
+   *
+   * @param attribute_id The id of the attribute to write.
+   * @param buffers The buffer of the attribute, or two buffers for a
+   *     variable-sized attribute as in WriteState::write().
+   * @param buffer_sizes The sizes (in bytes) of the input buffers.
+   * @return TILEDB_WS_OK for success and TILEDB_WS_ERR for error.
+   */
+  int write_attribute(
+      int attribute_id,
+      const void** buffers,
+      const size_t* buffer_sizes);
+
  private:
   /* ********************************* */
   /*         PRIVATE ATTRIBUTES        */
@@ -211,12 +228,22 @@ class WriteState {
   /** The Storage Filesystem */
   StorageFS *fs_;
 
+  /** Serializes the creation of the fragment directory by concurrent writes. */
+  std::mutex fragment_dir_mtx_;
+
 
 
   /* ********************************* */
   /*           PRIVATE METHODS         */
   /* ********************************* */
 
+  /**
+   * Creates the fragment directory if it does not exist.
+   *
+   * @return TILEDB_WS_OK on success and TILEDB_WS_ERR on error.
+   */
+  int create_fragment_dir();
+
   /**
    * Compresses the input tile buffer, and stores it inside tile_compressed_
    * member attribute. 
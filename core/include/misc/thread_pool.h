@@ -0,0 +1,134 @@
+/**
+ * @file   thread_pool.h
+ *
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2026 Omics Data Automation, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *
+ * @section DESCRIPTION
+ *
+ * Pool of worker threads for running many short parallel loops.
+ */
+
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Runs parallel loops like parallel_for() on worker threads that are started
+ * once, for callers like reads that run a parallel loop per read round and
+ * would otherwise start and join threads thousands of times. The calling
+ * thread takes part in every loop, so a pool of num_threads runs
+ * num_threads-1 workers. Loops of a pool are run one at a time by the thread
+ * that owns the pool.
+ */
+class ThreadPool {
+ public:
+  /* ********************************* */
+  /*     CONSTRUCTORS & DESTRUCTORS    */
+  /* ********************************* */
+
+  /**
+   * Constructor.
+   *
+   * @param num_threads The maximum number of concurrent invocations, including
+   *     the calling thread.
+   */
+  explicit ThreadPool(int num_threads);
+
+  /** Destructor, joins the workers. */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /* ********************************* */
+  /*             ACCESSORS             */
+  /* ********************************* */
+
+  /** Returns the maximum number of concurrent invocations. */
+  int num_threads() const { return workers_.size() + 1; }
+
+  /* ********************************* */
+  /*             MUTATORS              */
+  /* ********************************* */
+
+  /**
+   * Invokes fn(i) for i in [0, n) in increasing order of i on the workers and
+   * the calling thread. No more invocations are started once one fails.
+   *
+   * @param n The number of invocations.
+   * @param fn The function to invoke, returns 0 on success.
+   * @return TILEDB_UT_OK if all invocations succeeded and TILEDB_UT_ERR otherwise.
+   */
+  int parallel_for(size_t n, const std::function<int(size_t)>& fn);
+
+ private:
+  /* ********************************* */
+  /*         PRIVATE ATTRIBUTES        */
+  /* ********************************* */
+
+  /** Signals the workers that a loop is started or that the pool is stopped. */
+  std::condition_variable start_cv_;
+  /** Signals the calling thread that all the workers are done with the loop. */
+  std::condition_variable done_cv_;
+  /** Number of workers done with the current loop. */
+  size_t done_num_ = 0;
+  /** True if any invocation of the current loop failed. */
+  std::atomic<bool> failed_;
+  /** The function invoked by the current loop. */
+  const std::function<int(size_t)>* fn_ = nullptr;
+  /** Incremented for every loop, so that each worker runs it once. */
+  uint64_t loop_ = 0;
+  /** Protects the loop state shared with the workers. */
+  std::mutex mtx_;
+  /** Number of invocations of the current loop. */
+  size_t n_ = 0;
+  /** The next invocation of the current loop. */
+  std::atomic<size_t> next_;
+  /** True once the pool is being destroyed. */
+  bool stop_ = false;
+  /** The worker threads. */
+  std::vector<std::thread> workers_;
+
+  /* ********************************* */
+  /*          PRIVATE METHODS          */
+  /* ********************************* */
+
+  /** Runs the invocations of the current loop until none are left. */
+  void run();
+
+  /** The main function of a worker. */
+  void work();
+};
+
+#endif /* __THREAD_POOL_H__ */
@@ -40,6 +40,7 @@
 #ifdef HAVE_MPI
   #include <mpi.h>
 #endif
+#include <functional>
 #include <pthread.h>
 #include <string>
 #include <vector>
@@ -73,8 +74,8 @@
 /*          GLOBAL VARIABLES         */
 /* ********************************* */
 
-/** Stores potential error messages. */
-extern std::string tiledb_ut_errmsg;
+/** Stores potential error messages of the calling thread. */
+extern thread_local std::string tiledb_ut_errmsg;
 
 
 /* ********************************* */
@@ -201,7 +202,7 @@ int cmp_row_order(
 /**
  * Checks if a given pathURL is a supported URL
  * @param pathURL URL to path to be checked.
- * @return true if pathURL starts with a supported URL, e.g. hdfs:// or s3://
+ * @return true if pathURL starts with a supported URL, e.g. hdfs://, s3:// or mem://
  */
 bool is_supported_cloud_path(const std::string& pathURL);
 
@@ -240,6 +241,13 @@ bool is_gcs_path(const std::string& pathURL);
  */
 bool is_hdfs_path(const std::string& pathURL);
 
+/**
+ * Checks if a given pathURL is in-memory.
+ * @param pathURL URL to path to be checked.
+ * @return true if pathURL starts with mem://
+ */
+bool is_memory_path(const std::string& pathURL);
+
 /**
  * Checks if the given environment variable is set to true(case ignored) or "1"
  * @param name environment variable name
@@ -247,6 +255,18 @@ bool is_hdfs_path(const std::string& pathURL);
  */
 bool is_env_set(const std::string& name);
 
+/**
+ * Invokes fn(i) for i in [0, n) in increasing order of i on upto num_threads
+ * threads, including the calling thread. No more invocations are started once
+ * one fails. fn should not set error messages as it can be invoked concurrently.
+ *
+ * @param num_threads The maximum number of concurrent invocations.
+ * @param n The number of invocations.
+ * @param fn The function to invoke, returns 0 on success.
+ * @return TILEDB_UT_OK if all invocations succeeded and TILEDB_UT_ERR otherwise.
+ */
+int parallel_for(int num_threads, size_t n, const std::function<int(size_t)>& fn);
+
 /**
  * Given a path, retrieve the last segment(filename)
  * @param path to file
@@ -690,6 +710,19 @@ int read_from_file(StorageFS *fs,
     void* buffer,
     size_t length);
 
+/**
+ * Reads several ranges of a file into their buffers with as few requests to the
+ * filesystem as possible.
+ *
+ * @param fs The storage filesystem type in use. e.g. posix, hdfs, etc.
+ * @param filename The name of the file.
+ * @param ranges The offsets and lengths of the ranges and their buffers.
+ * @return TILEDB_UT_OK on success and TILEDB_UT_ERR on error.
+ */
+int read_from_file_v(StorageFS *fs,
+    const std::string& filename,
+    const std::vector<read_range_t>& ranges);
+
 /**
  * Returns the absolute canonicalized directory path of the input directory.
  *
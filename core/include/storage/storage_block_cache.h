@@ -0,0 +1,172 @@
+/**
+ * @file storage_block_cache.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2026 Omics Data Automation, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * BlockCacheFS wraps another StorageFS, typically a cloud filesystem, and keeps
+ * fixed-size blocks of the files read from it on local disk.
+ *
+ */
+
+#ifndef __STORAGE_BLOCK_CACHE_H__
+#define  __STORAGE_BLOCK_CACHE_H__
+
+#include "storage_fs.h"
+#include "storage_posixfs.h"
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Read-through cache of file blocks on a local directory. Every call is forwarded to the
+ * wrapped filesystem, but read_from_file() is served from cached blocks when possible.
+ *
+ * Only files in committed fragment directories are cached, as they are immutable. Other
+ * files, e.g. array schemas and fragment manifests, may be rewritten in place and are always
+ * read from the wrapped filesystem. Blocks are stored one per file in the cache directory
+ * and are named <hash of uri>-<file size>-<block offset>. Blocks are written to a temporary file first and
+ * renamed into place, the in-memory LRU index is rebuilt from the directory on startup.
+ * Cached blocks are dropped once the cache grows beyond its size limit.
+ */
+class BlockCacheFS : public StorageCloudFS {
+ public:
+  /**
+   * Takes ownership of fs. Block size and the cache size limit default to 1MB and 1GB
+   * and are overridden with env TILEDB_BLOCK_CACHE_BLOCK_SIZE and TILEDB_BLOCK_CACHE_SIZE.
+   * Throws std::system_error if the cache directory cannot be created.
+   */
+  BlockCacheFS(StorageFS *fs, const std::string& home, const std::string& cache_dir);
+  ~BlockCacheFS();
+
+  std::string current_dir();
+  int set_working_dir(const std::string& dir);
+
+  bool is_dir(const std::string& dir);
+  bool is_file(const std::string& file);
+  std::string real_dir(const std::string& dir);
+
+  int create_dir(const std::string& dir);
+  int delete_dir(const std::string& dir);
+
+  std::vector<std::string> get_dirs(const std::string& dir);
+  std::vector<std::string> get_files(const std::string& dir);
+
+  int create_file(const std::string& filename, int flags, mode_t mode);
+  int delete_file(const std::string& filename);
+
+  ssize_t file_size(const std::string& filename);
+
+  int read_from_file(const std::string& filename, off_t offset, void *buffer, size_t length);
+  int write_to_file(const std::string& filename, const void *buffer, size_t buffer_size);
+
+  int move_path(const std::string& old_path, const std::string& new_path);
+
+  int sync_path(const std::string& path);
+
+  int close_file(const std::string& filename);
+
+  bool locking_support();
+
+  StorageFS *get_wrapped_fs() {
+    return fs_;
+  }
+
+  size_t block_size() {
+    return block_size_;
+  }
+
+  size_t max_cache_size() {
+    return max_cache_size_;
+  }
+
+  /** Number of bytes of cached blocks currently on disk. */
+  size_t cache_size();
+
+  /** Number of blocks served from the local cache. */
+  size_t block_cache_hits() {
+    return hits_;
+  }
+
+  /** Number of blocks that had to be read from the wrapped filesystem. */
+  size_t block_cache_misses() {
+    return misses_;
+  }
+
+ protected:
+  bool path_exists(const std::string& path);
+  int create_path(const std::string& path);
+  int commit_file(const std::string& filename);
+
+ private:
+  StorageFS *fs_;
+  PosixFS local_fs_;
+
+  std::string root_;
+  std::string cache_dir_;
+  size_t block_size_ = 1024*1024;
+  size_t max_cache_size_ = 1024*1024*1024;
+
+  // LRU list of cached block names, most recently used first. The map is ordered so all
+  // the blocks of a file can be found by their common prefix.
+  typedef std::pair<std::string, size_t> block_entry_t;
+  std::mutex mtx_;
+  std::list<block_entry_t> lru_;
+  std::map<std::string, std::list<block_entry_t>::iterator> blocks_;
+  size_t total_size_ = 0;
+  std::unordered_map<std::string, ssize_t> file_sizes_;
+
+  std::atomic<size_t> hits_{0};
+  std::atomic<size_t> misses_{0};
+  std::atomic<size_t> tmp_counter_{0};
+
+  std::string cache_uri(const std::string& path);
+  bool is_cacheable(const std::string& path);
+  std::string block_prefix(const std::string& path, ssize_t filesize);
+  std::string block_path(const std::string& name) {
+    return cache_dir_ + "/" + name;
+  }
+
+  ssize_t cached_file_size(const std::string& path);
+  void invalidate(const std::string& path);
+
+  void load_index();
+  bool lookup_block(const std::string& name);
+  void insert_block(const std::string& name, size_t size);
+  void remove_block(const std::string& name);
+  void evict_blocks();
+
+  int read_cached_block(const std::string& name, size_t offset, void *buffer, size_t length);
+  void store_block(const std::string& name, const void *buffer, size_t length);
+  int fetch_blocks(const std::string& filename, const std::string& prefix, ssize_t filesize,
+                   size_t first_block, size_t last_block, off_t offset, void *buffer, size_t length);
+};
+
+#endif /* __STORAGE_BLOCK_CACHE_H__ */
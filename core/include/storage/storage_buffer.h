@@ -36,7 +36,10 @@
 #include "storage_posixfs.h"
 #include "tiledb_constants.h"
 
+#include <functional>
+#include <future>
 #include <memory>
+#include <vector>
 #include <zlib.h>
 
 /* ********************************* */
@@ -56,14 +59,16 @@
 /*          GLOBAL VARIABLES         */
 /* ********************************* */
 
-/** Stores potential error messages. */
-extern std::string tiledb_bf_errmsg;
+/** Stores potential error messages of the calling thread. */
+extern thread_local std::string tiledb_bf_errmsg;
 
 class StorageBuffer {
  public:
   /**
    * Constructor that accepts StorageFS and the filename minimally. StorageBuffer is a no-op
-   * if the upload/download limits are not set in StorageFS.
+   * if the upload/download limits are not set in StorageFS. Buffered reads prefetch the next
+   * chunk asynchronously for sequential access if env TILEDB_READ_AHEAD is set. Buffered writes
+   * hand off full chunks to a background write if env TILEDB_WRITE_BEHIND is set.
    */
   StorageBuffer(StorageFS *fs, const std::string& filename, size_t chunk_size, const bool is_read=false);
 
@@ -115,6 +120,15 @@ class StorageBuffer {
    * Finalize flushes existing buffers and releases any allocated memory.
    */
   virtual int finalize();
+
+  /**
+   * Enable/disable writing out full chunks in the background while the next chunk is being
+   * appended. Errors from background writes are returned by subsequent calls to append_buffer,
+   * flush or finalize.
+   */
+  void set_write_behind(const bool write_behind) {
+    write_behind_ = write_behind && !read_only_;
+  }
   
  protected:
   void *buffer_ = NULL;
@@ -133,10 +147,36 @@ class StorageBuffer {
 
   bool is_error_ = false;
 
+  // Read-ahead state, the cached buffer and the prefetch buffer each use about half of chunk_size_
+  bool read_ahead_ = false;
+  size_t last_read_end_ = 0;
+  void *prefetch_buffer_ = NULL;
+  off_t prefetch_offset_ = 0;
+  size_t prefetch_size_ = 0;
+  size_t allocated_prefetch_size_ = 0;
+  std::future<int> prefetch_;
+
+  // Write-behind state, only one chunk is written out in the background at any time to preserve
+  // the order of writes
+  bool write_behind_ = false;
+  void *write_behind_buffer_ = NULL;
+  size_t allocated_write_behind_size_ = 0;
+  std::future<int> write_behind_future_;
+  std::string write_behind_errmsg_;
+
   /**
    * Frees the allocated cached buffers and reinitializes all associated variables.
    */
   virtual void free_buffer() {
+    wait_for_prefetch();
+    wait_for_write_behind();
+    if (write_behind_buffer_) free(write_behind_buffer_);
+    write_behind_buffer_ = NULL;
+    allocated_write_behind_size_ = 0;
+    if (prefetch_buffer_) free(prefetch_buffer_);
+    prefetch_buffer_ = NULL;
+    prefetch_size_ = 0;
+    allocated_prefetch_size_ = 0;
     if (buffer_) free(buffer_);
     buffer_ = NULL;
     buffer_offset_ = 0;
@@ -144,16 +184,45 @@ class StorageBuffer {
   }
 
   int read_buffer();
+
+  /**
+   * Starts reading the chunk following the cached buffer in the background.
+   */
+  void start_prefetch();
+
+  /**
+   * Waits for any outstanding prefetch to complete, returns TILEDB_BF_ERR if the prefetch failed.
+   */
+  int wait_for_prefetch();
+
+  /**
+   * Swaps the prefetched chunk in as the cached buffer if it starts at offset.
+   * @return true if the cached buffer now contains offset.
+   */
+  bool use_prefetch(off_t offset);
+
+  /**
+   * Writes out size bytes from buffer in the background after waiting for any previous background
+   * write. buffer is swapped with an idle buffer of allocated_size bytes that can be refilled right away.
+   */
+  int write_behind(void *&buffer, size_t& allocated_size, size_t size);
+
+  /**
+   * Waits for any outstanding background write to complete, returns TILEDB_BF_ERR if the write failed.
+   */
+  int wait_for_write_behind();
   virtual int write_buffer();
 };
 
 class CompressedStorageBuffer : public StorageBuffer {
  public:
+  /**
+   * Constructor for compressed StorageBuffers, supported compression types are TILEDB_GZIP and TILEDB_ZSTD.
+   * Segments are compressed/decompressed as independent blocks on upto env TILEDB_COMPRESSION_THREADS
+   * threads. Files compressed with TILEDB_ZSTD are recognized and read even if compression type is TILEDB_GZIP.
+   */
   CompressedStorageBuffer(StorageFS *fs, const std::string& filename, size_t chunk_size, const bool is_read=false,
-                          const int compression_type=TILEDB_NO_COMPRESSION, const int compression_level=0)
-      : StorageBuffer(fs, filename, chunk_size, is_read),
-        compression_type_(compression_type), compression_level_(compression_level) {
-  }
+                          const int compression_type=TILEDB_NO_COMPRESSION, const int compression_level=0);
 
   ~CompressedStorageBuffer() {
     free_buffer();
@@ -164,9 +233,7 @@ class CompressedStorageBuffer : public StorageBuffer {
   int finalize();
 
   void free_buffer() {
-    if (compress_buffer_) free(compress_buffer_);
-    compress_buffer_ = NULL;
-    compress_buffer_size_ = 0;
+    free_compress_buffer();
     StorageBuffer::free_buffer();
   }
 
@@ -179,7 +246,36 @@ class CompressedStorageBuffer : public StorageBuffer {
   std::shared_ptr<StorageBuffer> compressed_write_buffer_ = 0;
   size_t compressed_write_buffer_size_ = 0;
 
+  int num_threads_ = 1; // use TILEDB_COMPRESSION_THREADS if needed
+
+  void free_compress_buffer() {
+    if (compress_buffer_) free(compress_buffer_);
+    compress_buffer_ = NULL;
+    compress_buffer_size_ = 0;
+  }
+
   int initialize_gzip_stream(z_stream *strm);
   int gzip_read_buffer();
+  int gzip_parallel_read_buffer();
   int gzip_write_buffer();
+  int zstd_read_buffer();
+  int zstd_decompress_buffer();
+  int zstd_write_buffer();
+
+  /**
+   * Reads the entire compressed file into compress_buffer_.
+   */
+  int read_compressed_file();
+
+  /**
+   * Compresses buffer_ as independent blocks into compress_buffer_ using compress_fn on upto num_threads_ threads.
+   * @param processed Set to the number of compressed bytes in compress_buffer_.
+   */
+  int compress_blocks(size_t& processed,
+                      const std::function<int(const unsigned char*, size_t, std::vector<unsigned char>&)>& compress_fn);
+
+  /**
+   * Writes out the processed bytes from compress_buffer_ directly or via compressed_write_buffer_.
+   */
+  int write_compressed_buffer(size_t processed);
 };
@@ -57,8 +57,15 @@
 /*          GLOBAL VARIABLES         */
 /* ********************************* */
 
-/** Stores potential error messages. */
-extern std::string tiledb_fs_errmsg;
+/** Stores potential error messages of the calling thread. */
+extern thread_local std::string tiledb_fs_errmsg;
+
+/** A byte range in a file and the buffer it is read into, see read_from_file_v() */
+typedef struct read_range_t {
+  off_t offset;
+  void *buffer;
+  size_t length;
+} read_range_t;
 
 /** Base Class for Filesystems */
 class StorageFS {
@@ -86,6 +93,13 @@ class StorageFS {
   virtual int read_from_file(const std::string& filename, off_t offset, void *buffer, size_t length) = 0;
   virtual int write_to_file(const std::string& filename, const void *buffer, size_t buffer_size) = 0;
 
+  /**
+   * Reads several ranges of a file into their buffers. Ranges may be in any order.
+   * The default implementation issues a read_from_file() per range, filesystems
+   * override it to batch the ranges into fewer requests.
+   */
+  virtual int read_from_file_v(const std::string& filename, const std::vector<read_range_t>& ranges);
+
   virtual int move_path(const std::string& old_path, const std::string& new_path) = 0;
     
   virtual int sync_path(const std::string& path) = 0;
@@ -176,6 +190,12 @@ class StorageCloudFS : public virtual StorageFS {
 
   int close_file(const std::string& filename);
 
+  /**
+   * Ranges separated by no more than TILEDB_READ_COALESCE_GAP bytes are coalesced
+   * into one request, the bytes in the gaps are read and discarded.
+   */
+  int read_from_file_v(const std::string& filename, const std::vector<read_range_t>& ranges);
+
  protected:
   std::string get_path(const std::string& path);
 
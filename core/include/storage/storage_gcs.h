@@ -90,6 +90,13 @@ class GCS : public StorageCloudFS {
   std::string bucket_name_;
   StatusOr<gcs::Client> client_;
 
+  int num_threads_ = 1; // use TILEDB_NUM_THREADS if needed
+  // Reads longer than parallel_read_threshold_ are split into upto num_threads_ concurrent ranged reads,
+  // overridden with env TILEDB_PARALLEL_READ_THRESHOLD
+  size_t parallel_read_threshold_ = 8*1024*1024;
+
+  std::string read_range(const std::string& path, off_t offset, void *buffer, size_t length);
+
   std::mutex write_map_mtx_;
   typedef struct multipart_upload_info_t {
    public:
@@ -0,0 +1,98 @@
+/**
+ * @file   storage_io_uring.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2026 Omics Data Automation, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Batched asynchronous reads for PosixFS with Linux io_uring
+ */
+
+#ifndef __STORAGE_IO_URING_H__
+#define  __STORAGE_IO_URING_H__
+
+#include "storage_fs.h"
+
+#include <vector>
+
+/**
+ * An io_uring instance used to submit a batch of reads from a file with a single
+ * system call and reap their completions as they arrive. The ring is set up with
+ * raw system calls, so there is no dependency on liburing. An instance is not
+ * thread-safe, concurrent readers should each use their own ring.
+ */
+class IoUring {
+ public:
+  IoUring(unsigned queue_depth);
+  ~IoUring();
+
+  /**
+   * False if io_uring is not supported by the platform or kernel or is not
+   * permitted, e.g. by seccomp policies in containers.
+   */
+  bool is_valid() {
+    return ring_fd_ >= 0;
+  }
+
+  /**
+   * Reads the ranges from the file descriptor into their buffers.
+   *
+   * @return TILEDB_FS_OK on success and TILEDB_FS_ERR on error with errno set. errno
+   *    is 0 if EOF was reached.
+   */
+  int read(int fd, const std::vector<read_range_t>& ranges);
+
+ private:
+  int ring_fd_ = -1;
+
+  // Submission queue ring
+  void *sq_ring_ = NULL;
+  size_t sq_ring_size_ = 0;
+  unsigned *sq_head_ = NULL;
+  unsigned *sq_tail_ = NULL;
+  unsigned *sq_mask_ = NULL;
+  unsigned *sq_array_ = NULL;
+  unsigned sq_entries_ = 0;
+  void *sqes_ = NULL;
+  size_t sqes_size_ = 0;
+
+  // Completion queue ring, may share the mapping with the submission queue ring
+  void *cq_ring_ = NULL;
+  size_t cq_ring_size_ = 0;
+  unsigned *cq_head_ = NULL;
+  unsigned *cq_tail_ = NULL;
+  unsigned *cq_mask_ = NULL;
+  void *cqes_ = NULL;
+
+  void teardown();
+
+  /**
+   * Reaps completions until the given number of submitted requests have
+   * completed, e.g. before giving up on the ring after an error.
+   */
+  void wait_for_completions(unsigned submitted);
+};
+
+#endif /* __STORAGE_IO_URING_H__ */
@@ -43,6 +43,7 @@
 #include "metadata_schema_c.h"
 #include "storage_manager_config.h"
 #include <map>
+#include <memory>
 #ifdef HAVE_OPENMP
   #include <omp.h>
 #endif
@@ -78,8 +79,8 @@
 /*          GLOBAL VARIABLES         */
 /* ********************************* */
 
-/** Stores potential error messages. */
-extern std::string tiledb_sm_errmsg;
+/** Stores potential error messages of the calling thread. */
+extern thread_local std::string tiledb_sm_errmsg;
 
 
 
@@ -601,15 +602,19 @@ class StorageManager {
   int array_delete(const std::string& array) const;
 
   /** 
-   * Gets the names of the existing fragments of an array.
+   * Gets the names of the existing fragments of an array, from its fragment
+   * manifest if it has one or else by listing the array directory.
    *
    * @param array The input array.
    * @param fragment_names The fragment names to be returned.
+   * @param fragment_dense Whether each fragment is dense, returned only if
+   *     the fragment names come from the manifest.
    * @return void
    */
   void array_get_fragment_names(
       const std::string& array,
-      std::vector<std::string>& fragment_names);
+      std::vector<std::string>& fragment_names,
+      std::vector<int>& fragment_dense);
 
   /**
    * Gets an open array entry for the array being initialized. If this
@@ -632,15 +637,25 @@ class StorageManager {
    *
    * @param array_schema The array schema.
    * @param fragment_names The names of the fragments of the array.
+   * @param fragment_dense Whether each fragment is dense, if known. If empty,
+   *     the fragment directories are checked for a coordinates file.
    * @param book_keeping The book-keeping structures to be returned.
+   * @param cached_book_keeping References to the book-keeping structures that are
+   *     shared through the process-wide BookKeepingCache, if it is enabled. The
+   *     structures are then owned by these references instead of book_keeping.
    * @param mode The array mode
+   * @param attribute_ids The ids of the attributes whose tile offsets and sizes
+   *     are loaded, the rest are loaded on demand.
    * @return TILEDB_SM_OK for success, and TILEDB_SM_ERR for error.
    */
   int array_load_book_keeping(
       const ArraySchema* array_schema,
       const std::vector<std::string>& fragment_names,
+      const std::vector<int>& fragment_dense,
       std::vector<BookKeeping*>& book_keeping,
-      int mode);
+      std::vector<std::shared_ptr<BookKeeping>>& cached_book_keeping,
+      int mode,
+      const std::vector<int>& attribute_ids);
 
   /**
    * Moves a TileDB array.
@@ -663,12 +678,15 @@ class StorageManager {
    * @param mode The mode in which the array is being initialized.
    * @param open_array The open array entry that is retrieved.
    * @param mode The array mode.
+   * @param attribute_ids The ids of the attributes whose book-keeping is
+   *     loaded if the array is opened for the first time.
    * @return TILEDB_SM_OK for success and TILEDB_SM_ERR for error.
    */
   int array_open(
       const std::string& array_name, 
       OpenArray*& open_array,
-      int mode);
+      int mode,
+      const std::vector<int>& attribute_ids);
 
   /**
    * Stores the input array schema into the input array directory (serializing
@@ -896,6 +914,11 @@ class StorageManager::OpenArray {
   ArraySchema* array_schema_;
   /** The book-keeping structures for all the fragments of the array. */
   std::vector<BookKeeping*> book_keeping_;
+  /**
+   * Keeps the book-keeping structures shared with the BookKeepingCache alive,
+   * empty if the cache is disabled and book_keeping_ owns the structures.
+   */
+  std::vector<std::shared_ptr<BookKeeping>> cached_book_keeping_;
   /** 
    * A counter for the number of times the array has been initialized after 
    * it was opened.
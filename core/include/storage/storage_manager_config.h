@@ -63,8 +63,8 @@
 /*          GLOBAL VARIABLES         */
 /* ********************************* */
 
-/** Stores potential error messages. */
-extern std::string tiledb_smc_errmsg;
+/** Stores potential error messages of the calling thread. */
+extern thread_local std::string tiledb_smc_errmsg;
 
 /** 
  * This class is responsible for the TileDB storage manager configuration 
@@ -103,6 +103,8 @@ class StorageManagerConfig {
    *          TileDB will use mmap.
    *        - TILEDB_IO_MPI
    *          TileDB will use MPI-IO read. 
+   *        - TILEDB_IO_URING
+   *          TileDB will use io_uring for batched reads. 
    * @param write_method The method for writing data to a file. 
    *     It can be one of the following: 
    *        - TILEDB_IO_WRITE
@@ -131,6 +133,8 @@ class StorageManagerConfig {
    *          TileDB will use mmap.
    *        - TILEDB_IO_MPI
    *          TileDB will use MPI-IO read. 
+   *        - TILEDB_IO_URING
+   *          TileDB will use io_uring for batched reads. 
    * @param write_method The method for writing data to a file. 
    *     It can be one of the following: 
    *        - TILEDB_IO_WRITE
@@ -188,6 +192,8 @@ class StorageManagerConfig {
    *      TileDB will use mmap.
    *    - TILEDB_IO_MPI
    *      TileDB will use MPI-IO read. 
+   *    - TILEDB_IO_URING
+   *      TileDB will use io_uring for batched reads. 
    */
   int read_method_;
   /** 
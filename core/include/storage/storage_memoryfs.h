@@ -0,0 +1,112 @@
+/**
+ * @file   storage_memoryfs.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2026 Omics Data Automation, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * In-memory Support for StorageFS, addressed as mem://<namespace>/<path>
+ */
+
+#ifndef __STORAGE_MEMORYFS_H__
+#define  __STORAGE_MEMORYFS_H__
+
+#include "storage_fs.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * Files and directories are kept in memory for the lifetime of the process. All the
+ * MemoryFS instances created for the same mem://<namespace> share their files, so
+ * arrays written with one TileDB context can be read from another. Files are reference
+ * counted byte vectors, reads copy out of a reference to the file contents while writes
+ * replace the contents of files that are being read.
+ */
+class MemoryFS : public StorageCloudFS {
+ public:
+  MemoryFS(const std::string& home);
+
+  std::string get_path(const std::string& path) {
+    return StorageCloudFS::get_path(path);
+  }
+
+  std::string current_dir();
+  int set_working_dir(const std::string& dir);
+
+  bool is_dir(const std::string& dir);
+  bool is_file(const std::string& file);
+  std::string real_dir(const std::string& dir);
+
+  int create_dir(const std::string& dir);
+  int delete_dir(const std::string& dir);
+
+  std::vector<std::string> get_dirs(const std::string& dir);
+  std::vector<std::string> get_files(const std::string& dir);
+
+  int create_file(const std::string& filename, int flags, mode_t mode);
+  int delete_file(const std::string& filename);
+
+  ssize_t file_size(const std::string& filename);
+
+  int read_from_file(const std::string& filename, off_t offset, void *buffer, size_t length);
+  int write_to_file(const std::string& filename, const void *buffer, size_t buffer_size);
+
+  // No requests to coalesce, every range is copied out of memory
+  int read_from_file_v(const std::string& filename, const std::vector<read_range_t>& ranges) {
+    return StorageFS::read_from_file_v(filename, ranges);
+  }
+
+  int move_path(const std::string& old_path, const std::string& new_path);
+
+  int sync_path(const std::string& path);
+
+  int close_file(const std::string& filename);
+
+  typedef std::shared_ptr<std::vector<char>> file_t;
+  typedef struct memory_store_t {
+    std::mutex mtx_;
+    std::map<std::string, file_t> files_;
+    std::set<std::string> dirs_;
+  } memory_store_t;
+
+ protected:
+  std::string namespace_;
+  std::shared_ptr<memory_store_t> store_;
+
+  bool path_exists(const std::string& path);
+  int create_path(const std::string& path);
+  int commit_file(const std::string& filename);
+
+ private:
+  // Called with store_->mtx_ held
+  bool is_dir_locked(const std::string& path);
+};
+
+#endif /* __STORAGE_MEMORYFS_H__ */
@@ -35,7 +35,11 @@
 #define  __STORAGE_POSIXFS_H__
 
 #include "storage_fs.h"
+#include "storage_io_uring.h"
 
+#include <atomic>
+#include <list>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 
@@ -63,6 +67,12 @@ class PosixFS : public StorageFS {
 
   int read_from_file(const std::string& filename, off_t offset, void *buffer, size_t length);
   int write_to_file(const std::string& filename, const void *buffer, size_t buffer_size);
+
+  /**
+   * Ranges are submitted together to an io_uring if enabled with set_use_io_uring()
+   * and supported, otherwise adjacent ranges are read with a single preadv().
+   */
+  int read_from_file_v(const std::string& filename, const std::vector<read_range_t>& ranges);
   
   int move_path(const std::string& old_path, const std::string& new_path);
     
@@ -80,6 +90,32 @@ class PosixFS : public StorageFS {
 
   bool disable_file_locking();
 
+  /**
+   * Sets the maximum number of read-only file descriptors cached for reuse across
+   * read_from_file() calls. A value of 0 disables caching.
+   */
+  void set_read_file_handles_cache_size(const size_t val);
+
+  size_t read_file_handles_cache_size();
+
+  /**
+   * Use io_uring for read_from_file_v() calls. Falls back to preadv() if io_uring is
+   * not available or a read with the ring fails.
+   */
+  void set_use_io_uring(const bool val);
+
+  bool use_io_uring();
+
+  /** Number of read_from_file() calls served by a cached file descriptor. */
+  size_t read_file_handles_cache_hits() {
+    return read_cache_hits_;
+  }
+
+  /** Number of read_from_file() calls that had to open the file. */
+  size_t read_file_handles_cache_misses() {
+    return read_cache_misses_;
+  }
+
   private:
   std::mutex write_map_mtx_;
   std::unordered_map<std::string, int> write_map_;
@@ -91,6 +127,34 @@ class PosixFS : public StorageFS {
   bool disable_file_locking_ = false;
 
   int write_to_file_keep_file_handles_open(const std::string& filename, const void *buffer, size_t buffer_size);
+
+  // LRU cache of read-only file descriptors keyed by filename. The descriptors are
+  // reference counted, so an evicted or invalidated descriptor is only closed once
+  // the last in-flight read using it is done.
+  typedef std::pair<std::string, std::shared_ptr<int>> read_fd_entry_t;
+  std::mutex read_map_mtx_;
+  std::list<read_fd_entry_t> read_lru_;
+  std::unordered_map<std::string, std::list<read_fd_entry_t>::iterator> read_map_;
+
+  bool read_file_handles_cache_size_set_ = false;
+  size_t read_file_handles_cache_size_ = 32;
+
+  std::atomic<size_t> read_cache_hits_{0};
+  std::atomic<size_t> read_cache_misses_{0};
+
+  // Pool of idle rings. A ring is used by one read_from_file_v() call at a time, so
+  // concurrent readers do not wait on each other. Rings that failed are not returned.
+  bool use_io_uring_ = false;
+  std::mutex io_uring_mtx_;
+  std::vector<std::unique_ptr<IoUring>> io_uring_pool_;
+  bool io_uring_unsupported_ = false;
+
+  std::unique_ptr<IoUring> acquire_io_uring();
+  void release_io_uring(std::unique_ptr<IoUring> io_uring);
+
+  std::shared_ptr<int> get_read_fd(const std::string& filename);
+  void invalidate_read_fds(const std::string& path);
+  void evict_read_fds(size_t max_size);
 };
 
 #endif /* __STORAGE_POSIXFS_H__ */
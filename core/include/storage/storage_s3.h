@@ -36,6 +36,12 @@
 
 #include "storage_fs.h"
 
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
 #include <aws/core/Aws.h>
 #include <aws/s3/S3Client.h>
 #include <aws/core/auth/AWSCredentials.h>
@@ -43,6 +49,7 @@
 #include <aws/core/utils/memory/AWSMemory.h>
 #include <aws/core/utils/stream/PreallocatedStreamBuf.h>
 #include <aws/s3/model/CompleteMultipartUploadRequest.h>
+#include <aws/s3/model/CompletedPart.h>
 
 class S3 : public StorageCloudFS {
 
@@ -82,19 +89,39 @@ class S3 : public StorageCloudFS {
   std::string bucket_name_;
  
   std::shared_ptr<Aws::S3::S3Client> client_;
+
+  // Maximum number of parts per file that can be uploading at any given time, overridden with env
+  // TILEDB_MAX_INFLIGHT_UPLOADS. Every inflight part holds a copy of its buffer until the upload completes.
+  size_t max_inflight_uploads_ = 4;
+
+  int num_threads_ = 1; // use TILEDB_NUM_THREADS if needed
+  // Reads longer than parallel_read_threshold_ are split into upto num_threads_ concurrent ranged GETs,
+  // overridden with env TILEDB_PARALLEL_READ_THRESHOLD
+  size_t parallel_read_threshold_ = 8*1024*1024;
+
+  typedef struct inflight_part_t {
+    size_t part_number_;
+    std::shared_ptr<std::vector<unsigned char>> buffer_;
+    Aws::S3::Model::UploadPartOutcomeCallable outcome_;
+  } inflight_part_t;
+
   std::mutex write_map_mtx_;
   typedef struct multipart_upload_info_t {
    public:
     multipart_upload_info_t(const std::string& upload_id) : upload_id_(upload_id) {
-      completed_parts_ = std::make_shared<Aws::S3::Model::CompletedMultipartUpload>();
     }
+    // Serializes writes and commits to the same file
+    std::mutex mtx_;
     std::string upload_id_;
     size_t part_number_ = 0;
     size_t last_uploaded_size_ = 0;
-    std::shared_ptr<Aws::S3::Model::CompletedMultipartUpload> completed_parts_;
+    std::deque<inflight_part_t> inflight_parts_;
+    Aws::Vector<Aws::S3::Model::CompletedPart> completed_parts_;
     bool abort_upload_ = false;
   } multipart_upload_info_t;
-  std::unordered_map<std::string, multipart_upload_info_t> write_map_;
+  std::unordered_map<std::string, std::shared_ptr<multipart_upload_info_t>> write_map_;
+
+  int wait_for_part(const std::string& filename, multipart_upload_info_t& upload_info);
 
   bool path_exists(const std::string& path);
   int create_path(const std::string& path);
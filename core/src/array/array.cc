@@ -33,10 +33,12 @@
  */
 
 #include "array.h"
+#include "consolidation_plan.h"
 #include "mem_utils.h"
 #include "utils.h"
 #include <algorithm>
 #include <cassert>
+#include <climits>
 #include <cstring>
 #include <iostream>
 #include <memory>
@@ -55,6 +57,9 @@
 #  define PRINT_ERROR(x) do { } while(0) 
 #endif
 
+/** Default bytes of cell position ranges of a consolidation plan kept in memory. */
+#define CONSOLIDATION_PLAN_MEMORY_SIZE (128*1024*1024)
+
 
 
 
@@ -62,7 +67,7 @@
 /*        GLOBAL VARIABLES        */
 /* ****************************** */
 
-std::string tiledb_ar_errmsg = "";
+thread_local std::string tiledb_ar_errmsg = "";
 
 
 /* ****************************** */
@@ -286,19 +291,8 @@ int Array::read(void** buffers, size_t* buffer_sizes, size_t* skip_counts) {
   }
 
   // Check if there are no fragments 
-  int buffer_i = 0;
-  int attribute_id_num = attribute_ids_.size();
-  if(fragments_.size() == 0) {             
-    for(int i=0; i<attribute_id_num; ++i) {
-      // Update all sizes to 0
-      buffer_sizes[buffer_i] = 0; 
-      if(!array_schema_->var_size(attribute_ids_[i])) 
-        ++buffer_i;
-      else 
-        buffer_i += 2;
-    }
-    return TILEDB_AR_OK;
-  }
+  if(fragments_.size() == 0)
+    return read_default(buffers, buffer_sizes, skip_counts);
 
   // Handle sorted modes
   if(mode_ == TILEDB_ARRAY_READ_SORTED_COL ||
@@ -332,6 +326,22 @@ int Array::evaluate_cell(void** buffer, size_t* buffer_sizes, int64_t* positions
 }
 
 int Array::read_default(void** buffers, size_t* buffer_sizes, size_t* skip_counts) {
+  // Check if there are no fragments overlapping the subarray, e.g. when
+  // reading a tile of a sorted read
+  if(fragments_.size() == 0) {
+    int buffer_i = 0;
+    int attribute_id_num = attribute_ids_.size();
+    for(int i=0; i<attribute_id_num; ++i) {
+      // Update all sizes to 0
+      buffer_sizes[buffer_i] = 0; 
+      if(!array_schema_->var_size(attribute_ids_[i])) 
+        ++buffer_i;
+      else 
+        buffer_i += 2;
+    }
+    return TILEDB_AR_OK;
+  }
+
   if(array_read_state_->read(buffers, buffer_sizes, skip_counts) != TILEDB_ARS_OK) {
     tiledb_ar_errmsg = tiledb_ars_errmsg;
     return TILEDB_AR_ERR;
@@ -391,6 +401,22 @@ int Array::consolidate(
   print_memory_stats("beginning consolidation");
 #endif
 
+  // Attributes are consolidated concurrently on upto TILEDB_CONSOLIDATION_THREADS
+  // threads, each with its own buffers. A TILEDB_CONSOLIDATION_MEMORY_BUDGET
+  // bounds the attributes in flight to the ones whose buffers fit in the budget
+  int consolidation_threads = 1;
+  auto env_var = getenv("TILEDB_CONSOLIDATION_THREADS");
+  if(env_var)
+    consolidation_threads = std::max(std::stoi(env_var), 1);
+  env_var = getenv("TILEDB_CONSOLIDATION_MEMORY_BUDGET");
+  if(env_var && consolidation_threads > 1) {
+    size_t memory_budget = std::stoull(env_var);
+    if(memory_budget > 0)
+      consolidation_threads = std::max(
+          std::min(consolidation_threads, (int)std::min<size_t>(memory_budget/(2*buffer_size), INT_MAX)),
+          1);
+  }
+
   // Consolidate on a per-batch and per-attribute basis
   if (batch_size <= 0 || (size_t)batch_size > fragment_names_.size()) {
     batch_size = fragment_names_.size();
@@ -405,8 +431,15 @@ int Array::consolidate(
   void **buffers = (void**) malloc(buffer_num * sizeof(void*));
   size_t *buffer_sizes = (size_t*) malloc(buffer_num * sizeof(size_t));
 
-  void *buffer = malloc(buffer_size);
-  void *buffer_var = malloc(buffer_size);
+  // Attributes consolidated concurrently read with their own read state and
+  // buffers, sparse arrays merge the coordinates of a batch once into a
+  // consolidation plan replayed by every attribute. Plans are also used when
+  // TILEDB_CONSOLIDATION_PLAN_MEMORY_SIZE is set, otherwise attributes are
+  // consolidated one at a time with a single read state
+  bool per_attribute_reads = consolidation_threads > 1 ||
+      (!array_schema_->dense() && getenv("TILEDB_CONSOLIDATION_PLAN_MEMORY_SIZE"));
+  void *buffer = per_attribute_reads ? NULL : malloc(buffer_size);
+  void *buffer_var = per_attribute_reads ? NULL : malloc(buffer_size);
 
   StorageFS* fs = config_->get_filesystem();
 
@@ -447,31 +480,71 @@ int Array::consolidate(
       fragments_.push_back(get_fragment_for_consolidation(fs, last_batch_fragment_name, this));
     }
 
-    array_read_state_ = new ArrayReadState(this);
-
-    // Consolidating per batch per attribute
-    for (auto i=0u,j=0u; i<(size_t)array_schema_->attribute_num()+1; ++i,++j) {
-      buffers[j] = buffer;
-      buffer_sizes[j] = buffer_size;
-      if (array_schema_->var_size(i)) {
-        buffers[j+1] = buffer_var;
-        buffer_sizes[j+1] = buffer_size;
-        j++;
+    if (per_attribute_reads) {
+      ConsolidationPlan* consolidation_plan = NULL;
+      if (!array_schema_->dense()) {
+        consolidation_plan = compute_consolidation_plan();
+        if (consolidation_plan == NULL) {
+          delete_dir(fs, new_fragment->fragment_name());
+          delete new_fragment;
+          return TILEDB_AR_ERR;
+        }
       }
-      if(consolidate(new_fragment, i, buffers, buffer_sizes, buffer_size) != TILEDB_AR_OK) {
+
+      // Consolidating per batch, upto consolidation_threads attributes at a time.
+      // Error messages are thread-local, so each attribute keeps its own error
+      // message to be reported once all the attributes are done.
+      std::vector<std::string> errmsgs(attribute_num+1);
+      auto consolidate_attribute = [&](size_t i) {
+        tiledb_ar_errmsg = "";
+        if(consolidate(new_fragment, i, buffer_size, consolidation_plan) != TILEDB_AR_OK) {
+          errmsgs[i] = tiledb_ar_errmsg;
+          if(errmsgs[i].empty())
+            errmsgs[i] = TILEDB_AR_ERRMSG + std::string("Cannot consolidate attribute ") + array_schema_->attribute(i);
+          return TILEDB_AR_ERR;
+        }
+        return TILEDB_AR_OK;
+      };
+      int rc = parallel_for(consolidation_threads, attribute_num+1, consolidate_attribute);
+      delete consolidation_plan;
+      if(rc != TILEDB_UT_OK) {
+        // Report the first attribute that failed to consolidate
+        tiledb_ar_errmsg = *std::find_if(errmsgs.begin(), errmsgs.end(),
+                                         [](const std::string& errmsg) { return !errmsg.empty(); });
         delete_dir(fs, new_fragment->fragment_name());
         delete new_fragment;
         return TILEDB_AR_ERR;
       }
+      trim_memory();
+    } else {
+      array_read_state_ = new ArrayReadState(this);
+
+      // Consolidating per batch per attribute
+      for (auto i=0u,j=0u; i<(size_t)array_schema_->attribute_num()+1; ++i,++j) {
+        buffers[j] = buffer;
+        buffer_sizes[j] = buffer_size;
+        if (array_schema_->var_size(i)) {
+          buffers[j+1] = buffer_var;
+          buffer_sizes[j+1] = buffer_size;
+          j++;
+        }
+        if(consolidate(new_fragment, i, buffers, buffer_sizes, buffer_size) != TILEDB_AR_OK) {
+          delete_dir(fs, new_fragment->fragment_name());
+          delete new_fragment;
+          return TILEDB_AR_ERR;
+        }
 #ifdef DO_MEMORY_PROFILING
-      print_memory_stats("End: consolidating attribute " + array_schema_->attribute(i));
+        print_memory_stats("End: consolidating attribute " + array_schema_->attribute(i));
 #endif
-      trim_memory();
+        trim_memory();
+      }
     }
 
     // Cleanup after batch consolidation
-    delete array_read_state_;
-    array_read_state_ = NULL;
+    if (array_read_state_ != NULL) {
+      delete array_read_state_;
+      array_read_state_ = NULL;
+    }
     for (auto fragment_i = 0u; fragment_i<fragments_.size(); fragment_i++) {
       fragments_[fragment_i]->finalize();
       delete fragments_[fragment_i]->book_keeping();
@@ -585,6 +658,69 @@ int Array::consolidate(
   return TILEDB_AR_OK;
 }
 
+int Array::consolidate(
+    Fragment* new_fragment,
+    int attribute_id,
+    size_t buffer_size,
+    const ConsolidationPlan* consolidation_plan) const {
+  // For easy reference
+  int attribute_num = array_schema_->attribute_num();
+
+  // Do nothing if the array is dense for the coordinates attribute
+  if(array_schema_->dense() && attribute_id == attribute_num)
+    return TILEDB_AR_OK;
+
+  // Open the fragments for the attribute
+  Array* reader = consolidation_reader(attribute_id, consolidation_plan);
+  if(reader == NULL)
+    return TILEDB_AR_ERR;
+
+  // Create the buffers
+  bool var_size = array_schema_->var_size(attribute_id);
+  void* buffers[2] = { malloc(buffer_size), var_size ? malloc(buffer_size) : NULL };
+  size_t buffer_sizes[2];
+
+  // Read and write attribute until there is no overflow
+  int rc_write = TILEDB_FG_OK;
+  int rc_read = TILEDB_AR_OK;
+  do {
+    // Set or reset buffer sizes as they are modified by the reads
+    buffer_sizes[0] = buffer_size;
+    buffer_sizes[1] = var_size ? buffer_size : 0;
+
+    // Read
+    rc_read = reader->read(buffers, buffer_sizes);
+    if(rc_read != TILEDB_AR_OK)
+      break;
+
+    // Write
+    rc_write = new_fragment->write_attribute(
+                   attribute_id,
+                   (const void**) buffers,
+                   (const size_t*) buffer_sizes);
+    if(rc_write != TILEDB_FG_OK)
+      break;
+  } while(reader->overflow(attribute_id));
+
+  // Clean up
+  for(auto fragment : reader->fragments_)
+    fragment->finalize();
+  delete reader;
+  free(buffers[0]);
+  free(buffers[1]);
+
+  // Error
+  if(rc_read != TILEDB_AR_OK)
+    return TILEDB_AR_ERR;
+  if(rc_write != TILEDB_FG_OK) {
+    tiledb_ar_errmsg = tiledb_fg_errmsg;
+    return TILEDB_AR_ERR;
+  }
+
+  // Success
+  return TILEDB_AR_OK;
+}
+
 int Array::finalize() {
   // Initializations
   int rc = TILEDB_FG_OK;
@@ -906,6 +1042,30 @@ int Array::reset_attributes(
     return TILEDB_AR_ERR;
   }
 
+  // The clone of a sorted array reads the cells, it also needs the
+  // coordinates of sparse arrays to sort them
+  if(array_clone_ != NULL) {
+    std::vector<const char*> clone_attributes;
+    for(auto& attribute : attributes_vec)
+      clone_attributes.push_back(attribute.c_str());
+    if(!array_schema_->dense() &&
+       std::find(attributes_vec.begin(), attributes_vec.end(), TILEDB_COORDS) == attributes_vec.end())
+      clone_attributes.push_back(TILEDB_COORDS);
+    if(array_clone_->reset_attributes(clone_attributes.data(), clone_attributes.size()) != TILEDB_AR_OK)
+      return TILEDB_AR_ERR;
+  }
+
+  // Book-keeping is loaded on open only for the attributes opened, load the
+  // newly requested attributes of the fragments being read
+  if(read_mode()) {
+    for(auto fragment : fragments_) {
+      if(fragment->book_keeping()->load_attributes(config_->get_filesystem(), attribute_ids_) != TILEDB_BK_OK) {
+        tiledb_ar_errmsg = tiledb_bk_errmsg;
+        return TILEDB_AR_ERR;
+      }
+    }
+  }
+
   // Reset subarray so that the read/write states are flushed
   if(reset_subarray(subarray_) != TILEDB_AR_OK) 
     return TILEDB_AR_ERR;
@@ -986,9 +1146,10 @@ int Array::reset_subarray(const void* subarray) {
       return TILEDB_AR_ERR;
     }
   } else {           // READ MODE
-    // Re-initialize the read state of the fragments
-    for(int i=0; i<fragment_num; ++i) 
-      fragments_[i]->reset_read_state();
+    // Re-select the fragments overlapping the subarray, resetting their
+    // read state
+    if(select_fragments() != TILEDB_AR_OK)
+      return TILEDB_AR_ERR;
 
     // Re-initialize array read state
     if(array_read_state_ != NULL) {
@@ -1047,9 +1208,10 @@ int Array::reset_subarray_soft(const void* subarray) {
   if(write_mode()) {  // WRITE MODE 
     // Do nothing
   } else {            // READ MODE
-    // Re-initialize the read state of the fragments
-    for(int i=0; i<fragment_num; ++i) 
-      fragments_[i]->reset_read_state();
+    // Re-select the fragments overlapping the subarray, resetting their
+    // read state
+    if(select_fragments() != TILEDB_AR_OK)
+      return TILEDB_AR_ERR;
 
     // Re-initialize array read state
     if(array_read_state_ != NULL) {
@@ -1420,26 +1582,181 @@ std::string Array::new_fragment_name() const {
   return fragment_name;
 }
 
+ConsolidationPlan* Array::compute_consolidation_plan() {
+  // Read rounds beyond TILEDB_CONSOLIDATION_PLAN_MEMORY_SIZE bytes of cell
+  // position ranges are spilled to disk
+  size_t memory_size = CONSOLIDATION_PLAN_MEMORY_SIZE;
+  auto env_var = getenv("TILEDB_CONSOLIDATION_PLAN_MEMORY_SIZE");
+  if(env_var)
+    memory_size = std::stoull(env_var);
+
+  // Merge the fragments of the batch
+  ConsolidationPlan* consolidation_plan = new ConsolidationPlan(memory_size);
+  array_read_state_ = new ArrayReadState(this);
+  int rc = array_read_state_->compute_consolidation_plan(consolidation_plan);
+  delete array_read_state_;
+  array_read_state_ = NULL;
+
+  // Error
+  if(rc != TILEDB_ARS_OK) {
+    tiledb_ar_errmsg = tiledb_ars_errmsg;
+    delete consolidation_plan;
+    return NULL;
+  }
+
+  return consolidation_plan;
+}
+
+Array* Array::consolidation_reader(
+    int attribute_id,
+    const ConsolidationPlan* consolidation_plan) const {
+  // The reader shares the array schema, configuration and book-keeping, which
+  // are not modified by reads
+  Array* reader = new Array();
+  reader->mode_ = mode_;
+  reader->config_ = config_;
+  reader->array_schema_ = array_schema_;
+  reader->array_path_used_ = array_path_used_;
+  reader->attribute_ids_.push_back(attribute_id);
+  size_t subarray_size = 2*array_schema_->coords_size();
+  reader->subarray_ = malloc(subarray_size);
+  memcpy(reader->subarray_, subarray_, subarray_size);
+
+  // Open the fragments with read states of their own
+  for(auto fragment : fragments_) {
+    Fragment* reader_fragment = new Fragment(reader);
+    reader->fragments_.push_back(reader_fragment);
+    if(reader_fragment->init(
+           fragment->fragment_name(),
+           fragment->book_keeping(),
+           TILEDB_ARRAY_READ) != TILEDB_FG_OK) {
+      tiledb_ar_errmsg = tiledb_fg_errmsg;
+      delete reader;
+      return NULL;
+    }
+  }
+  reader->array_read_state_ = new ArrayReadState(reader, consolidation_plan);
+
+  return reader;
+}
+
 int Array::open_fragments(
     const std::vector<std::string>& fragment_names,
     const std::vector<BookKeeping*>& book_keeping) {
   // Sanity check
   assert(fragment_names.size() == book_keeping.size());
 
-  // Create a fragment object for each fragment directory
-  int fragment_num = fragment_names.size();
+  fragment_names_ = fragment_names;
+  book_keeping_ = book_keeping;
+
+  return select_fragments();
+}
+
+int Array::select_fragments() {
+  // Find the fragments overlapping the subarray
+  int fragment_num = book_keeping_.size();
+  std::vector<bool> overlaps(fragment_num);
+  int coords_type = array_schema_->coords_type();
+  bool any_overlaps = false;
   for(int i=0; i<fragment_num; ++i) {
-    Fragment* fragment = new Fragment(this);
-    fragments_.push_back(fragment);
+    if(coords_type == TILEDB_INT32)
+      overlaps[i] = fragment_overlaps_subarray<int>(book_keeping_[i]);
+    else if(coords_type == TILEDB_INT64)
+      overlaps[i] = fragment_overlaps_subarray<int64_t>(book_keeping_[i]);
+    else if(coords_type == TILEDB_FLOAT32)
+      overlaps[i] = fragment_overlaps_subarray<float>(book_keeping_[i]);
+    else if(coords_type == TILEDB_FLOAT64)
+      overlaps[i] = fragment_overlaps_subarray<double>(book_keeping_[i]);
+    else
+      overlaps[i] = true;
+    any_overlaps |= overlaps[i];
+  }
+
+  // Dense reads fill the subarray with empty cells as long as there is a
+  // fragment, so keep the latest one open
+  if(array_schema_->dense() && !any_overlaps && fragment_num > 0)
+    overlaps[fragment_num-1] = true;
+
+  // Fragments already open are in the same order as their book-keeping
+  std::vector<Fragment*> fragments;
+  int opened_i = 0;
+  int opened_num = fragments_.size();
+  int rc = TILEDB_AR_OK;
+  for(int i=0; i<fragment_num; ++i) {
+    Fragment* fragment = NULL;
+    if(opened_i < opened_num && fragments_[opened_i]->book_keeping() == book_keeping_[i])
+      fragment = fragments_[opened_i++];
+
+    if(!overlaps[i]) {
+      if(fragment != NULL) {
+        fragment->finalize();
+        delete fragment;
+      }
+      continue;
+    }
+
+    // Book-keeping shared with other arrays may not have loaded the
+    // attributes of this array yet
+    if(book_keeping_[i]->load_attributes(config_->get_filesystem(), attribute_ids_) != TILEDB_BK_OK) {
+      tiledb_ar_errmsg = tiledb_bk_errmsg;
+      rc = TILEDB_AR_ERR;
+      if(fragment != NULL)
+        fragments.push_back(fragment);
+      break;
+    }
+
+    if(fragment != NULL) {
+      fragment->reset_read_state();
+      fragments.push_back(fragment);
+      continue;
+    }
 
-    if(fragment->init(fragment_names[i], book_keeping[i], mode()) != TILEDB_FG_OK) {
+    fragment = new Fragment(this);
+    fragments.push_back(fragment);
+    if(fragment->init(fragment_names_[i], book_keeping_[i], mode()) != TILEDB_FG_OK) {
       tiledb_ar_errmsg = tiledb_fg_errmsg;
-      return TILEDB_AR_ERR;
+      rc = TILEDB_AR_ERR;
+      break;
     }
-  } 
+  }
 
-  // Success
-  return TILEDB_AR_OK;
+  // Keep the fragments not visited on error, so they are finalized with the array
+  for(; opened_i<opened_num; ++opened_i)
+    fragments.push_back(fragments_[opened_i]);
+  fragments_ = fragments;
+
+  return rc;
+}
+
+template<class T>
+bool Array::fragment_overlaps_subarray(const BookKeeping* book_keeping) const {
+  const T* non_empty_domain = static_cast<const T*>(book_keeping->non_empty_domain());
+  if(non_empty_domain == NULL)
+    return true;
+
+  const T* subarray = static_cast<const T*>(subarray_);
+  int dim_num = array_schema_->dim_num();
+  for(int i=0; i<dim_num; ++i) {
+    if(non_empty_domain[2*i] > subarray[2*i+1] ||
+       non_empty_domain[2*i+1] < subarray[2*i])
+      return false;
+  }
+
+  // Sparse fragments written without a subarray have the array domain as
+  // their non-empty domain, the bounding box of their MBRs is tighter. The
+  // R-tree over the MBRs is left to be built by the reads that need it.
+  if(!book_keeping->dense()) {
+    const T* mbrs_bounds = static_cast<const T*>(book_keeping->mbrs_bounds());
+    if(mbrs_bounds == NULL)
+      return true;
+    for(int i=0; i<dim_num; ++i) {
+      if(mbrs_bounds[2*i] > subarray[2*i+1] ||
+         mbrs_bounds[2*i+1] < subarray[2*i])
+        return false;
+    }
+  }
+
+  return true;
 }
 
 void Array::free_array_schema()
@@ -54,7 +54,7 @@
 /*        GLOBAL VARIABLES        */
 /* ****************************** */
 
-std::string tiledb_ait_errmsg = "";
+thread_local std::string tiledb_ait_errmsg = "";
 
 
 
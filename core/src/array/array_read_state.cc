@@ -31,9 +31,13 @@
  */
 
 #include "array_read_state.h"
+#include "consolidation_plan.h"
 #include "utils.h"
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <deque>
+#include <numeric>
 
 
 
@@ -48,6 +52,15 @@
 #  define PRINT_ERROR(x) do { } while(0) 
 #endif
 
+/** Default number of attributes read concurrently. */
+#define READ_THREADS 1
+/** Default number of fragments searched concurrently for their cell ranges. */
+#define FRAGMENT_THREADS 1
+/** Number of cell ranges per chunk of the cell range arena. */
+#define CELL_RANGE_ARENA_CHUNK 4096
+/** Default minimum number of fragments merged with a tournament tree. */
+#define MERGE_TREE_MIN_FRAGMENTS 16
+
 
 
 
@@ -55,7 +68,7 @@
 /*        GLOBAL VARIABLES        */
 /* ****************************** */
 
-std::string tiledb_ars_errmsg = "";
+thread_local std::string tiledb_ars_errmsg = "";
 
 
 
@@ -65,19 +78,25 @@ std::string tiledb_ars_errmsg = "";
 /* ****************************** */
 
 ArrayReadState::ArrayReadState(
-    const Array* array)
-    : array_(array) {
+    const Array* array,
+    const ConsolidationPlan* consolidation_plan)
+    : array_(array), consolidation_plan_(consolidation_plan) {
   // For easy reference
   array_schema_ = array_->array_schema();
   attribute_num_ = array_schema_->attribute_num();
   coords_size_ = array_schema_->coords_size();
 
   // Initializations
+  cell_range_arena_ = new CellRangeArena(2*coords_size_);
+  consolidation_plan_round_ = 0;
   done_ = false;
   empty_cells_written_.resize(attribute_num_+1);
   fragment_cell_pos_ranges_vec_pos_.resize(attribute_num_+1);
   min_bounding_coords_end_ = NULL;
-  read_round_done_.resize(attribute_num_);
+  // No overflow until the first read, which may not happen when no
+  // fragments overlap the subarray
+  overflow_.resize(attribute_num_+1, false);
+  read_round_done_.resize(attribute_num_+1);
   subarray_tile_coords_ = NULL;
   subarray_tile_domain_ = NULL;
 
@@ -93,9 +112,39 @@ ArrayReadState::ArrayReadState(
   fragment_read_states_.resize(fragment_num_);
   for(int i=0; i<fragment_num_; ++i)
     fragment_read_states_[i] = fragments[i]->read_state(); 
+
+  // Attributes are read concurrently on upto TILEDB_READ_THREADS threads,
+  // except with TILEDB_IO_MPI as MPI-IO reads are collective
+  read_threads_ = READ_THREADS;
+  auto env_var = getenv("TILEDB_READ_THREADS");
+  if(env_var)
+    read_threads_ = std::max(std::stoi(env_var), 1);
+  if(array_->attribute_ids().size() < 2 ||
+     array_->config()->read_method() == TILEDB_IO_MPI)
+    read_threads_ = 1;
+  if(read_threads_ > 1)
+    read_thread_pool_.reset(new ThreadPool(read_threads_));
+
+  // The cell ranges of sparse fragments are computed concurrently on upto
+  // TILEDB_FRAGMENT_THREADS threads, each fragment has its own read state
+  fragment_threads_ = FRAGMENT_THREADS;
+  env_var = getenv("TILEDB_FRAGMENT_THREADS");
+  if(env_var)
+    fragment_threads_ = std::max(std::stoi(env_var), 1);
+  if(array_->config()->read_method() == TILEDB_IO_MPI)
+    fragment_threads_ = 1;
+  if(fragment_threads_ > 1 && fragment_num_ > 1 && !array_schema_->dense())
+    fragment_thread_pool_.reset(new ThreadPool(fragment_threads_));
+
+  merge_tree_min_fragments_ = MERGE_TREE_MIN_FRAGMENTS;
+  env_var = getenv("TILEDB_MERGE_TREE_MIN_FRAGMENTS");
+  if(env_var)
+    merge_tree_min_fragments_ = std::stoi(env_var);
 }
 
 ArrayReadState::~ArrayReadState() { 
+  delete cell_range_arena_;
+
   if(min_bounding_coords_end_ != NULL)
     free(min_bounding_coords_end_);
 
@@ -165,6 +214,38 @@ int ArrayReadState::read(
 
 
 
+/* ****************************** */
+/*            MUTATORS            */
+/* ****************************** */
+
+int ArrayReadState::compute_consolidation_plan(
+    ConsolidationPlan* consolidation_plan) {
+  // For easy reference
+  int coords_type = array_schema_->coords_type();
+
+  // Sanity check
+  assert(!array_schema_->dense());
+
+  // Invoke the proper templated function
+  if(coords_type == TILEDB_INT32) {
+    return compute_consolidation_plan<int>(consolidation_plan);
+  } else if(coords_type == TILEDB_INT64) {
+    return compute_consolidation_plan<int64_t>(consolidation_plan);
+  } else if(coords_type == TILEDB_FLOAT32) {
+    return compute_consolidation_plan<float>(consolidation_plan);
+  } else if(coords_type == TILEDB_FLOAT64) {
+    return compute_consolidation_plan<double>(consolidation_plan);
+  } else {
+    std::string errmsg = "Cannot compute consolidation plan; Invalid coordinates type";
+    PRINT_ERROR(errmsg);
+    tiledb_ars_errmsg = TILEDB_ARS_ERRMSG + errmsg;
+    return TILEDB_ARS_ERR;
+  }
+}
+
+
+
+
 /* ****************************** */
 /*         PRIVATE METHODS        */
 /* ****************************** */
@@ -173,7 +254,7 @@ void ArrayReadState::clean_up_processed_fragment_cell_pos_ranges() {
   // Find the minimum overlapping tile position across all attributes
   const std::vector<int>& attribute_ids = array_->attribute_ids();
   int attribute_id_num = attribute_ids.size(); 
-  int64_t min_pos = fragment_cell_pos_ranges_vec_pos_[0];
+  int64_t min_pos = fragment_cell_pos_ranges_vec_pos_[attribute_ids[0]];
   for(int i=1; i<attribute_id_num; ++i) 
     if(fragment_cell_pos_ranges_vec_pos_[attribute_ids[i]] < min_pos) 
       min_pos = fragment_cell_pos_ranges_vec_pos_[attribute_ids[i]];
@@ -195,6 +276,32 @@ void ArrayReadState::clean_up_processed_fragment_cell_pos_ranges() {
   }
 }
 
+template<class T>
+int ArrayReadState::compute_consolidation_plan(
+    ConsolidationPlan* consolidation_plan) {
+  // Move every read round to the plan as soon as it is computed
+  while(!done_) {
+    if(get_next_fragment_cell_ranges_sparse<T>() != TILEDB_ARS_OK)
+      return TILEDB_ARS_ERR;
+    if(fragment_cell_pos_ranges_vec_.empty())
+      continue;
+    FragmentCellPosRanges* fragment_cell_pos_ranges =
+        fragment_cell_pos_ranges_vec_.back();
+    fragment_cell_pos_ranges_vec_.pop_back();
+    if(fragment_cell_pos_ranges->empty()) {
+      delete fragment_cell_pos_ranges;
+      continue;
+    }
+    if(consolidation_plan->append(fragment_cell_pos_ranges) != TILEDB_CP_OK) {
+      tiledb_ars_errmsg = tiledb_cp_errmsg;
+      return TILEDB_ARS_ERR;
+    }
+  }
+
+  // Success
+  return TILEDB_ARS_OK;
+}
+
 template<class T>
 int ArrayReadState::compute_fragment_cell_pos_ranges(
     FragmentCellRanges& fragment_cell_ranges,
@@ -228,8 +335,6 @@ int ArrayReadState::compute_fragment_cell_pos_ranges(
                 static_cast<T*>(fragment_cell_ranges[i].second),
                 fragment_cell_pos_range) != TILEDB_RS_OK) {
         // Error
-        for(int j=i; j<fragment_cell_ranges_num; ++j) 
-          free(fragment_cell_ranges[j].second);
         fragment_cell_ranges.clear();
         fragment_cell_pos_ranges.clear();
         tiledb_ars_errmsg = tiledb_rs_errmsg;
@@ -239,12 +344,9 @@ int ArrayReadState::compute_fragment_cell_pos_ranges(
       if(fragment_cell_pos_range.second.first != -1)
         fragment_cell_pos_ranges.push_back(fragment_cell_pos_range);
     }
-    
-    // Clean up corresponding input cell range
-    free(fragment_cell_ranges[i].second);
   }
 
-  // Clean up
+  // Clean up, the cell ranges are held by the cell range arena
   fragment_cell_ranges.clear();  
 
   // Success
@@ -357,53 +459,68 @@ int ArrayReadState::compute_unsorted_fragment_cell_ranges_sparse(
   int dim_num = array_schema_->dim_num();
   T* min_bounding_coords_end = static_cast<T*>(min_bounding_coords_end_);
 
-  // Compute the relevant fragment cell ranges
-  for(int i=0; i<fragment_num_; ++i) {
+  // Compute the relevant fragment cell ranges, each fragment independently.
+  // Error messages are thread-local, so each fragment keeps its own error
+  // message to be reported once all the fragments are done
+  unsorted_fragment_cell_ranges.resize(fragment_num_);
+  std::vector<std::string> errmsgs(fragment_num_);
+  auto fragment_error = [&](size_t i) {
+    errmsgs[i] = tiledb_rs_errmsg.empty() ?
+        TILEDB_RS_ERRMSG + std::string("Cannot compute cell ranges of fragment ") + std::to_string(i) :
+        tiledb_rs_errmsg;
+    return TILEDB_ARS_ERR;
+  };
+  auto compute_fragment_cell_ranges = [&](size_t i) {
+    tiledb_rs_errmsg = "";
     T* fragment_bounding_coords = static_cast<T*>(fragment_bounding_coords_[i]);
 
-    // Compute new fragment cell ranges
-    if(fragment_bounding_coords != NULL &&
+    // Leave an empty list for fragments past the smallest end bounding coords
+    if(fragment_bounding_coords == NULL ||
        array_schema_->tile_cell_order_cmp(
              fragment_bounding_coords,
-             min_bounding_coords_end) <= 0) {
-      FragmentCellRanges fragment_cell_ranges;
-      if(fragment_read_states_[i]->get_fragment_cell_ranges_sparse<T>(
-          i,
-          fragment_bounding_coords,
-          min_bounding_coords_end,
-          fragment_cell_ranges) != TILEDB_RS_OK) {
-        tiledb_ars_errmsg = tiledb_rs_errmsg;
-        return TILEDB_ARS_ERR;
-      }
-
-      //This might be empty if no cells found in fragment for the query subarray
-      //MBR overlap does not guarantee existence of cells in the subarray
-      unsorted_fragment_cell_ranges.push_back(fragment_cell_ranges);
+             min_bounding_coords_end) > 0)
+      return TILEDB_ARS_OK;
 
-      // If the end bounding coordinate is not the same as the smallest one, 
-      // update the start bounding coordinate to exceed the smallest
-      // end bounding coordinates
-      if(memcmp(
-             &fragment_bounding_coords[dim_num], 
+    // Compute new fragment cell ranges
+    //This might be empty if no cells found in fragment for the query subarray
+    //MBR overlap does not guarantee existence of cells in the subarray
+    if(fragment_read_states_[i]->get_fragment_cell_ranges_sparse<T>(
+        i,
+        fragment_bounding_coords,
+        min_bounding_coords_end,
+        unsorted_fragment_cell_ranges[i]) != TILEDB_RS_OK)
+      return fragment_error(i);
+
+    // If the end bounding coordinate is not the same as the smallest one, 
+    // update the start bounding coordinate to exceed the smallest
+    // end bounding coordinates
+    if(memcmp(
+           &fragment_bounding_coords[dim_num], 
+           min_bounding_coords_end, 
+           coords_size_)) {
+      // Get the first coordinates AFTER the min bounding coords end 
+      bool coords_retrieved;
+      if(fragment_read_states_[i]->get_coords_after<T>(
              min_bounding_coords_end, 
-             coords_size_)) {
-        // Get the first coordinates AFTER the min bounding coords end 
-        bool coords_retrieved;
-        if(fragment_read_states_[i]->get_coords_after<T>(
-               min_bounding_coords_end, 
-               fragment_bounding_coords,
-               coords_retrieved) != TILEDB_RS_OK) {  
-          tiledb_ars_errmsg = tiledb_rs_errmsg;
-          return TILEDB_ARS_ERR;
-        }
+             fragment_bounding_coords,
+             coords_retrieved) != TILEDB_RS_OK)
+        return fragment_error(i);
 
-        // Sanity check for the sparse case
-        assert(coords_retrieved);
-      } 
-    } else {
-      // Append an empty list
-      unsorted_fragment_cell_ranges.push_back(FragmentCellRanges());
-    }
+      // Sanity check for the sparse case
+      assert(coords_retrieved);
+    } 
+
+    return TILEDB_ARS_OK;
+  };
+  int rc = fragment_thread_pool_ ?
+      fragment_thread_pool_->parallel_for(fragment_num_, compute_fragment_cell_ranges) :
+      parallel_for(1, fragment_num_, compute_fragment_cell_ranges);
+  if(rc != TILEDB_UT_OK) {
+    // Report the first fragment that failed
+    tiledb_rs_errmsg = *std::find_if(errmsgs.begin(), errmsgs.end(),
+                                     [](const std::string& errmsg) { return !errmsg.empty(); });
+    tiledb_ars_errmsg = tiledb_rs_errmsg;
+    return TILEDB_ARS_ERR;
   }
 
   // Success
@@ -975,6 +1092,33 @@ ArrayReadState::empty_fragment_cell_ranges() const {
   return fragment_cell_ranges;
 }
 
+int ArrayReadState::get_next_fragment_cell_ranges() {
+  // For easy reference
+  int coords_type = array_schema_->coords_type();
+
+  // Invoke the proper templated function
+  if(array_schema_->dense()) {
+    if(coords_type == TILEDB_INT32)
+      return get_next_fragment_cell_ranges_dense<int>();
+    else if(coords_type == TILEDB_INT64)
+      return get_next_fragment_cell_ranges_dense<int64_t>();
+  } else {
+    if(coords_type == TILEDB_INT32)
+      return get_next_fragment_cell_ranges_sparse<int>();
+    else if(coords_type == TILEDB_INT64)
+      return get_next_fragment_cell_ranges_sparse<int64_t>();
+    else if(coords_type == TILEDB_FLOAT32)
+      return get_next_fragment_cell_ranges_sparse<float>();
+    else if(coords_type == TILEDB_FLOAT64)
+      return get_next_fragment_cell_ranges_sparse<double>();
+  }
+
+  std::string errmsg = "Cannot read from array; Invalid coordinates type";
+  PRINT_ERROR(errmsg);
+  tiledb_ars_errmsg = TILEDB_ARS_ERRMSG + errmsg;
+  return TILEDB_ARS_ERR;
+}
+
 template<class T>
 int ArrayReadState::get_next_fragment_cell_ranges_dense() {
   // Trivial case
@@ -1019,12 +1163,48 @@ int ArrayReadState::get_next_fragment_cell_ranges_dense() {
 }
 
 
+int ArrayReadState::get_next_fragment_cell_ranges_plan() {
+  // Trivial case
+  if(done_)
+    return TILEDB_ARS_OK;
+
+  // Return if there are no more read rounds
+  if(consolidation_plan_round_ == consolidation_plan_->round_num()) {
+    done_ = true;
+    return TILEDB_ARS_OK;
+  }
+
+  // Get the fragment cell position ranges of the read round
+  FragmentCellPosRanges* fragment_cell_pos_ranges = new FragmentCellPosRanges();
+  if(consolidation_plan_->get(
+         consolidation_plan_round_,
+         *fragment_cell_pos_ranges) != TILEDB_CP_OK) {
+    delete fragment_cell_pos_ranges;
+    tiledb_ars_errmsg = tiledb_cp_errmsg;
+    return TILEDB_ARS_ERR;
+  }
+  ++consolidation_plan_round_;
+
+  // Insert cell pos ranges in the state
+  fragment_cell_pos_ranges_vec_.push_back(fragment_cell_pos_ranges);
+
+  // Clean up processed overlapping tiles
+  clean_up_processed_fragment_cell_pos_ranges();
+
+  // Success
+  return TILEDB_ARS_OK;
+}
+
 template<class T>
 int ArrayReadState::get_next_fragment_cell_ranges_sparse() {
   // Trivial case
   if(done_)
     return TILEDB_ARS_OK;
 
+  // Replay the read rounds of the consolidation plan
+  if(consolidation_plan_ != NULL)
+    return get_next_fragment_cell_ranges_plan();
+
   // Gets the next overlapping tiles in the fragment read states
   get_next_overlapping_tiles_sparse<T>();
 
@@ -1276,9 +1456,118 @@ void ArrayReadState::get_next_subarray_tile_coords() {
   } 
 }
 
+int ArrayReadState::read_concurrently(
+    void** buffers,
+    size_t* buffer_sizes,
+    size_t* skip_counts) {
+  // For easy reference
+  const std::vector<int>& attribute_ids = array_->attribute_ids();
+  int attribute_id_num = attribute_ids.size();
+
+  // Find the buffers of each attribute
+  std::vector<int> buffer_ids(attribute_id_num);
+  int buffer_num = 0;
+  for(int i=0; i<attribute_id_num; ++i) {
+    buffer_ids[i] = buffer_num;
+    buffer_num += array_schema_->var_size(attribute_ids[i]) ? 2 : 1;
+  }
+  std::vector<size_t> buffer_offsets(buffer_num, 0);
+  std::vector<size_t> zero_skip_counts(buffer_num, 0);
+  if(skip_counts == NULL)
+    skip_counts = zero_skip_counts.data();
+
+  // Attributes still reading, i.e., without an overflow
+  std::vector<int> pending(attribute_id_num);
+  std::iota(pending.begin(), pending.end(), 0);
+
+  // Error messages are thread-local, so each attribute keeps its own error
+  // message to be reported once all the attributes of the round are done
+  std::vector<std::string> errmsgs(attribute_id_num);
+
+  // Copies the computed read rounds for an attribute
+  auto copy_read_rounds = [&](size_t i) {
+    int attribute_id = attribute_ids[pending[i]];
+    int buffer_i = buffer_ids[pending[i]];
+    tiledb_ars_errmsg = "";
+    while(!read_round_done_[attribute_id] ||
+          fragment_cell_pos_ranges_vec_pos_[attribute_id] <
+          int64_t(fragment_cell_pos_ranges_vec_.size())) {
+      int rc;
+      if(!array_schema_->var_size(attribute_id)) // FIXED CELLS
+        rc = copy_cells(
+                 attribute_id,
+                 buffers[buffer_i],
+                 buffer_sizes[buffer_i],
+                 buffer_offsets[buffer_i],
+                 skip_counts[buffer_i]);
+      else                                       // VARIABLE-SIZED CELLS
+        rc = copy_cells_var(
+                 attribute_id,
+                 buffers[buffer_i],       // offsets
+                 buffer_sizes[buffer_i],
+                 buffer_offsets[buffer_i],
+                 skip_counts[buffer_i],
+                 buffers[buffer_i+1],     // actual values
+                 buffer_sizes[buffer_i+1],
+                 buffer_offsets[buffer_i+1],
+                 skip_counts[buffer_i+1]);
+      if(rc != TILEDB_ARS_OK) {
+        errmsgs[pending[i]] = tiledb_ars_errmsg;
+        if(errmsgs[pending[i]].empty())
+          errmsgs[pending[i]] = TILEDB_ARS_ERRMSG + std::string("Cannot read attribute ") +
+              array_schema_->attribute(attribute_id);
+        return TILEDB_ARS_ERR;
+      }
+
+      // Check for buffer overflow
+      if(overflow_[attribute_id])
+        break;
+    }
+    return TILEDB_ARS_OK;
+  };
+
+  // Until read is done or all attributes overflow
+  for(;;) {
+    // Tiles gathered lazily are located before the attributes share the fragments
+    for(auto fragment_read_state : fragment_read_states_)
+      fragment_read_state->prepare_gathered_reads();
+
+    if(read_thread_pool_->parallel_for(pending.size(), copy_read_rounds) !=
+       TILEDB_UT_OK) {
+      // Report the first attribute that failed
+      tiledb_ars_errmsg = *std::find_if(errmsgs.begin(), errmsgs.end(),
+                                        [](const std::string& errmsg) { return !errmsg.empty(); });
+      return TILEDB_ARS_ERR;
+    }
+
+    pending.erase(
+        std::remove_if(
+            pending.begin(),
+            pending.end(),
+            [&](int i) { return overflow_[attribute_ids[i]]; }),
+        pending.end());
+    if(pending.empty() || done_)
+      break;
+
+    // Prepare the cell ranges for the next read round
+    if(get_next_fragment_cell_ranges() != TILEDB_ARS_OK)
+      return TILEDB_ARS_ERR;
+  }
+
+  for(int i=0; i<buffer_num; ++i)
+    buffer_sizes[i] = buffer_offsets[i];
+
+  // Success
+  return TILEDB_ARS_OK;
+}
+
 int ArrayReadState::read_dense(
     void** buffers,  
     size_t* buffer_sizes) {
+  // Read the attributes concurrently
+  if(read_threads_ > 1)
+    return read_concurrently(buffers, buffer_sizes, NULL);
+
   // For easy reference
   std::vector<int> attribute_ids = array_->attribute_ids();
   int attribute_id_num = attribute_ids.size(); 
@@ -1497,6 +1786,10 @@ int ArrayReadState::read_sparse(
     void** buffers,  
     size_t* buffer_sizes,
     size_t* skip_counts) {
+  // Read the attributes concurrently
+  if(read_threads_ > 1)
+    return read_concurrently(buffers, buffer_sizes, skip_counts);
+
   // For easy reference
   std::vector<int> attribute_ids = array_->attribute_ids();
   int attribute_id_num = attribute_ids.size(); 
@@ -1803,10 +2096,16 @@ int ArrayReadState::read_sparse_attr_var(
 template<class T>
 int ArrayReadState::sort_fragment_cell_ranges(
     std::vector<FragmentCellRanges>& unsorted_fragment_cell_ranges,
-    FragmentCellRanges& fragment_cell_ranges) const {
+    FragmentCellRanges& fragment_cell_ranges) {
   // For easy reference
   int fragment_num = (int) unsorted_fragment_cell_ranges.size();
 
+  // Release the cell ranges of the previous read run and hold the new ones
+  cell_range_arena_->reset();
+  for(const auto& ranges : unsorted_fragment_cell_ranges)
+    for(const auto& range : ranges)
+      cell_range_arena_->adopt(range.second);
+
   // Calculate the number of non-empty unsorted fragment range lists
   int non_empty = 0;
   int first_non_empty = -1;
@@ -1828,7 +2127,33 @@ int ArrayReadState::sort_fragment_cell_ranges(
     return TILEDB_ARS_OK;
   }
 
+  // Merge with a tournament tree if many fragments have ranges, as it takes
+  // fewer comparisons than the heap for many fragments
+  if(non_empty >= merge_tree_min_fragments_) {
+    PQFragmentCellRangeTree<T> pq(array_schema_, non_empty);
+    return merge_fragment_cell_ranges<T>(
+               pq,
+               unsorted_fragment_cell_ranges,
+               fragment_cell_ranges);
+  }
+
+  std::priority_queue<
+      PQFragmentCellRange<T>*,
+      std::vector<PQFragmentCellRange<T>* >,
+      SmallerPQFragmentCellRange<T> > pq(array_schema_);
+  return merge_fragment_cell_ranges<T>(
+             pq,
+             unsorted_fragment_cell_ranges,
+             fragment_cell_ranges);
+}
+
+template<class T, class PQ>
+int ArrayReadState::merge_fragment_cell_ranges(
+    PQ& pq,
+    std::vector<FragmentCellRanges>& unsorted_fragment_cell_ranges,
+    FragmentCellRanges& fragment_cell_ranges) {
   // For easy reference
+  int fragment_num = (int) unsorted_fragment_cell_ranges.size();
   int dim_num = array_schema_->dim_num();
   const T* domain = static_cast<const T*>(array_schema_->domain());
   const T* tile_extents = static_cast<const T*>(array_schema_->tile_extents());
@@ -1855,6 +2180,25 @@ int ArrayReadState::sort_fragment_cell_ranges(
     rid[i] = 0;
   }
 
+  // Nodes of the queue are recycled, as there are at most a few per fragment
+  std::deque<PQFragmentCellRange<T> > nodes;
+  std::vector<PQFragmentCellRange<T>*> free_nodes;
+  auto new_node = [&]() {
+    if(free_nodes.empty()) {
+      nodes.emplace_back(
+          array_schema_,
+          &fragment_read_states_,
+          cell_range_arena_);
+      return &nodes.back();
+    }
+    PQFragmentCellRange<T>* node = free_nodes.back();
+    free_nodes.pop_back();
+    return node;
+  };
+  auto delete_node = [&](PQFragmentCellRange<T>* node) {
+    free_nodes.push_back(node);
+  };
+
   // Initializations
   PQFragmentCellRange<T>* pq_fragment_cell_range;
   PQFragmentCellRange<T>* popped;
@@ -1866,16 +2210,9 @@ int ArrayReadState::sort_fragment_cell_ranges(
   FragmentCellRange result;
 
   // Populate queue
-  std::priority_queue<
-      PQFragmentCellRange<T>*,
-      std::vector<PQFragmentCellRange<T>* >,
-      SmallerPQFragmentCellRange<T> > pq(array_schema_);
-
   for(int i=0; i<fragment_num; ++i) { 
     if(rlen[i] != 0) {
-      pq_fragment_cell_range = new PQFragmentCellRange<T>( 
-          array_schema_,
-          &fragment_read_states_);
+      pq_fragment_cell_range = new_node();
       pq_fragment_cell_range->import_from(unsorted_fragment_cell_ranges[i][0]);
       pq.push(pq_fragment_cell_range);
       ++rid[i];
@@ -1896,14 +2233,12 @@ int ArrayReadState::sort_fragment_cell_ranges(
       fid = (popped->fragment_id_ != -1) ? 
              popped->fragment_id_ : 
              fragment_num-1;
-      delete popped;
+      delete_node(popped);
 
       if(rid[fid] == rlen[fid]) {
         break;
       } else {
-        pq_fragment_cell_range = new PQFragmentCellRange<T>( 
-                                         array_schema_,
-                                         &fragment_read_states_);
+        pq_fragment_cell_range = new_node();
         pq_fragment_cell_range->import_from(
             unsorted_fragment_cell_ranges[fid][rid[fid]]);
         pq.push(pq_fragment_cell_range);
@@ -1922,14 +2257,11 @@ int ArrayReadState::sort_fragment_cell_ranges(
         // Cut the top range and re-insert, only if there is partial overlap
         if(top->ends_after(popped)) {
           // Create the new trimmed top range
-          trimmed_top = new PQFragmentCellRange<T>(
-              array_schema_,
-              &fragment_read_states_);
+          trimmed_top = new_node();
           popped->trim(top, trimmed_top, tile_domain);
       
           // Discard top
-          free(top->cell_range_);
-          delete top;
+          delete_node(top);
           pq.pop();
 
           if(trimmed_top->cell_range_ != NULL) { 
@@ -1941,16 +2273,14 @@ int ArrayReadState::sort_fragment_cell_ranges(
                    trimmed_top->fragment_id_ : 
                    fragment_num-1;
             if(rid[fid] != rlen[fid]) {
-              pq_fragment_cell_range = new PQFragmentCellRange<T>( 
-                  array_schema_,
-                  &fragment_read_states_);
+              pq_fragment_cell_range = new_node();
               pq_fragment_cell_range->import_from(
                   unsorted_fragment_cell_ranges[fid][rid[fid]]);
               pq.push(pq_fragment_cell_range);
               ++rid[fid];
             }
             // Clear trimmed top
-            delete trimmed_top;
+            delete_node(trimmed_top);
           }
         } else {
           // Get the next range from the top fragment
@@ -1958,16 +2288,13 @@ int ArrayReadState::sort_fragment_cell_ranges(
                  top->fragment_id_ : 
                  fragment_num-1;
           if(rid[fid] != rlen[fid]) {
-            pq_fragment_cell_range = new PQFragmentCellRange<T>(
-                                             array_schema_,
-                                             &fragment_read_states_);
+            pq_fragment_cell_range = new_node();
             pq_fragment_cell_range->import_from(
                 unsorted_fragment_cell_ranges[fid][rid[fid]]);
           }
 
           // Discard top
-          free(top->cell_range_);
-          delete top;
+          delete_node(top);
           pq.pop();
 
           if(rid[fid] != rlen[fid]) {
@@ -1984,9 +2311,7 @@ int ArrayReadState::sort_fragment_cell_ranges(
       // Potentially split the popped range
       if(!pq.empty() && popped->must_be_split(top)) {
         // Split the popped range
-        extra_popped = new PQFragmentCellRange<T>( 
-            array_schema_,
-            &fragment_read_states_);
+        extra_popped = new_node();
         popped->split(top, extra_popped, tile_domain);
         // Re-instert the extra popped range into the queue
         pq.push(extra_popped);
@@ -1996,9 +2321,7 @@ int ArrayReadState::sort_fragment_cell_ranges(
                popped->fragment_id_ :
                fragment_num-1;
         if(rid[fid] != rlen[fid]) {
-          pq_fragment_cell_range = new PQFragmentCellRange<T>( 
-              array_schema_,
-              &fragment_read_states_);
+          pq_fragment_cell_range = new_node();
           pq_fragment_cell_range->import_from(
               unsorted_fragment_cell_ranges[fid][rid[fid]]);
           pq.push(pq_fragment_cell_range);
@@ -2009,7 +2332,7 @@ int ArrayReadState::sort_fragment_cell_ranges(
       // Insert the final popped range into the results
       popped->export_to(result);
       fragment_cell_ranges.push_back(result);
-      delete popped;
+      delete_node(popped);
     } else {                               // SPARSE POPPED
       // If popped does not overlap with top, insert popped into results
       if(!pq.empty() && top->begins_after(popped)) {
@@ -2018,32 +2341,24 @@ int ArrayReadState::sort_fragment_cell_ranges(
         // Get the next range from the popped fragment
         fid = popped->fragment_id_;
         if(rid[fid] != rlen[fid]) {
-          pq_fragment_cell_range = new PQFragmentCellRange<T>( 
-              array_schema_,
-              &fragment_read_states_);
+          pq_fragment_cell_range = new_node();
           pq_fragment_cell_range->import_from(
               unsorted_fragment_cell_ranges[fid][rid[fid]]);
           pq.push(pq_fragment_cell_range);
           ++rid[fid];
         }
-        delete popped;
+        delete_node(popped);
       } else {
         // Create up to 3 more ranges (left, unary, new popped/right)
-        left = new PQFragmentCellRange<T>(
-                   array_schema_, 
-                   &fragment_read_states_);
-        unary = new PQFragmentCellRange<T>( 
-                   array_schema_,
-                   &fragment_read_states_);
+        left = new_node();
+        unary = new_node();
         popped->split_to_3(top, left, unary);
 
         // Get the next range from the popped fragment
         if(unary->cell_range_ == NULL && popped->cell_range_ == NULL) {
           fid = popped->fragment_id_;
           if(rid[fid] != rlen[fid]) {
-            pq_fragment_cell_range = new PQFragmentCellRange<T>( 
-                array_schema_,
-                &fragment_read_states_);
+            pq_fragment_cell_range = new_node();
             pq_fragment_cell_range->import_from(
                 unsorted_fragment_cell_ranges[fid][rid[fid]]);
             pq.push(pq_fragment_cell_range);
@@ -2056,19 +2371,19 @@ int ArrayReadState::sort_fragment_cell_ranges(
           left->export_to(result);
           fragment_cell_ranges.push_back(result);
         } 
-        delete left;
+        delete_node(left);
 
         // Insert unary to the priority queue 
         if(unary->cell_range_ != NULL) 
           pq.push(unary); 
         else
-          delete unary;
+          delete_node(unary);
 
         // Re-insert new popped (right) range to the priority queue
         if(popped->cell_range_ != NULL) 
           pq.push(popped);
         else
-          delete popped;
+          delete_node(popped);
       }
     }
   }
@@ -2080,15 +2395,8 @@ int ArrayReadState::sort_fragment_cell_ranges(
   delete [] rlen;
   delete [] rid;
 
-  // Clean up in case of error
+  // Clean up in case of error, the cell ranges are held by the arena
   if(rc != TILEDB_ARS_OK) {
-    while(!pq.empty()) {
-      free(pq.top()->cell_range_);
-      delete pq.top();
-      pq.pop();
-    }
-    for(int64_t i=0; i<int64_t(fragment_cell_ranges.size()); ++i)
-      free(fragment_cell_ranges[i].second);
     fragment_cell_ranges.clear();
   } else {
     assert(pq.empty()); // Sanity check
@@ -2101,12 +2409,56 @@ int ArrayReadState::sort_fragment_cell_ranges(
 
 
 
+ArrayReadState::CellRangeArena::CellRangeArena(size_t cell_range_size) {
+  cell_range_size_ = cell_range_size;
+  chunk_ = 0;
+  chunk_offset_ = 0;
+}
+
+ArrayReadState::CellRangeArena::~CellRangeArena() {
+  reset();
+  for(auto chunk : chunks_)
+    free(chunk);
+}
+
+void ArrayReadState::CellRangeArena::adopt(void* cell_range) {
+  malloced_.push_back(cell_range);
+}
+
+void* ArrayReadState::CellRangeArena::allocate() {
+  // Move to the next chunk if the current one is full
+  if(chunk_offset_ == CELL_RANGE_ARENA_CHUNK*cell_range_size_) {
+    ++chunk_;
+    chunk_offset_ = 0;
+  }
+  if(chunk_ == chunks_.size())
+    chunks_.push_back(
+        static_cast<char*>(malloc(CELL_RANGE_ARENA_CHUNK*cell_range_size_)));
+
+  void* cell_range = chunks_[chunk_] + chunk_offset_;
+  chunk_offset_ += cell_range_size_;
+  return cell_range;
+}
+
+void ArrayReadState::CellRangeArena::reset() {
+  for(auto cell_range : malloced_)
+    free(cell_range);
+  malloced_.clear();
+  chunk_ = 0;
+  chunk_offset_ = 0;
+}
+
+
+
+
 template<class T>
 ArrayReadState::PQFragmentCellRange<T>::PQFragmentCellRange(
     const ArraySchema* array_schema,
-    const std::vector<ReadState*>* fragment_read_states) {
+    const std::vector<ReadState*>* fragment_read_states,
+    CellRangeArena* cell_range_arena) {
   array_schema_ = array_schema;
   fragment_read_states_ = fragment_read_states;
+  cell_range_arena_ = cell_range_arena;
 
   cell_range_ = NULL;
   fragment_id_ = -1;
@@ -2198,7 +2550,7 @@ void ArrayReadState::PQFragmentCellRange<T>::split(
   // Create the new range
   fcr_new->fragment_id_ = fragment_id_;
   fcr_new->tile_pos_ = tile_pos_;
-  fcr_new->cell_range_ = (T*) malloc(2*coords_size_);
+  fcr_new->cell_range_ = static_cast<T*>(cell_range_arena_->allocate());
   fcr_new->tile_id_l_ = fcr->tile_id_l_;
   memcpy(
       fcr_new->cell_range_, 
@@ -2226,7 +2578,7 @@ void ArrayReadState::PQFragmentCellRange<T>::split_to_3(
   // Initialize fcr_left
   fcr_left->fragment_id_ = fragment_id_;
   fcr_left->tile_pos_ = tile_pos_;
-  fcr_left->cell_range_ = (T*) malloc(2*coords_size_);
+  fcr_left->cell_range_ = static_cast<T*>(cell_range_arena_->allocate());
   fcr_left->tile_id_l_ = tile_id_l_;
   memcpy(fcr_left->cell_range_, cell_range_, coords_size_);
 
@@ -2250,14 +2602,12 @@ void ArrayReadState::PQFragmentCellRange<T>::split_to_3(
     fcr_left->tile_id_r_ = 
         array_schema_->tile_id<T>(&fcr_left->cell_range_[dim_num_]);
   } else {
-    free(fcr_left->cell_range_);
     fcr_left->cell_range_ = NULL;
   }
 
   if(right_retrieved) {
     tile_id_l_ = array_schema_->tile_id<T>(cell_range_);
   } else {
-    free(cell_range_);
     cell_range_ = NULL;
   }
 
@@ -2265,7 +2615,7 @@ void ArrayReadState::PQFragmentCellRange<T>::split_to_3(
   if(target_exists) {
     fcr_unary->fragment_id_ = fragment_id_;
     fcr_unary->tile_pos_ = tile_pos_;
-    fcr_unary->cell_range_ = (T*) malloc(2*coords_size_);
+    fcr_unary->cell_range_ = static_cast<T*>(cell_range_arena_->allocate());
     fcr_unary->tile_id_l_ = fcr->tile_id_l_;
     memcpy(fcr_unary->cell_range_, fcr->cell_range_, coords_size_); 
     fcr_unary->tile_id_r_ = fcr->tile_id_l_;
@@ -2284,7 +2634,7 @@ void ArrayReadState::PQFragmentCellRange<T>::trim(
   // Construct trimmed range
   fcr_trimmed->fragment_id_ = fcr->fragment_id_;
   fcr_trimmed->tile_pos_ = fcr->tile_pos_;
-  fcr_trimmed->cell_range_ = (T*) malloc(2*coords_size_);
+  fcr_trimmed->cell_range_ = static_cast<T*>(cell_range_arena_->allocate());
   memcpy(fcr_trimmed->cell_range_, &cell_range_[dim_num_], coords_size_);
   fcr_trimmed->tile_id_l_ = tile_id_r_;
   memcpy(
@@ -2308,10 +2658,8 @@ void ArrayReadState::PQFragmentCellRange<T>::trim(
     assert(rc == TILEDB_RS_OK);
   }
 
-  if(!coords_retrieved) {
-    free(fcr_trimmed->cell_range_);
+  if(!coords_retrieved)
     fcr_trimmed->cell_range_ = NULL;
-  }
 }
 
 template<class T>
@@ -2371,6 +2719,141 @@ bool ArrayReadState::SmallerPQFragmentCellRange<T>::operator () (
 
 
 
+template<class T>
+ArrayReadState::PQFragmentCellRangeTree<T>::PQFragmentCellRangeTree(
+    const ArraySchema* array_schema,
+    int fragment_num) {
+  array_schema_ = array_schema;
+  cell_order_ = array_schema_->cell_order();
+  dim_num_ = array_schema_->dim_num();
+  size_ = 0;
+
+  // One leaf per fragment, the tree grows in the rare case more are needed
+  int leaf_num = 2;
+  while(leaf_num < fragment_num)
+    leaf_num *= 2;
+  leaves_.resize(leaf_num, NULL);
+  winners_.resize(leaf_num, -1);
+  for(int i=leaf_num-1; i>=0; --i)
+    free_leaves_.push_back(i);
+}
+
+template<class T>
+bool ArrayReadState::PQFragmentCellRangeTree<T>::empty() const {
+  return size_ == 0;
+}
+
+template<class T>
+void ArrayReadState::PQFragmentCellRangeTree<T>::pop() {
+  // Sanity check
+  assert(size_ > 0);
+
+  int leaf = winners_[1];
+  leaves_[leaf] = NULL;
+  free_leaves_.push_back(leaf);
+  --size_;
+  replay(leaf);
+}
+
+template<class T>
+void ArrayReadState::PQFragmentCellRangeTree<T>::push(
+    PQFragmentCellRange<T>* fcr) {
+  if(free_leaves_.empty())
+    grow();
+
+  int leaf = free_leaves_.back();
+  free_leaves_.pop_back();
+  leaves_[leaf] = fcr;
+  ++size_;
+  replay(leaf);
+}
+
+template<class T>
+ArrayReadState::PQFragmentCellRange<T>*
+ArrayReadState::PQFragmentCellRangeTree<T>::top() const {
+  // Sanity check
+  assert(size_ > 0);
+
+  return leaves_[winners_[1]];
+}
+
+template<class T>
+void ArrayReadState::PQFragmentCellRangeTree<T>::grow() {
+  int leaf_num = leaves_.size();
+  leaves_.resize(2*leaf_num, NULL);
+  for(int i=2*leaf_num-1; i>=leaf_num; --i)
+    free_leaves_.push_back(i);
+
+  // The leaves moved, replay all the matches bottom up
+  winners_.assign(2*leaf_num, -1);
+  for(int node=2*leaf_num-1; node>=1; --node)
+    winners_[node] = play(winner(2*node), winner(2*node+1));
+}
+
+template<class T>
+int ArrayReadState::PQFragmentCellRangeTree<T>::play(
+    int leaf_a,
+    int leaf_b) const {
+  if(leaf_a == -1)
+    return leaf_b;
+  if(leaf_b == -1)
+    return leaf_a;
+  return precedes(leaves_[leaf_a], leaves_[leaf_b]) ? leaf_a : leaf_b;
+}
+
+template<class T>
+bool ArrayReadState::PQFragmentCellRangeTree<T>::precedes(
+    const PQFragmentCellRange<T>* a,
+    const PQFragmentCellRange<T>* b) const {
+  // First the smallest tile id of the left range end point
+  if(a->tile_id_l_ != b->tile_id_l_)
+    return a->tile_id_l_ < b->tile_id_l_;
+
+  // Then the smallest start range endpoint
+  const T* coords_a = a->cell_range_;
+  const T* coords_b = b->cell_range_;
+  if(cell_order_ == TILEDB_ROW_MAJOR) {        // ROW-MAJOR
+    for(int i=0; i<dim_num_; ++i)
+      if(coords_a[i] != coords_b[i])
+        return coords_a[i] < coords_b[i];
+  } else if(cell_order_ == TILEDB_COL_MAJOR) { // COLUMN-MAJOR
+    for(int i=dim_num_-1; i>=0; --i)
+      if(coords_a[i] != coords_b[i])
+        return coords_a[i] < coords_b[i];
+  } else {                                     // HILBERT
+    int cmp = array_schema_->cell_order_cmp<T>(coords_a, coords_b);
+    if(cmp != 0)
+      return cmp < 0;
+  }
+
+  // Then the largest fragment id, i.e., the latest fragment wins
+  return a->fragment_id_ > b->fragment_id_;
+}
+
+template<class T>
+void ArrayReadState::PQFragmentCellRangeTree<T>::replay(int leaf) {
+  int leaf_num = leaves_.size();
+  for(int node=(leaf_num+leaf)/2; node>=1; node/=2) {
+    int old_winner = winners_[node];
+    winners_[node] = play(winner(2*node), winner(2*node+1));
+
+    // The matches above are unchanged if another leaf still wins
+    if(winners_[node] == old_winner && old_winner != leaf)
+      break;
+  }
+}
+
+template<class T>
+int ArrayReadState::PQFragmentCellRangeTree<T>::winner(int node) const {
+  int leaf_num = leaves_.size();
+  if(node < leaf_num)
+    return winners_[node];
+  return (leaves_[node-leaf_num] != NULL) ? node-leaf_num : -1;
+}
+
+
+
+
 // Explicit template instantiations
 template class ArrayReadState::PQFragmentCellRange<int>;
 template class ArrayReadState::PQFragmentCellRange<int64_t>;
@@ -2382,3 +2865,8 @@ template class ArrayReadState::SmallerPQFragmentCellRange<int64_t>;
 template class ArrayReadState::SmallerPQFragmentCellRange<float>;
 template class ArrayReadState::SmallerPQFragmentCellRange<double>;
 
+template class ArrayReadState::PQFragmentCellRangeTree<int>;
+template class ArrayReadState::PQFragmentCellRangeTree<int64_t>;
+template class ArrayReadState::PQFragmentCellRangeTree<float>;
+template class ArrayReadState::PQFragmentCellRangeTree<double>;
+
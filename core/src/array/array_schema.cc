@@ -68,7 +68,7 @@
 /*        GLOBAL VARIABLES        */
 /* ****************************** */
 
-std::string tiledb_as_errmsg = "";
+thread_local std::string tiledb_as_errmsg = "";
 
 
 /* ****************************** */
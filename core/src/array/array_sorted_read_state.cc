@@ -63,7 +63,7 @@
 /*         GLOBAL VARIABLES       */
 /* ****************************** */
 
-std::string tiledb_asrs_errmsg = "";
+thread_local std::string tiledb_asrs_errmsg = "";
 
 
 
@@ -55,7 +55,7 @@
 /*         GLOBAL VARIABLES       */
 /* ****************************** */
 
-std::string tiledb_asws_errmsg = "";
+thread_local std::string tiledb_asws_errmsg = "";
 
 
 
@@ -0,0 +1,215 @@
+/**
+ * @file   consolidation_plan.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2026 Omics Data Automation, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file implements the ConsolidationPlan class.
+ */
+
+#include "consolidation_plan.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+
+
+
+
+/* ****************************** */
+/*             MACROS             */
+/* ****************************** */
+
+#ifdef TILEDB_VERBOSE
+#  define PRINT_ERROR(x) std::cerr << TILEDB_CP_ERRMSG << x << ".\n"
+#else
+#  define PRINT_ERROR(x) do { } while(0)
+#endif
+
+
+
+
+/* ****************************** */
+/*        GLOBAL VARIABLES        */
+/* ****************************** */
+
+thread_local std::string tiledb_cp_errmsg = "";
+
+
+
+
+/* ****************************** */
+/*   CONSTRUCTORS & DESTRUCTORS   */
+/* ****************************** */
+
+ConsolidationPlan::ConsolidationPlan(size_t memory_size)
+    : memory_size_(memory_size) {
+  memory_used_ = 0;
+  spill_fd_ = -1;
+  spill_size_ = 0;
+}
+
+ConsolidationPlan::~ConsolidationPlan() {
+  for(auto fragment_cell_pos_ranges : rounds_)
+    delete fragment_cell_pos_ranges;
+
+  if(spill_fd_ != -1)
+    close(spill_fd_);
+}
+
+
+
+
+/* ****************************** */
+/*           ACCESSORS            */
+/* ****************************** */
+
+int ConsolidationPlan::get(
+    int64_t round,
+    FragmentCellPosRanges& fragment_cell_pos_ranges) const {
+  // Read round kept in memory
+  if(round < int64_t(rounds_.size())) {
+    fragment_cell_pos_ranges = *rounds_[round];
+    return TILEDB_CP_OK;
+  }
+
+  // Spilled read round
+  const std::pair<off_t, size_t>& spilled_round =
+      spilled_rounds_[round - rounds_.size()];
+  fragment_cell_pos_ranges.resize(spilled_round.second);
+  char* data = reinterpret_cast<char*>(fragment_cell_pos_ranges.data());
+  size_t size =
+      spilled_round.second * sizeof(ArrayReadState::FragmentCellPosRange);
+  size_t offset = 0;
+  while(offset < size) {
+    ssize_t bytes_read = pread(
+        spill_fd_,
+        data + offset,
+        size - offset,
+        spilled_round.first + offset);
+    if(bytes_read < 0 && errno == EINTR)
+      continue;
+    if(bytes_read <= 0) {
+      std::string errmsg =
+          std::string("Cannot read spilled read round; ") +
+          (bytes_read == 0 ? "unexpected EOF" : strerror(errno));
+      PRINT_ERROR(errmsg);
+      tiledb_cp_errmsg = TILEDB_CP_ERRMSG + errmsg;
+      return TILEDB_CP_ERR;
+    }
+    offset += bytes_read;
+  }
+
+  return TILEDB_CP_OK;
+}
+
+int64_t ConsolidationPlan::round_num() const {
+  return rounds_.size() + spilled_rounds_.size();
+}
+
+bool ConsolidationPlan::spilled() const {
+  return !spilled_rounds_.empty();
+}
+
+
+
+
+/* ****************************** */
+/*            MUTATORS            */
+/* ****************************** */
+
+int ConsolidationPlan::append(FragmentCellPosRanges* fragment_cell_pos_ranges) {
+  size_t size = fragment_cell_pos_ranges->size() *
+                sizeof(ArrayReadState::FragmentCellPosRange);
+
+  // Keep the read round in memory if it fits and nothing was spilled yet
+  if(spilled_rounds_.empty() && memory_used_ + size <= memory_size_) {
+    rounds_.push_back(fragment_cell_pos_ranges);
+    memory_used_ += size;
+    return TILEDB_CP_OK;
+  }
+
+  // Spill the read round
+  if(spill_fd_ == -1 && create_spill_file() != TILEDB_CP_OK) {
+    delete fragment_cell_pos_ranges;
+    return TILEDB_CP_ERR;
+  }
+  const char* data =
+      reinterpret_cast<const char*>(fragment_cell_pos_ranges->data());
+  size_t offset = 0;
+  while(offset < size) {
+    ssize_t bytes_written = pwrite(
+        spill_fd_,
+        data + offset,
+        size - offset,
+        spill_size_ + offset);
+    if(bytes_written < 0 && errno == EINTR)
+      continue;
+    if(bytes_written < 0) {
+      std::string errmsg =
+          std::string("Cannot spill read round; ") + strerror(errno);
+      PRINT_ERROR(errmsg);
+      tiledb_cp_errmsg = TILEDB_CP_ERRMSG + errmsg;
+      delete fragment_cell_pos_ranges;
+      return TILEDB_CP_ERR;
+    }
+    offset += bytes_written;
+  }
+  spilled_rounds_.emplace_back(spill_size_, fragment_cell_pos_ranges->size());
+  spill_size_ += size;
+  delete fragment_cell_pos_ranges;
+
+  return TILEDB_CP_OK;
+}
+
+
+
+
+/* ****************************** */
+/*         PRIVATE METHODS        */
+/* ****************************** */
+
+int ConsolidationPlan::create_spill_file() {
+  const char *tmp_dir = getenv("TMPDIR");
+  if(tmp_dir == NULL)
+    tmp_dir = P_tmpdir; // defined in stdio
+  std::string path = std::string(tmp_dir) + "/TileDBPlanXXXXXX";
+
+  spill_fd_ = mkstemp(&path[0]);
+  if(spill_fd_ == -1) {
+    std::string errmsg = "Cannot create spill file in " + std::string(tmp_dir) +
+                         "; " + strerror(errno);
+    PRINT_ERROR(errmsg);
+    tiledb_cp_errmsg = TILEDB_CP_ERRMSG + errmsg;
+    return TILEDB_CP_ERR;
+  }
+  unlink(path.c_str());
+
+  return TILEDB_CP_OK;
+}
@@ -60,7 +60,7 @@
 /*        GLOBAL VARIABLES        */
 /* ****************************** */
 
-std::string tiledb_cd_errmsg = "";
+thread_local std::string tiledb_cd_errmsg = "";
 
 /* ****************************** */
 /*        FACTORY METHODS         */
@@ -48,7 +48,7 @@
 /*        GLOBAL VARIABLES        */
 /* ****************************** */
 
-std::string tiledb_cdf_errmsg = "";
+thread_local std::string tiledb_cdf_errmsg = "";
 
 int CodecFilter::print_errmsg(const std::string& msg) {
   if (msg.length() > 0) {
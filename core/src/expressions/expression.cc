@@ -51,7 +51,7 @@
 /*        GLOBAL VARIABLES        */
 /* ****************************** */
 
-std::string tiledb_expr_errmsg = "";
+thread_local std::string tiledb_expr_errmsg = "";
 
 int Expression::init(const std::vector<int>& attribute_ids, const ArraySchema* array_schema) {
   array_schema_ = array_schema;
@@ -33,15 +33,19 @@
  */
 
 #include "book_keeping.h"
+#include "book_keeping_cache.h"
 #include "error.h"
 #include "mem_utils.h"
 #include "storage_fs.h"
 #include "utils.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <fcntl.h>
 #include <iostream>
+#include <sys/mman.h>
+#include <unistd.h>
 
 
 
@@ -51,12 +55,44 @@
 
 #define BK_ERROR(MSG) delete buffer_; buffer_ = 0; TILEDB_ERROR(TILEDB_BK_ERRMSG, MSG, tiledb_bk_errmsg)
 
+/*
+ * Sections of a version 2 book-keeping file. The tile offsets of the
+ * attributes and the coordinates are followed by the variable tile offsets
+ * and then the variable tile sizes of the attributes.
+ */
+#define BK_V2_NON_EMPTY_DOMAIN 0
+#define BK_V2_MBRS             1
+#define BK_V2_BOUNDING_COORDS  2
+#define BK_V2_TILE_OFFSETS     3
+
+#define BK_V2_ALIGNMENT        8
+
+
+
+
+/* ****************************** */
+/*             TYPES              */
+/* ****************************** */
+
+/*
+ * Header of a version 2 book-keeping file, followed by a table of
+ * (offset, length) in bytes for each of the section_num_ sections.
+ */
+typedef struct bk_v2_header_t {
+  char magic_[8];
+  int64_t version_;
+  int64_t attribute_num_;
+  int64_t coords_size_;
+  int64_t last_tile_cell_num_;
+  int64_t section_num_;
+} bk_v2_header_t;
+
 
 /* ****************************** */
 /*        GLOBAL VARIABLES        */
 /* ****************************** */
 
-std::string tiledb_bk_errmsg = "";
+thread_local std::string tiledb_bk_errmsg = "";
 
 
 
@@ -74,6 +110,7 @@ BookKeeping::BookKeeping(
       dense_(dense),
       fragment_name_(fragment_name),
       mode_(mode) {
+  buffer_ = NULL;
   domain_ = NULL;
   non_empty_domain_ = NULL;
 
@@ -89,23 +126,20 @@ BookKeeping::~BookKeeping() {
   if(non_empty_domain_ != NULL)
     free(non_empty_domain_);
 
-  int64_t mbr_num = mbrs_.size(); 
-  for(int64_t i=0; i<mbr_num; ++i)
-    if(mbrs_[i] != NULL)
-      free(mbrs_[i]);
-
-  int64_t bounding_coords_num = bounding_coords_.size();
-  for(int64_t i=0; i<bounding_coords_num; ++i)
-    if(bounding_coords_[i] != NULL)
-      free(bounding_coords_[i]);
+  if(v2_mapped_)
+    munmap(const_cast<char*>(v2_data_), v2_size_);
 }
 
 /* ****************************** */
 /*             ACCESSORS          */
 /* ****************************** */
 
-const std::vector<void*>& BookKeeping::bounding_coords() const {
-  return bounding_coords_;
+TileRecordsView BookKeeping::bounding_coords() const {
+  size_t bounding_coords_size = 2*array_schema_->coords_size();
+  if(v2_data_ != NULL)
+    return TileRecordsView(v2_section(BK_V2_BOUNDING_COORDS), bounding_coords_size,
+                           v2_section_num(BK_V2_BOUNDING_COORDS, bounding_coords_size));
+  return TileRecordsView(bounding_coords_.data(), bounding_coords_size, bounding_coords_.size()/bounding_coords_size);
 }
 
 int64_t BookKeeping::cell_num(int64_t tile_pos) const {
@@ -132,8 +166,80 @@ int64_t BookKeeping::last_tile_cell_num() const {
   return last_tile_cell_num_;
 }
 
-const std::vector<void*>& BookKeeping::mbrs() const {
-  return mbrs_;
+TileRecordsView BookKeeping::mbrs() const {
+  size_t mbr_size = 2*array_schema_->coords_size();
+  if(v2_data_ != NULL)
+    return TileRecordsView(v2_section(BK_V2_MBRS), mbr_size, v2_section_num(BK_V2_MBRS, mbr_size));
+  return TileRecordsView(mbrs_.data(), mbr_size, mbrs_.size()/mbr_size);
+}
+
+const void* BookKeeping::mbrs_dim_major() const {
+  std::call_once(mbrs_dim_major_once_, [this]() {
+    // For easy reference
+    int dim_num = array_schema_->dim_num();
+    size_t value_size = array_schema_->coords_size()/dim_num;
+    size_t mbr_size = 2*array_schema_->coords_size();
+    TileRecordsView mbrs = this->mbrs();
+    int64_t mbr_num = mbrs.size();
+    const char* mbrs_c = static_cast<const char*>(mbrs.data());
+
+    // Bound j of MBR i moves from i*mbr_size + j*value_size to (j*mbr_num + i)*value_size
+    mbrs_dim_major_.resize(mbr_num*mbr_size);
+    for(int64_t i=0; i<mbr_num; ++i) {
+      for(int j=0; j<2*dim_num; ++j) {
+        memcpy(&mbrs_dim_major_[(j*mbr_num + i)*value_size], &mbrs_c[i*mbr_size + j*value_size], value_size);
+      }
+    }
+    add_lazy_memory_size(mbrs_dim_major_.capacity());
+  });
+  return mbrs_dim_major_.data();
+}
+
+const MBRIndex* BookKeeping::mbr_index() const {
+  std::call_once(mbr_index_once_, [this]() {
+    TileRecordsView mbrs = this->mbrs();
+    mbr_index_.reset(new MBRIndex(array_schema_->coords_type(), array_schema_->dim_num(), mbrs.data(), mbrs.size()));
+    add_lazy_memory_size(mbr_index_->memory_size());
+  });
+  return mbr_index_.get();
+}
+
+const void* BookKeeping::mbrs_bounds() const {
+  std::call_once(mbrs_bounds_once_, [this]() {
+    int coords_type = array_schema_->coords_type();
+    if(coords_type == TILEDB_INT32)
+      compute_mbrs_bounds<int>();
+    else if(coords_type == TILEDB_INT64)
+      compute_mbrs_bounds<int64_t>();
+    else if(coords_type == TILEDB_FLOAT32)
+      compute_mbrs_bounds<float>();
+    else if(coords_type == TILEDB_FLOAT64)
+      compute_mbrs_bounds<double>();
+    add_lazy_memory_size(mbrs_bounds_.capacity());
+  });
+  return mbrs_bounds_.empty() ? NULL : mbrs_bounds_.data();
+}
+
+size_t BookKeeping::memory_size() const {
+  std::lock_guard<std::mutex> lock(attribute_mtx_);
+  size_t coords_pair_size = 2*array_schema_->coords_size();
+  size_t size = sizeof(BookKeeping) + fragment_name_.size() + filename_.size();
+  if(domain_ != NULL)
+    size += coords_pair_size;
+  if(non_empty_domain_ != NULL)
+    size += coords_pair_size;
+  size += mbrs_.capacity() + bounding_coords_.capacity();
+  for(auto const& offsets : tile_offsets_)
+    size += offsets.size() * sizeof(off_t);
+  for(auto const& offsets : tile_var_offsets_)
+    size += offsets.size() * sizeof(off_t);
+  for(auto const& sizes : tile_var_sizes_)
+    size += sizes.size() * sizeof(size_t);
+  // Mapped version 2 files are backed by the page cache
+  size += v2_buffer_.capacity() + sections_.size()*sizeof(sections_[0]);
+  // The MBR layouts built on first use by the reads
+  size += lazy_memory_size_.load();
+  return size;
 }
 
 const void* BookKeeping::non_empty_domain() const {
@@ -149,20 +255,39 @@ int64_t BookKeeping::tile_num() const {
   if(dense_) {
     return array_schema_->tile_num(domain_);
   } else { 
-    return mbrs_.size();
+    return mbrs().size();
   }
 }
 
-const std::vector<std::vector<off_t> >& BookKeeping::tile_offsets() const {
-  return tile_offsets_;
+TileValuesView<off_t> BookKeeping::tile_offsets(int attribute_id) const {
+  if(v2_mapped_) {
+    int section = BK_V2_TILE_OFFSETS + attribute_id;
+    return TileValuesView<off_t>(reinterpret_cast<const off_t*>(v2_section(section)),
+                                 v2_section_num(section, sizeof(off_t)));
+  }
+  return TileValuesView<off_t>(tile_offsets_[attribute_id].data(), tile_offsets_[attribute_id].size());
+}
+
+TileValuesView<off_t> BookKeeping::tile_var_offsets(int attribute_id) const {
+  if(v2_mapped_) {
+    int section = BK_V2_TILE_OFFSETS + array_schema_->attribute_num() + 1 + attribute_id;
+    return TileValuesView<off_t>(reinterpret_cast<const off_t*>(v2_section(section)),
+                                 v2_section_num(section, sizeof(off_t)));
+  }
+  return TileValuesView<off_t>(tile_var_offsets_[attribute_id].data(), tile_var_offsets_[attribute_id].size());
 }
 
-const std::vector<std::vector<off_t> >& BookKeeping::tile_var_offsets() const {
-  return tile_var_offsets_;
+TileValuesView<size_t> BookKeeping::tile_var_sizes(int attribute_id) const {
+  if(v2_mapped_) {
+    int section = BK_V2_TILE_OFFSETS + 2*array_schema_->attribute_num() + 1 + attribute_id;
+    return TileValuesView<size_t>(reinterpret_cast<const size_t*>(v2_section(section)),
+                                  v2_section_num(section, sizeof(size_t)));
+  }
+  return TileValuesView<size_t>(tile_var_sizes_[attribute_id].data(), tile_var_sizes_[attribute_id].size());
 }
 
-const std::vector<std::vector<size_t> >& BookKeeping::tile_var_sizes() const {
-  return tile_var_sizes_;
+bool BookKeeping::v2() const {
+  return v2_data_ != NULL;
 }
 
 inline
@@ -181,20 +306,18 @@ void BookKeeping::append_bounding_coords(const void* bounding_coords) {
   // For easy reference
   size_t bounding_coords_size = 2*array_schema_->coords_size();
 
-  // Copy and append MBR
-  void* new_bounding_coords = malloc(bounding_coords_size);
-  memcpy(new_bounding_coords, bounding_coords, bounding_coords_size);
-  bounding_coords_.push_back(new_bounding_coords);
+  // Append bounding coordinates
+  const char* bounding_coords_c = static_cast<const char*>(bounding_coords);
+  bounding_coords_.insert(bounding_coords_.end(), bounding_coords_c, bounding_coords_c + bounding_coords_size);
 }
 
 void BookKeeping::append_mbr(const void* mbr) {
   // For easy reference
   size_t mbr_size = 2*array_schema_->coords_size();
 
-  // Copy and append MBR
-  void* new_mbr = malloc(mbr_size);
-  memcpy(new_mbr, mbr, mbr_size);
-  mbrs_.push_back(new_mbr);
+  // Append MBR
+  const char* mbr_c = static_cast<const char*>(mbr);
+  mbrs_.insert(mbrs_.end(), mbr_c, mbr_c + mbr_size);
 }
 
 void BookKeeping::append_tile_offset(
@@ -255,9 +378,18 @@ int BookKeeping::finalize(StorageFS *fs) {
   if(!is_dir(fs, fragment_name_))
     return TILEDB_BK_OK;
 
-  // Create StorageBuffer to serialize book_keeping content
-  buffer_ = new CompressedStorageBuffer(fs, filename_, upload_uncompressed_size_, /*is_read*/false,
-                                        TILEDB_GZIP, TILEDB_COMPRESSION_LEVEL_GZIP);
+  if(is_env_set("TILEDB_BOOKKEEPING_V2"))
+    return finalize_v2(fs);
+
+  // Create StorageBuffer to serialize book_keeping content. Note that zstd compressed book_keeping
+  // content is recognized when loading even though the filename has a gzip suffix
+  if (is_env_set("TILEDB_BOOKKEEPING_ZSTD")) {
+    buffer_ = new CompressedStorageBuffer(fs, filename_, upload_uncompressed_size_, /*is_read*/false,
+                                          TILEDB_ZSTD, TILEDB_COMPRESSION_LEVEL_ZSTD);
+  } else {
+    buffer_ = new CompressedStorageBuffer(fs, filename_, upload_uncompressed_size_, /*is_read*/false,
+                                          TILEDB_GZIP, TILEDB_COMPRESSION_LEVEL_GZIP);
+  }
 
   // Write non-empty domain
   if(flush_non_empty_domain() != TILEDB_BK_OK)
@@ -366,58 +498,72 @@ int BookKeeping::init(const void* non_empty_domain) {
  * last_tile_cell_num(int64_t)
  */
 int BookKeeping::load(StorageFS *fs) {
+  std::vector<int> attribute_ids(array_schema_->attribute_num()+1);
+  for(int i=0; i<(int)attribute_ids.size(); ++i)
+    attribute_ids[i] = i;
+  return load(fs, attribute_ids);
+}
+
+int BookKeeping::load(StorageFS *fs, const std::vector<int>& attribute_ids) {
   if (is_env_set("TILEDB_BOOKKEEPING_STATS")) {
     print_memory_stats("Before BookKeeping::load");
   }
-  // Cache the booking file in tmpdir for cloud paths
-  bool used_cache = false;
-  PosixFS posix_fs;
-  if (dynamic_cast<const StorageCloudFS *>(fs) != nullptr && is_env_set("TILEDB_CACHE")) {
-    std::string cached_filename = get_fragment_metadata_cache_dir() + get_filename_from_path(fragment_name_);
-    if (posix_fs.is_file(cached_filename)) {
-      buffer_ = new CompressedStorageBuffer(&posix_fs, cached_filename, download_compressed_size_, /*is_read*/ true,
-                                            TILEDB_GZIP, TILEDB_COMPRESSION_LEVEL_GZIP);
-      used_cache = true;
-    }
+
+  // For easy reference
+  int attribute_num = array_schema_->attribute_num();
+
+  // Allocate the per-attribute structures, filled in as attributes are loaded
+  sections_.assign(BK_V2_TILE_OFFSETS + 3*attribute_num + 1, std::make_pair(0, 0));
+  attribute_loaded_.assign(attribute_num+1, false);
+  tile_offsets_.resize(attribute_num+1);
+  tile_var_offsets_.resize(attribute_num);
+  tile_var_sizes_.resize(attribute_num);
+
+  // The coordinates are needed by every read
+  std::vector<int> to_load;
+  for(auto attribute_id : attribute_ids) {
+    if(attribute_id != attribute_num)
+      to_load.push_back(attribute_id);
   }
-  if (!used_cache) {
+  to_load.push_back(attribute_num);
+
+  // Uncompressed version 2 book-keeping is used in place
+  std::string v2_filename = StorageFS::append_paths(fragment_name_, std::string(TILEDB_BOOK_KEEPING_FILENAME)
+                                                    + TILEDB_FILE_SUFFIX);
+  if (fs->is_file(v2_filename)) {
+    if(load_v2(fs, v2_filename) != TILEDB_BK_OK ||
+       (!v2_mapped_ && load_attribute_sections(fs, to_load) != TILEDB_BK_OK))
+      return TILEDB_BK_ERR;
+  } else {
     // Create StorageBuffer to deserialize book_keeping content
-    buffer_ = new CompressedStorageBuffer(fs, filename_, download_compressed_size_, /*is_read*/ true,
-                                          TILEDB_GZIP, TILEDB_COMPRESSION_LEVEL_GZIP);
-  }
-  
-  // Load non-empty domain
-  if(load_non_empty_domain() != TILEDB_BK_OK)
-    return TILEDB_BK_ERR;
+    PosixFS posix_fs;
+    open_buffer(fs, &posix_fs);
 
-  // Load MBRs
-  if(load_mbrs() != TILEDB_BK_OK)
-    return TILEDB_BK_ERR;
-
-  // Load bounding coordinates
-  if(load_bounding_coords() != TILEDB_BK_OK)
-    return TILEDB_BK_ERR;
+    // Load non-empty domain
+    if(load_non_empty_domain() != TILEDB_BK_OK)
+      return TILEDB_BK_ERR;
 
-  // Load tile offsets
-  if(load_tile_offsets() != TILEDB_BK_OK)
-    return TILEDB_BK_ERR;
+    // Load MBRs
+    if(load_mbrs() != TILEDB_BK_OK)
+      return TILEDB_BK_ERR;
 
-  // Load variable tile offsets
-  if(load_tile_var_offsets() != TILEDB_BK_OK)
-    return TILEDB_BK_ERR;
+    // Load bounding coordinates
+    if(load_bounding_coords() != TILEDB_BK_OK)
+      return TILEDB_BK_ERR;
 
-  // Load variable tile sizes
-  if(load_tile_var_sizes() != TILEDB_BK_OK)
-    return TILEDB_BK_ERR;
+    // Index the tile offsets and sizes and load cell number of last tile
+    if(index_sections() != TILEDB_BK_OK)
+      return TILEDB_BK_ERR;
 
-  // Load cell number of last tile
-  if(load_last_tile_cell_num() != TILEDB_BK_OK)
-    return TILEDB_BK_ERR;
+    // Load the tile offsets and sizes of the requested attributes
+    if(load_attribute_sections(fs, to_load) != TILEDB_BK_OK)
+      return TILEDB_BK_ERR;
 
-  // Free up StorageBuffer
-  buffer_->finalize();
-  delete buffer_;
-  buffer_ = 0;
+    // Free up StorageBuffer
+    buffer_->finalize();
+    delete buffer_;
+    buffer_ = 0;
+  }
 
   if (is_env_set("TILEDB_BOOKKEEPING_STATS")) {
     print_memory_stats("After BookKeeping::load");
@@ -426,6 +572,26 @@ int BookKeeping::load(StorageFS *fs) {
   return TILEDB_BK_OK;
 }
 
+int BookKeeping::load_attributes(StorageFS *fs, const std::vector<int>& attribute_ids) {
+  int rc;
+  {
+    std::lock_guard<std::mutex> lock(attribute_mtx_);
+    std::vector<int> to_load;
+    for(auto attribute_id : attribute_ids) {
+      if(!attribute_loaded_[attribute_id])
+        to_load.push_back(attribute_id);
+    }
+    if(to_load.empty())
+      return TILEDB_BK_OK;
+    rc = load_missing_attributes(fs, to_load);
+  }
+
+  // The tile offsets loaded now are charged to the cache, outside of
+  // attribute_mtx_ as memory_size() takes it
+  BookKeepingCache::instance().recharge(fragment_name_, this);
+  return rc;
+}
+
 void BookKeeping::set_last_tile_cell_num(int64_t cell_num) {
   last_tile_cell_num_ = cell_num;
 }
@@ -435,6 +601,239 @@ void BookKeeping::set_last_tile_cell_num(int64_t cell_num) {
 /*        PRIVATE METHODS         */
 /* ****************************** */
 
+int BookKeeping::load_missing_attributes(StorageFS *fs, const std::vector<int>& to_load) {
+  // Version 2 files are read by section, the compressed book-keeping is
+  // decompressed again and read at the indexed offsets
+  if(v2_data_ != NULL)
+    return load_attribute_sections(fs, to_load);
+
+  // The first read decompresses the whole file into the buffer
+  PosixFS posix_fs;
+  open_buffer(fs, &posix_fs);
+  size_t domain_size;
+  if(buffer_->read_buffer(&domain_size, sizeof(size_t)) == TILEDB_BF_ERR) {
+    BK_ERROR("Cannot load book-keeping; Reading domain size failed");
+    return TILEDB_BK_ERR;
+  }
+  if(load_attribute_sections(fs, to_load) != TILEDB_BK_OK)
+    return TILEDB_BK_ERR;
+  buffer_->finalize();
+  delete buffer_;
+  buffer_ = 0;
+
+  // Success
+  return TILEDB_BK_OK;
+}
+
+void BookKeeping::add_lazy_memory_size(size_t size) const {
+  lazy_memory_size_ += size;
+  BookKeepingCache::instance().recharge(fragment_name_, this);
+}
+
+template<class T>
+void BookKeeping::compute_mbrs_bounds() const {
+  // For easy reference
+  int dim_num = array_schema_->dim_num();
+  TileRecordsView mbrs = this->mbrs();
+  int64_t mbr_num = mbrs.size();
+  if(mbr_num == 0)
+    return;
+
+  const T* mbr = static_cast<const T*>(mbrs.data());
+  mbrs_bounds_.resize(2*array_schema_->coords_size());
+  T* bounds = reinterpret_cast<T*>(mbrs_bounds_.data());
+  std::copy(mbr, mbr + 2*dim_num, bounds);
+  for(int64_t i=1; i<mbr_num; ++i) {
+    mbr += 2*dim_num;
+    for(int j=0; j<dim_num; ++j) {
+      bounds[2*j] = std::min(bounds[2*j], mbr[2*j]);
+      bounds[2*j+1] = std::max(bounds[2*j+1], mbr[2*j+1]);
+    }
+  }
+}
+
+/* FORMAT:
+ * header (bk_v2_header_t)
+ * section_#1_offset(int64_t) section_#1_length(int64_t) ...
+ * section_#1 section_#2 ...
+ * Sections are raw arrays starting at offsets aligned to BK_V2_ALIGNMENT.
+ */
+int BookKeeping::finalize_v2(StorageFS *fs) {
+  // For easy reference
+  int attribute_num = array_schema_->attribute_num();
+  size_t domain_size = (non_empty_domain_ == NULL) 
+                           ? 0 
+                           : array_schema_->coords_size() * 2;
+  int64_t cell_num_per_tile = 
+      dense_ ? array_schema_->cell_num_per_tile() :
+               array_schema_->capacity();
+
+  // Collect the sections in file order
+  std::vector<std::pair<const void*, size_t>> sections;
+  sections.emplace_back(non_empty_domain_, domain_size);
+  sections.emplace_back(mbrs_.data(), mbrs_.size());
+  sections.emplace_back(bounding_coords_.data(), bounding_coords_.size());
+  for(int i=0; i<attribute_num+1; ++i)
+    sections.emplace_back(tile_offsets_[i].data(), tile_offsets_[i].size()*sizeof(off_t));
+  for(int i=0; i<attribute_num; ++i)
+    sections.emplace_back(tile_var_offsets_[i].data(), tile_var_offsets_[i].size()*sizeof(off_t));
+  for(int i=0; i<attribute_num; ++i)
+    sections.emplace_back(tile_var_sizes_[i].data(), tile_var_sizes_[i].size()*sizeof(size_t));
+
+  // Header, handling a zero last tile cell number like flush_last_tile_cell_num()
+  bk_v2_header_t header;
+  memset(&header, 0, sizeof(bk_v2_header_t));
+  memcpy(header.magic_, TILEDB_BK_V2_MAGIC, sizeof(TILEDB_BK_V2_MAGIC));
+  header.version_ = 2;
+  header.attribute_num_ = attribute_num;
+  header.coords_size_ = array_schema_->coords_size();
+  header.last_tile_cell_num_ = (last_tile_cell_num_ == 0) ? cell_num_per_tile : last_tile_cell_num_;
+  header.section_num_ = sections.size();
+
+  // Lay out the sections after the section table
+  std::vector<int64_t> section_table;
+  size_t offset = sizeof(bk_v2_header_t) + 2*sections.size()*sizeof(int64_t);
+  for(auto const& section : sections) {
+    offset = ((offset + BK_V2_ALIGNMENT - 1) / BK_V2_ALIGNMENT) * BK_V2_ALIGNMENT;
+    section_table.push_back(offset);
+    section_table.push_back(section.second);
+    offset += section.second;
+  }
+
+  // Serialize
+  std::vector<char> contents(offset, 0);
+  memcpy(contents.data(), &header, sizeof(bk_v2_header_t));
+  memcpy(contents.data() + sizeof(bk_v2_header_t), section_table.data(), section_table.size()*sizeof(int64_t));
+  for(size_t i=0; i<sections.size(); ++i) {
+    if(sections[i].second != 0)
+      memcpy(contents.data() + section_table[2*i], sections[i].first, sections[i].second);
+  }
+
+  std::string filename = StorageFS::append_paths(fragment_name_, std::string(TILEDB_BOOK_KEEPING_FILENAME)
+                                                 + TILEDB_FILE_SUFFIX);
+  if(write_to_file(fs, filename, contents.data(), contents.size()) != TILEDB_UT_OK ||
+     close_file(fs, filename) != TILEDB_UT_OK) {
+    tiledb_bk_errmsg = tiledb_ut_errmsg;
+    return TILEDB_BK_ERR;
+  }
+
+  // Success
+  return TILEDB_BK_OK;
+}
+
+int BookKeeping::load_v2(StorageFS *fs, const std::string& filename) {
+  // For easy reference
+  int attribute_num = array_schema_->attribute_num();
+  size_t coords_size = array_schema_->coords_size();
+  int64_t section_num = BK_V2_TILE_OFFSETS + 3*attribute_num + 1;
+
+  ssize_t file_size = fs->file_size(filename);
+  if(file_size < (ssize_t)sizeof(bk_v2_header_t)) {
+    BK_ERROR("Cannot load book-keeping; Truncated version 2 file");
+    return TILEDB_BK_ERR;
+  }
+  v2_size_ = file_size;
+
+  // Map the file from local filesystems, the pages of a section are only read
+  // when the section is accessed. Other filesystems read the header and the
+  // section table here, the attribute sections are read when loaded.
+  size_t table_size = sizeof(bk_v2_header_t) + 2*section_num*sizeof(int64_t);
+  if(dynamic_cast<PosixFS *>(fs) != nullptr) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if(fd == -1) {
+      BK_ERROR("Cannot load book-keeping; File opening error");
+      return TILEDB_BK_ERR;
+    }
+    void* addr = mmap(NULL, v2_size_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(addr == MAP_FAILED) {
+      BK_ERROR("Cannot load book-keeping; Memory map error");
+      return TILEDB_BK_ERR;
+    }
+    v2_data_ = static_cast<const char*>(addr);
+    v2_mapped_ = true;
+  } else {
+    v2_buffer_.resize(std::min(table_size, v2_size_));
+    if(read_from_file(fs, filename, 0, v2_buffer_.data(), v2_buffer_.size()) != TILEDB_UT_OK) {
+      v2_buffer_.clear();
+      tiledb_bk_errmsg = tiledb_ut_errmsg;
+      return TILEDB_BK_ERR;
+    }
+    v2_data_ = v2_buffer_.data();
+  }
+
+  // Check the header against the array schema
+  const bk_v2_header_t* header = reinterpret_cast<const bk_v2_header_t*>(v2_data_);
+  if(memcmp(header->magic_, TILEDB_BK_V2_MAGIC, sizeof(TILEDB_BK_V2_MAGIC)) ||
+     header->version_ != 2 ||
+     header->attribute_num_ != attribute_num ||
+     header->coords_size_ != (int64_t)coords_size ||
+     header->section_num_ != section_num ||
+     table_size > v2_size_) {
+    BK_ERROR("Cannot load book-keeping; Invalid version 2 file header");
+    return TILEDB_BK_ERR;
+  }
+
+  // Check that the sections are aligned arrays within the file
+  const int64_t* section_table = reinterpret_cast<const int64_t*>(v2_data_ + sizeof(bk_v2_header_t));
+  for(int64_t i=0; i<section_num; ++i) {
+    int64_t offset = section_table[2*i];
+    int64_t length = section_table[2*i+1];
+    size_t element_size = sizeof(off_t);
+    if(i == BK_V2_NON_EMPTY_DOMAIN || i == BK_V2_MBRS || i == BK_V2_BOUNDING_COORDS)
+      element_size = 2*coords_size;
+    else if(i >= BK_V2_TILE_OFFSETS + 2*attribute_num + 1)
+      element_size = sizeof(size_t);
+    if(offset < 0 || length < 0 || offset % BK_V2_ALIGNMENT != 0 ||
+       (size_t)(offset + length) > v2_size_ || length % element_size != 0) {
+      BK_ERROR("Cannot load book-keeping; Invalid version 2 file section");
+      return TILEDB_BK_ERR;
+    }
+    sections_[i] = std::make_pair(offset, length);
+  }
+  if(sections_[BK_V2_NON_EMPTY_DOMAIN].second > (int64_t)(2*coords_size) ||
+     sections_[BK_V2_MBRS].second != sections_[BK_V2_BOUNDING_COORDS].second) {
+    BK_ERROR("Cannot load book-keeping; Invalid version 2 file section");
+    return TILEDB_BK_ERR;
+  }
+
+  last_tile_cell_num_ = header->last_tile_cell_num_;
+
+  // The non-empty domain, the MBRs and the bounding coordinates are needed
+  // by every read and are read right away
+  if(!v2_mapped_) {
+    size_t prefix_size = table_size;
+    for(int i=BK_V2_NON_EMPTY_DOMAIN; i<=BK_V2_BOUNDING_COORDS; ++i)
+      prefix_size = std::max(prefix_size, (size_t)(sections_[i].first + sections_[i].second));
+    if(prefix_size > table_size) {
+      v2_buffer_.resize(prefix_size);
+      if(read_from_file(fs, filename, table_size, v2_buffer_.data() + table_size,
+                        prefix_size - table_size) != TILEDB_UT_OK) {
+        v2_buffer_.clear();
+        v2_data_ = NULL;
+        tiledb_bk_errmsg = tiledb_ut_errmsg;
+        return TILEDB_BK_ERR;
+      }
+      v2_data_ = v2_buffer_.data();
+    }
+  } else {
+    attribute_loaded_.assign(attribute_num+1, true);
+  }
+
+  // The non-empty and expanded domains are small, keep copies like load_non_empty_domain()
+  size_t domain_size = sections_[BK_V2_NON_EMPTY_DOMAIN].second;
+  if(domain_size != 0) {
+    non_empty_domain_ = malloc(domain_size);
+    memcpy(non_empty_domain_, v2_section(BK_V2_NON_EMPTY_DOMAIN), domain_size);
+    domain_ = malloc(domain_size);
+    memcpy(domain_, non_empty_domain_, domain_size);
+    array_schema_->expand_domain(domain_);
+  }
+
+  // Success
+  return TILEDB_BK_OK;
+}
+
 /* FORMAT:
  * bounding_coords_num(int64_t)
  * bounding_coords_#1(void*) bounding_coords_#2(void*) ...
@@ -442,7 +841,7 @@ void BookKeeping::set_last_tile_cell_num(int64_t cell_num) {
 int BookKeeping::flush_bounding_coords() {
   // For easy reference
   size_t bounding_coords_size = 2*array_schema_->coords_size();
-  int64_t bounding_coords_num = bounding_coords_.size();
+  int64_t bounding_coords_num = bounding_coords_.size()/bounding_coords_size;
 
   // Write number of bounding coordinates
   if(buffer_->append_buffer(&bounding_coords_num, sizeof(int64_t)) == TILEDB_BF_ERR) {
@@ -451,11 +850,10 @@ int BookKeeping::flush_bounding_coords() {
   }
 
   // Write bounding coordinates
-  for(int64_t i=0; i<bounding_coords_num; ++i) {
-    if(buffer_->append_buffer(bounding_coords_[i], bounding_coords_size) == TILEDB_BF_ERR) {
-      BK_ERROR( "Cannot finalize book-keeping; Writing bounding coordinates failed");
-      return TILEDB_BK_ERR;
-    }
+  if(bounding_coords_num != 0 &&
+     buffer_->append_buffer(bounding_coords_.data(), bounding_coords_.size()) == TILEDB_BF_ERR) {
+    BK_ERROR( "Cannot finalize book-keeping; Writing bounding coordinates failed");
+    return TILEDB_BK_ERR;
   }
 
   // Success
@@ -491,7 +889,7 @@ int BookKeeping::flush_last_tile_cell_num() {
 int BookKeeping::flush_mbrs() {
   // For easy reference
   size_t mbr_size = 2*array_schema_->coords_size();
-  int64_t mbr_num = mbrs_.size();
+  int64_t mbr_num = mbrs_.size()/mbr_size;
 
   // Write number of MBRs
   if(buffer_->append_buffer(&mbr_num, sizeof(int64_t)) == TILEDB_BF_ERR) {
@@ -500,12 +898,10 @@ int BookKeeping::flush_mbrs() {
   }
 
   // Write MBRs
-  for(int64_t i=0; i<mbr_num; ++i) {
-    if(buffer_->append_buffer(mbrs_[i], mbr_size) == TILEDB_BF_ERR) {
-      BK_ERROR( "Cannot finalize book-keeping; Writing MBR failed");
-      return TILEDB_BK_ERR;
-    }
-  } 
+  if(mbr_num != 0 && buffer_->append_buffer(mbrs_.data(), mbrs_.size()) == TILEDB_BF_ERR) {
+    BK_ERROR( "Cannot finalize book-keeping; Writing MBR failed");
+    return TILEDB_BK_ERR;
+  }
 
   // Success
   return TILEDB_BK_OK;
@@ -661,31 +1057,14 @@ int BookKeeping::load_bounding_coords() {
   }
 
   // Get bounding coordinates
-  void* bounding_coords;
-  bounding_coords_.resize(bounding_coords_num);
-  for(int64_t i=0; i<bounding_coords_num; ++i) {
-    bounding_coords = malloc(bounding_coords_size);
-    if(buffer_->read_buffer(bounding_coords, bounding_coords_size) == TILEDB_BF_ERR) {
-      free(bounding_coords);
-      BK_ERROR("Cannot load book-keeping; Reading bounding coordinates failed");
-      return TILEDB_BK_ERR;
-    }
-    bounding_coords_[i] = bounding_coords;
-  }
-
-  // Success
-  return TILEDB_BK_OK;
-}
-
-/* FORMAT:
- * last_tile_cell_num (int64_t)  
- */
-int BookKeeping::load_last_tile_cell_num() {
-  // Get last tile cell number
-  if(buffer_->read_buffer(&last_tile_cell_num_, sizeof(int64_t)) == TILEDB_BF_ERR) {
-    BK_ERROR("Cannot load book-keeping; Reading last tile cell number failed");
+  bounding_coords_.resize(bounding_coords_num*bounding_coords_size);
+  if(buffer_->read_buffer(bounding_coords_.data(), bounding_coords_.size()) == TILEDB_BF_ERR) {
+    BK_ERROR("Cannot load book-keeping; Reading bounding coordinates failed");
     return TILEDB_BK_ERR;
   }
+  sections_[BK_V2_BOUNDING_COORDS] = std::make_pair(
+      sections_[BK_V2_MBRS].first + sections_[BK_V2_MBRS].second + sizeof(int64_t),
+      bounding_coords_.size());
 
   // Success
   return TILEDB_BK_OK;
@@ -707,17 +1086,14 @@ int BookKeeping::load_mbrs() {
   }
 
   // Get MBRs
-  void* mbr;
-  mbrs_.resize(mbr_num);
-  for(int64_t i=0; i<mbr_num; ++i) {
-    mbr = malloc(mbr_size);
-    if(buffer_->read_buffer(mbr, mbr_size) == TILEDB_BF_ERR) {
-      free(mbr);
-      BK_ERROR( "Cannot load book-keeping; Reading MBR failed");
-      return TILEDB_BK_ERR;
-    }
-    mbrs_[i] = mbr;
+  mbrs_.resize(mbr_num*mbr_size);
+  if(buffer_->read_buffer(mbrs_.data(), mbrs_.size()) == TILEDB_BF_ERR) {
+    BK_ERROR( "Cannot load book-keeping; Reading MBR failed");
+    return TILEDB_BK_ERR;
   }
+  sections_[BK_V2_MBRS] = std::make_pair(
+      sections_[BK_V2_NON_EMPTY_DOMAIN].first + sections_[BK_V2_NON_EMPTY_DOMAIN].second + sizeof(int64_t),
+      mbrs_.size());
 
   // Success
   return TILEDB_BK_OK;
@@ -734,6 +1110,8 @@ int BookKeeping::load_non_empty_domain() {
     return TILEDB_BK_ERR;
   }
 
+  sections_[BK_V2_NON_EMPTY_DOMAIN] = std::make_pair(sizeof(size_t), domain_size);
+
   // Get non-empty domain
   if(domain_size == 0) {
     non_empty_domain_ = NULL;
@@ -766,112 +1144,114 @@ int BookKeeping::load_non_empty_domain() {
  * tile_offsets_attr#<attribute_num>_num (int64_t)
  * tile_offsets_attr#<attribute_num>_#1 (off_t) 
  * tile_offsets_attr#<attribute_num>_#2 (off_t) ...
- */
-int BookKeeping::load_tile_offsets() {
-  // For easy reference
-  int attribute_num = array_schema_->attribute_num();
-  int64_t tile_offsets_num;
-
-  // Allocate tile offsets
-  tile_offsets_.resize(attribute_num+1);
-
-  // For all attributes, get the tile offsets
-  for(int i=0; i<attribute_num+1; ++i) {
-    // Get number of tile offsets
-    if(buffer_->read_buffer(&tile_offsets_num, sizeof(int64_t)) == TILEDB_BF_ERR) {
-      BK_ERROR("Cannot load book-keeping; Reading number of tile offsets failed");
-      return TILEDB_BK_ERR;
-    }
- 
-    if(tile_offsets_num == 0)
-      continue;
-
-    // Get tile offsets
-    tile_offsets_[i].resize(tile_offsets_num);
-    if(buffer_->read_buffer(&tile_offsets_[i][0], tile_offsets_num * sizeof(off_t)) == TILEDB_BF_ERR) { 
-      BK_ERROR("Cannot load book-keeping; Reading tile offsets failed");
-      return TILEDB_BK_ERR;
-    }
-  }
-
-  // Success
-  return TILEDB_BK_OK;
-}
-
-/* FORMAT:
  * tile_var_offsets_attr#0_num (int64_t)
  * tile_var_offsets_attr#0_#1 (off_t) tile_var_offsets_attr#0_#2 (off_t) ...
  * ...
  * tile_var_offsets_attr#<attribute_num-1>_num(int64_t)
  * tile_var_offsets_attr#<attribute_num-1>_#1 (off_t)
  *     tile_ver_offsets_attr#<attribute_num-1>_#2 (off_t) ...
+ * tile_var_sizes_attr#0_num (int64_t)
+ * tile_var_sizes_attr#0_#1 (size_t) tile_sizes_attr#0_#2 (size_t) ...
+ * ...
+ * tile_var_sizes_attr#<attribute_num-1>_num( int64_t)
+ * tile_var_sizes__attr#<attribute_num-1>_#1 (size_t) 
+ *     tile_var_sizes_attr#<attribute_num-1>_#2 (size_t) ...
+ * last_tile_cell_num (int64_t)
  */
-int BookKeeping::load_tile_var_offsets() {
+int BookKeeping::index_sections() {
   // For easy reference
   int attribute_num = array_schema_->attribute_num();
-  int64_t tile_var_offsets_num;
-
-  // Allocate tile offsets
-  tile_var_offsets_.resize(attribute_num);
-
-  // For all attributes, get the variable tile offsets
-  for(int i=0; i<attribute_num; ++i) {
-    // Get number of tile offsets
-    if(buffer_->read_buffer(&tile_var_offsets_num, sizeof(int64_t)) == TILEDB_BF_ERR) {
-      BK_ERROR("Cannot load book-keeping; Reading number of variable tile offsets failed");
+  int64_t section_num = BK_V2_TILE_OFFSETS + 3*attribute_num + 1;
+  off_t offset = sections_[BK_V2_BOUNDING_COORDS].first + sections_[BK_V2_BOUNDING_COORDS].second;
+
+  // Only the number of elements of each section is read, off_t and size_t
+  // elements are both 8 bytes
+  for(int64_t i=BK_V2_TILE_OFFSETS; i<section_num; ++i) {
+    int64_t num;
+    if(buffer_->read_buffer(offset, &num, sizeof(int64_t)) == TILEDB_BF_ERR || num < 0) {
+      if(i < BK_V2_TILE_OFFSETS + attribute_num + 1) {
+        BK_ERROR("Cannot load book-keeping; Reading number of tile offsets failed");
+      } else if(i < BK_V2_TILE_OFFSETS + 2*attribute_num + 1) {
+        BK_ERROR("Cannot load book-keeping; Reading number of variable tile offsets failed");
+      } else {
+        BK_ERROR("Cannot load book-keeping; Reading number of variable tile sizes failed");
+      }
       return TILEDB_BK_ERR;
     }
- 
-    if(tile_var_offsets_num == 0)
-      continue;
+    sections_[i] = std::make_pair(offset + sizeof(int64_t), num * sizeof(off_t));
+    offset += sizeof(int64_t) + num * sizeof(off_t);
+  }
 
-    // Get variable tile offsets
-    tile_var_offsets_[i].resize(tile_var_offsets_num);
-    if(buffer_->read_buffer(&tile_var_offsets_[i][0], tile_var_offsets_num * sizeof(off_t)) == TILEDB_BF_ERR) {
-      BK_ERROR("Cannot load book-keeping; Reading variable tile offsets failed");
-      return TILEDB_BK_ERR;
-    }
+  // Get last tile cell number
+  if(buffer_->read_buffer(offset, &last_tile_cell_num_, sizeof(int64_t)) == TILEDB_BF_ERR) {
+    BK_ERROR("Cannot load book-keeping; Reading last tile cell number failed");
+    return TILEDB_BK_ERR;
   }
 
   // Success
   return TILEDB_BK_OK;
 }
 
-/* FORMAT:
- * tile_var_sizes_attr#0_num (int64_t)
- * tile_var_sizes_attr#0_#1 (size_t) tile_sizes_attr#0_#2 (size_t) ...
- * ...
- * tile_var_sizes_attr#<attribute_num-1>_num( int64_t)
- * tile_var_sizes__attr#<attribute_num-1>_#1 (size_t) 
- *     tile_var_sizes_attr#<attribute_num-1>_#2 (size_t) ...
- */
-int BookKeeping::load_tile_var_sizes() {
+int BookKeeping::load_attribute_sections(StorageFS *fs, const std::vector<int>& attribute_ids) {
   // For easy reference
   int attribute_num = array_schema_->attribute_num();
-  int64_t tile_var_sizes_num;
-
-  // Allocate tile sizes
-  tile_var_sizes_.resize(attribute_num);
 
-  // For all attributes, get the variable tile sizes
-  for(int i=0; i<attribute_num; ++i) {
-    // Get number of tile sizes
-    if(buffer_->read_buffer(&tile_var_sizes_num, sizeof(int64_t)) == TILEDB_BF_ERR) {
-      BK_ERROR("Cannot load book-keeping; Reading number of variable tile sizes failed");
-      return TILEDB_BK_ERR;
-    }
- 
-    if(tile_var_sizes_num == 0)
+  // Size the tile offsets and sizes from the section index
+  std::vector<read_range_t> ranges;
+  auto add_range = [&](int section, void* buffer) {
+    if(sections_[section].second > 0)
+      ranges.push_back({sections_[section].first, buffer, (size_t)sections_[section].second});
+  };
+  for(auto attribute_id : attribute_ids) {
+    int section = BK_V2_TILE_OFFSETS + attribute_id;
+    tile_offsets_[attribute_id].resize(v2_section_num(section, sizeof(off_t)));
+    add_range(section, tile_offsets_[attribute_id].data());
+    if(attribute_id == attribute_num)
       continue;
 
-    // Get variable tile sizes
-    tile_var_sizes_[i].resize(tile_var_sizes_num);
-    if(buffer_->read_buffer(&tile_var_sizes_[i][0], tile_var_sizes_num * sizeof(size_t)) == TILEDB_BF_ERR) {
-      BK_ERROR("Cannot load book-keeping; Reading variable tile sizes failed");
+    section = BK_V2_TILE_OFFSETS + attribute_num + 1 + attribute_id;
+    tile_var_offsets_[attribute_id].resize(v2_section_num(section, sizeof(off_t)));
+    add_range(section, tile_var_offsets_[attribute_id].data());
+
+    section = BK_V2_TILE_OFFSETS + 2*attribute_num + 1 + attribute_id;
+    tile_var_sizes_[attribute_id].resize(v2_section_num(section, sizeof(size_t)));
+    add_range(section, tile_var_sizes_[attribute_id].data());
+  }
+
+  // Sections of version 2 files are read with one vectored read
+  if(buffer_ == NULL) {
+    std::string v2_filename = StorageFS::append_paths(fragment_name_, std::string(TILEDB_BOOK_KEEPING_FILENAME)
+                                                      + TILEDB_FILE_SUFFIX);
+    if(read_from_file_v(fs, v2_filename, ranges) != TILEDB_UT_OK) {
+      tiledb_bk_errmsg = tiledb_ut_errmsg;
       return TILEDB_BK_ERR;
     }
+  } else {
+    for(auto const& range : ranges) {
+      if(buffer_->read_buffer(range.offset, range.buffer, range.length) == TILEDB_BF_ERR) {
+        BK_ERROR("Cannot load book-keeping; Reading tile offsets failed");
+        return TILEDB_BK_ERR;
+      }
+    }
   }
 
+  for(auto attribute_id : attribute_ids)
+    attribute_loaded_[attribute_id] = true;
+
   // Success
   return TILEDB_BK_OK;
 }
+
+void BookKeeping::open_buffer(StorageFS *fs, PosixFS *posix_fs) {
+  // Cache the booking file in tmpdir for cloud paths
+  if (dynamic_cast<const StorageCloudFS *>(fs) != nullptr && is_env_set("TILEDB_CACHE")) {
+    std::string cached_filename = get_fragment_metadata_cache_dir() + get_filename_from_path(fragment_name_);
+    if (posix_fs->is_file(cached_filename)) {
+      buffer_ = new CompressedStorageBuffer(posix_fs, cached_filename, download_compressed_size_, /*is_read*/ true,
+                                            TILEDB_GZIP, TILEDB_COMPRESSION_LEVEL_GZIP);
+      return;
+    }
+  }
+  buffer_ = new CompressedStorageBuffer(fs, filename_, download_compressed_size_, /*is_read*/ true,
+                                        TILEDB_GZIP, TILEDB_COMPRESSION_LEVEL_GZIP);
+}
@@ -0,0 +1,151 @@
+/**
+ * @file   book_keeping_cache.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2026 Omics Data Automation, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file implements the BookKeepingCache class.
+ */
+
+#include "book_keeping_cache.h"
+
+#include <cstdlib>
+
+BookKeepingCache& BookKeepingCache::instance() {
+  static BookKeepingCache cache;
+  return cache;
+}
+
+BookKeepingCache::BookKeepingCache() {
+  auto max_size = getenv("TILEDB_BOOKKEEPING_CACHE_SIZE");
+  max_size_ = max_size ? std::stoull(max_size) : 0;
+}
+
+std::shared_ptr<BookKeeping> BookKeepingCache::get(const std::string& fragment_name) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  auto it = entries_.find(fragment_name);
+  if (it == entries_.end()) {
+    ++misses_;
+    return std::shared_ptr<BookKeeping>();
+  }
+  ++hits_;
+  lru_.splice(lru_.begin(), lru_, it->second.lru_it_);
+  return it->second.book_keeping_;
+}
+
+void BookKeepingCache::put(const std::string& fragment_name, const std::shared_ptr<BookKeeping>& book_keeping) {
+  size_t entry_size = book_keeping->memory_size();
+  std::lock_guard<std::mutex> lock(mtx_);
+  auto it = entries_.find(fragment_name);
+  if (it != entries_.end()) {
+    erase(it);
+  }
+  if (entry_size > max_size_) {
+    return;
+  }
+  lru_.push_front(fragment_name);
+  entries_[fragment_name] = { book_keeping, entry_size, lru_.begin() };
+  size_ += entry_size;
+  evict();
+}
+
+void BookKeepingCache::recharge(const std::string& fragment_name, const BookKeeping* book_keeping) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  auto it = entries_.find(fragment_name);
+  if (it == entries_.end() || it->second.book_keeping_.get() != book_keeping) {
+    return;
+  }
+  size_t entry_size = book_keeping->memory_size();
+  if (entry_size > max_size_) {
+    erase(it);
+    return;
+  }
+  size_ += entry_size - it->second.size_;
+  it->second.size_ = entry_size;
+  evict();
+}
+
+void BookKeepingCache::invalidate(const std::string& dir) {
+  if (dir.empty()) {
+    return;
+  }
+  std::string path = dir.back() == '/' ? dir.substr(0, dir.size()-1) : dir;
+  std::string prefix = path + "/";
+  std::lock_guard<std::mutex> lock(mtx_);
+  auto it = entries_.find(path);
+  if (it != entries_.end()) {
+    erase(it);
+  }
+  it = entries_.lower_bound(prefix);
+  while (it != entries_.end() && it->first.compare(0, prefix.size(), prefix) == 0) {
+    erase(it++);
+  }
+}
+
+void BookKeepingCache::clear() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  entries_.clear();
+  lru_.clear();
+  size_ = 0;
+}
+
+void BookKeepingCache::set_max_size(size_t max_size) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  max_size_ = max_size;
+  evict();
+}
+
+size_t BookKeepingCache::max_size() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return max_size_;
+}
+
+size_t BookKeepingCache::size() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return size_;
+}
+
+size_t BookKeepingCache::hits() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return hits_;
+}
+
+size_t BookKeepingCache::misses() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return misses_;
+}
+
+void BookKeepingCache::erase(std::map<std::string, cache_entry_t>::iterator it) {
+  size_ -= it->second.size_;
+  lru_.erase(it->second.lru_it_);
+  entries_.erase(it);
+}
+
+void BookKeepingCache::evict() {
+  while (size_ > max_size_ && !lru_.empty()) {
+    erase(entries_.find(lru_.back()));
+  }
+}
@@ -32,6 +32,7 @@
  */
 
 #include "fragment.h"
+#include "fragment_manifest.h"
 #include "tiledb_constants.h"
 #include "utils.h"
 #include <cassert>
@@ -60,7 +61,7 @@
 /*        GLOBAL VARIABLES        */
 /* ****************************** */
 
-std::string tiledb_fg_errmsg = "";
+thread_local std::string tiledb_fg_errmsg = "";
 
 
 
@@ -178,6 +179,14 @@ int Fragment::finalize() {
         tiledb_fg_errmsg = tiledb_ut_errmsg;
         return TILEDB_FG_ERR;
       }
+      // The fragment is committed at this point. Readers reconcile the manifest
+      // with the array directory, so a failed update is not a failed write.
+      if (FragmentManifest::add_fragment(fs, ::real_dir(fs, fragment_name_), dense_,
+                                         book_keeping_->non_empty_domain(),
+                                         2*array_->array_schema()->coords_size())) {
+        PRINT_ERROR("Fragment " + fragment_name_ + " committed without updating the fragment manifest; " +
+                    tiledb_fm_errmsg);
+      }
     }
 
     // Success
@@ -306,6 +315,23 @@ int Fragment::write(const void** buffers, const size_t* buffer_sizes) {
   return TILEDB_FG_OK;
 }
 
+int Fragment::write_attribute(
+    int attribute_id,
+    const void** buffers,
+    const size_t* buffer_sizes) {
+  // Forward the write command to the write state
+  int rc = write_state_->write_attribute(attribute_id, buffers, buffer_sizes);
+
+  // Error
+  if(rc != TILEDB_WS_OK) {
+    tiledb_fg_errmsg = tiledb_ws_errmsg;
+    return TILEDB_FG_ERR;
+  }
+
+  // Success
+  return TILEDB_FG_OK;
+}
+
 
 
 
@@ -0,0 +1,381 @@
+/**
+ * @file   fragment_manifest.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2026 Omics Data Automation, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file implements the FragmentManifest class.
+ */
+
+#include "error.h"
+#include "fragment_manifest.h"
+#include "tiledb_constants.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <set>
+#include <unistd.h>
+
+/* ****************************** */
+/*        GLOBAL VARIABLES        */
+/* ****************************** */
+
+thread_local std::string tiledb_fm_errmsg = "";
+
+std::mutex FragmentManifest::update_mtx_;
+
+/*
+ * The manifest file is laid out as follows
+ * magic(char[8]) fragment_num(int64_t)
+ * and then for each fragment
+ * name_size(int32_t) name(char*) timestamp(int64_t) dense(char)
+ * non_empty_domain_size(int64_t) non_empty_domain(char*)
+ */
+
+/** Returns the timestamp at the end of a fragment name, after the last '_'. */
+static int64_t fragment_timestamp(const std::string& name) {
+  long long int timestamp = 0;
+  for(size_t i=2; i<name.size(); ++i) {
+    if(name[i] == '_') {
+      sscanf(name.c_str()+i+1, "%lld", &timestamp);
+      break;
+    }
+  }
+  return timestamp;
+}
+
+
+
+
+/* ****************************** */
+/*   CONSTRUCTORS & DESTRUCTORS   */
+/* ****************************** */
+
+FragmentManifest::FragmentManifest(StorageFS* fs, const std::string& array_dir)
+    : array_dir_(array_dir), fs_(fs) {
+  filename_ = fs_->append_paths(array_dir_, TILEDB_FRAGMENT_MANIFEST_FILENAME);
+}
+
+
+
+
+/* ****************************** */
+/*           ACCESSORS            */
+/* ****************************** */
+
+const std::vector<FragmentManifest::entry_t>& FragmentManifest::entries() const {
+  return entries_;
+}
+
+
+
+
+/* ****************************** */
+/*            MUTATORS            */
+/* ****************************** */
+
+bool FragmentManifest::load() {
+  entries_.clear();
+  if(!is_file(fs_, filename_))
+    return false;
+
+  ssize_t size = file_size(fs_, filename_);
+  if(size < (ssize_t)(sizeof(TILEDB_FM_MAGIC) + sizeof(int64_t)))
+    return false;
+  // The manifest is replaced on every update, do not hold on to its descriptor
+  std::vector<char> buffer(size);
+  int rc = read_from_file(fs_, filename_, 0, buffer.data(), size);
+  close_file(fs_, filename_);
+  if(rc != TILEDB_UT_OK)
+    return false;
+  if(memcmp(buffer.data(), TILEDB_FM_MAGIC, sizeof(TILEDB_FM_MAGIC)))
+    return false;
+
+  // Reads the next value, failing on truncated files
+  size_t offset = sizeof(TILEDB_FM_MAGIC);
+  auto read = [&](void* value, size_t length) {
+    if(offset + length > buffer.size())
+      return false;
+    memcpy(value, buffer.data()+offset, length);
+    offset += length;
+    return true;
+  };
+
+  int64_t fragment_num;
+  if(!read(&fragment_num, sizeof(int64_t)) || fragment_num < 0)
+    return false;
+  for(int64_t i=0; i<fragment_num; ++i) {
+    entry_t entry;
+    int32_t name_size;
+    char dense;
+    int64_t domain_size;
+    if(!read(&name_size, sizeof(int32_t)) || name_size <= 0 || offset + name_size > buffer.size())
+      return false;
+    entry.name_.assign(buffer.data()+offset, name_size);
+    offset += name_size;
+    if(!read(&entry.timestamp_, sizeof(int64_t)) ||
+       !read(&dense, sizeof(char)) ||
+       !read(&domain_size, sizeof(int64_t)) ||
+       domain_size < 0 || offset + domain_size > buffer.size())
+      return false;
+    entry.dense_ = dense;
+    entry.non_empty_domain_.resize(domain_size);
+    read(entry.non_empty_domain_.data(), domain_size);
+    entries_.push_back(std::move(entry));
+  }
+
+  return offset == buffer.size();
+}
+
+void FragmentManifest::reconcile() {
+  std::vector<std::string> fragment_dirs = get_dirs(fs_, array_dir_);
+  std::set<std::string> names;
+  for(auto const& fragment_dir : fragment_dirs)
+    names.insert(fragment_dir.substr(parent_dir(fs_, fragment_dir).size() + 1));
+
+  // Drop the fragments whose directories are gone
+  entries_.erase(
+      std::remove_if(entries_.begin(), entries_.end(),
+                     [&names](const entry_t& e) { return names.find(e.name_) == names.end(); }),
+      entries_.end());
+
+  // Add the committed fragments missing from the manifest
+  std::set<std::string> entry_names;
+  for(auto const& entry : entries_)
+    entry_names.insert(entry.name_);
+  bool added = false;
+  for(auto const& fragment_dir : fragment_dirs) {
+    if(entry_names.find(fragment_dir.substr(parent_dir(fs_, fragment_dir).size() + 1)) != entry_names.end() ||
+       !is_fragment(fs_, fragment_dir))
+      continue;
+    entries_.push_back(scan_entry(fragment_dir));
+    added = true;
+  }
+  if(added)
+    std::stable_sort(entries_.begin(), entries_.end(),
+                     [](const entry_t& a, const entry_t& b) { return a.timestamp_ < b.timestamp_; });
+}
+
+int FragmentManifest::add_fragment(
+    StorageFS* fs,
+    const std::string& fragment_dir,
+    bool dense,
+    const void* non_empty_domain,
+    size_t domain_size) {
+  std::string array_dir = parent_dir(fs, fragment_dir);
+  // Most arrays have no manifest, do not lock their directories on every commit
+  if(!is_env_set("TILEDB_FRAGMENT_MANIFEST") &&
+     !is_file(fs, fs->append_paths(array_dir, TILEDB_FRAGMENT_MANIFEST_FILENAME)))
+    return TILEDB_FM_OK;
+
+  entry_t entry;
+  entry.name_ = fragment_dir.substr(array_dir.size() + 1);
+  entry.timestamp_ = fragment_timestamp(entry.name_);
+  entry.dense_ = dense;
+  if(non_empty_domain != NULL)
+    entry.non_empty_domain_.assign(
+        static_cast<const char*>(non_empty_domain),
+        static_cast<const char*>(non_empty_domain) + domain_size);
+
+  std::lock_guard<std::mutex> update_lock(update_mtx_);
+  int fd;
+  if(lock(fs, array_dir, fd) != TILEDB_FM_OK)
+    return TILEDB_FM_ERR;
+  FragmentManifest manifest(fs, array_dir);
+  if(manifest.load()) {
+    // Also recovers the entries lost by updates that failed or raced without a lock
+    manifest.reconcile();
+  } else if(is_env_set("TILEDB_FRAGMENT_MANIFEST")) {
+    // The new fragment is already committed and is found by the scan
+    manifest.scan();
+  } else {
+    unlock(fd);
+    return TILEDB_FM_OK;
+  }
+
+  std::vector<entry_t>& entries = manifest.entries_;
+  entries.erase(
+      std::remove_if(entries.begin(), entries.end(),
+                     [&entry](const entry_t& e) { return e.name_ == entry.name_; }),
+      entries.end());
+  entries.push_back(std::move(entry));
+
+  int rc = manifest.store();
+  unlock(fd);
+  return rc;
+}
+
+int FragmentManifest::remove_fragments(
+    StorageFS* fs,
+    const std::string& array_dir,
+    const std::vector<std::string>& fragment_dirs) {
+  if(!is_file(fs, fs->append_paths(array_dir, TILEDB_FRAGMENT_MANIFEST_FILENAME)))
+    return TILEDB_FM_OK;
+
+  std::lock_guard<std::mutex> update_lock(update_mtx_);
+  int fd;
+  if(lock(fs, array_dir, fd) != TILEDB_FM_OK)
+    return TILEDB_FM_ERR;
+  FragmentManifest manifest(fs, array_dir);
+  if(!manifest.load()) {
+    unlock(fd);
+    return TILEDB_FM_OK;
+  }
+
+  std::vector<std::string> names;
+  for(auto const& fragment_dir : fragment_dirs)
+    names.push_back(fragment_dir.substr(parent_dir(fs, fragment_dir).size() + 1));
+  std::vector<entry_t>& entries = manifest.entries_;
+  entries.erase(
+      std::remove_if(entries.begin(), entries.end(),
+                     [&names](const entry_t& e) {
+                       return std::find(names.begin(), names.end(), e.name_) != names.end();
+                     }),
+      entries.end());
+
+  int rc = manifest.store();
+  unlock(fd);
+  return rc;
+}
+
+int FragmentManifest::remove(StorageFS* fs, const std::string& array_dir) {
+  std::lock_guard<std::mutex> update_lock(update_mtx_);
+  std::string filename = fs->append_paths(array_dir, TILEDB_FRAGMENT_MANIFEST_FILENAME);
+  if(is_file(fs, filename) && delete_file(fs, filename) != TILEDB_UT_OK) {
+    tiledb_fm_errmsg = tiledb_ut_errmsg;
+    return TILEDB_FM_ERR;
+  }
+
+  return TILEDB_FM_OK;
+}
+
+
+
+
+/* ****************************** */
+/*         PRIVATE METHODS        */
+/* ****************************** */
+
+void FragmentManifest::scan() {
+  entries_.clear();
+  for(auto const& fragment_dir : get_fragment_dirs(fs_, array_dir_))
+    entries_.push_back(scan_entry(fragment_dir));
+  std::stable_sort(entries_.begin(), entries_.end(),
+                   [](const entry_t& a, const entry_t& b) { return a.timestamp_ < b.timestamp_; });
+}
+
+FragmentManifest::entry_t FragmentManifest::scan_entry(const std::string& fragment_dir) {
+  entry_t entry;
+  entry.name_ = fragment_dir.substr(parent_dir(fs_, fragment_dir).size() + 1);
+  entry.timestamp_ = fragment_timestamp(entry.name_);
+  entry.dense_ = !is_file(fs_, fs_->append_paths(fragment_dir, std::string(TILEDB_COORDS) + TILEDB_FILE_SUFFIX));
+  return entry;
+}
+
+int FragmentManifest::lock(StorageFS* fs, const std::string& array_dir, int& fd) {
+  fd = -1;
+  if(!fs->locking_support())
+    return TILEDB_FM_OK;
+
+  std::string filename = fs->append_paths(array_dir, TILEDB_FM_LOCK_FILENAME);
+  fd = ::open(filename.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+  if(fd == -1) {
+    std::string errmsg = "Cannot lock fragment manifest; Cannot open " + filename + "; " + strerror(errno);
+    PRINT_ERROR(errmsg);
+    tiledb_fm_errmsg = TILEDB_FM_ERRMSG + errmsg;
+    return TILEDB_FM_ERR;
+  }
+
+  struct flock fl;
+  memset(&fl, 0, sizeof(fl));
+  fl.l_type = F_WRLCK;
+  fl.l_whence = SEEK_SET;
+  while(fcntl(fd, F_SETLKW, &fl) == -1) {
+    if(errno == EINTR)
+      continue;
+    std::string errmsg = "Cannot lock fragment manifest; " + std::string(strerror(errno));
+    PRINT_ERROR(errmsg);
+    tiledb_fm_errmsg = TILEDB_FM_ERRMSG + errmsg;
+    ::close(fd);
+    fd = -1;
+    return TILEDB_FM_ERR;
+  }
+
+  return TILEDB_FM_OK;
+}
+
+void FragmentManifest::unlock(int fd) {
+  // Closing the descriptor releases the lock
+  if(fd != -1)
+    ::close(fd);
+}
+
+int FragmentManifest::store() {
+  // Serialize
+  std::vector<char> buffer(TILEDB_FM_MAGIC, TILEDB_FM_MAGIC + sizeof(TILEDB_FM_MAGIC));
+  auto write = [&buffer](const void* value, size_t length) {
+    buffer.insert(buffer.end(), static_cast<const char*>(value), static_cast<const char*>(value) + length);
+  };
+  int64_t fragment_num = entries_.size();
+  write(&fragment_num, sizeof(int64_t));
+  for(auto const& entry : entries_) {
+    int32_t name_size = entry.name_.size();
+    char dense = entry.dense_;
+    int64_t domain_size = entry.non_empty_domain_.size();
+    write(&name_size, sizeof(int32_t));
+    write(entry.name_.data(), name_size);
+    write(&entry.timestamp_, sizeof(int64_t));
+    write(&dense, sizeof(char));
+    write(&domain_size, sizeof(int64_t));
+    write(entry.non_empty_domain_.data(), domain_size);
+  }
+
+  // Readers see either the old or the new manifest where files can be renamed
+  // over, otherwise the manifest is missing for a moment and readers list the
+  // array directory instead
+  std::string filename = filename_;
+  if(fs_->locking_support())
+    filename += ".tmp." + std::to_string(getpid());
+  if(is_file(fs_, filename) && delete_file(fs_, filename) != TILEDB_UT_OK) {
+    tiledb_fm_errmsg = tiledb_ut_errmsg;
+    return TILEDB_FM_ERR;
+  }
+  if(write_to_file(fs_, filename, buffer.data(), buffer.size()) != TILEDB_UT_OK ||
+     close_file(fs_, filename) != TILEDB_UT_OK) {
+    tiledb_fm_errmsg = tiledb_ut_errmsg;
+    return TILEDB_FM_ERR;
+  }
+  if(filename != filename_ && move_path(fs_, filename, filename_) != TILEDB_UT_OK) {
+    tiledb_fm_errmsg = tiledb_ut_errmsg;
+    delete_file(fs_, filename);
+    return TILEDB_FM_ERR;
+  }
+
+  return TILEDB_FM_OK;
+}
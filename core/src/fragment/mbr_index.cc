@@ -0,0 +1,185 @@
+/**
+ * @file   mbr_index.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2026 Omics Data Automation, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file implements the MBRIndex class.
+ */
+
+#include "mbr_index.h"
+#include "tiledb_constants.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+MBRIndex::MBRIndex(int coords_type, int dim_num, const void* mbrs, int64_t mbr_num)
+    : dim_num_(dim_num), mbrs_(mbrs), mbr_num_(mbr_num) {
+  if(coords_type == TILEDB_INT32) {
+    build<int>();
+  } else if(coords_type == TILEDB_INT64) {
+    build<int64_t>();
+  } else if(coords_type == TILEDB_FLOAT32) {
+    build<float>();
+  } else if(coords_type == TILEDB_FLOAT64) {
+    build<double>();
+  } else {
+    // The code should never reach here
+    assert(0);
+  }
+}
+
+size_t MBRIndex::memory_size() const {
+  size_t size = sizeof(MBRIndex);
+  for(auto const& level : levels_)
+    size += level.capacity();
+  return size + level_node_num_.capacity()*sizeof(int64_t);
+}
+
+template<class T>
+void MBRIndex::query(
+    const T* subarray,
+    int64_t first,
+    int64_t last,
+    std::vector<int64_t>& tiles) const {
+  first = std::max(first, (int64_t)0);
+  last = std::min(last, mbr_num_-1);
+  if(first > last)
+    return;
+
+  // Start from the top level, each of its nodes spans fanout^levels tiles
+  int level = levels_.size() - 1;
+  int64_t span = 1;
+  for(size_t i=0; i<levels_.size(); ++i)
+    span *= TILEDB_MBR_INDEX_FANOUT;
+  int64_t node_num = (level < 0) ? mbr_num_ : level_node_num_[level];
+  query<T>(level, 0, node_num, span, subarray, first, last, tiles);
+}
+
+template<class T>
+bool MBRIndex::overlaps(const T* subarray) const {
+  const T* boxes = levels_.empty() ?
+      static_cast<const T*>(mbrs_) :
+      reinterpret_cast<const T*>(levels_.back().data());
+  int64_t box_num = levels_.empty() ? mbr_num_ : level_node_num_.back();
+
+  for(int64_t i=0; i<box_num; ++i) {
+    const T* box = &boxes[2*dim_num_*i];
+    bool overlap = true;
+    for(int d=0; d<dim_num_ && overlap; ++d)
+      overlap = box[2*d] <= subarray[2*d+1] && box[2*d+1] >= subarray[2*d];
+    if(overlap)
+      return true;
+  }
+
+  return false;
+}
+
+template<class T>
+void MBRIndex::build() {
+  // For easy reference
+  size_t box_size = 2*dim_num_*sizeof(T);
+
+  // Group the nodes of each level until the top level fits in one node
+  const T* children = static_cast<const T*>(mbrs_);
+  int64_t child_num = mbr_num_;
+  while(child_num > TILEDB_MBR_INDEX_FANOUT) {
+    int64_t node_num = (child_num + TILEDB_MBR_INDEX_FANOUT - 1) / TILEDB_MBR_INDEX_FANOUT;
+    std::vector<char> level(node_num*box_size);
+    T* nodes = reinterpret_cast<T*>(level.data());
+    for(int64_t i=0; i<node_num; ++i) {
+      T* node = &nodes[2*dim_num_*i];
+      int64_t child_begin = i*TILEDB_MBR_INDEX_FANOUT;
+      int64_t child_end = std::min(child_begin + TILEDB_MBR_INDEX_FANOUT, child_num);
+      memcpy(node, &children[2*dim_num_*child_begin], box_size);
+      for(int64_t j=child_begin+1; j<child_end; ++j) {
+        const T* child = &children[2*dim_num_*j];
+        for(int d=0; d<dim_num_; ++d) {
+          node[2*d] = std::min(node[2*d], child[2*d]);
+          node[2*d+1] = std::max(node[2*d+1], child[2*d+1]);
+        }
+      }
+    }
+    levels_.push_back(std::move(level));
+    level_node_num_.push_back(node_num);
+    children = reinterpret_cast<const T*>(levels_.back().data());
+    child_num = node_num;
+  }
+}
+
+template<class T>
+void MBRIndex::query(
+    int level,
+    int64_t begin,
+    int64_t end,
+    int64_t span,
+    const T* subarray,
+    int64_t first,
+    int64_t last,
+    std::vector<int64_t>& tiles) const {
+  const T* boxes = (level < 0) ?
+      static_cast<const T*>(mbrs_) :
+      reinterpret_cast<const T*>(levels_[level].data());
+  int64_t child_num = (level <= 0) ? mbr_num_ : level_node_num_[level-1];
+
+  for(int64_t i=begin; i<end; ++i) {
+    // Skip the nodes outside the tile range, the rest of the nodes follow it
+    if((i+1)*span <= first)
+      continue;
+    if(i*span > last)
+      break;
+
+    const T* box = &boxes[2*dim_num_*i];
+    bool overlap = true;
+    for(int d=0; d<dim_num_ && overlap; ++d)
+      overlap = box[2*d] <= subarray[2*d+1] && box[2*d+1] >= subarray[2*d];
+    if(!overlap)
+      continue;
+
+    if(level < 0) {
+      tiles.push_back(i);
+    } else {
+      int64_t child_begin = i*TILEDB_MBR_INDEX_FANOUT;
+      int64_t child_end = std::min(child_begin + TILEDB_MBR_INDEX_FANOUT, child_num);
+      query<T>(level-1, child_begin, child_end, span/TILEDB_MBR_INDEX_FANOUT, subarray, first, last, tiles);
+    }
+  }
+}
+
+// Explicit template instantiations
+template void MBRIndex::query<int>(
+    const int* subarray, int64_t first, int64_t last, std::vector<int64_t>& tiles) const;
+template void MBRIndex::query<int64_t>(
+    const int64_t* subarray, int64_t first, int64_t last, std::vector<int64_t>& tiles) const;
+template void MBRIndex::query<float>(
+    const float* subarray, int64_t first, int64_t last, std::vector<int64_t>& tiles) const;
+template void MBRIndex::query<double>(
+    const double* subarray, int64_t first, int64_t last, std::vector<int64_t>& tiles) const;
+template bool MBRIndex::overlaps<int>(const int* subarray) const;
+template bool MBRIndex::overlaps<int64_t>(const int64_t* subarray) const;
+template bool MBRIndex::overlaps<float>(const float* subarray) const;
+template bool MBRIndex::overlaps<double>(const double* subarray) const;
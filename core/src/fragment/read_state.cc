@@ -54,6 +54,12 @@
 #  define PRINT_ERROR(x) do { } while(0) 
 #endif
 
+/** Default bytes of compressed tiles gathered per read with TILEDB_IO_URING. */
+#define IO_URING_GATHER_SIZE 8*1024*1024
+
+/** Default minimum number of tiles in the search range to look up with the MBR index. */
+#define MBR_INDEX_MIN_TILES 1024
+
 
 
 
@@ -61,7 +67,7 @@
 /*        GLOBAL VARIABLES        */
 /* ****************************** */
 
-std::string tiledb_rs_errmsg = "";
+thread_local std::string tiledb_rs_errmsg = "";
 
 
 
@@ -86,14 +92,14 @@ ReadState::ReadState(
   last_tile_coords_ = NULL;
   map_addr_.resize(attribute_num_+2);
   map_addr_lengths_.resize(attribute_num_+2);
-  map_addr_compressed_ = NULL;
-  map_addr_compressed_length_ = 0;
+  map_addr_compressed_.resize(attribute_num_+2);
+  map_addr_compressed_lengths_.resize(attribute_num_+2);
   map_addr_var_.resize(attribute_num_);
   map_addr_var_lengths_.resize(attribute_num_);
   search_tile_overlap_subarray_ = malloc(2*coords_size_);
   search_tile_pos_ = -1;
-  tile_compressed_ = NULL;
-  tile_compressed_allocated_size_ = 0;
+  tile_compressed_.resize(attribute_num_+2);
+  tile_compressed_allocated_size_.resize(attribute_num_+2);
   tiles_.resize(attribute_num_+2);
   tiles_offsets_.resize(attribute_num_+2);
   tiles_file_offsets_.resize(attribute_num_+2);
@@ -103,7 +109,10 @@ ReadState::ReadState(
   tiles_var_file_offsets_.resize(attribute_num_);
   tiles_var_sizes_.resize(attribute_num_);
   tiles_var_allocated_size_.resize(attribute_num_);
+  cached_tiles_.resize(attribute_num_+2);
+  cached_tiles_var_.resize(attribute_num_);
   tmp_coords_ = malloc(coords_size_);
+  tmp_offset_.resize(attribute_num_);
 
   for(int i=0; i<attribute_num_; ++i) {
     map_addr_var_[i] = NULL;
@@ -123,6 +132,10 @@ ReadState::ReadState(
     map_addr_[i] = NULL;
     map_addr_lengths_[i] = 0;
     tiles_[i] = NULL;
+    map_addr_compressed_[i] = NULL;
+    map_addr_compressed_lengths_[i] = 0;
+    tile_compressed_[i] = NULL;
+    tile_compressed_allocated_size_[i] = 0;
     tiles_offsets_[i] = 0;
     tiles_file_offsets_[i] = 0;
     tiles_sizes_[i] = 0;
@@ -142,8 +155,31 @@ ReadState::ReadState(
   // Setup file buffers for buffered reading per attribute+coords
   file_buffer_.resize(attribute_num_+1);
   file_var_buffer_.resize(attribute_num_+1);
+  gathered_tiles_.resize(attribute_num_+1);
+  gathered_var_tiles_.resize(attribute_num_+1);
   reset_file_buffers();
 
+  // Overlapping tiles of sparse fragments are optionally gathered with vectored reads,
+  // always gathered with io_uring to batch the tile reads
+  gather_size_ = 0;
+  auto gather_size = getenv("TILEDB_READ_GATHER_SIZE");
+  if (!fragment_->dense()) {
+    if (gather_size) {
+      gather_size_ = std::stoull(gather_size);
+    } else if (array_->config()->read_method() == TILEDB_IO_URING) {
+      gather_size_ = IO_URING_GATHER_SIZE;
+    }
+  }
+  overlapping_tiles_computed_ = false;
+  mbr_index_min_tiles_ = MBR_INDEX_MIN_TILES;
+  auto mbr_index_min_tiles = getenv("TILEDB_MBR_INDEX_MIN_TILES");
+  if (mbr_index_min_tiles) {
+    mbr_index_min_tiles_ = std::stoll(mbr_index_min_tiles);
+  }
+
+  // Decompressed tiles are shared through the process-wide cache if it is enabled
+  use_tile_cache_ = TileCache::instance().max_size() > 0;
+
   // Get compression for tiles per attribute+coords+search_tile from schema
   codec_.resize(attribute_num_+2);
   for(int i=0; i<attribute_num_+2; ++i) {
@@ -178,18 +214,22 @@ ReadState::~ReadState() {
   if(last_tile_coords_ != NULL)
     free(last_tile_coords_);
 
+  // Tiles pinned from the tile cache are released with cached_tiles_
   for(int i=0; i<int(tiles_.size()); ++i) {
-    if(map_addr_[i] == NULL && tiles_[i] != NULL)
+    if(map_addr_[i] == NULL && tiles_[i] != NULL && !cached_tiles_[i])
       free(tiles_[i]);
   }
 
   for(int i=0; i<int(tiles_var_.size()); ++i) {
-    if(map_addr_var_[i] == NULL && tiles_var_[i] != NULL)
+    if(map_addr_var_[i] == NULL && tiles_var_[i] != NULL && 
+       !cached_tiles_var_[i])
       free(tiles_var_[i]);
   }
 
-  if(map_addr_compressed_ == NULL && tile_compressed_ != NULL)
-    free(tile_compressed_);
+  for(int i=0; i<int(tile_compressed_.size()); ++i) {
+    if(map_addr_compressed_[i] == NULL && tile_compressed_[i] != NULL)
+      free(tile_compressed_[i]);
+  }
 
   for(int i=0; i<int(map_addr_.size()); ++i) {
     if(map_addr_[i] != NULL && munmap(map_addr_[i], map_addr_lengths_[i])) {
@@ -210,11 +250,14 @@ ReadState::~ReadState() {
     }
   }
 
-  if(map_addr_compressed_ != NULL &&  
-     munmap(map_addr_compressed_, map_addr_compressed_length_)) {
-    std::string errmsg = "Problem in finalizing ReadState; Memory unmap error";
-    PRINT_ERROR(errmsg);
-    tiledb_rs_errmsg = TILEDB_RS_ERRMSG + errmsg;
+  for(int i=0; i<int(map_addr_compressed_.size()); ++i) {
+    if(map_addr_compressed_[i] != NULL &&  
+       munmap(map_addr_compressed_[i], map_addr_compressed_lengths_[i])) {
+      std::string errmsg = 
+          "Problem in finalizing ReadState; Memory unmap error";
+      PRINT_ERROR(errmsg);
+      tiledb_rs_errmsg = TILEDB_RS_ERRMSG + errmsg;
+    }
   }
 
   if(search_tile_overlap_subarray_ != NULL)
@@ -292,6 +335,7 @@ void ReadState::reset() {
   done_ = false;
   search_tile_pos_ = -1;
   compute_tile_search_range();
+  overlapping_tiles_computed_ = false;
 
   for(int i=0; i<attribute_num_+2; ++i)
     tiles_offsets_[i] = 0;
@@ -305,6 +349,11 @@ void ReadState::reset_overflow() {
     overflow_[i] = false;
 }
 
+void ReadState::prepare_gathered_reads() {
+  if(gather_size_ > 0 && !overlapping_tiles_computed_)
+    compute_overlapping_tiles();
+}
+
 
 
 
@@ -1033,35 +1082,32 @@ void ReadState::get_next_overlapping_tile_sparse() {
     return;
 
   // For easy reference
-  const std::vector<void*>& mbrs = book_keeping_->mbrs();
+  TileRecordsView mbrs = book_keeping_->mbrs();
   const T* subarray = static_cast<const T*>(array_->subarray());
 
-  // Update the search tile position
-  if(search_tile_pos_ == -1)
-     search_tile_pos_ = tile_search_range_[0];
-  else
-    ++search_tile_pos_;
+  // The overlapping tiles are looked up once per subarray
+  if(!overlapping_tiles_computed_)
+    compute_overlapping_tiles<T>();
 
   // Find the position to the next overlapping tile with the query range
-  for(;;) {
-    // No overlap - exit
-    if(search_tile_pos_ > tile_search_range_[1]) {
-      done_ = true;
-      return;
-    }
-
+  auto it = (search_tile_pos_ == -1) ?
+      overlapping_tiles_.begin() :
+      std::upper_bound(overlapping_tiles_.begin(), overlapping_tiles_.end(), search_tile_pos_);
+  for(; it != overlapping_tiles_.end(); ++it) {
+    search_tile_pos_ = *it;
     const T* mbr = static_cast<const T*>(mbrs[search_tile_pos_]);
     search_tile_overlap_ = 
         array_schema_->subarray_overlap(
             subarray,
             mbr, 
             static_cast<T*>(search_tile_overlap_subarray_));
-
-    if(!search_tile_overlap_)
-      ++search_tile_pos_;
-    else
+    if(search_tile_overlap_)
       return;
   }
+
+  // No overlap - exit
+  search_tile_pos_ = tile_search_range_[1] + 1;
+  done_ = true;
 }
 
 template<class T> 
@@ -1073,7 +1119,7 @@ void ReadState::get_next_overlapping_tile_sparse(
 
   // For easy reference
   int dim_num = array_schema_->dim_num();
-  const std::vector<void*>& mbrs = book_keeping_->mbrs();
+  TileRecordsView mbrs = book_keeping_->mbrs();
   const T* subarray = static_cast<const T*>(array_->subarray());
 
   // Compute the tile subarray
@@ -1199,6 +1245,8 @@ void ReadState::reset_file_buffers() {
       delete file_var_buffer_[i];
       file_var_buffer_[i] = NULL;
     }
+    gathered_tiles_[i] = gathered_tiles_t();
+    gathered_var_tiles_[i] = gathered_tiles_t();
 
     StorageFS *fs = array_->config()->get_filesystem();
     close_file(fs, construct_filename(i, true));
@@ -1252,7 +1300,7 @@ int ReadState::read_segment(int attribute_num, bool is_var, off_t offset, void *
   MPI_Comm* mpi_comm = array_->config()->mpi_comm();
 #endif
 
-  if(read_method == TILEDB_IO_READ || read_method == TILEDB_IO_MMAP) {
+  if(read_method == TILEDB_IO_READ || read_method == TILEDB_IO_MMAP || read_method == TILEDB_IO_URING) {
     rc = read_from_file(fs, filename, offset, segment, length);
   } else if(read_method == TILEDB_IO_MPI) {
 #ifdef HAVE_MPI
@@ -1275,6 +1323,141 @@ int ReadState::read_segment(int attribute_num, bool is_var, off_t offset, void *
   return rc;
 }
 
+int ReadState::read_tile_gathered(int attribute_id, bool is_var, off_t offset, void *tile, size_t tile_size) {
+  gathered_tiles_t& gathered = is_var ? gathered_var_tiles_[attribute_id] : gathered_tiles_[attribute_id];
+  auto search = gathered.tiles_.find(offset);
+  if (search == gathered.tiles_.end()) {
+    if (gather_tiles(attribute_id, is_var, offset) == TILEDB_RS_ERR) {
+      return TILEDB_RS_ERR;
+    }
+    search = gathered.tiles_.find(offset);
+  }
+
+  // Tiles not at a tile boundary are read directly
+  if (search == gathered.tiles_.end() || search->second.second != tile_size) {
+    return read_segment(attribute_id, is_var, offset, tile, tile_size);
+  }
+
+  memcpy(tile, gathered.data_.data() + search->second.first, tile_size);
+  return TILEDB_RS_OK;
+}
+
+int ReadState::gather_tiles(int attribute_id, bool is_var, off_t offset) {
+  // For easy reference
+  TileValuesView<off_t> tile_offsets = is_var ?
+      book_keeping_->tile_var_offsets(attribute_id) : book_keeping_->tile_offsets(attribute_id);
+  size_t file_size = is_var ? file_var_size_[attribute_id] : file_size_[attribute_id];
+  int64_t tile_num = tile_offsets.size();
+
+  if(!overlapping_tiles_computed_)
+    compute_overlapping_tiles();
+
+  // Find the tile starting at offset, empty tiles share their offset with the next tile
+  auto it = std::upper_bound(tile_offsets.begin(), tile_offsets.end(), offset);
+  if (it == tile_offsets.begin() || *(it-1) != offset) {
+    return TILEDB_RS_OK;
+  }
+  int64_t tile_i = it - tile_offsets.begin() - 1;
+
+  // Collect the tile and the following overlapping tiles
+  std::vector<int64_t> tiles = { tile_i };
+  for (auto pos = std::upper_bound(overlapping_tiles_.begin(), overlapping_tiles_.end(), tile_i);
+       pos != overlapping_tiles_.end(); ++pos) {
+    tiles.push_back(*pos);
+  }
+
+  gathered_tiles_t& gathered = is_var ? gathered_var_tiles_[attribute_id] : gathered_tiles_[attribute_id];
+  gathered.tiles_.clear();
+  size_t gathered_size = 0;
+  for (auto i : tiles) {
+    size_t tile_size = (i == tile_num-1) ? file_size - tile_offsets[i] : tile_offsets[i+1] - tile_offsets[i];
+    if (tile_size == 0) {
+      continue;
+    }
+    if (gathered_size > 0 && gathered_size + tile_size > gather_size_) {
+      break;
+    }
+    gathered.tiles_[tile_offsets[i]] = std::make_pair(gathered_size, tile_size);
+    gathered_size += tile_size;
+  }
+
+  gathered.data_.resize(gathered_size);
+  std::vector<read_range_t> ranges;
+  for (auto& tile : gathered.tiles_) {
+    ranges.push_back({tile.first, gathered.data_.data() + tile.second.first, tile.second.second});
+  }
+
+  StorageFS *fs = array_->config()->get_filesystem();
+  std::string filename = construct_filename(attribute_id, is_var);
+  if (read_from_file_v(fs, filename, ranges) == TILEDB_UT_ERR) {
+    gathered = gathered_tiles_t();
+    std::string errmsg = "Cannot read tiles from attribute file " + filename;
+    PRINT_ERROR(errmsg);
+    tiledb_rs_errmsg = TILEDB_RS_ERRMSG + errmsg;
+    return TILEDB_RS_ERR;
+  }
+
+  return TILEDB_RS_OK;
+}
+
+void ReadState::compute_overlapping_tiles() {
+  // For easy reference
+  int coords_type = array_schema_->coords_type();
+
+  // Invoke the proper templated function
+  if(coords_type == TILEDB_INT32) {
+    compute_overlapping_tiles<int>();
+  } else if(coords_type == TILEDB_INT64) {
+    compute_overlapping_tiles<int64_t>();
+  } else if(coords_type == TILEDB_FLOAT32) {
+    compute_overlapping_tiles<float>();
+  } else if(coords_type == TILEDB_FLOAT64) {
+    compute_overlapping_tiles<double>();
+  } else {
+    // The code should never reach here
+    assert(0);
+  }
+}
+
+template<class T>
+void ReadState::compute_overlapping_tiles() {
+  // For easy reference
+  int dim_num = array_schema_->dim_num();
+  int64_t mbr_num = book_keeping_->tile_num();
+  const T* subarray = static_cast<const T*>(array_->subarray());
+
+  overlapping_tiles_.clear();
+  if(tile_search_range_[0] != -1 && tile_search_range_[1] != -1) {
+    int64_t first = tile_search_range_[0];
+    int64_t num = tile_search_range_[1] - first + 1;
+
+    // Large search ranges, e.g. for narrow subarrays across the cell order
+    // or for Hilbert cell order, are looked up in the R-tree over the MBRs
+    if(num >= mbr_index_min_tiles_) {
+      book_keeping_->mbr_index()->query<T>(subarray, first, tile_search_range_[1], overlapping_tiles_);
+      overlapping_tiles_computed_ = true;
+      return;
+    }
+
+    // The MBRs are scanned one dimension at a time, over contiguous bounds
+    const T* mbrs = static_cast<const T*>(book_keeping_->mbrs_dim_major());
+    std::vector<char> overlap(num, 1);
+    for(int i=0; i<dim_num; ++i) {
+      const T* mbr_lo = mbrs + 2*i*mbr_num + first;
+      const T* mbr_hi = mbrs + (2*i+1)*mbr_num + first;
+      T subarray_lo = subarray[2*i];
+      T subarray_hi = subarray[2*i+1];
+      for(int64_t j=0; j<num; ++j)
+        overlap[j] &= (mbr_lo[j] <= subarray_hi) & (mbr_hi[j] >= subarray_lo);
+    }
+    for(int64_t j=0; j<num; ++j) {
+      if(overlap[j])
+        overlapping_tiles_.push_back(first+j);
+    }
+  }
+  overlapping_tiles_computed_ = true;
+}
+
 int ReadState::CMP_COORDS_TO_SEARCH_TILE(
     const void* buffer,
     size_t tile_offset) {
@@ -1441,7 +1624,7 @@ void ReadState::compute_tile_search_range_col_or_row() {
   int dim_num = array_schema_->dim_num();
   const T* subarray = static_cast<const T*>(array_->subarray());
   int64_t tile_num = book_keeping_->tile_num();
-  const std::vector<void*>& bounding_coords = 
+  TileRecordsView bounding_coords = 
       book_keeping_->bounding_coords();
 
   // Calculate subarray coordinates
@@ -1546,7 +1729,7 @@ void ReadState::compute_tile_search_range_hil() {
 
   if(is_unary_subarray(subarray, dim_num)) {  // Unary range
     // For easy reference
-    const std::vector<void*>& bounding_coords = 
+    TileRecordsView bounding_coords = 
         book_keeping_->bounding_coords();
 
     // Calculate range coordinates
@@ -1781,12 +1964,12 @@ int ReadState::GET_CELL_PTR_FROM_OFFSET_TILE(
   }
 
   // Read attribute
-  if (read_segment(attribute_id, false, tiles_file_offsets_[attribute_id] + i*sizeof(size_t), &tmp_offset_, sizeof(size_t)) == TILEDB_RS_ERR) {
+  if (read_segment(attribute_id, false, tiles_file_offsets_[attribute_id] + i*sizeof(size_t), &tmp_offset_[attribute_id], sizeof(size_t)) == TILEDB_RS_ERR) {
     return TILEDB_RS_ERR;
   }
 
   // Get coordinates pointer
-  offset = tiles_file_offsets_[attribute_id] + &tmp_offset_;
+  offset = tiles_file_offsets_[attribute_id] + &tmp_offset_[attribute_id];
 
   // Success
   return TILEDB_RS_OK;
@@ -1810,8 +1993,10 @@ int ReadState::map_tile_from_file_cmp(
       (attribute_id == attribute_num_+1) ? attribute_num_ : attribute_id;
 
   // Unmap
-  if(map_addr_compressed_ != NULL) {
-    if(munmap(map_addr_compressed_, map_addr_compressed_length_)) {
+  if(map_addr_compressed_[attribute_id] != NULL) {
+    if(munmap(
+           map_addr_compressed_[attribute_id],
+           map_addr_compressed_lengths_[attribute_id])) {
       std::string errmsg = 
           "Cannot read tile from file with map; Memory unmap error";
       PRINT_ERROR(errmsg);
@@ -1835,10 +2020,12 @@ int ReadState::map_tile_from_file_cmp(
   // Open file
   int fd = open(filename.c_str(), O_RDONLY);
   if(fd == -1) {
-    munmap(map_addr_compressed_, map_addr_compressed_length_);
-    map_addr_compressed_ = NULL;
-    map_addr_compressed_length_ = 0;
-    tile_compressed_ = NULL;
+    munmap(
+        map_addr_compressed_[attribute_id],
+        map_addr_compressed_lengths_[attribute_id]);
+    map_addr_compressed_[attribute_id] = NULL;
+    map_addr_compressed_lengths_[attribute_id] = 0;
+    tile_compressed_[attribute_id] = NULL;
     std::string errmsg = "Cannot read tile from file; File opening error";
     PRINT_ERROR(errmsg);
     tiledb_rs_errmsg = TILEDB_RS_ERRMSG + errmsg;
@@ -1846,34 +2033,36 @@ int ReadState::map_tile_from_file_cmp(
   }
 
   // Map
-  map_addr_compressed_ = mmap(
-                             map_addr_compressed_, 
+  map_addr_compressed_[attribute_id] = mmap(
+                             map_addr_compressed_[attribute_id], 
                              new_length, 
                              PROT_READ, 
                              MAP_SHARED, 
                              fd, 
                              start_offset);
-  if(map_addr_compressed_ == MAP_FAILED) {
-    map_addr_compressed_ = NULL;
-    map_addr_compressed_length_ = 0;
-    tile_compressed_ = NULL;
+  if(map_addr_compressed_[attribute_id] == MAP_FAILED) {
+    map_addr_compressed_[attribute_id] = NULL;
+    map_addr_compressed_lengths_[attribute_id] = 0;
+    tile_compressed_[attribute_id] = NULL;
     std::string errmsg = "Cannot read tile from file; Memory map error";
     PRINT_ERROR(errmsg);
     tiledb_rs_errmsg = TILEDB_RS_ERRMSG + errmsg;
     return TILEDB_RS_ERR;
   }
-  map_addr_compressed_length_ = new_length;
+  map_addr_compressed_lengths_[attribute_id] = new_length;
 
   // Set properly the compressed tile pointer
-  tile_compressed_ = 
-      static_cast<char*>(map_addr_compressed_) + extra_offset;
+  tile_compressed_[attribute_id] = 
+      static_cast<char*>(map_addr_compressed_[attribute_id]) + extra_offset;
 
   // Close file
   if(close(fd)) {
-    munmap(map_addr_compressed_, map_addr_compressed_length_);
-    map_addr_compressed_ = NULL;
-    map_addr_compressed_length_ = 0;
-    tile_compressed_ = NULL;
+    munmap(
+        map_addr_compressed_[attribute_id],
+        map_addr_compressed_lengths_[attribute_id]);
+    map_addr_compressed_[attribute_id] = NULL;
+    map_addr_compressed_lengths_[attribute_id] = 0;
+    tile_compressed_[attribute_id] = NULL;
     std::string errmsg = "Cannot read tile from file; File closing error";
     PRINT_ERROR(errmsg);
     tiledb_rs_errmsg = TILEDB_RS_ERRMSG + errmsg;
@@ -1888,8 +2077,10 @@ int ReadState::map_tile_from_file_var_cmp(
     off_t offset,
     size_t tile_size) {
   // Unmap
-  if(map_addr_compressed_ != NULL) {
-    if(munmap(map_addr_compressed_, map_addr_compressed_length_)) {
+  if(map_addr_compressed_[attribute_id] != NULL) {
+    if(munmap(
+           map_addr_compressed_[attribute_id],
+           map_addr_compressed_lengths_[attribute_id])) {
       std::string errmsg = 
           "Cannot read tile from file with map; Memory unmap error";
       PRINT_ERROR(errmsg);
@@ -1913,10 +2104,12 @@ int ReadState::map_tile_from_file_var_cmp(
   // Open file
   int fd = open(filename.c_str(), O_RDONLY);
   if(fd == -1) {
-    munmap(map_addr_compressed_, map_addr_compressed_length_);
-    map_addr_compressed_ = NULL;
-    map_addr_compressed_length_ = 0;
-    tile_compressed_ = NULL;
+    munmap(
+        map_addr_compressed_[attribute_id],
+        map_addr_compressed_lengths_[attribute_id]);
+    map_addr_compressed_[attribute_id] = NULL;
+    map_addr_compressed_lengths_[attribute_id] = 0;
+    tile_compressed_[attribute_id] = NULL;
     std::string errmsg = "Cannot read tile from file; File opening error";
     PRINT_ERROR(errmsg);
     tiledb_rs_errmsg = TILEDB_RS_ERRMSG + errmsg;
@@ -1927,17 +2120,17 @@ int ReadState::map_tile_from_file_var_cmp(
   // new_length could be 0 for variable length fields, mmap will fail
   // if new_length == 0
   if(new_length > 0u) {
-    map_addr_compressed_ = mmap(
-        map_addr_compressed_, 
+    map_addr_compressed_[attribute_id] = mmap(
+        map_addr_compressed_[attribute_id], 
         new_length, 
         PROT_READ, 
         MAP_SHARED, 
         fd, 
         start_offset);
-    if(map_addr_compressed_ == MAP_FAILED) {
-      map_addr_compressed_ = NULL;
-      map_addr_compressed_length_ = 0;
-      tile_compressed_ = NULL;
+    if(map_addr_compressed_[attribute_id] == MAP_FAILED) {
+      map_addr_compressed_[attribute_id] = NULL;
+      map_addr_compressed_lengths_[attribute_id] = 0;
+      tile_compressed_[attribute_id] = NULL;
       std::string errmsg = "Cannot read tile from file; Memory map error";
       PRINT_ERROR(errmsg);
       tiledb_rs_errmsg = TILEDB_RS_ERRMSG + errmsg;
@@ -1946,18 +2139,20 @@ int ReadState::map_tile_from_file_var_cmp(
   } else {
     map_addr_var_[attribute_id] = 0;
   }
-  map_addr_compressed_length_ = new_length;
+  map_addr_compressed_lengths_[attribute_id] = new_length;
 
   // Set properly the compressed tile pointer
-  tile_compressed_ = 
-      static_cast<char*>(map_addr_compressed_) + extra_offset;
+  tile_compressed_[attribute_id] = 
+      static_cast<char*>(map_addr_compressed_[attribute_id]) + extra_offset;
 
   // Close file
   if(close(fd)) {
-    munmap(map_addr_compressed_, map_addr_compressed_length_);
-    map_addr_compressed_ = NULL;
-    map_addr_compressed_length_ = 0;
-    tile_compressed_ = NULL;
+    munmap(
+        map_addr_compressed_[attribute_id],
+        map_addr_compressed_lengths_[attribute_id]);
+    map_addr_compressed_[attribute_id] = NULL;
+    map_addr_compressed_lengths_[attribute_id] = 0;
+    tile_compressed_[attribute_id] = NULL;
     std::string errmsg = "Cannot read tile from file; File closing error";
     PRINT_ERROR(errmsg);
     tiledb_rs_errmsg = TILEDB_RS_ERRMSG + errmsg;
@@ -2154,12 +2349,12 @@ int ReadState::mpi_io_read_tile_from_file_cmp(
       (attribute_id == attribute_num_+1) ? attribute_num_ : attribute_id;
 
   // Potentially allocate compressed tile buffer
-  if(tile_compressed_ == NULL) {
+  if(tile_compressed_[attribute_id] == NULL) {
     size_t full_tile_size = fragment_->tile_size(attribute_id_real);
     size_t tile_max_size = 
         full_tile_size + 6 + 5*(ceil(full_tile_size/16834.0));
-    tile_compressed_ = malloc(tile_max_size); 
-    tile_compressed_allocated_size_ = tile_max_size;
+    tile_compressed_[attribute_id] = malloc(tile_max_size); 
+    tile_compressed_allocated_size_[attribute_id] = tile_max_size;
   }
 
   // Prepare attribute file name
@@ -2173,7 +2368,7 @@ int ReadState::mpi_io_read_tile_from_file_cmp(
          mpi_comm, 
          filename, 
          offset, 
-         tile_compressed_, 
+         tile_compressed_[attribute_id], 
          tile_size) != TILEDB_UT_OK) {
     tiledb_rs_errmsg = tiledb_ut_errmsg;
     return TILEDB_RS_ERR;
@@ -2191,15 +2386,15 @@ int ReadState::mpi_io_read_tile_from_file_var_cmp(
   const MPI_Comm* mpi_comm = array_->config()->mpi_comm();
 
   // Potentially allocate compressed tile buffer
-  if(tile_compressed_ == NULL) {
-    tile_compressed_ = malloc(tile_size); 
-    tile_compressed_allocated_size_ = tile_size;
+  if(tile_compressed_[attribute_id] == NULL) {
+    tile_compressed_[attribute_id] = malloc(tile_size); 
+    tile_compressed_allocated_size_[attribute_id] = tile_size;
   }
 
   // Potentially expand compressed tile buffer
-  if(tile_compressed_allocated_size_ < tile_size) {
-    tile_compressed_ = realloc(tile_compressed_, tile_size); 
-    tile_compressed_allocated_size_ = tile_size;
+  if(tile_compressed_allocated_size_[attribute_id] < tile_size) {
+    tile_compressed_[attribute_id] = realloc(tile_compressed_[attribute_id], tile_size); 
+    tile_compressed_allocated_size_[attribute_id] = tile_size;
   }
 
   // Prepare attribute file name
@@ -2213,7 +2408,7 @@ int ReadState::mpi_io_read_tile_from_file_var_cmp(
          mpi_comm,
          filename, 
          offset, 
-         tile_compressed_, 
+         tile_compressed_[attribute_id], 
          tile_size) != TILEDB_UT_OK) {
     tiledb_rs_errmsg = tiledb_ut_errmsg;
     return TILEDB_RS_ERR;
@@ -2224,6 +2419,74 @@ int ReadState::mpi_io_read_tile_from_file_var_cmp(
 }
 #endif
 
+bool ReadState::get_cached_tile(
+    int attribute_id,
+    int64_t tile_i,
+    bool var) {
+  // The search tile shares the cached tiles of the coordinates
+  int attribute_id_real = 
+      (attribute_id == attribute_num_+1) ? attribute_num_ : attribute_id;
+
+  std::shared_ptr<TileCache::Tile> tile = TileCache::instance().get(
+      fragment_->fragment_name(), attribute_id_real, tile_i, var);
+  if(!tile)
+    return false;
+
+  // Pin the cached tile in place of the buffer owned by the read state
+  release_cached_tile(attribute_id, var);
+  if(var) {
+    if(tiles_var_[attribute_id] != NULL)
+      free(tiles_var_[attribute_id]);
+    tiles_var_[attribute_id] = tile->data();
+    tiles_var_allocated_size_[attribute_id] = 0;
+    cached_tiles_var_[attribute_id] = tile;
+  } else {
+    if(tiles_[attribute_id] != NULL)
+      free(tiles_[attribute_id]);
+    tiles_[attribute_id] = tile->data();
+    cached_tiles_[attribute_id] = tile;
+  }
+
+  return true;
+}
+
+void ReadState::put_cached_tile(
+    int attribute_id,
+    int64_t tile_i,
+    bool var,
+    size_t size) {
+  // The search tile shares the cached tiles of the coordinates
+  int attribute_id_real = 
+      (attribute_id == attribute_num_+1) ? attribute_num_ : attribute_id;
+
+  // The cache owns the tile buffer from now on, which stays pinned until the
+  // next tile is prepared for the attribute
+  std::shared_ptr<TileCache::Tile> tile;
+  if(var) {
+    tile = std::make_shared<TileCache::Tile>(tiles_var_[attribute_id], size);
+    tiles_var_allocated_size_[attribute_id] = 0;
+    cached_tiles_var_[attribute_id] = tile;
+  } else {
+    tile = std::make_shared<TileCache::Tile>(tiles_[attribute_id], size);
+    cached_tiles_[attribute_id] = tile;
+  }
+  TileCache::instance().put(
+      fragment_->fragment_name(), attribute_id_real, tile_i, var, tile);
+}
+
+void ReadState::release_cached_tile(int attribute_id, bool var) {
+  if(var) {
+    if(cached_tiles_var_[attribute_id]) {
+      tiles_var_[attribute_id] = NULL;
+      tiles_var_allocated_size_[attribute_id] = 0;
+      cached_tiles_var_[attribute_id].reset();
+    }
+  } else if(cached_tiles_[attribute_id]) {
+    tiles_[attribute_id] = NULL;
+    cached_tiles_[attribute_id].reset();
+  }
+}
+
 int ReadState::prepare_tile_for_reading(
     int attribute_id, 
     int64_t tile_i) {
@@ -2267,28 +2530,40 @@ int ReadState::prepare_tile_for_reading_cmp(
   size_t full_tile_size = fragment_->tile_size(attribute_id_real);
   int64_t cell_num = book_keeping_->cell_num(tile_i);  
   size_t tile_size = cell_num * cell_size; 
-  const std::vector<std::vector<off_t> >& tile_offsets = 
-      book_keeping_->tile_offsets(); 
+  TileValuesView<off_t> tile_offsets = 
+      book_keeping_->tile_offsets(attribute_id_real); 
   int64_t tile_num = book_keeping_->tile_num();
 
+  // Use the decompressed tile from the tile cache if present
+  if(use_tile_cache_) {
+    if(get_cached_tile(attribute_id, tile_i, false)) {
+      tiles_sizes_[attribute_id] = tile_size;
+      tiles_offsets_[attribute_id] = 0;
+      fetched_tile_[attribute_id] = tile_i;
+      return TILEDB_RS_OK;
+    }
+    release_cached_tile(attribute_id, false);
+  }
+
   // Allocate space for the tile if needed
   if(tiles_[attribute_id] == NULL) 
     tiles_[attribute_id] = malloc(full_tile_size);
 
   // Find file offset where the tile begins
-  off_t file_offset = tile_offsets[attribute_id_real][tile_i];
+  off_t file_offset = tile_offsets[tile_i];
   auto file_size = file_size_[attribute_id_real];
   assert(file_size != TILEDB_FS_ERR);
   size_t tile_compressed_size = 
       (tile_i == tile_num-1) 
-          ? file_size - tile_offsets[attribute_id_real][tile_i] 
-          : tile_offsets[attribute_id_real][tile_i+1] - 
-            tile_offsets[attribute_id_real][tile_i];
+          ? file_size - tile_offsets[tile_i] 
+          : tile_offsets[tile_i+1] - 
+            tile_offsets[tile_i];
 
   // Read tile from file
   int rc = TILEDB_RS_OK;
   int read_method = array_->config()->read_method();
-  if(read_method ==  TILEDB_IO_READ) {
+  if(read_method ==  TILEDB_IO_READ ||
+     read_method == TILEDB_IO_URING) {
     rc = read_tile_from_file_cmp(
          attribute_id, 
          file_offset, 
@@ -2321,11 +2596,15 @@ int ReadState::prepare_tile_for_reading_cmp(
   // Decompress tile
   if(decompress_tile(
          attribute_id, 
-         static_cast<unsigned char*>(tile_compressed_), 
+         static_cast<unsigned char*>(tile_compressed_[attribute_id]), 
          tile_compressed_size, 
          static_cast<unsigned char*>(tiles_[attribute_id]),
          full_tile_size) != TILEDB_RS_OK)
     return TILEDB_RS_ERR;
+
+  // Share the decompressed tile
+  if(use_tile_cache_)
+    put_cached_tile(attribute_id, tile_i, false, full_tile_size);
          
   // Set the tile size
   tiles_sizes_[attribute_id] = tile_size;
@@ -2365,7 +2644,8 @@ int ReadState::prepare_tile_for_reading_cmp_none(
   int rc = TILEDB_RS_OK;
   int read_method = array_->config()->read_method();
   if(read_method ==  TILEDB_IO_READ || 
-     read_method == TILEDB_IO_MPI)
+     read_method == TILEDB_IO_MPI ||
+     read_method == TILEDB_IO_URING)
     rc = set_tile_file_offset(
          attribute_id, 
          file_offset);
@@ -2409,22 +2689,38 @@ int ReadState::prepare_tile_for_reading_var_cmp(
   size_t full_tile_size = fragment_->tile_size(attribute_id);
   int64_t cell_num = book_keeping_->cell_num(tile_i); 
   size_t tile_size = cell_num * cell_size;
-  const std::vector<std::vector<off_t> >& tile_offsets = 
-      book_keeping_->tile_offsets(); 
-  const std::vector<std::vector<off_t> >& tile_var_offsets = 
-      book_keeping_->tile_var_offsets(); 
+  TileValuesView<off_t> tile_offsets = 
+      book_keeping_->tile_offsets(attribute_id); 
+  TileValuesView<off_t> tile_var_offsets = 
+      book_keeping_->tile_var_offsets(attribute_id); 
   int64_t tile_num = book_keeping_->tile_num();
 
+  // Use the decompressed tiles from the tile cache if both are present
+  if(use_tile_cache_) {
+    size_t tile_var_size = book_keeping_->tile_var_sizes(attribute_id)[tile_i];
+    if(get_cached_tile(attribute_id, tile_i, false) &&
+       (tile_var_size == 0u || get_cached_tile(attribute_id, tile_i, true))) {
+      tiles_sizes_[attribute_id] = tile_size;
+      tiles_offsets_[attribute_id] = 0;
+      tiles_var_sizes_[attribute_id] = tile_var_size;
+      tiles_var_offsets_[attribute_id] = 0;
+      fetched_tile_[attribute_id] = tile_i;
+      return TILEDB_RS_OK;
+    }
+    release_cached_tile(attribute_id, false);
+    release_cached_tile(attribute_id, true);
+  }
+
   // ========== Get tile with variable cell offsets ========== //
 
   // Find file offset where the tile begins
-  off_t file_offset = tile_offsets[attribute_id][tile_i];
+  off_t file_offset = tile_offsets[tile_i];
   auto file_size = file_size_[attribute_id];
   assert(file_size != TILEDB_FS_ERR);
   size_t tile_compressed_size = 
-      (tile_i == tile_num-1) ? file_size - tile_offsets[attribute_id][tile_i]
-                             : tile_offsets[attribute_id][tile_i+1] - 
-                               tile_offsets[attribute_id][tile_i];
+      (tile_i == tile_num-1) ? file_size - tile_offsets[tile_i]
+                             : tile_offsets[tile_i+1] - 
+                               tile_offsets[tile_i];
 
   // Allocate space for the tile if needed
   if(tiles_[attribute_id] == NULL) 
@@ -2433,7 +2729,8 @@ int ReadState::prepare_tile_for_reading_var_cmp(
   // Read tile from file
   int rc = TILEDB_RS_OK;
   int read_method = array_->config()->read_method();
-  if(read_method ==  TILEDB_IO_READ) {
+  if(read_method ==  TILEDB_IO_READ ||
+     read_method == TILEDB_IO_URING) {
     rc = read_tile_from_file_cmp(
          attribute_id, 
          file_offset, 
@@ -2466,7 +2763,7 @@ int ReadState::prepare_tile_for_reading_var_cmp(
   // Decompress tile
   if(decompress_tile(
          attribute_id, 
-         static_cast<unsigned char*>(tile_compressed_), 
+         static_cast<unsigned char*>(tile_compressed_[attribute_id]), 
          tile_compressed_size, 
          static_cast<unsigned char*>(tiles_[attribute_id]),
          tile_size,
@@ -2482,16 +2779,16 @@ int ReadState::prepare_tile_for_reading_var_cmp(
   // ========== Get variable tile ========== //
 
   // Calculate offset and compressed tile size
-  file_offset = tile_var_offsets[attribute_id][tile_i];
+  file_offset = tile_var_offsets[tile_i];
   file_size = file_var_size_[attribute_id];
   assert(file_size != TILEDB_FS_ERR);
   tile_compressed_size = 
-      (tile_i == tile_num-1) ? file_size-tile_var_offsets[attribute_id][tile_i]
-                          : tile_var_offsets[attribute_id][tile_i+1] - 
-                            tile_var_offsets[attribute_id][tile_i];
+      (tile_i == tile_num-1) ? file_size-tile_var_offsets[tile_i]
+                          : tile_var_offsets[tile_i+1] - 
+                            tile_var_offsets[tile_i];
 
   // Get size of decompressed tile
-  size_t tile_var_size = book_keeping_->tile_var_sizes()[attribute_id][tile_i];
+  size_t tile_var_size = book_keeping_->tile_var_sizes(attribute_id)[tile_i];
 
   //Non-empty tile, decompress
   if(tile_var_size > 0u) {
@@ -2511,7 +2808,8 @@ int ReadState::prepare_tile_for_reading_var_cmp(
     // Read tile from file
     int rc = TILEDB_RS_OK;
     int read_method = array_->config()->read_method();
-    if(read_method ==  TILEDB_IO_READ) {
+    if(read_method ==  TILEDB_IO_READ ||
+       read_method == TILEDB_IO_URING) {
       rc = read_tile_from_file_var_cmp(
                attribute_id, 
                file_offset, 
@@ -2544,7 +2842,7 @@ int ReadState::prepare_tile_for_reading_var_cmp(
     // Decompress tile
     if(decompress_tile(
            attribute_id, 
-           static_cast<unsigned char*>(tile_compressed_), 
+           static_cast<unsigned char*>(tile_compressed_[attribute_id]), 
            tile_compressed_size, 
            static_cast<unsigned char*>(tiles_var_[attribute_id]),
            tile_var_size) != TILEDB_RS_OK)
@@ -2560,6 +2858,14 @@ int ReadState::prepare_tile_for_reading_var_cmp(
   // Shift variable cell offsets
   shift_var_offsets(attribute_id);
 
+  // Share the decompressed tiles, the offsets are cached already shifted
+  if(use_tile_cache_) {
+    put_cached_tile(attribute_id, tile_i, false, full_tile_size);
+    if(tile_var_size > 0u)
+      put_cached_tile(
+          attribute_id, tile_i, true, tiles_var_allocated_size_[attribute_id]);
+  }
+
   // Mark as fetched
   fetched_tile_[attribute_id] = tile_i;
 
@@ -2590,7 +2896,8 @@ int ReadState::prepare_tile_for_reading_var_cmp_none(
   int rc = TILEDB_RS_OK;
   int read_method = array_->config()->read_method();
   if(read_method ==  TILEDB_IO_READ || 
-     read_method == TILEDB_IO_MPI)
+     read_method == TILEDB_IO_MPI ||
+     read_method == TILEDB_IO_URING)
     rc = set_tile_file_offset(
          attribute_id, 
          file_offset);
@@ -2633,7 +2940,8 @@ int ReadState::prepare_tile_for_reading_var_cmp_none(
 
   // Read tile from file
   if(read_method ==  TILEDB_IO_READ || 
-     read_method == TILEDB_IO_MPI)
+     read_method == TILEDB_IO_MPI ||
+     read_method == TILEDB_IO_URING)
     rc = set_tile_var_file_offset(
          attribute_id, 
          start_tile_var_offset);
@@ -2708,19 +3016,21 @@ int ReadState::read_tile_from_file_cmp(
       (attribute_id == attribute_num_+1) ? attribute_num_ : attribute_id;
 
   // Potentially allocate compressed tile buffer
-  if(tile_compressed_ == NULL) {
-    tile_compressed_ = malloc(tile_size); 
-    tile_compressed_allocated_size_ = tile_size;
+  if(tile_compressed_[attribute_id] == NULL) {
+    tile_compressed_[attribute_id] = malloc(tile_size); 
+    tile_compressed_allocated_size_[attribute_id] = tile_size;
   }
 
   // Potentially expand compressed tile buffer
-  if(tile_compressed_allocated_size_ < tile_size) {
-    tile_compressed_ = realloc(tile_compressed_, tile_size); 
-    tile_compressed_allocated_size_ = tile_size;
+  if(tile_compressed_allocated_size_[attribute_id] < tile_size) {
+    tile_compressed_[attribute_id] = realloc(tile_compressed_[attribute_id], tile_size); 
+    tile_compressed_allocated_size_[attribute_id] = tile_size;
   }
 
-  // Read from file
-  return read_segment(attribute_id_real, false, offset, tile_compressed_, tile_size);
+  // Read from gathered tiles or from file
+  if(gather_size_ > 0)
+    return read_tile_gathered(attribute_id_real, false, offset, tile_compressed_[attribute_id], tile_size);
+  return read_segment(attribute_id_real, false, offset, tile_compressed_[attribute_id], tile_size);
 }
 
 int ReadState::read_tile_from_file_var_cmp(
@@ -2728,18 +3038,20 @@ int ReadState::read_tile_from_file_var_cmp(
     off_t offset,
     size_t tile_size) {
   // Potentially allocate compressed tile buffer
-  if(tile_compressed_ == NULL) {
-    tile_compressed_ = malloc(tile_size); 
-    tile_compressed_allocated_size_ = tile_size;
+  if(tile_compressed_[attribute_id] == NULL) {
+    tile_compressed_[attribute_id] = malloc(tile_size); 
+    tile_compressed_allocated_size_[attribute_id] = tile_size;
   }
 
   // Potentially expand compressed tile buffer
-  if(tile_compressed_allocated_size_ < tile_size) {
-    tile_compressed_ = realloc(tile_compressed_, tile_size); 
-    tile_compressed_allocated_size_ = tile_size;
+  if(tile_compressed_allocated_size_[attribute_id] < tile_size) {
+    tile_compressed_[attribute_id] = realloc(tile_compressed_[attribute_id], tile_size); 
+    tile_compressed_allocated_size_[attribute_id] = tile_size;
   }
 
-  return read_segment(attribute_id, true, offset, tile_compressed_, tile_size);
+  if(gather_size_ > 0)
+    return read_tile_gathered(attribute_id, true, offset, tile_compressed_[attribute_id], tile_size);
+  return read_segment(attribute_id, true, offset, tile_compressed_[attribute_id], tile_size);
 }
 
 int ReadState::set_tile_file_offset(
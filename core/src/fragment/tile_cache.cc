@@ -0,0 +1,162 @@
+/**
+ * @file   tile_cache.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2026 Omics Data Automation, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file implements the TileCache class.
+ */
+
+#include "tile_cache.h"
+
+#include <functional>
+#include <string>
+
+TileCache& TileCache::instance() {
+  static TileCache cache;
+  return cache;
+}
+
+TileCache::TileCache() {
+  auto max_size = getenv("TILEDB_TILE_CACHE_SIZE");
+  max_size_ = max_size ? std::stoull(max_size) : 0;
+}
+
+size_t TileCache::tile_key_hash_t::operator()(const tile_key_t& key) const {
+  size_t hash = std::hash<std::string>()(key.fragment_name_);
+  hash ^= std::hash<int64_t>()(key.tile_i_) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+  hash ^= std::hash<int>()(key.attribute_id_*2 + key.var_) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+  return hash;
+}
+
+std::shared_ptr<TileCache::Tile> TileCache::get(const std::string& fragment_name, int attribute_id,
+                                                int64_t tile_i, bool var) {
+  tile_key_t key = { fragment_name, attribute_id, tile_i, var };
+  shard_t& shard = this->shard(key);
+  std::lock_guard<std::mutex> lock(shard.mtx_);
+  auto it = shard.entries_.find(key);
+  if (it == shard.entries_.end()) {
+    ++misses_;
+    return std::shared_ptr<Tile>();
+  }
+  ++hits_;
+  shard.lru_.splice(shard.lru_.begin(), shard.lru_, it->second.lru_it_);
+  return it->second.tile_;
+}
+
+void TileCache::put(const std::string& fragment_name, int attribute_id, int64_t tile_i, bool var,
+                    const std::shared_ptr<Tile>& tile) {
+  tile_key_t key = { fragment_name, attribute_id, tile_i, var };
+  shard_t& shard = this->shard(key);
+  std::lock_guard<std::mutex> lock(shard.mtx_);
+  auto it = shard.entries_.find(key);
+  if (it != shard.entries_.end()) {
+    erase(shard, it);
+  }
+  if (tile->size() > max_size_/TILEDB_TILE_CACHE_SHARDS) {
+    return;
+  }
+  shard.lru_.push_front(key);
+  shard.entries_[key] = { tile, shard.lru_.begin() };
+  shard.size_ += tile->size();
+  evict(shard);
+}
+
+void TileCache::invalidate(const std::string& dir) {
+  if (dir.empty()) {
+    return;
+  }
+  std::string path = dir.back() == '/' ? dir.substr(0, dir.size()-1) : dir;
+  std::string prefix = path + "/";
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mtx_);
+    for (auto it = shard.entries_.begin(); it != shard.entries_.end();) {
+      const std::string& fragment_name = it->first.fragment_name_;
+      if (fragment_name == path || fragment_name.compare(0, prefix.size(), prefix) == 0) {
+        erase(shard, it++);
+      } else {
+        ++it;
+      }
+    }
+  }
+}
+
+void TileCache::clear() {
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mtx_);
+    shard.entries_.clear();
+    shard.lru_.clear();
+    shard.size_ = 0;
+  }
+}
+
+void TileCache::set_max_size(size_t max_size) {
+  if (max_size_.exchange(max_size) <= max_size) {
+    return;
+  }
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mtx_);
+    evict(shard);
+  }
+}
+
+size_t TileCache::max_size() {
+  return max_size_;
+}
+
+size_t TileCache::size() {
+  size_t size = 0;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mtx_);
+    size += shard.size_;
+  }
+  return size;
+}
+
+size_t TileCache::hits() {
+  return hits_;
+}
+
+size_t TileCache::misses() {
+  return misses_;
+}
+
+TileCache::shard_t& TileCache::shard(const tile_key_t& key) {
+  return shards_[tile_key_hash_t()(key) % TILEDB_TILE_CACHE_SHARDS];
+}
+
+void TileCache::erase(shard_t& shard, std::unordered_map<tile_key_t, cache_entry_t, tile_key_hash_t>::iterator it) {
+  shard.size_ -= it->second.tile_->size();
+  shard.lru_.erase(it->second.lru_it_);
+  shard.entries_.erase(it);
+}
+
+void TileCache::evict(shard_t& shard) {
+  size_t max_shard_size = max_size_/TILEDB_TILE_CACHE_SHARDS;
+  while (shard.size_ > max_shard_size && !shard.lru_.empty()) {
+    erase(shard, shard.entries_.find(shard.lru_.back()));
+  }
+}
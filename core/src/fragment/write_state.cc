@@ -69,7 +69,7 @@
 /*        GLOBAL VARIABLES        */
 /* ****************************** */
 
-std::string tiledb_ws_errmsg = "";
+thread_local std::string tiledb_ws_errmsg = "";
 
 
 
@@ -552,13 +552,8 @@ int WriteState::write_segment(int attribute_id, bool is_var, const void *segment
 
 int WriteState::write(const void** buffers, const size_t* buffer_sizes) {
   // Create fragment directory if it does not exist
-  std::string fragment_name = fragment_->fragment_name();
-  if(!is_dir(fs_, fragment_name)) {
-    if(create_dir(fs_, fragment_name) != TILEDB_UT_OK) {
-      tiledb_ws_errmsg = tiledb_ut_errmsg;
-      return TILEDB_WS_ERR;
-    }
-  }
+  if(create_fragment_dir() != TILEDB_WS_OK)
+    return TILEDB_WS_ERR;
 
   // Dispatch the proper write command
   if(fragment_->mode() == TILEDB_ARRAY_WRITE ||
@@ -581,10 +576,66 @@ int WriteState::write(const void** buffers, const size_t* buffer_sizes) {
 
 
 
+int WriteState::write_attribute(
+    int attribute_id,
+    const void** buffers,
+    const size_t* buffer_sizes) {
+  // Sanity check
+  if(fragment_->mode() != TILEDB_ARRAY_WRITE) {
+    std::string errmsg = "Cannot write attribute to fragment; Invalid mode";
+    PRINT_ERROR(errmsg);
+    tiledb_ws_errmsg = TILEDB_WS_ERRMSG + errmsg;
+    return TILEDB_WS_ERR;
+  }
+
+  // Create fragment directory if it does not exist
+  if(create_fragment_dir() != TILEDB_WS_OK)
+    return TILEDB_WS_ERR;
+
+  // Dispatch the proper write command
+  if(!array_schema_->var_size(attribute_id)) {    // FIXED CELLS
+    if(fragment_->dense())
+      return write_dense_attr(attribute_id, buffers[0], buffer_sizes[0]);
+    else
+      return write_sparse_attr(attribute_id, buffers[0], buffer_sizes[0]);
+  } else {                                        // VARIABLE-SIZED CELLS
+    if(fragment_->dense())
+      return write_dense_attr_var(
+                 attribute_id,
+                 buffers[0],
+                 buffer_sizes[0],
+                 buffers[1],
+                 buffer_sizes[1]);
+    else
+      return write_sparse_attr_var(
+                 attribute_id,
+                 buffers[0],
+                 buffer_sizes[0],
+                 buffers[1],
+                 buffer_sizes[1]);
+  }
+}
+
+
+
+
 /* ****************************** */
 /*         PRIVATE METHODS        */
 /* ****************************** */
 
+int WriteState::create_fragment_dir() {
+  std::lock_guard<std::mutex> lock(fragment_dir_mtx_);
+  std::string fragment_name = fragment_->fragment_name();
+  if(!is_dir(fs_, fragment_name)) {
+    if(create_dir(fs_, fragment_name) != TILEDB_UT_OK) {
+      tiledb_ws_errmsg = tiledb_ut_errmsg;
+      return TILEDB_WS_ERR;
+    }
+  }
+
+  return TILEDB_WS_OK;
+}
+
 int WriteState::compress_tile(
     int attribute_id,
     unsigned char* tile, 
@@ -53,7 +53,7 @@
 /*        GLOBAL VARIABLES        */
 /* ****************************** */
 
-std::string tiledb_mt_errmsg = "";
+thread_local std::string tiledb_mt_errmsg = "";
 
 
 
@@ -52,7 +52,7 @@
 /*        GLOBAL VARIABLES        */
 /* ****************************** */
 
-std::string tiledb_mit_errmsg = "";
+thread_local std::string tiledb_mit_errmsg = "";
 
 
 
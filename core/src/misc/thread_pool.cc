@@ -0,0 +1,125 @@
+/**
+ * @file   thread_pool.cc
+ *
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2026 Omics Data Automation, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *
+ * @section DESCRIPTION
+ *
+ * This file implements the ThreadPool class.
+ */
+
+#include "thread_pool.h"
+#include "utils.h"
+
+
+
+
+/* ****************************** */
+/*   CONSTRUCTORS & DESTRUCTORS   */
+/* ****************************** */
+
+ThreadPool::ThreadPool(int num_threads) : failed_(false), next_(0) {
+  for(int i=1; i<num_threads; ++i)
+    workers_.emplace_back(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    stop_ = true;
+  }
+  start_cv_.notify_all();
+  for(auto& worker : workers_)
+    worker.join();
+}
+
+
+
+
+/* ****************************** */
+/*            MUTATORS            */
+/* ****************************** */
+
+int ThreadPool::parallel_for(size_t n, const std::function<int(size_t)>& fn) {
+  if(n == 0)
+    return TILEDB_UT_OK;
+  failed_ = false;
+  next_ = 0;
+  if(workers_.empty() || n == 1) {
+    fn_ = &fn;
+    n_ = n;
+    run();
+    return failed_ ? TILEDB_UT_ERR : TILEDB_UT_OK;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    fn_ = &fn;
+    n_ = n;
+    done_num_ = 0;
+    ++loop_;
+  }
+  start_cv_.notify_all();
+  run();
+
+  // fn may reference the stack of the caller, wait for every worker to leave it
+  std::unique_lock<std::mutex> lock(mtx_);
+  done_cv_.wait(lock, [this]() { return done_num_ == workers_.size(); });
+  return failed_ ? TILEDB_UT_ERR : TILEDB_UT_OK;
+}
+
+
+
+
+/* ****************************** */
+/*         PRIVATE METHODS        */
+/* ****************************** */
+
+void ThreadPool::run() {
+  size_t i;
+  while(!failed_ && (i = next_++) < n_) {
+    if((*fn_)(i))
+      failed_ = true;
+  }
+}
+
+void ThreadPool::work() {
+  uint64_t loop = 0;
+  for(;;) {
+    {
+      std::unique_lock<std::mutex> lock(mtx_);
+      start_cv_.wait(lock, [this, loop]() { return stop_ || loop_ != loop; });
+      if(stop_)
+        return;
+      loop = loop_;
+    }
+    run();
+    std::lock_guard<std::mutex> lock(mtx_);
+    if(++done_num_ == workers_.size())
+      done_cv_.notify_one();
+  }
+}
@@ -37,11 +37,13 @@
 #include "utils.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstring>
 #include <cstdio>
 #include <dirent.h>
 #include <fcntl.h>
+#include <future>
 #include <iostream>
 #include <netdb.h>
 #include <set>
@@ -83,7 +85,7 @@
 /*        GLOBAL VARIABLES        */
 /* ****************************** */
 
-std::string tiledb_ut_errmsg = "";
+thread_local std::string tiledb_ut_errmsg = "";
 
 
 
@@ -231,7 +233,8 @@ int cmp_row_order(
 }
 
 bool is_supported_cloud_path(const std::string& pathURL) {
-  return is_hdfs_path(pathURL) || is_gcs_path(pathURL) || is_azure_path(pathURL) || is_azure_blob_storage_path(pathURL) || is_s3_storage_path(pathURL);
+  return is_hdfs_path(pathURL) || is_gcs_path(pathURL) || is_azure_path(pathURL) || is_azure_blob_storage_path(pathURL) || is_s3_storage_path(pathURL)
+      || is_memory_path(pathURL);
 }
 
 bool is_azure_path(const std::string& pathURL) {
@@ -276,6 +279,14 @@ bool is_hdfs_path(const std::string& pathURL) {
   }
 }
 
+bool is_memory_path(const std::string& pathURL) {
+  if (!pathURL.empty() && starts_with(pathURL, "mem:")) {
+    return true;
+  } else {
+    return false;
+  }
+}
+
 bool is_env_set(const std::string& name) {
   auto env_var = getenv(name.c_str());
   if(env_var && ((strcasecmp(env_var, "true") == 0) || (strcmp(env_var, "1") == 0))) {
@@ -285,6 +296,26 @@ bool is_env_set(const std::string& name) {
   }
 }
 
+int parallel_for(int num_threads, size_t n, const std::function<int(size_t)>& fn) {
+  std::atomic<size_t> next(0);
+  std::atomic<bool> failed(false);
+  auto worker = [&]() {
+    size_t i;
+    while (!failed && (i = next++) < n) {
+      if (fn(i)) failed = true;
+    }
+  };
+  std::vector<std::future<void>> workers;
+  for (auto i = 1ul; i < std::min((size_t)num_threads, n); i++) {
+    workers.emplace_back(std::async(std::launch::async, worker));
+  }
+  worker();
+  for (auto& w : workers) {
+    w.get();
+  }
+  return failed?TILEDB_UT_ERR:TILEDB_UT_OK;
+}
+
 std::string get_filename_from_path(const std::string& path) {
   size_t pos = path.find_last_of("\\/");
   if (pos == std::string::npos || path.length() == pos++) {
@@ -909,6 +940,16 @@ int read_from_file(StorageFS *fs,
   return TILEDB_UT_OK;
 }
 
+int read_from_file_v(StorageFS *fs,
+    const std::string& filename,
+    const std::vector<read_range_t>& ranges) {
+  if (fs->read_from_file_v(filename, ranges)) {
+    tiledb_ut_errmsg = tiledb_fs_errmsg;
+    return TILEDB_UT_ERR;
+  }
+  return TILEDB_UT_OK;
+}
+
 std::string real_dir(StorageFS *fs, const std::string& dir) {
   return fs->real_dir(dir);
 }
@@ -0,0 +1,458 @@
+/**
+ * @file   storage_block_cache.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2026 Omics Data Automation, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Local disk block cache for StorageFS
+ */
+
+#include "storage_block_cache.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Temporary block files older than this are left over from a crashed process
+#define STALE_TMP_BLOCK_SECS 3600
+
+static uint64_t fnv1a_hash(const std::string& str) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (auto ch : str) {
+    hash ^= static_cast<unsigned char>(ch);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+BlockCacheFS::BlockCacheFS(StorageFS *fs, const std::string& home, const std::string& cache_dir) {
+  if (home.find("://") != std::string::npos) {
+    uri home_uri(home);
+    root_ = home_uri.protocol() + "://" + home_uri.host();
+  }
+  cache_dir_ = unslashify(cache_dir);
+  if (cache_dir_.empty()) {
+    throw std::system_error(EINVAL, std::generic_category(), "Block cache directory not specified");
+  }
+
+  auto env_var = getenv("TILEDB_BLOCK_CACHE_BLOCK_SIZE");
+  if (env_var && std::stoull(env_var) > 0) {
+    block_size_ = std::stoull(env_var);
+  }
+  env_var = getenv("TILEDB_BLOCK_CACHE_SIZE");
+  if (env_var) {
+    max_cache_size_ = std::stoull(env_var);
+  }
+
+  // The cache is private to TileDB, so skip file locking and open write handles
+  local_fs_.set_disable_file_locking(true);
+  local_fs_.set_keep_write_file_handles_open(false);
+  if (!local_fs_.is_dir(cache_dir_) && local_fs_.create_dir(cache_dir_)) {
+    throw std::system_error(EIO, std::generic_category(), "Could not create block cache directory " + cache_dir_ +
+                            " " + tiledb_fs_errmsg);
+  }
+  load_index();
+
+  fs_ = fs;
+  download_buffer_size_ = fs_->download_buffer_size_;
+  upload_buffer_size_ = fs_->upload_buffer_size_;
+}
+
+BlockCacheFS::~BlockCacheFS() {
+  delete fs_;
+}
+
+std::string BlockCacheFS::current_dir() {
+  return fs_->current_dir();
+}
+
+int BlockCacheFS::set_working_dir(const std::string& dir) {
+  return fs_->set_working_dir(dir);
+}
+
+bool BlockCacheFS::is_dir(const std::string& dir) {
+  return fs_->is_dir(dir);
+}
+
+bool BlockCacheFS::is_file(const std::string& file) {
+  return fs_->is_file(file);
+}
+
+std::string BlockCacheFS::real_dir(const std::string& dir) {
+  return fs_->real_dir(dir);
+}
+
+int BlockCacheFS::create_dir(const std::string& dir) {
+  return fs_->create_dir(dir);
+}
+
+int BlockCacheFS::delete_dir(const std::string& dir) {
+  std::string prefix = slashify(cache_uri(dir));
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (auto it = file_sizes_.begin(); it != file_sizes_.end();) {
+      if (starts_with(it->first, prefix)) {
+        it = file_sizes_.erase(it);
+      } else {
+        it++;
+      }
+    }
+  }
+  return fs_->delete_dir(dir);
+}
+
+std::vector<std::string> BlockCacheFS::get_dirs(const std::string& dir) {
+  return fs_->get_dirs(dir);
+}
+
+std::vector<std::string> BlockCacheFS::get_files(const std::string& dir) {
+  return fs_->get_files(dir);
+}
+
+int BlockCacheFS::create_file(const std::string& filename, int flags, mode_t mode) {
+  invalidate(filename);
+  return fs_->create_file(filename, flags, mode);
+}
+
+int BlockCacheFS::delete_file(const std::string& filename) {
+  invalidate(filename);
+  return fs_->delete_file(filename);
+}
+
+ssize_t BlockCacheFS::file_size(const std::string& filename) {
+  if (!is_cacheable(filename)) {
+    return fs_->file_size(filename);
+  }
+  return cached_file_size(filename);
+}
+
+int BlockCacheFS::read_from_file(const std::string& filename, off_t offset, void *buffer, size_t length) {
+  if (length == 0 || !is_cacheable(filename)) {
+    return fs_->read_from_file(filename, offset, buffer, length);
+  }
+
+  // Let the wrapped filesystem report reads that cannot be satisfied
+  ssize_t filesize = cached_file_size(filename);
+  if (filesize < 0 || offset < 0 || offset + length > static_cast<size_t>(filesize)) {
+    return fs_->read_from_file(filename, offset, buffer, length);
+  }
+
+  std::string prefix = block_prefix(filename, filesize);
+  size_t last_block = (offset + length - 1) / block_size_;
+  size_t block = offset / block_size_;
+  while (block <= last_block) {
+    size_t block_offset = block * block_size_;
+    size_t start = std::max(static_cast<size_t>(offset), block_offset);
+    size_t end = std::min(offset + length, block_offset + block_size_);
+    std::string name = prefix + std::to_string(block_offset);
+    if (lookup_block(name)) {
+      if (read_cached_block(name, start - block_offset, reinterpret_cast<char *>(buffer) + (start - offset),
+                            end - start) == TILEDB_FS_OK) {
+        hits_++;
+        block++;
+        continue;
+      }
+      // Evicted by another process or otherwise unreadable, fetch it again
+      remove_block(name);
+    }
+
+    // Coalesce consecutive missing blocks into one read from the wrapped filesystem
+    size_t next_block = block + 1;
+    while (next_block <= last_block && !lookup_block(prefix + std::to_string(next_block * block_size_))) {
+      next_block++;
+    }
+    if (fetch_blocks(filename, prefix, filesize, block, next_block, offset, buffer, length)) {
+      return TILEDB_FS_ERR;
+    }
+    misses_ += next_block - block;
+    block = next_block;
+  }
+
+  return TILEDB_FS_OK;
+}
+
+int BlockCacheFS::write_to_file(const std::string& filename, const void *buffer, size_t buffer_size) {
+  invalidate(filename);
+  return fs_->write_to_file(filename, buffer, buffer_size);
+}
+
+int BlockCacheFS::move_path(const std::string& old_path, const std::string& new_path) {
+  invalidate(old_path);
+  invalidate(new_path);
+  return fs_->move_path(old_path, new_path);
+}
+
+int BlockCacheFS::sync_path(const std::string& path) {
+  return fs_->sync_path(path);
+}
+
+int BlockCacheFS::close_file(const std::string& filename) {
+  // Files are also closed after reads, so only forget the size here. Cached blocks are
+  // keyed by file size and are not used if the file has been rewritten since.
+  std::string key = cache_uri(filename);
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    file_sizes_.erase(key);
+  }
+  return fs_->close_file(filename);
+}
+
+bool BlockCacheFS::locking_support() {
+  return fs_->locking_support();
+}
+
+size_t BlockCacheFS::cache_size() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return total_size_;
+}
+
+// The public methods are all forwarded to the wrapped filesystem, so the StorageCloudFS
+// hooks are not used by BlockCacheFS itself.
+bool BlockCacheFS::path_exists(const std::string& path) {
+  return fs_->is_file(path) || fs_->is_dir(path);
+}
+
+int BlockCacheFS::create_path(const std::string& path) {
+  return fs_->create_file(path, O_WRONLY|O_CREAT, S_IRWXU);
+}
+
+int BlockCacheFS::commit_file(const std::string& filename) {
+  return fs_->close_file(filename);
+}
+
+std::string BlockCacheFS::cache_uri(const std::string& path) {
+  if (path.find("://") != std::string::npos) {
+    return path;
+  } else if (!path.empty() && path[0] == '/') {
+    return root_ + path;
+  } else {
+    std::string dir = fs_->current_dir();
+    if (dir.empty() || dir[0] != '/') {
+      dir = "/" + dir;
+    }
+    return root_ + append_paths(dir, path);
+  }
+}
+
+bool BlockCacheFS::is_cacheable(const std::string& path) {
+  // Files in committed fragment directories, named __<uuid>..., are never modified. Array schemas,
+  // fragment manifests, consolidation locks and other files alongside them can be rewritten
+  // in place by other processes, possibly with the same size, so they are not cached.
+  std::string dir = unslashify(path);
+  size_t pos = dir.find_last_of('/');
+  if (pos == std::string::npos) {
+    return false;
+  }
+  dir.resize(pos);
+  return starts_with(get_filename_from_path(dir), "__");
+}
+
+std::string BlockCacheFS::block_prefix(const std::string& path, ssize_t filesize) {
+  char prefix[64];
+  snprintf(prefix, sizeof(prefix), "%016llx-%zd-", static_cast<unsigned long long>(fnv1a_hash(cache_uri(path))),
+           filesize);
+  return prefix;
+}
+
+ssize_t BlockCacheFS::cached_file_size(const std::string& path) {
+  std::string key = cache_uri(path);
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto search = file_sizes_.find(key);
+    if (search != file_sizes_.end()) {
+      return search->second;
+    }
+  }
+  ssize_t size = fs_->file_size(path);
+  if (size >= 0) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    file_sizes_[key] = size;
+  }
+  return size;
+}
+
+void BlockCacheFS::invalidate(const std::string& path) {
+  std::string key = cache_uri(path);
+  char prefix[32];
+  snprintf(prefix, sizeof(prefix), "%016llx-", static_cast<unsigned long long>(fnv1a_hash(key)));
+
+  std::lock_guard<std::mutex> lock(mtx_);
+  file_sizes_.erase(key);
+  auto it = blocks_.lower_bound(prefix);
+  while (it != blocks_.end() && starts_with(it->first, prefix)) {
+    local_fs_.delete_file(block_path(it->first));
+    total_size_ -= it->second->second;
+    lru_.erase(it->second);
+    it = blocks_.erase(it);
+  }
+}
+
+void BlockCacheFS::load_index() {
+  typedef struct {
+    std::string name;
+    size_t size;
+    time_t mtime;
+  } cached_block_t;
+  std::vector<cached_block_t> cached_blocks;
+
+  time_t now = time(NULL);
+  for (auto& file : local_fs_.get_files(cache_dir_)) {
+    std::string name = file.substr(cache_dir_.size()+1);
+    struct stat st;
+    if (stat(file.c_str(), &st)) {
+      continue;
+    }
+    if (name.find(".tmp.") != std::string::npos) {
+      if (now - st.st_mtime > STALE_TMP_BLOCK_SECS) {
+        local_fs_.delete_file(file);
+      }
+      continue;
+    }
+
+    unsigned long long hash;
+    size_t filesize, block_offset;
+    int nchars = 0;
+    if (sscanf(name.c_str(), "%16llx-%zu-%zu%n", &hash, &filesize, &block_offset, &nchars) != 3 ||
+        static_cast<size_t>(nchars) != name.size()) {
+      // Not a block file
+      continue;
+    }
+    // Blocks from an interrupted write or from a different block size cannot be used
+    if (block_offset % block_size_ || block_offset >= filesize ||
+        static_cast<size_t>(st.st_size) != std::min(block_size_, filesize - block_offset)) {
+      local_fs_.delete_file(file);
+      continue;
+    }
+    cached_blocks.push_back({name, static_cast<size_t>(st.st_size), st.st_mtime});
+  }
+
+  std::sort(cached_blocks.begin(), cached_blocks.end(),
+            [](const cached_block_t& a, const cached_block_t& b) { return a.mtime < b.mtime; });
+  std::lock_guard<std::mutex> lock(mtx_);
+  for (auto& cached_block : cached_blocks) {
+    lru_.emplace_front(cached_block.name, cached_block.size);
+    blocks_[cached_block.name] = lru_.begin();
+    total_size_ += cached_block.size;
+  }
+  evict_blocks();
+}
+
+bool BlockCacheFS::lookup_block(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  auto search = blocks_.find(name);
+  if (search == blocks_.end()) {
+    return false;
+  }
+  lru_.splice(lru_.begin(), lru_, search->second);
+  return true;
+}
+
+void BlockCacheFS::insert_block(const std::string& name, size_t size) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  auto search = blocks_.find(name);
+  if (search != blocks_.end()) {
+    // Another thread stored the same block
+    total_size_ -= search->second->second;
+    lru_.erase(search->second);
+  }
+  lru_.emplace_front(name, size);
+  blocks_[name] = lru_.begin();
+  total_size_ += size;
+  evict_blocks();
+}
+
+void BlockCacheFS::remove_block(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  auto search = blocks_.find(name);
+  if (search != blocks_.end()) {
+    local_fs_.delete_file(block_path(name));
+    total_size_ -= search->second->second;
+    lru_.erase(search->second);
+    blocks_.erase(search);
+  }
+}
+
+// Called with mtx_ held
+void BlockCacheFS::evict_blocks() {
+  while (total_size_ > max_cache_size_ && !lru_.empty()) {
+    auto& entry = lru_.back();
+    local_fs_.delete_file(block_path(entry.first));
+    total_size_ -= entry.second;
+    blocks_.erase(entry.first);
+    lru_.pop_back();
+  }
+}
+
+int BlockCacheFS::read_cached_block(const std::string& name, size_t offset, void *buffer, size_t length) {
+  return local_fs_.read_from_file(block_path(name), offset, buffer, length);
+}
+
+void BlockCacheFS::store_block(const std::string& name, const void *buffer, size_t length) {
+  // Write to a temporary file and rename, so a block file is never seen partially written
+  std::string tmp_path = block_path(name) + ".tmp." + std::to_string(getpid()) + "." +
+      std::to_string(tmp_counter_++);
+  if (local_fs_.write_to_file(tmp_path, buffer, length) || local_fs_.move_path(tmp_path, block_path(name))) {
+    // The cache is best effort, the block is just not cached
+    if (local_fs_.is_file(tmp_path)) {
+      local_fs_.delete_file(tmp_path);
+    }
+    return;
+  }
+  insert_block(name, length);
+}
+
+int BlockCacheFS::fetch_blocks(const std::string& filename, const std::string& prefix, ssize_t filesize,
+                               size_t first_block, size_t last_block, off_t offset, void *buffer, size_t length) {
+  size_t fetch_offset = first_block * block_size_;
+  size_t fetch_length = std::min(last_block * block_size_, static_cast<size_t>(filesize)) - fetch_offset;
+  std::vector<char> blocks(fetch_length);
+  if (fs_->read_from_file(filename, fetch_offset, blocks.data(), fetch_length)) {
+    return TILEDB_FS_ERR;
+  }
+
+  for (auto block = first_block; block < last_block; block++) {
+    size_t block_offset = block * block_size_;
+    size_t block_length = std::min(block_size_, static_cast<size_t>(filesize) - block_offset);
+    char *block_buffer = blocks.data() + (block_offset - fetch_offset);
+    store_block(prefix + std::to_string(block_offset), block_buffer, block_length);
+
+    size_t start = std::max(static_cast<size_t>(offset), block_offset);
+    size_t end = std::min(offset + length, block_offset + block_length);
+    memcpy(reinterpret_cast<char *>(buffer) + (start - offset), block_buffer + (start - block_offset), end - start);
+  }
+
+  return TILEDB_FS_OK;
+}
@@ -31,11 +31,18 @@
  * This file implements the StorageBuffer class that buffers writes/reads to/from files
  */
 
+#include "codec.h"
+#ifdef ENABLE_ZSTD
+#  define ZSTD_EXTERN_DECL extern
+#  include "codec_zstd.h"
+#endif
 #include "error.h"
 #include "storage_buffer.h"
 #include "utils.h"
 
+#include <algorithm>
 #include <assert.h>
+#include <chrono>
 #include <iostream>
 #include <string>
 #include <string.h>
@@ -56,6 +63,9 @@ StorageBuffer::StorageBuffer(StorageFS *fs, const std::string& filename, size_t
     } else {
       filesize_ = (size_t)fs_->file_size(filename);
     }
+    read_ahead_ = is_env_set("TILEDB_READ_AHEAD");
+  } else {
+    write_behind_ = is_env_set("TILEDB_WRITE_BEHIND");
   }
   if (!(chunk_size_ = chunk_size)) {
     BUFFER_PATH_ERROR("Cannot perform buffered reads or writes as there is no buffer chunk size set", filename_);
@@ -89,9 +99,30 @@ int StorageBuffer::read_buffer(off_t offset, void *bytes, size_t size) {
     return TILEDB_BF_ERR;  
   }
 
-  if (buffer_ == NULL || !(offset>=buffer_offset_ && (offset+size)<=(buffer_offset_+buffer_size_))) {
+  bool is_sequential = read_ahead_ && (size_t)offset == last_read_end_;
+  last_read_end_ = offset + size;
+
+  char *dest = (char *)bytes;
+  while (size > 0) {
+    if (buffer_ && offset >= buffer_offset_ && size_t(offset) < buffer_offset_+buffer_size_) {
+      // Serve whatever is cached, the remainder is usually in the prefetched chunk for sequential reads
+      size_t cached_size = std::min(size, buffer_offset_+buffer_size_-offset);
+      void *pmem = memcpy(dest, (char *)buffer_+offset-buffer_offset_, cached_size);
+      assert(pmem == dest);
+      dest += cached_size;
+      offset += cached_size;
+      size -= cached_size;
+      continue;
+    }
+
+    if (use_prefetch(offset)) {
+      if (is_sequential) start_prefetch();
+      continue;
+    }
+
+    size_t window_size = read_ahead_?std::max(chunk_size_/2, (size_t)CHUNK):chunk_size_;
     buffer_offset_ = (offset/CHUNK)*CHUNK;
-    buffer_size_ = ((size/chunk_size_)+1)*chunk_size_ + (offset%CHUNK);
+    buffer_size_ = ((size/window_size)+1)*window_size + (offset%CHUNK);
     // Factor in last chunk
     if (buffer_offset_+buffer_size_ > filesize_) {
       buffer_size_ = filesize_-buffer_offset_;
@@ -107,25 +138,71 @@ int StorageBuffer::read_buffer(off_t offset, void *bytes, size_t size) {
     if (read_buffer()) {
       return TILEDB_BF_ERR;
     }
+    if (is_sequential) start_prefetch();
   }
-  
-  assert(offset >= buffer_offset_);
-  assert(size <= buffer_size_);
-  assert(size_t(offset-buffer_offset_) <= buffer_size_);
-  
-  void *pmem = memcpy(bytes, (char *)buffer_+offset-buffer_offset_, size);
-  assert(pmem == bytes);
 
   return TILEDB_BF_OK;
 }
 
 int StorageBuffer::read_buffer() {
-    if (fs_->read_from_file(filename_, buffer_offset_, (char *)buffer_, buffer_size_)) {
-      BUFFER_PATH_ERROR("Cannot read to buffer", filename_);
+  // Any outstanding prefetch is waited on, so there are no concurrent reads to the file from StorageBuffer
+  wait_for_prefetch();
+  if (fs_->read_from_file(filename_, buffer_offset_, (char *)buffer_, buffer_size_)) {
+    BUFFER_PATH_ERROR("Cannot read to buffer", filename_);
+    return TILEDB_BF_ERR;
+  }
+  return TILEDB_BF_OK;
+}
+
+void StorageBuffer::start_prefetch() {
+  if (prefetch_.valid() || (prefetch_buffer_ && prefetch_offset_ == buffer_offset_+(off_t)buffer_size_)) {
+    return; // Already prefetching or prefetched
+  }
+  prefetch_offset_ = buffer_offset_+buffer_size_;
+  if ((size_t)prefetch_offset_ >= filesize_) {
+    return; // Nothing more to prefetch
+  }
+  prefetch_size_ = std::min(std::max(chunk_size_/2, (size_t)CHUNK), filesize_-prefetch_offset_);
+  if (prefetch_size_ > allocated_prefetch_size_) {
+    void *prefetch_buffer = realloc(prefetch_buffer_, prefetch_size_);
+    if (prefetch_buffer == NULL) {
+      // Not an error, reads will just not be prefetched
+      prefetch_size_ = 0;
+      return;
+    }
+    prefetch_buffer_ = prefetch_buffer;
+    allocated_prefetch_size_ = prefetch_size_;
+  }
+  prefetch_ = std::async(std::launch::async, [this]() {
+    return fs_->read_from_file(filename_, prefetch_offset_, prefetch_buffer_, prefetch_size_);
+  });
+}
+
+int StorageBuffer::wait_for_prefetch() {
+  if (prefetch_.valid()) {
+    if (prefetch_.get()) {
+      // Discard the prefetched chunk, the chunk will be read again in the foreground if needed
+      prefetch_size_ = 0;
       return TILEDB_BF_ERR;
     }
-    return TILEDB_BF_OK;
   }
+  return TILEDB_BF_OK;
+}
+
+bool StorageBuffer::use_prefetch(off_t offset) {
+  if (!prefetch_buffer_ || offset != prefetch_offset_) {
+    return false;
+  }
+  if (wait_for_prefetch() || prefetch_size_ == 0) {
+    return false;
+  }
+  std::swap(buffer_, prefetch_buffer_);
+  std::swap(allocated_buffer_size_, allocated_prefetch_size_);
+  buffer_offset_ = prefetch_offset_;
+  buffer_size_ = prefetch_size_;
+  prefetch_size_ = 0;
+  return true;
+}
 
 int StorageBuffer::append_buffer(const void *bytes, size_t size) {
   assert(!read_only_);
@@ -139,6 +216,14 @@ int StorageBuffer::append_buffer(const void *bytes, size_t size) {
     return TILEDB_BF_ERR;
   }
 
+  // Report errors from a completed background write early
+  if (write_behind_future_.valid()
+      && write_behind_future_.wait_for(std::chrono::seconds(0)) == std::future_status::ready
+      && wait_for_write_behind()) {
+    BUFFER_PATH_ERROR("Cannot write bytes in the background; " + write_behind_errmsg_, filename_);
+    return TILEDB_BF_ERR;
+  }
+
   if (buffer_size_ >= chunk_size_) {
     assert(buffer_ != NULL);
     if (write_buffer()) {
@@ -168,7 +253,14 @@ int StorageBuffer::write_buffer() {
   if (is_error_) {
     return TILEDB_BF_ERR;
   }
-  if (fs_->write_to_file(filename_, buffer_, buffer_size_)) {
+  if (write_behind_ && buffer_size_ > 0) {
+    if (write_behind(buffer_, allocated_buffer_size_, buffer_size_)) {
+      return TILEDB_BF_ERR;
+    }
+  } else if (wait_for_write_behind()) {
+    BUFFER_PATH_ERROR("Cannot write bytes in the background; " + write_behind_errmsg_, filename_);
+    return TILEDB_BF_ERR;
+  } else if (fs_->write_to_file(filename_, buffer_, buffer_size_)) {
     BUFFER_PATH_ERROR("Cannot write bytes", filename_);
     return TILEDB_BF_ERR;
   }
@@ -176,10 +268,43 @@ int StorageBuffer::write_buffer() {
   return TILEDB_BF_OK;
 }
 
+int StorageBuffer::write_behind(void *&buffer, size_t& allocated_size, size_t size) {
+  if (wait_for_write_behind()) {
+    BUFFER_PATH_ERROR("Cannot write bytes in the background; " + write_behind_errmsg_, filename_);
+    return TILEDB_BF_ERR;
+  }
+  std::swap(buffer, write_behind_buffer_);
+  std::swap(allocated_size, allocated_write_behind_size_);
+  void *write_behind_buffer = write_behind_buffer_;
+  write_behind_future_ = std::async(std::launch::async, [this, write_behind_buffer, size]() {
+    // Error messages are thread-local, keep the cause to be reported by the writing thread
+    int rc = fs_->write_to_file(filename_, write_behind_buffer, size);
+    if (rc) {
+      write_behind_errmsg_ = tiledb_fs_errmsg;
+    }
+    return rc;
+  });
+  return TILEDB_BF_OK;
+}
+
+int StorageBuffer::wait_for_write_behind() {
+  if (write_behind_future_.valid() && write_behind_future_.get()) {
+    return TILEDB_BF_ERR;
+  }
+  return TILEDB_BF_OK;
+}
+
 int StorageBuffer::finalize() {
   int rc = TILEDB_BF_OK;
   if (!read_only_) {
-    rc =  write_buffer();
+    rc = write_buffer();
+    if (wait_for_write_behind()) {
+      BUFFER_PATH_ERROR("Cannot write bytes in the background; " + write_behind_errmsg_, filename_);
+      rc = TILEDB_BF_ERR;
+    }
+  } else {
+    // Prefetched bytes are not needed anymore, the result can be ignored
+    wait_for_prefetch();
   }
   rc = fs_->close_file(filename_) || rc;
   free_buffer();
@@ -191,6 +316,16 @@ int StorageBuffer::finalize() {
   }
 }
 
+CompressedStorageBuffer::CompressedStorageBuffer(StorageFS *fs, const std::string& filename, size_t chunk_size,
+                                                 const bool is_read, const int compression_type, const int compression_level)
+    : StorageBuffer(fs, filename, chunk_size, is_read),
+      compression_type_(compression_type), compression_level_(compression_level) {
+  auto num_threads = getenv("TILEDB_COMPRESSION_THREADS");
+  if (num_threads) {
+    num_threads_ = std::max(1, atoi(num_threads));
+  }
+}
+
 int CompressedStorageBuffer::read_buffer(void *bytes, size_t size) {
   // Nothing to do
   if (bytes == NULL || size == 0) {
@@ -208,6 +343,12 @@ int CompressedStorageBuffer::read_buffer(void *bytes, size_t size) {
           return TILEDB_BF_ERR;
         }
         break;
+      case TILEDB_ZSTD:
+        if (zstd_read_buffer()) {
+          BUFFER_PATH_ERROR("Cannot decompress and/or read bytes", filename_);
+          return TILEDB_BF_ERR;
+        }
+        break;
       case TILEDB_NO_COMPRESSION:
         break;
       default:
@@ -233,6 +374,12 @@ int CompressedStorageBuffer::write_buffer() {
           return TILEDB_BF_ERR;
         }
         break;
+      case TILEDB_ZSTD:
+        if (zstd_write_buffer()) {
+          BUFFER_PATH_ERROR("Cannot compress and/or write bytes", filename_);
+          return TILEDB_BF_ERR;
+        }
+        break;
       case TILEDB_NO_COMPRESSION:
         return StorageBuffer::write_buffer();
       default:
@@ -249,6 +396,94 @@ int CompressedStorageBuffer::write_buffer() {
 
 void gzip_handle_error(int rc, const std::string& message);
 
+// Blocks compressed independently are between 1M and 1G of uncompressed bytes
+#define MIN_BLOCK_SIZE (1024*1024)
+#define MAX_BLOCK_SIZE (1024*1024*1024)
+
+static inline void put_le32(unsigned char *p, uint32_t value) {
+  p[0] = value & 0xff;
+  p[1] = (value >> 8) & 0xff;
+  p[2] = (value >> 16) & 0xff;
+  p[3] = (value >> 24) & 0xff;
+}
+
+static inline uint32_t get_le32(const unsigned char *p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Gzip members compressed in parallel have the member size in an extra subfield, similar to BGZF, so they can be
+// located and inflated independently. Other gzip readers skip the extra subfield.
+#define GZIP_HEADER_SIZE 20
+#define GZIP_TRAILER_SIZE 8
+#define GZIP_FEXTRA 4
+#define GZIP_OS_UNKNOWN 255
+
+static int gzip_compress_member(const unsigned char *in, size_t in_size, int level, std::vector<unsigned char>& member) {
+  z_stream strm;
+  memset(&strm, 0, sizeof(z_stream));
+  if (deflateInit2(&strm, level, Z_DEFLATED, -windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    return TILEDB_BF_ERR;
+  }
+  member.resize(GZIP_HEADER_SIZE + deflateBound(&strm, in_size) + GZIP_TRAILER_SIZE);
+  strm.next_in = const_cast<unsigned char *>(in);
+  strm.avail_in = in_size;
+  strm.next_out = member.data() + GZIP_HEADER_SIZE;
+  strm.avail_out = member.size() - GZIP_HEADER_SIZE - GZIP_TRAILER_SIZE;
+  int rc = deflate(&strm, Z_FINISH);
+  size_t member_size = GZIP_HEADER_SIZE + strm.total_out + GZIP_TRAILER_SIZE;
+  deflateEnd(&strm);
+  if (rc != Z_STREAM_END || member_size > UINT32_MAX) {
+    return TILEDB_BF_ERR;
+  }
+  member.resize(member_size);
+
+  unsigned char *header = member.data();
+  const unsigned char gzip_header[] = { 0x1f, 0x8b, Z_DEFLATED, GZIP_FEXTRA, 0, 0, 0, 0, 0, GZIP_OS_UNKNOWN,
+                                        8, 0, // XLEN
+                                        'T', 'D', 4, 0 }; // SI1, SI2, LEN
+  memcpy(header, gzip_header, sizeof(gzip_header));
+  put_le32(header + sizeof(gzip_header), member_size);
+
+  unsigned char *trailer = member.data() + member_size - GZIP_TRAILER_SIZE;
+  put_le32(trailer, crc32(crc32(0L, Z_NULL, 0), in, in_size));
+  put_le32(trailer + 4, in_size);
+  return TILEDB_BF_OK;
+}
+
+// Returns the size of the gzip member at in if it was compressed with gzip_compress_member, 0 otherwise
+static size_t gzip_member_size(const unsigned char *in, size_t in_size) {
+  if (in_size < GZIP_HEADER_SIZE + GZIP_TRAILER_SIZE || in[0] != 0x1f || in[1] != 0x8b || in[2] != Z_DEFLATED
+      || !(in[3] & GZIP_FEXTRA) || in[10] != 8 || in[11] != 0 || in[12] != 'T' || in[13] != 'D' || in[14] != 4 || in[15] != 0) {
+    return 0;
+  }
+  size_t member_size = get_le32(in + 16);
+  if (member_size < GZIP_HEADER_SIZE + GZIP_TRAILER_SIZE || member_size > in_size) {
+    return 0;
+  }
+  return member_size;
+}
+
+static int gzip_decompress_member(const unsigned char *in, size_t in_size, unsigned char *out, size_t out_size) {
+  z_stream strm;
+  memset(&strm, 0, sizeof(z_stream));
+  if (inflateInit2(&strm, windowBits + GZIP_ENCODING) != Z_OK) {
+    return TILEDB_BF_ERR;
+  }
+  strm.next_in = const_cast<unsigned char *>(in);
+  strm.avail_in = in_size;
+  strm.next_out = out;
+  strm.avail_out = out_size;
+  int rc = inflate(&strm, Z_FINISH);
+  bool complete = rc == Z_STREAM_END && strm.avail_in == 0 && strm.avail_out == 0;
+  inflateEnd(&strm);
+  return complete?TILEDB_BF_OK:TILEDB_BF_ERR;
+}
+
+static inline bool is_zstd_frame(const void *in, size_t in_size) {
+  const unsigned char zstd_magic[] = { 0x28, 0xb5, 0x2f, 0xfd };
+  return in_size >= sizeof(zstd_magic) && memcmp(in, zstd_magic, sizeof(zstd_magic)) == 0;
+}
+
 int CompressedStorageBuffer::initialize_gzip_stream(z_stream *strm) {
   memset(strm, 0, sizeof(z_stream));
   strm->zalloc = Z_NULL;
@@ -268,12 +503,24 @@ int CompressedStorageBuffer::gzip_read_buffer() {
   // gzip_read is done only once for a given file as we need all the bytes to decompress into buffer
   assert(!buffer_);
 
+  // With multiple threads, the entire file is read to locate gzip members that can be inflated independently
+  bool in_memory = num_threads_ > 1;
+  if (in_memory) {
+    if (read_compressed_file()) return TILEDB_BF_ERR;
+    if (is_zstd_frame(compress_buffer_, filesize_)) {
+      return zstd_decompress_buffer();
+    }
+    if (gzip_member_size((unsigned char *)compress_buffer_, filesize_)) {
+      return gzip_parallel_read_buffer();
+    }
+  }
+
   /* allocate inflate state */
   z_stream strm;
   if (initialize_gzip_stream(&strm)) return TILEDB_BF_ERR;
 
-  unsigned char *in = (unsigned char *)malloc(chunk_size_);
-  if (in == NULL) {
+  unsigned char *in = in_memory?NULL:(unsigned char *)malloc(chunk_size_);
+  if (!in_memory && in == NULL) {
     BUFFER_ERROR_WITH_ERRNO( "Cannot read file into buffer; Mem allocation error for " + filename_
                              + " filesize=" + std::to_string(chunk_size_));
     return TILEDB_BF_ERR;
@@ -284,12 +531,23 @@ int CompressedStorageBuffer::gzip_read_buffer() {
   size_t processed = 0;
   do {
     // decompress in chunks until input is exhausted
-    memset(in, 0, chunk_size_);
-    size_t read_size = filesize_-processed>chunk_size_?chunk_size_:filesize_-processed;
-    if (fs_->read_from_file(filename_, processed, in, read_size) == TILEDB_UT_ERR) {
-      free(in);
-      BUFFER_PATH_ERROR("Could not read from file for decompression", filename_);
-      return TILEDB_BF_ERR;
+    size_t read_size;
+    if (in_memory) {
+      in = (unsigned char *)compress_buffer_+processed;
+      read_size = filesize_-processed>chunk_size_?chunk_size_:filesize_-processed;
+    } else {
+      memset(in, 0, chunk_size_);
+      read_size = filesize_-processed>chunk_size_?chunk_size_:filesize_-processed;
+      if (fs_->read_from_file(filename_, processed, in, read_size) == TILEDB_UT_ERR) {
+        free(in);
+        BUFFER_PATH_ERROR("Could not read from file for decompression", filename_);
+        return TILEDB_BF_ERR;
+      }
+      if (processed == 0 && is_zstd_frame(in, read_size)) {
+        free(in);
+        inflateEnd(&strm);
+        return zstd_read_buffer();
+      }
     }
 
     strm.avail_in = read_size;
@@ -309,7 +567,7 @@ int CompressedStorageBuffer::gzip_read_buffer() {
         case Z_DATA_ERROR:
         case Z_STREAM_ERROR:
         case Z_MEM_ERROR:
-          free(in);
+          if (!in_memory) free(in);
           inflateEnd(&strm);
           close_file(fs_, filename_);
           gzip_handle_error(rc, std::string("Error encountered during inflate with ")+filename_);
@@ -338,8 +596,9 @@ int CompressedStorageBuffer::gzip_read_buffer() {
   }  while (rc !=  Z_STREAM_END || processed < filesize_);
 
   // clean up before return
-  free(in);
+  if (!in_memory) free(in);
   inflateEnd(&strm);
+  free_compress_buffer();
 
   // All bytes have been decompressed
   assert(rc == Z_STREAM_END);
@@ -352,7 +611,59 @@ int CompressedStorageBuffer::gzip_read_buffer() {
   return TILEDB_BF_OK;
 }
 
+int CompressedStorageBuffer::gzip_parallel_read_buffer() {
+  // Locate the gzip members and their decompressed offsets, the decompressed size of a member is in its trailer
+  unsigned char *in = (unsigned char *)compress_buffer_;
+  std::vector<std::pair<size_t, size_t>> members; // compressed and decompressed offsets
+  size_t decompressed_size = 0;
+  for (size_t pos = 0; pos < filesize_;) {
+    size_t member_size = gzip_member_size(in+pos, filesize_-pos);
+    if (!member_size) {
+      BUFFER_PATH_ERROR("Could not locate gzip member for parallel decompression at offset=" + std::to_string(pos), filename_);
+      return TILEDB_BF_ERR;
+    }
+    members.emplace_back(pos, decompressed_size);
+    decompressed_size += get_le32(in+pos+member_size-4);
+    pos += member_size;
+  }
+  members.emplace_back(filesize_, decompressed_size);
+
+  buffer_ = malloc(decompressed_size);
+  if (buffer_ == NULL) {
+    BUFFER_ERROR_WITH_ERRNO("Cannot read to buffer; Mem allocation error");
+    return TILEDB_BF_ERR;
+  }
+  if (parallel_for(num_threads_, members.size()-1, [this, in, &members](size_t i) {
+        return gzip_decompress_member(in+members[i].first, members[i+1].first-members[i].first,
+                                      (unsigned char *)buffer_+members[i].second, members[i+1].second-members[i].second);
+      })) {
+    BUFFER_PATH_ERROR("Error encountered during parallel inflate", filename_);
+    return TILEDB_BF_ERR;
+  }
+  free_compress_buffer();
+
+  // adjust filesize_ to decompressed size as the reading will only be from memory now on
+  buffer_size_ = decompressed_size;
+  filesize_ = buffer_size_;
+  allocated_buffer_size_ = buffer_size_;
+
+  return TILEDB_BF_OK;
+}
+
 int CompressedStorageBuffer::gzip_write_buffer() {
+  if (num_threads_ > 1) {
+    // Compress blocks as independent gzip members that can be inflated in parallel
+    size_t processed = 0;
+    int level = compression_level_;
+    if (compress_blocks(processed, [level](const unsigned char *in, size_t in_size, std::vector<unsigned char>& out) {
+          return gzip_compress_member(in, in_size, level, out);
+        })) {
+      BUFFER_PATH_ERROR("Could not compress blocks in parallel", filename_);
+      return TILEDB_BF_ERR;
+    }
+    return write_compressed_buffer(processed);
+  }
+
   unsigned have;
   z_stream strm;
   unsigned char out[TILEDB_GZIP_CHUNK_SIZE];
@@ -404,18 +715,32 @@ int CompressedStorageBuffer::gzip_write_buffer() {
     return TILEDB_BF_ERR;
   }
 
+  return write_compressed_buffer(processed);
+}
+
+int CompressedStorageBuffer::write_compressed_buffer(size_t processed) {
   // Write directly if and only if the bytes to be written out is greater than the upload_file_size
   if (!fs_->get_upload_buffer_size() || (!compressed_write_buffer_size_ && processed >= fs_->get_upload_buffer_size())) {
-    // Write directly
-    if (fs_->write_to_file(filename_, compress_buffer_, processed)) {
+    // Write directly, compress_buffer_ is swapped out with write-behind so the next chunk can be compressed meanwhile
+    if (write_behind_) {
+      if (write_behind(compress_buffer_, compress_buffer_size_, processed)) {
+        return TILEDB_BF_ERR;
+      }
+    } else if (fs_->write_to_file(filename_, compress_buffer_, processed)) {
       BUFFER_PATH_ERROR("Cannot write bytes", filename_);
       return TILEDB_BF_ERR;
     }
   } else {
+    // Direct writes in the background have to complete before writing out from compressed_write_buffer_
+    if (wait_for_write_behind()) {
+      BUFFER_PATH_ERROR("Cannot write bytes in the background; " + write_behind_errmsg_, filename_);
+      return TILEDB_BF_ERR;
+    }
     // Use another buffer to hold the compressed bytes until the minimum upload_file_size is satisfied
     if (!compressed_write_buffer_) {
       assert(compressed_write_buffer_size_ == 0);
       compressed_write_buffer_ = std::make_shared<StorageBuffer>(fs_, filename_, fs_->get_upload_buffer_size());
+      compressed_write_buffer_->set_write_behind(false);
     }
     if (compressed_write_buffer_->append_buffer(compress_buffer_, processed)) {
       BUFFER_PATH_ERROR("Cannot write buffer after compression", filename_);
@@ -431,11 +756,162 @@ int CompressedStorageBuffer::gzip_write_buffer() {
   return TILEDB_BF_OK;
 }
 
+int CompressedStorageBuffer::compress_blocks(size_t& processed,
+                                             const std::function<int(const unsigned char*, size_t, std::vector<unsigned char>&)>& compress_fn) {
+  size_t block_size = std::min(std::max((buffer_size_+num_threads_-1)/num_threads_, (size_t)MIN_BLOCK_SIZE), (size_t)MAX_BLOCK_SIZE);
+  size_t num_blocks = (buffer_size_+block_size-1)/block_size;
+  std::vector<std::vector<unsigned char>> compressed_blocks(num_blocks);
+  if (parallel_for(num_threads_, num_blocks, [this, block_size, &compressed_blocks, &compress_fn](size_t i) {
+        size_t offset = i*block_size;
+        return compress_fn((unsigned char *)buffer_+offset, std::min(block_size, buffer_size_-offset), compressed_blocks[i]);
+      })) {
+    return TILEDB_BF_ERR;
+  }
+
+  processed = 0;
+  for (auto& compressed_block : compressed_blocks) {
+    processed += compressed_block.size();
+  }
+  if (compress_buffer_size_ < processed) {
+    compress_buffer_ = realloc(compress_buffer_, processed);
+    if (compress_buffer_ == NULL) {
+      BUFFER_ERROR_WITH_ERRNO("Cannot write to compress buffer; Mem allocation error");
+      return TILEDB_BF_ERR;
+    }
+    compress_buffer_size_ = processed;
+  }
+  size_t offset = 0;
+  for (auto& compressed_block : compressed_blocks) {
+    memcpy((char *)compress_buffer_+offset, compressed_block.data(), compressed_block.size());
+    offset += compressed_block.size();
+  }
+  return TILEDB_BF_OK;
+}
+
+int CompressedStorageBuffer::read_compressed_file() {
+  if (compress_buffer_size_ < filesize_) {
+    compress_buffer_ = realloc(compress_buffer_, filesize_);
+    if (compress_buffer_ == NULL) {
+      BUFFER_ERROR_WITH_ERRNO("Cannot read file into buffer; Mem allocation error for " + filename_
+                              + " filesize=" + std::to_string(filesize_));
+      return TILEDB_BF_ERR;
+    }
+    compress_buffer_size_ = filesize_;
+  }
+  if (fs_->read_from_file(filename_, 0, compress_buffer_, filesize_)) {
+    BUFFER_PATH_ERROR("Could not read from file for decompression", filename_);
+    return TILEDB_BF_ERR;
+  }
+  return TILEDB_BF_OK;
+}
+
+int CompressedStorageBuffer::zstd_read_buffer() {
+  if (read_compressed_file()) return TILEDB_BF_ERR;
+  return zstd_decompress_buffer();
+}
+
+#ifdef ENABLE_ZSTD
+int CompressedStorageBuffer::zstd_decompress_buffer() {
+  // Codecs are created per block as they are not thread-safe, the first one also binds the zstd symbols
+  Codec *codec = NULL;
+  try {
+    if (Codec::create((void **)&codec, TILEDB_ZSTD, compression_level_)) {
+      BUFFER_PATH_ERROR("Could not create zstd codec", filename_);
+      return TILEDB_BF_ERR;
+    }
+  } catch (const std::exception& ex) {
+    BUFFER_PATH_ERROR("Could not create zstd codec: " + std::string(ex.what()), filename_);
+    return TILEDB_BF_ERR;
+  }
+  delete codec;
+
+  // Locate the zstd frames and their decompressed offsets
+  unsigned char *in = (unsigned char *)compress_buffer_;
+  std::vector<std::pair<size_t, size_t>> frames; // compressed and decompressed offsets
+  size_t decompressed_size = 0;
+  for (size_t pos = 0; pos < filesize_;) {
+    size_t frame_size = ZSTD_findFrameCompressedSize(in+pos, filesize_-pos);
+    unsigned long long content_size = ZSTD_getFrameContentSize(in+pos, filesize_-pos);
+    // ZSTD_CONTENTSIZE_UNKNOWN and ZSTD_CONTENTSIZE_ERROR are the two largest values
+    if (ZSTD_isError(frame_size) || content_size >= (0ULL-2)) {
+      BUFFER_PATH_ERROR("Could not locate zstd frame for decompression at offset=" + std::to_string(pos), filename_);
+      return TILEDB_BF_ERR;
+    }
+    frames.emplace_back(pos, decompressed_size);
+    decompressed_size += content_size;
+    pos += frame_size;
+  }
+  frames.emplace_back(filesize_, decompressed_size);
+
+  buffer_ = malloc(decompressed_size);
+  if (buffer_ == NULL) {
+    BUFFER_ERROR_WITH_ERRNO("Cannot read to buffer; Mem allocation error");
+    return TILEDB_BF_ERR;
+  }
+  int level = compression_level_;
+  if (parallel_for(num_threads_, frames.size()-1, [this, in, level, &frames](size_t i) {
+        void *handle;
+        if (Codec::create(&handle, TILEDB_ZSTD, level)) return TILEDB_BF_ERR;
+        std::unique_ptr<Codec> codec(reinterpret_cast<Codec *>(handle));
+        return codec->do_decompress_tile(in+frames[i].first, frames[i+1].first-frames[i].first,
+                                         (unsigned char *)buffer_+frames[i].second, frames[i+1].second-frames[i].second);
+      })) {
+    BUFFER_PATH_ERROR("Error encountered during zstd decompression", filename_);
+    return TILEDB_BF_ERR;
+  }
+  free_compress_buffer();
+
+  // adjust filesize_ to decompressed size as the reading will only be from memory now on
+  buffer_size_ = decompressed_size;
+  filesize_ = buffer_size_;
+  allocated_buffer_size_ = buffer_size_;
+
+  return TILEDB_BF_OK;
+}
+
+int CompressedStorageBuffer::zstd_write_buffer() {
+  int level = compression_level_;
+  size_t processed = 0;
+  try {
+    if (compress_blocks(processed, [level](const unsigned char *in, size_t in_size, std::vector<unsigned char>& out) {
+          void *handle;
+          if (Codec::create(&handle, TILEDB_ZSTD, level)) return TILEDB_BF_ERR;
+          std::unique_ptr<Codec> codec(reinterpret_cast<Codec *>(handle));
+          void *compressed;
+          size_t compressed_size;
+          if (codec->do_compress_tile(const_cast<unsigned char *>(in), in_size, &compressed, compressed_size)) {
+            return TILEDB_BF_ERR;
+          }
+          out.assign((unsigned char *)compressed, (unsigned char *)compressed+compressed_size);
+          return TILEDB_BF_OK;
+        })) {
+      BUFFER_PATH_ERROR("Could not compress blocks with zstd", filename_);
+      return TILEDB_BF_ERR;
+    }
+  } catch (const std::exception& ex) {
+    BUFFER_PATH_ERROR("Could not compress blocks with zstd: " + std::string(ex.what()), filename_);
+    return TILEDB_BF_ERR;
+  }
+  return write_compressed_buffer(processed);
+}
+#else
+int CompressedStorageBuffer::zstd_decompress_buffer() {
+  BUFFER_PATH_ERROR("Cannot decompress zstd file as zstd support is not enabled", filename_);
+  return TILEDB_BF_ERR;
+}
+
+int CompressedStorageBuffer::zstd_write_buffer() {
+  BUFFER_PATH_ERROR("Cannot compress with zstd as zstd support is not enabled", filename_);
+  return TILEDB_BF_ERR;
+}
+#endif
+
 int CompressedStorageBuffer::finalize() {
   int rc = TILEDB_BF_OK;
   if (!read_only_) {
     // Compress and write out any remaining bytes
     rc = write_buffer();
+    rc = wait_for_write_behind() || rc;
     if (compressed_write_buffer_) {
       rc = rc || compressed_write_buffer_->finalize();
     }
@@ -34,6 +34,7 @@
 #include "storage_fs.h"
 #include "utils.h"
 
+#include <algorithm>
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
@@ -42,7 +43,7 @@
 /*        GLOBAL VARIABLES        */
 /* ****************************** */
 
-std::string tiledb_fs_errmsg = "";
+thread_local std::string tiledb_fs_errmsg = "";
 
 StorageFS::~StorageFS() {
   // Default
@@ -52,6 +53,15 @@ int StorageFS::close_file(const std::string& filename) {
   return TILEDB_FS_OK;
 }
 
+int StorageFS::read_from_file_v(const std::string& filename, const std::vector<read_range_t>& ranges) {
+  for (auto& range : ranges) {
+    if (read_from_file(filename, range.offset, range.buffer, range.length)) {
+      return TILEDB_FS_ERR;
+    }
+  }
+  return TILEDB_FS_OK;
+}
+
 bool StorageFS::locking_support() {
   return false;
 }
@@ -89,3 +99,49 @@ int StorageCloudFS::close_file(const std::string& filename) {
   return commit_file(filename);
 }
 
+
+#define READ_COALESCE_GAP 256*1024
+
+int StorageCloudFS::read_from_file_v(const std::string& filename, const std::vector<read_range_t>& ranges) {
+  size_t gap = READ_COALESCE_GAP;
+  auto coalesce_gap = getenv("TILEDB_READ_COALESCE_GAP");
+  if (coalesce_gap) {
+    gap = std::stoull(coalesce_gap);
+  }
+
+  std::vector<const read_range_t *> sorted;
+  for (auto& range : ranges) {
+    if (range.length > 0) {
+      sorted.push_back(&range);
+    }
+  }
+  std::sort(sorted.begin(), sorted.end(), [](const read_range_t *a, const read_range_t *b) {
+    return a->offset < b->offset;
+  });
+
+  std::vector<char> coalesced;
+  for (auto i=0ul; i<sorted.size();) {
+    off_t start = sorted[i]->offset;
+    off_t end = start + sorted[i]->length;
+    auto j = i+1;
+    while (j < sorted.size() && sorted[j]->offset <= end + static_cast<off_t>(gap)) {
+      end = std::max(end, static_cast<off_t>(sorted[j]->offset + sorted[j]->length));
+      j++;
+    }
+    if (j == i+1) {
+      if (read_from_file(filename, start, sorted[i]->buffer, sorted[i]->length)) {
+        return TILEDB_FS_ERR;
+      }
+    } else {
+      coalesced.resize(end - start);
+      if (read_from_file(filename, start, coalesced.data(), coalesced.size())) {
+        return TILEDB_FS_ERR;
+      }
+      for (auto k=i; k<j; k++) {
+        memcpy(sorted[k]->buffer, coalesced.data() + (sorted[k]->offset - start), sorted[k]->length);
+      }
+    }
+    i = j;
+  }
+  return TILEDB_FS_OK;
+}
@@ -36,12 +36,14 @@
 
 #include "google/cloud/storage/client_options.h"
 
+#include <algorithm>
 #include <cerrno>
 #include <cstring>
 #include <clocale>
 #include <iostream>
 #include <memory>
 #include <cstdlib>
+#include <future>
 #include <unistd.h>
 #include <system_error>
 
@@ -97,6 +99,17 @@ GCS::GCS(const std::string& home) {
   // Minimum size for each part of a multipart upload, except for the last part, using the same value for both uploads and downloads for now
   download_buffer_size_ = 5*1024*1024; // 5M
   upload_buffer_size_ = 5*1024*1024; // 5M
+
+  auto num_threads = getenv("TILEDB_NUM_THREADS");
+  if (num_threads) {
+    num_threads_ = std::string(num_threads)=="0"?1:std::stoi(num_threads);
+    if (!num_threads_) num_threads_ = 1;
+  }
+  auto parallel_read_threshold = getenv("TILEDB_PARALLEL_READ_THRESHOLD");
+  if (parallel_read_threshold) {
+    parallel_read_threshold_ = std::stoull(parallel_read_threshold);
+    if (!parallel_read_threshold_) parallel_read_threshold_ = 1;
+  }
 }
   
 GCS::~GCS() {
@@ -227,23 +240,54 @@ ssize_t GCS::file_size(const std::string& filename) {
   }
 }
 
+// Returns an error message if the range could not be read completely, empty otherwise. Errors are not
+// set here as ranges can be read concurrently.
+std::string GCS::read_range(const std::string& path, off_t offset, void *buffer, size_t length) {
+  gcs::ObjectReadStream stream = client_->ReadObject(bucket_name_, path, gcs::ReadRange(offset, offset+length));
+  if (!stream.status().ok()) {
+    return "Failed to get object " + stream.status().message();
+  }
+
+  stream.read(static_cast<char *>(buffer), length);
+  if ((size_t)stream.gcount() < length) {
+    return "Could not read the file for bytes of length=" + std::to_string(length) + " from offset=" + std::to_string(offset);
+  }
+
+  return "";
+}
+
 int GCS::read_from_file(const std::string& filename, off_t offset, void *buffer, size_t length) {
   if (length == 0) {
     return TILEDB_FS_OK; // Nothing to read
   }
 
-  gcs::ObjectReadStream stream = client_->ReadObject(bucket_name_, get_path(filename), gcs::ReadRange(offset, offset+length));
-  if (!stream.status().ok()) {
-    GCS_ERROR1("Failed to get object", stream.status(), filename);
-    return TILEDB_FS_ERR;
+  // Split large reads into concurrent ranged reads, each landing directly in its slice of buffer
+  size_t num_ranges = 1;
+  if (num_threads_ > 1 && length > parallel_read_threshold_) {
+    num_ranges = std::min((size_t)num_threads_, (length+parallel_read_threshold_-1)/parallel_read_threshold_);
   }
-  
-  stream.read(static_cast<char *>(buffer), length);
-  if ((size_t)stream.gcount() < length) {
-    GCS_ERROR("Could not read the file for bytes of length=" + std::to_string(length) + " from offset=" + std::to_string(offset), filename);
+  size_t range_size = (length+num_ranges-1)/num_ranges;
+
+  std::string path = get_path(filename);
+  std::vector<std::future<std::string>> range_futures;
+  for (size_t range_offset = range_size; range_offset < length; range_offset += range_size) {
+    size_t range_length = std::min(range_size, length-range_offset);
+    char *buf = static_cast<char *>(buffer)+range_offset;
+    range_futures.emplace_back(std::async(std::launch::async, &GCS::read_range, this, path, offset+range_offset, buf, range_length));
+  }
+  // Read the first range on this thread
+  std::string msg = read_range(path, offset, buffer, std::min(range_size, length));
+
+  // Wait for all the ranges to complete before returning as they write into buffer
+  for (auto& range_future : range_futures) {
+    auto range_msg = range_future.get();
+    if (msg.empty()) msg = range_msg;
+  }
+  if (!msg.empty()) {
+    GCS_ERROR(msg, filename);
     return TILEDB_FS_ERR;
   }
-  
+
   return TILEDB_FS_OK;
 }
 
@@ -0,0 +1,253 @@
+/**
+ * @file   storage_io_uring.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2026 Omics Data Automation, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Batched asynchronous reads for PosixFS with Linux io_uring
+ */
+
+#include "storage_io_uring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/uio.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#  include <linux/io_uring.h>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#  if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#    define HAVE_IO_URING
+#  endif
+#endif
+
+#ifdef HAVE_IO_URING
+
+IoUring::IoUring(unsigned queue_depth) {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring_fd_ = syscall(__NR_io_uring_setup, queue_depth, &params);
+  if (ring_fd_ < 0) {
+    ring_fd_ = -1;
+    return;
+  }
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries*sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries*sizeof(struct io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+
+  sq_ring_ = mmap(NULL, sq_ring_size_, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    sq_ring_ = NULL;
+    teardown();
+    return;
+  }
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    cq_ring_ = sq_ring_;
+  } else {
+    cq_ring_ = mmap(NULL, cq_ring_size_, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      cq_ring_ = NULL;
+      teardown();
+      return;
+    }
+  }
+  sqes_size_ = params.sq_entries*sizeof(struct io_uring_sqe);
+  sqes_ = mmap(NULL, sqes_size_, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes_ == MAP_FAILED) {
+    sqes_ = NULL;
+    teardown();
+    return;
+  }
+
+  char *sq_ring = reinterpret_cast<char *>(sq_ring_);
+  sq_head_ = reinterpret_cast<unsigned *>(sq_ring + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq_ring + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned *>(sq_ring + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq_ring + params.sq_off.array);
+  sq_entries_ = params.sq_entries;
+
+  char *cq_ring = reinterpret_cast<char *>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned *>(cq_ring + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq_ring + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned *>(cq_ring + params.cq_off.ring_mask);
+  cqes_ = cq_ring + params.cq_off.cqes;
+}
+
+void IoUring::teardown() {
+  if (sqes_) {
+    munmap(sqes_, sqes_size_);
+    sqes_ = NULL;
+  }
+  if (cq_ring_ && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  cq_ring_ = NULL;
+  if (sq_ring_) {
+    munmap(sq_ring_, sq_ring_size_);
+    sq_ring_ = NULL;
+  }
+  if (ring_fd_ >= 0) {
+    // Closing the ring also cancels requests still in flight
+    close(ring_fd_);
+    ring_fd_ = -1;
+  }
+}
+
+void IoUring::wait_for_completions(unsigned submitted) {
+  while (submitted > 0) {
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    submitted -= std::min(submitted, tail - head);
+    __atomic_store_n(cq_head_, tail, __ATOMIC_RELEASE);
+    if (submitted > 0 && syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0
+        && errno != EINTR) {
+      // Completions are still posted to the ring, poll for them
+      usleep(1000);
+    }
+  }
+}
+
+int IoUring::read(int fd, const std::vector<read_range_t>& ranges) {
+  if (!is_valid()) {
+    errno = ENOSYS;
+    return TILEDB_FS_ERR;
+  }
+
+  // Remaining part of each range, short reads are resubmitted for the rest of the range
+  typedef struct request_t {
+    struct iovec iov;
+    off_t offset;
+  } request_t;
+  std::vector<request_t> requests;
+  std::vector<size_t> pending;
+  for (auto& range : ranges) {
+    if (range.length > 0) {
+      pending.push_back(requests.size());
+      requests.push_back({{range.buffer, range.length}, range.offset});
+    }
+  }
+
+  struct io_uring_sqe *sqes = reinterpret_cast<struct io_uring_sqe *>(sqes_);
+  struct io_uring_cqe *cqes = reinterpret_cast<struct io_uring_cqe *>(cqes_);
+  unsigned inflight = 0;
+  unsigned unsubmitted = 0;
+  int err = -1;
+  while ((!pending.empty() && err < 0) || inflight > 0) {
+    // Queue as many requests as there are free submission entries
+    unsigned tail = *sq_tail_;
+    while (!pending.empty() && err < 0 && inflight < sq_entries_) {
+      request_t& request = requests[pending.back()];
+      unsigned index = tail & *sq_mask_;
+      struct io_uring_sqe *sqe = &sqes[index];
+      memset(sqe, 0, sizeof(struct io_uring_sqe));
+      sqe->opcode = IORING_OP_READV;
+      sqe->fd = fd;
+      sqe->addr = reinterpret_cast<uint64_t>(&request.iov);
+      sqe->len = 1;
+      sqe->off = request.offset;
+      sqe->user_data = pending.back();
+      sq_array_[index] = index;
+      pending.pop_back();
+      tail++;
+      inflight++;
+      unsubmitted++;
+    }
+    __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+
+    // Submit and wait for at least one completion
+    int rc = syscall(__NR_io_uring_enter, ring_fd_, unsubmitted, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+    if (rc < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+        continue;
+      }
+      // Give up on this ring, but only once the kernel is done with the buffers of the
+      // submitted requests, as the caller reads into them again
+      int saved_errno = errno;
+      wait_for_completions(inflight - unsubmitted);
+      teardown();
+      errno = saved_errno;
+      return TILEDB_FS_ERR;
+    }
+    unsubmitted -= rc;
+
+    // Reap completions
+    unsigned head = *cq_head_;
+    while (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      struct io_uring_cqe *cqe = &cqes[head & *cq_mask_];
+      size_t i = cqe->user_data;
+      if (cqe->res == -EINTR || cqe->res == -EAGAIN) {
+        pending.push_back(i);
+      } else if (cqe->res < 0) {
+        err = -cqe->res;
+      } else if (cqe->res == 0) {
+        err = 0; // EOF
+      } else if (static_cast<size_t>(cqe->res) < requests[i].iov.iov_len) {
+        requests[i].iov.iov_base = reinterpret_cast<char *>(requests[i].iov.iov_base) + cqe->res;
+        requests[i].iov.iov_len -= cqe->res;
+        requests[i].offset += cqe->res;
+        pending.push_back(i);
+      }
+      head++;
+      inflight--;
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+  }
+
+  if (err >= 0) {
+    errno = err;
+    return TILEDB_FS_ERR;
+  }
+  return TILEDB_FS_OK;
+}
+
+#else
+
+IoUring::IoUring(unsigned queue_depth) {
+  // io_uring not supported
+}
+
+void IoUring::teardown() {
+}
+
+void IoUring::wait_for_completions(unsigned submitted) {
+}
+
+int IoUring::read(int fd, const std::vector<read_range_t>& ranges) {
+  errno = ENOSYS;
+  return TILEDB_FS_ERR;
+}
+
+#endif
+
+IoUring::~IoUring() {
+  teardown();
+}
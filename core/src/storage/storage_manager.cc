@@ -33,9 +33,12 @@
 
 #include "storage_manager.h"
 
+#include "book_keeping_cache.h"
+#include "fragment_manifest.h"
 #include "uri.h"
 #include "utils.h"
 #include "storage_fs.h"
+#include "tile_cache.h"
 
 #include <cassert>
 #include <cstring>
@@ -69,6 +72,9 @@
 #define GET_MACRO(_1, _2, _3, NAME, ...) NAME
 #define SORT(...) GET_MACRO(__VA_ARGS__, SORT_3, SORT_2)(__VA_ARGS__)
 
+/** Default number of fragments whose book-keeping is loaded concurrently. */
+#define BOOK_KEEPING_LOAD_THREADS 8
+
 
 
 
@@ -76,7 +82,7 @@
 /*        GLOBAL VARIABLES        */
 /* ****************************** */
 
-std::string tiledb_sm_errmsg = "";
+thread_local std::string tiledb_sm_errmsg = "";
 
 
 
@@ -302,6 +308,10 @@ int StorageManager::array_consolidate(const char* array_dir, size_t buffer_size,
   delete array;
 
   int rc_delete = delete_directories(fs_, old_fragment_names);
+  for(auto const& fragment_name : old_fragment_names) {
+    BookKeepingCache::instance().invalidate(fragment_name);
+    TileCache::instance().invalidate(fragment_name);
+  }
 
   // Errors 
   if(rc_array_consolidate != TILEDB_AR_OK) {
@@ -386,10 +396,32 @@ int StorageManager::array_create(const ArraySchema* array_schema) const {
 
 void StorageManager::array_get_fragment_names(
     const std::string& array,
-    std::vector<std::string>& fragment_names) {
+    std::vector<std::string>& fragment_names,
+    std::vector<int>& fragment_dense) {
+  std::string array_real = real_dir(fs_, array);
+  fragment_names.clear();
+  fragment_dense.clear();
+
+  // The manifest lists the committed fragments in the order of their timestamps.
+  // Fragments missing from it, e.g. after an update lost to a concurrent commit
+  // without file locking, are found in the listing of the array directory.
+  FragmentManifest manifest(fs_, array_real);
+  if(manifest.load()) {
+    manifest.reconcile();
+    std::vector<FragmentManifest::entry_t> entries = manifest.entries();
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const FragmentManifest::entry_t& a, const FragmentManifest::entry_t& b) {
+                       return a.timestamp_ < b.timestamp_;
+                     });
+    for(auto const& entry : entries) {
+      fragment_names.push_back(fs_->append_paths(array_real, entry.name_));
+      fragment_dense.push_back(entry.dense_);
+    }
+    return;
+  }
 
   // Get directory names in the array folder
-  fragment_names = get_fragment_dirs(fs_, real_dir(fs_, array)); 
+  fragment_names = get_fragment_dirs(fs_, array_real); 
 
   // Sort the fragment names
   sort_fragment_names(fragment_names);
@@ -398,37 +430,127 @@ void StorageManager::array_get_fragment_names(
 int StorageManager::array_load_book_keeping(
     const ArraySchema* array_schema,
     const std::vector<std::string>& fragment_names,
+    const std::vector<int>& fragment_dense,
     std::vector<BookKeeping*>& book_keeping,
-    int mode) {
+    std::vector<std::shared_ptr<BookKeeping>>& cached_book_keeping,
+    int mode,
+    const std::vector<int>& attribute_ids) {
   // For easy reference
   int fragment_num = fragment_names.size(); 
 
   // Initialization
-  book_keeping.resize(fragment_num);
+  book_keeping.assign(fragment_num, NULL);
+  cached_book_keeping.clear();
+
+  int load_threads = BOOK_KEEPING_LOAD_THREADS;
+  auto env_var = getenv("TILEDB_BOOKKEEPING_LOAD_THREADS");
+  if(env_var)
+    load_threads = std::max(std::stoi(env_var), 1);
+
+  // Book-keeping of fragments opened for reads is shared through the
+  // process-wide cache if it is enabled
+  BookKeepingCache& cache = BookKeepingCache::instance();
+  bool use_cache = array_read_mode(mode) && cache.max_size() > 0;
+
+  // Only the fragments not found in the cache are loaded
+  std::vector<int> to_load;
+  if(use_cache) {
+    cached_book_keeping.resize(fragment_num);
+    for(int i=0; i<fragment_num; ++i) {
+      cached_book_keeping[i] = cache.get(fragment_names[i]);
+      if(cached_book_keeping[i])
+        book_keeping[i] = cached_book_keeping[i].get();
+      else
+        to_load.push_back(i);
+    }
+  } else {
+    for(int i=0; i<fragment_num; ++i)
+      to_load.push_back(i);
+  }
+
+  // Cached book-keeping may outlive the open array, so it refers to its own
+  // copy of the array schema
+  std::shared_ptr<ArraySchema> cached_array_schema;
+  if(use_cache && !to_load.empty()) {
+    void* array_schema_bin;
+    size_t array_schema_bin_size;
+    if(array_schema->serialize(array_schema_bin, array_schema_bin_size) != TILEDB_AS_OK) {
+      cached_book_keeping.clear();
+      book_keeping.clear();
+      tiledb_sm_errmsg = tiledb_as_errmsg;
+      return TILEDB_SM_ERR;
+    }
+    // The copy is not tied to the filesystem of this storage manager
+    cached_array_schema = std::make_shared<ArraySchema>(nullptr);
+    int rc = cached_array_schema->deserialize(array_schema_bin, array_schema_bin_size);
+    free(array_schema_bin);
+    if(rc != TILEDB_AS_OK) {
+      cached_book_keeping.clear();
+      book_keeping.clear();
+      tiledb_sm_errmsg = tiledb_as_errmsg;
+      return TILEDB_SM_ERR;
+    }
+  }
 
-  // Load the book-keeping for each fragment
-  for(int i=0; i<fragment_num; ++i) {
+  // Load the book-keeping for each fragment, upto load_threads fragments at a time.
+  // Error messages are thread-local, so each load keeps its own error message
+  // to be reported once all the loads are done.
+  std::vector<std::string> errmsgs(to_load.size());
+  auto load = [&](size_t j) {
     // For easy reference
-    int dense = 
+    int i = to_load[j];
+    int dense = !fragment_dense.empty() ? fragment_dense[i] :
         !fs_->is_file(fs_->append_paths(fragment_names[i], std::string(TILEDB_COORDS) + TILEDB_FILE_SUFFIX));
 
     // Create new book-keeping structure for the fragment
     BookKeeping* f_book_keeping = 
         new BookKeeping(
-            array_schema, 
+            use_cache ? cached_array_schema.get() : array_schema,
             dense, 
             fragment_names[i], 
             mode);
 
     // Load book-keeping
-    if(f_book_keeping->load(fs_) != TILEDB_BK_OK) {
+    if(f_book_keeping->load(fs_, attribute_ids) != TILEDB_BK_OK) {
       delete f_book_keeping;
-      tiledb_sm_errmsg = tiledb_bk_errmsg;
+      errmsgs[j] = tiledb_bk_errmsg;
       return TILEDB_SM_ERR;
     }
 
     // Append to the open array entry
     book_keeping[i] = f_book_keeping;
+    return TILEDB_SM_OK;
+  };
+
+  if(parallel_for(load_threads, to_load.size(), load) != TILEDB_UT_OK) {
+    for(auto i : to_load)
+      delete book_keeping[i];
+    book_keeping.clear();
+    cached_book_keeping.clear();
+
+    // Report the first fragment that failed to load
+    auto failed = std::find_if(errmsgs.begin(), errmsgs.end(),
+                               [](const std::string& errmsg) { return !errmsg.empty(); });
+    if(failed == errmsgs.end()) {
+      std::string errmsg = "Cannot load book-keeping";
+      PRINT_ERROR(errmsg);
+      tiledb_sm_errmsg = TILEDB_SM_ERRMSG + errmsg;
+    } else {
+      tiledb_bk_errmsg = *failed;
+      tiledb_sm_errmsg = tiledb_bk_errmsg;
+    }
+    return TILEDB_SM_ERR;
+  }
+
+  // Share the newly loaded book-keeping, it is deleted along with the last
+  // reference to it
+  if(use_cache) {
+    for(auto i : to_load) {
+      cached_book_keeping[i] = std::shared_ptr<BookKeeping>(
+          book_keeping[i],
+          [cached_array_schema](BookKeeping* f_book_keeping) { delete f_book_keeping; });
+      cache.put(fragment_names[i], cached_book_keeping[i]);
+    }
   }
 
   // Success
@@ -501,6 +623,33 @@ int StorageManager::array_load_schema(
   return TILEDB_SM_OK;
 }
 
+/*
+ * Returns the ids of the input attributes found in the array schema along with
+ * the coordinates, or the ids of all the attributes if there are no input
+ * attributes. Invalid attributes are reported by Array::init().
+ */
+static std::vector<int> attribute_ids_to_load(
+    const ArraySchema* array_schema,
+    const char** attributes,
+    int attribute_num) {
+  std::vector<int> attribute_ids;
+  const std::vector<std::string>& schema_attributes = array_schema->attributes();
+  if(attributes == NULL) {
+    for(int i=0; i<array_schema->attribute_num(); ++i)
+      attribute_ids.push_back(i);
+  } else {
+    for(int i=0; i<attribute_num; ++i) {
+      if(attributes[i] == NULL)
+        continue;
+      auto it = std::find(schema_attributes.begin(), schema_attributes.end(), attributes[i]);
+      if(it != schema_attributes.end())
+        attribute_ids.push_back(it - schema_attributes.begin());
+    }
+  }
+  attribute_ids.push_back(array_schema->attribute_num());
+  return attribute_ids;
+}
+
 int StorageManager::array_init(
     Array*& array,
     const char* array_dir,
@@ -526,7 +675,8 @@ int StorageManager::array_init(
   // Open the array
   OpenArray* open_array = NULL;
   if(array_read_mode(mode) || array_consolidate_mode(mode)) {
-    if(array_open(full_array_path, open_array, mode) != TILEDB_SM_OK)
+    if(array_open(full_array_path, open_array, mode,
+                  attribute_ids_to_load(array_schema, attributes, attribute_num)) != TILEDB_SM_OK)
       return TILEDB_SM_ERR;
   }
 
@@ -770,6 +920,10 @@ int StorageManager::metadata_consolidate(const char* metadata_dir) {
   delete metadata;
 
   int rc_delete = delete_directories(fs_, old_fragment_names);
+  for(auto const& fragment_name : old_fragment_names) {
+    BookKeepingCache::instance().invalidate(fragment_name);
+    TileCache::instance().invalidate(fragment_name);
+  }
 
   // Errors 
   if(rc_metadata_consolidate != TILEDB_MT_OK) {
@@ -955,7 +1109,8 @@ int StorageManager::metadata_init(
     if(array_open(
            real_dir(fs_, metadata_dir), 
            open_array, 
-           TILEDB_ARRAY_READ) != TILEDB_SM_OK)
+           TILEDB_ARRAY_READ,
+           attribute_ids_to_load(array_schema, NULL, 0)) != TILEDB_SM_OK)
       return TILEDB_SM_ERR;
   }
 
@@ -1139,6 +1294,10 @@ int StorageManager::ls_c(const char* parent_dir, int& dir_num) const {
 }
 
 int StorageManager::clear(const std::string& dir) const {
+  // Fragments are removed, drop their cached book-keeping and tiles
+  BookKeepingCache::instance().invalidate(::real_dir(fs_, dir));
+  TileCache::instance().invalidate(::real_dir(fs_, dir));
+
   if(is_workspace(fs_, dir)) {
     return workspace_clear(dir);
   } else if(is_group(fs_, dir)) {
@@ -1156,6 +1315,10 @@ int StorageManager::clear(const std::string& dir) const {
 }
 
 int StorageManager::delete_entire(const std::string& dir) {
+  // Fragments are removed, drop their cached book-keeping and tiles
+  BookKeepingCache::instance().invalidate(::real_dir(fs_, dir));
+  TileCache::instance().invalidate(::real_dir(fs_, dir));
+
   if(is_workspace(fs_, dir)) {
     return workspace_delete(dir);
   } else if(is_group(fs_, dir)) {
@@ -1178,6 +1341,10 @@ int StorageManager::delete_entire(const std::string& dir) {
 int StorageManager::move(
     const std::string& old_dir,
     const std::string& new_dir) {
+  // Fragments are renamed, drop their cached book-keeping and tiles
+  BookKeepingCache::instance().invalidate(::real_dir(fs_, old_dir));
+  TileCache::instance().invalidate(::real_dir(fs_, old_dir));
+
   if(is_workspace(fs_, old_dir)) {
     return workspace_move(old_dir, new_dir);
   } else if(is_group(fs_, old_dir)) {
@@ -1219,6 +1386,12 @@ int StorageManager::array_clear(
     return TILEDB_SM_ERR;
   }
 
+  // Fragments listed in the manifest are about to be deleted
+  if(FragmentManifest::remove(fs_, array_real) != TILEDB_FM_OK) {
+    tiledb_sm_errmsg = tiledb_fm_errmsg;
+    return TILEDB_SM_ERR;
+  }
+
   std::vector<std::string> all_dirs = ::get_dirs(fs_, array_real);
   for(auto const& dir: all_dirs) {
     if(is_metadata(fs_, dir)) {
@@ -1267,10 +1440,13 @@ int StorageManager::array_close(const std::string& array) {
   int rc_mtx_destroy = TILEDB_SM_OK;
   int rc_filelock = TILEDB_SM_OK;
   if(it->second->cnt_ == 0) {
-    // Clean up book-keeping
-    std::vector<BookKeeping*>::iterator bit = it->second->book_keeping_.begin();
-    for(; bit != it->second->book_keeping_.end(); ++bit) 
-      delete *bit;
+    // Clean up book-keeping, cached book-keeping is released with its references
+    if(it->second->cached_book_keeping_.empty()) {
+      std::vector<BookKeeping*>::iterator bit = it->second->book_keeping_.begin();
+      for(; bit != it->second->book_keeping_.end(); ++bit) 
+        delete *bit;
+    }
+    it->second->cached_book_keeping_.clear();
 
     // Unlock and destroy mutexes
     it->second->mutex_unlock();
@@ -1431,7 +1607,8 @@ int StorageManager::array_move(
 int StorageManager::array_open(
     const std::string& array_name, 
     OpenArray*& open_array,
-    int mode) {
+    int mode,
+    const std::vector<int>& attribute_ids) {
   auto opened_first_time = false;
 
   // Get the open array entry
@@ -1454,7 +1631,8 @@ int StorageManager::array_open(
     }
 
     // Get the fragment names
-    array_get_fragment_names(array_name, open_array->fragment_names_);
+    std::vector<int> fragment_dense;
+    array_get_fragment_names(array_name, open_array->fragment_names_, fragment_dense);
 
     // Get array schema
     if(is_array(fs_, array_name)) { // Array
@@ -1472,8 +1650,11 @@ int StorageManager::array_open(
     if(array_load_book_keeping(
            open_array->array_schema_,
            open_array->fragment_names_,
+           fragment_dense,
            open_array->book_keeping_,
-           mode) != TILEDB_SM_OK) {
+           open_array->cached_book_keeping_,
+           mode,
+           attribute_ids) != TILEDB_SM_OK) {
       delete open_array->array_schema_;
       open_array->array_schema_ = NULL;
       open_array->mutex_unlock();
@@ -1677,6 +1858,11 @@ int StorageManager::consolidation_finalize(
       return TILEDB_SM_ERR;
     }
   }
+  if(FragmentManifest::remove_fragments(fs_, parent_dir(fs_, real_dir(fs_, old_fragment_names[0])),
+                                        old_fragment_names) != TILEDB_FM_OK) {
+    tiledb_sm_errmsg = tiledb_fm_errmsg;
+    return TILEDB_SM_ERR;
+  }
 
   // Unlock consolidation filelock       
   if(consolidation_filelock_unlock(fd) != TILEDB_SM_OK)
@@ -1853,6 +2039,12 @@ int StorageManager::metadata_clear(
     return TILEDB_SM_ERR;
   }
 
+  // Fragments listed in the manifest are about to be deleted
+  if(FragmentManifest::remove(fs_, metadata_real) != TILEDB_FM_OK) {
+    tiledb_sm_errmsg = tiledb_fm_errmsg;
+    return TILEDB_SM_ERR;
+  }
+
   std::vector<std::string> all_dirs = ::get_dirs(fs_, metadata_real);
   for(auto const& dir: all_dirs) {
     if(is_fragment(fs_, dir)) {
@@ -32,7 +32,9 @@
  */
 
 #include "storage_azure_blob.h"
+#include "storage_block_cache.h"
 #include "storage_gcs.h"
+#include "storage_memoryfs.h"
 #include "storage_s3.h"
 #include "storage_manager_config.h"
 #include "tiledb_constants.h"
@@ -59,7 +61,7 @@
 /*        GLOBAL VARIABLES        */
 /* ****************************** */
 
-std::string tiledb_smc_errmsg = "";
+thread_local std::string tiledb_smc_errmsg = "";
 
 /* ****************************** */
 /*   CONSTRUCTORS & DESTRUCTORS   */
@@ -131,6 +133,15 @@ int StorageManagerConfig::init(
          tiledb_smc_errmsg = TILEDB_SMC_ERRMSG + errmsg;
          return TILEDB_SMC_ERR;
        }
+     } else if (is_memory_path(home_)) {
+       try {
+          fs_ = new MemoryFS(home_);
+       } catch(std::system_error& ex) {
+         errmsg = CONCAT_ERRMSG("MemoryFS initialization failed for home=" + home_, tiledb_fs_errmsg, ex.what());
+         PRINT_ERROR(ex.what());
+         tiledb_smc_errmsg = TILEDB_SMC_ERRMSG + errmsg;
+         return TILEDB_SMC_ERR;
+       }
      } else if (is_supported_cloud_path(home_)) {
        try {
 #ifdef USE_HDFS
@@ -150,6 +161,19 @@ int StorageManagerConfig::init(
        return TILEDB_SMC_ERR;
      }
 
+     // Optionally cache blocks read from the cloud on local disk
+     auto block_cache_dir = getenv("TILEDB_BLOCK_CACHE_DIR");
+     if (block_cache_dir && strlen(block_cache_dir) > 0 && !is_memory_path(home_)) {
+       try {
+         fs_ = new BlockCacheFS(fs_, home_, block_cache_dir);
+       } catch(std::system_error& ex) {
+         errmsg = CONCAT_ERRMSG("Block cache initialization failed for home=" + home_, tiledb_fs_errmsg, ex.what());
+         PRINT_ERROR(ex.what());
+         tiledb_smc_errmsg = TILEDB_SMC_ERRMSG + errmsg;
+         return TILEDB_SMC_ERR;
+       }
+     }
+
      read_method_ = TILEDB_IO_READ;
      write_method_ = TILEDB_IO_WRITE;
      return TILEDB_SMC_OK;
@@ -175,8 +199,10 @@ int StorageManagerConfig::init(
   read_method_ = read_method;
   if(read_method_ != TILEDB_IO_READ &&
      read_method_ != TILEDB_IO_MMAP &&
-     read_method_ != TILEDB_IO_MPI)
+     read_method_ != TILEDB_IO_MPI &&
+     read_method_ != TILEDB_IO_URING)
     read_method_ = TILEDB_IO_MMAP;  // Use default 
+  dynamic_cast<PosixFS *>(fs_)->set_use_io_uring(read_method_ == TILEDB_IO_URING);
 
   // Initialize write method
   write_method_ = write_method;
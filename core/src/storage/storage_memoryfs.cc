@@ -0,0 +1,343 @@
+/**
+ * @file   storage_memoryfs.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2026 Omics Data Automation, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * In-memory Support for StorageFS
+ */
+
+#include "error.h"
+#include "storage_memoryfs.h"
+#include "utils.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <system_error>
+#include <unordered_map>
+
+#define MEMORYFS_ERROR(MSG, PATH) PATH_ERROR(TILEDB_FS_ERRMSG, "MemoryFS: "+MSG, PATH, tiledb_fs_errmsg)
+
+// Stores are shared by all the MemoryFS instances for a namespace and live until the process exits
+static std::mutex memory_stores_mtx;
+static std::unordered_map<std::string, std::shared_ptr<MemoryFS::memory_store_t>> memory_stores;
+
+static std::string dir_prefix(const std::string& key) {
+  return key.empty() ? key : key + DELIMITER;
+}
+
+MemoryFS::MemoryFS(const std::string& home) {
+  uri path_uri(home);
+
+  if (path_uri.protocol().compare("mem") != 0) {
+    throw std::system_error(EPROTONOSUPPORT, std::generic_category(), "MemoryFS only supports mem:// URI protocols");
+  }
+
+  namespace_ = path_uri.host();
+  {
+    std::lock_guard<std::mutex> lock(memory_stores_mtx);
+    auto& store = memory_stores[namespace_];
+    if (!store) {
+      store = std::make_shared<memory_store_t>();
+    }
+    store_ = store;
+  }
+
+  working_dir_ = get_path(path_uri.path());
+}
+
+std::string MemoryFS::current_dir() {
+  return working_dir_;
+}
+
+int MemoryFS::set_working_dir(const std::string& dir) {
+  working_dir_ = get_path(dir);
+  return TILEDB_FS_OK;
+}
+
+bool MemoryFS::is_dir_locked(const std::string& key) {
+  if (key.empty() || store_->dirs_.count(key)) {
+    return true;
+  }
+  // Directories are also implied by the paths of their contents
+  std::string prefix = dir_prefix(key);
+  auto dir = store_->dirs_.lower_bound(prefix);
+  if (dir != store_->dirs_.end() && starts_with(*dir, prefix)) {
+    return true;
+  }
+  auto file = store_->files_.lower_bound(prefix);
+  return file != store_->files_.end() && starts_with(file->first, prefix);
+}
+
+bool MemoryFS::is_dir(const std::string& dir) {
+  std::string key = unslashify(get_path(dir));
+  std::lock_guard<std::mutex> lock(store_->mtx_);
+  return is_dir_locked(key);
+}
+
+bool MemoryFS::is_file(const std::string& file) {
+  std::string key = unslashify(get_path(file));
+  std::lock_guard<std::mutex> lock(store_->mtx_);
+  return store_->files_.count(key) > 0;
+}
+
+std::string MemoryFS::real_dir(const std::string& dir) {
+  if (dir.find("://") != std::string::npos) {
+    uri path_uri(dir);
+    if (path_uri.protocol().compare("mem") || path_uri.host().compare(namespace_)) {
+      throw std::runtime_error("Namespace during instantiation does not match the uri passed to real_dir. Aborting");
+    }
+  }
+  return get_path(dir);
+}
+
+int MemoryFS::create_dir(const std::string& dir) {
+  std::string key = unslashify(get_path(dir));
+  std::lock_guard<std::mutex> lock(store_->mtx_);
+  if (is_dir_locked(key) || store_->files_.count(key)) {
+    MEMORYFS_ERROR("Path already exists", dir);
+    return TILEDB_FS_ERR;
+  }
+  store_->dirs_.insert(key);
+  return TILEDB_FS_OK;
+}
+
+int MemoryFS::delete_dir(const std::string& dir) {
+  std::string key = unslashify(get_path(dir));
+  std::lock_guard<std::mutex> lock(store_->mtx_);
+  if (store_->files_.count(key)) {
+    MEMORYFS_ERROR("Cannot delete dir as it seems to be a file", dir);
+    return TILEDB_FS_ERR;
+  }
+  if (!is_dir_locked(key)) {
+    MEMORYFS_ERROR("Cannot delete non-existent dir", dir);
+    return TILEDB_FS_ERR;
+  }
+
+  std::string prefix = dir_prefix(key);
+  auto file = store_->files_.lower_bound(prefix);
+  while (file != store_->files_.end() && starts_with(file->first, prefix)) {
+    file = store_->files_.erase(file);
+  }
+  auto subdir = store_->dirs_.lower_bound(prefix);
+  while (subdir != store_->dirs_.end() && starts_with(*subdir, prefix)) {
+    subdir = store_->dirs_.erase(subdir);
+  }
+  store_->dirs_.erase(key);
+  return TILEDB_FS_OK;
+}
+
+std::vector<std::string> MemoryFS::get_dirs(const std::string& dir) {
+  std::string prefix = dir_prefix(unslashify(get_path(dir)));
+  std::set<std::string> dirs;
+  auto add_dir = [&dirs, &prefix](const std::string& path, bool path_is_dir) {
+    auto pos = path.find(DELIMITER, prefix.size());
+    if (pos != std::string::npos) {
+      dirs.insert(path.substr(0, pos));
+    } else if (path_is_dir) {
+      dirs.insert(path);
+    }
+  };
+
+  std::lock_guard<std::mutex> lock(store_->mtx_);
+  for (auto it = store_->dirs_.lower_bound(prefix); it != store_->dirs_.end() && starts_with(*it, prefix); it++) {
+    add_dir(*it, true);
+  }
+  for (auto it = store_->files_.lower_bound(prefix); it != store_->files_.end() && starts_with(it->first, prefix); it++) {
+    add_dir(it->first, false);
+  }
+  return std::vector<std::string>(dirs.begin(), dirs.end());
+}
+
+std::vector<std::string> MemoryFS::get_files(const std::string& dir) {
+  std::string prefix = dir_prefix(unslashify(get_path(dir)));
+  std::vector<std::string> files;
+
+  std::lock_guard<std::mutex> lock(store_->mtx_);
+  for (auto it = store_->files_.lower_bound(prefix); it != store_->files_.end() && starts_with(it->first, prefix); it++) {
+    if (it->first.find(DELIMITER, prefix.size()) == std::string::npos) {
+      files.push_back(it->first);
+    }
+  }
+  return files;
+}
+
+int MemoryFS::create_file(const std::string& filename, int flags, mode_t mode) {
+  std::string key = unslashify(get_path(filename));
+  std::lock_guard<std::mutex> lock(store_->mtx_);
+  if (is_dir_locked(key)) {
+    MEMORYFS_ERROR("Cannot create path as it already exists", filename);
+    return TILEDB_FS_ERR;
+  }
+  auto& file = store_->files_[key];
+  if (!file || (flags & O_TRUNC)) {
+    file = std::make_shared<std::vector<char>>();
+  } else if (flags & O_EXCL) {
+    MEMORYFS_ERROR("Cannot create path as it already exists", filename);
+    return TILEDB_FS_ERR;
+  }
+  return TILEDB_FS_OK;
+}
+
+int MemoryFS::delete_file(const std::string& filename) {
+  std::string key = unslashify(get_path(filename));
+  std::lock_guard<std::mutex> lock(store_->mtx_);
+  if (!store_->files_.erase(key)) {
+    MEMORYFS_ERROR("Cannot delete non-existent or non-file path", filename);
+    return TILEDB_FS_ERR;
+  }
+  return TILEDB_FS_OK;
+}
+
+ssize_t MemoryFS::file_size(const std::string& filename) {
+  std::string key = unslashify(get_path(filename));
+  std::lock_guard<std::mutex> lock(store_->mtx_);
+  auto search = store_->files_.find(key);
+  if (search == store_->files_.end()) {
+    return TILEDB_FS_ERR;
+  }
+  return search->second->size();
+}
+
+int MemoryFS::read_from_file(const std::string& filename, off_t offset, void *buffer, size_t length) {
+  if (length == 0) {
+    return TILEDB_FS_OK;
+  }
+
+  file_t file;
+  {
+    std::string key = unslashify(get_path(filename));
+    std::lock_guard<std::mutex> lock(store_->mtx_);
+    auto search = store_->files_.find(key);
+    if (search != store_->files_.end()) {
+      file = search->second;
+    }
+  }
+  if (!file) {
+    MEMORYFS_ERROR("Cannot read from non-existent file", filename);
+    return TILEDB_FS_ERR;
+  }
+  if (offset < 0 || offset + length > file->size()) {
+    MEMORYFS_ERROR("EOF reached; File reading error", filename);
+    return TILEDB_FS_ERR;
+  }
+
+  // The contents referenced by file are never modified, see write_to_file()
+  memcpy(buffer, file->data() + offset, length);
+  return TILEDB_FS_OK;
+}
+
+int MemoryFS::write_to_file(const std::string& filename, const void *buffer, size_t buffer_size) {
+  if (buffer_size == 0) {
+    return TILEDB_FS_OK;
+  }
+
+  std::string key = unslashify(get_path(filename));
+  std::lock_guard<std::mutex> lock(store_->mtx_);
+  if (is_dir_locked(key)) {
+    MEMORYFS_ERROR("Cannot write to path as it is a directory", filename);
+    return TILEDB_FS_ERR;
+  }
+  auto& file = store_->files_[key];
+  if (!file) {
+    file = std::make_shared<std::vector<char>>();
+  } else if (file.use_count() > 1) {
+    // Readers hold on to the current contents, so append to a copy
+    file = std::make_shared<std::vector<char>>(*file);
+  }
+  auto data = reinterpret_cast<const char *>(buffer);
+  file->insert(file->end(), data, data + buffer_size);
+  return TILEDB_FS_OK;
+}
+
+int MemoryFS::move_path(const std::string& old_path, const std::string& new_path) {
+  std::string old_key = unslashify(get_path(old_path));
+  std::string new_key = unslashify(get_path(new_path));
+  std::lock_guard<std::mutex> lock(store_->mtx_);
+
+  auto search = store_->files_.find(old_key);
+  if (search != store_->files_.end()) {
+    if (is_dir_locked(new_key)) {
+      MEMORYFS_ERROR("Cannot move file as the new path is a directory", new_path);
+      return TILEDB_FS_ERR;
+    }
+    auto file = search->second;
+    store_->files_.erase(search);
+    store_->files_[new_key] = file;
+    return TILEDB_FS_OK;
+  }
+
+  if (old_key.empty() || !is_dir_locked(old_key)) {
+    MEMORYFS_ERROR("Cannot move non-existent path", old_path);
+    return TILEDB_FS_ERR;
+  }
+  std::string old_prefix = dir_prefix(old_key);
+  if (is_dir_locked(new_key) || store_->files_.count(new_key) || starts_with(new_key, old_prefix)) {
+    MEMORYFS_ERROR("Cannot move dir as the new path exists or is a subdirectory", new_path);
+    return TILEDB_FS_ERR;
+  }
+
+  std::string new_prefix = dir_prefix(new_key);
+  auto file = store_->files_.lower_bound(old_prefix);
+  while (file != store_->files_.end() && starts_with(file->first, old_prefix)) {
+    store_->files_[new_prefix + file->first.substr(old_prefix.size())] = file->second;
+    file = store_->files_.erase(file);
+  }
+  auto dir = store_->dirs_.lower_bound(old_prefix);
+  while (dir != store_->dirs_.end() && starts_with(*dir, old_prefix)) {
+    store_->dirs_.insert(new_prefix + dir->substr(old_prefix.size()));
+    dir = store_->dirs_.erase(dir);
+  }
+  if (store_->dirs_.erase(old_key)) {
+    store_->dirs_.insert(new_key);
+  }
+  return TILEDB_FS_OK;
+}
+
+int MemoryFS::sync_path(const std::string& path) {
+  return TILEDB_FS_OK;
+}
+
+int MemoryFS::close_file(const std::string& filename) {
+  return TILEDB_FS_OK;
+}
+
+bool MemoryFS::path_exists(const std::string& path) {
+  if (!path.empty() && path.back() == '/') {
+    return is_dir(path);
+  } else {
+    return is_file(path);
+  }
+}
+
+int MemoryFS::create_path(const std::string& path) {
+  return create_file(path, O_WRONLY|O_CREAT, S_IRWXU);
+}
+
+int MemoryFS::commit_file(const std::string& filename) {
+  return TILEDB_FS_OK;
+}
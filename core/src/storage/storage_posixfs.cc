@@ -42,7 +42,9 @@
 #include <fcntl.h>
 #include <ftw.h>
 #include <iostream>
+#include <limits.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #define POSIX_ERROR(MSG, PATH) SYSTEM_ERROR(TILEDB_FS_ERRMSG, MSG, PATH, tiledb_fs_errmsg)
@@ -220,6 +222,9 @@ int PosixFS::delete_dir(const std::string& dirname) {
   // Get real path
   std::string dirname_real = this->real_dir(dirname); 
 
+  invalidate_read_fds(dirname);
+  invalidate_read_fds(dirname_real);
+
   if (nftw(dirname_real.c_str(), delete_file_nftw_cb, 64, FTW_DEPTH | FTW_PHYS)) {
     POSIX_ERROR("Could not recursively delete directory", dirname);
     return TILEDB_FS_ERR;
@@ -306,6 +311,8 @@ int PosixFS::create_file(const std::string& filename, int flags, mode_t mode) {
 int PosixFS::delete_file(const std::string& filename) {
   reset_errno();
 
+  invalidate_read_fds(filename);
+
   if(remove(filename.c_str())) {
     POSIX_ERROR("Cannot remove file", filename);
     return TILEDB_FS_ERR;
@@ -359,6 +366,79 @@ static void remove_fd(const std::string& filename, std::unordered_map<std::strin
   map.erase(filename);
 }
 
+std::shared_ptr<int> PosixFS::get_read_fd(const std::string& filename) {
+  size_t cache_size = read_file_handles_cache_size();
+  if (cache_size) {
+    std::lock_guard<std::mutex> lock(read_map_mtx_);
+    auto search = read_map_.find(filename);
+    if (search != read_map_.end()) {
+      // Move entry to the front of the LRU list
+      read_lru_.splice(read_lru_.begin(), read_lru_, search->second);
+      read_cache_hits_++;
+      return search->second->second;
+    }
+    read_cache_misses_++;
+  }
+
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd == -1 && (errno == EMFILE || errno == ENFILE) && cache_size) {
+    // Out of descriptors, release the cached ones and retry
+    evict_read_fds(0);
+    reset_errno();
+    fd = open(filename.c_str(), O_RDONLY);
+  }
+  if (fd == -1) {
+    return nullptr;
+  }
+
+  std::shared_ptr<int> read_fd(new int(fd), [](int *pfd) {
+      close(*pfd);
+      delete pfd;
+    });
+
+  if (cache_size) {
+    std::lock_guard<std::mutex> lock(read_map_mtx_);
+    auto search = read_map_.find(filename);
+    if (search != read_map_.end()) {
+      // Another thread cached a descriptor for this file in the meantime, use that instead
+      return search->second->second;
+    }
+    read_lru_.emplace_front(filename, read_fd);
+    read_map_.emplace(filename, read_lru_.begin());
+    while (read_lru_.size() > cache_size) {
+      read_map_.erase(read_lru_.back().first);
+      read_lru_.pop_back();
+    }
+  }
+
+  return read_fd;
+}
+
+void PosixFS::invalidate_read_fds(const std::string& path) {
+  std::lock_guard<std::mutex> lock(read_map_mtx_);
+  if (read_map_.empty()) {
+    return;
+  }
+  // path could either be a file or a directory, so remove all entries rooted at path
+  std::string dir_prefix = slashify(path);
+  for (auto it = read_lru_.begin(); it != read_lru_.end();) {
+    if (it->first == path || starts_with(it->first, dir_prefix)) {
+      read_map_.erase(it->first);
+      it = read_lru_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void PosixFS::evict_read_fds(size_t max_size) {
+  std::lock_guard<std::mutex> lock(read_map_mtx_);
+  while (read_lru_.size() > max_size) {
+    read_map_.erase(read_lru_.back().first);
+    read_lru_.pop_back();
+  }
+}
+
 int PosixFS::read_from_file(const std::string& filename, off_t offset, void *buffer, size_t length) {
   reset_errno();
 
@@ -372,9 +452,10 @@ int PosixFS::read_from_file(const std::string& filename, off_t offset, void *buf
     return TILEDB_FS_ERR;
   }
   
-  // Open file
-  int fd = open(filename.c_str(), O_RDONLY);
-  if (fd == -1) {
+  // Open file or reuse a cached file descriptor. The descriptor is closed when the
+  // last reference to it is released.
+  std::shared_ptr<int> fd = get_read_fd(filename);
+  if (!fd) {
     POSIX_ERROR("Cannot read from file; File opening error", filename);
     return TILEDB_FS_ERR;
   }
@@ -384,9 +465,11 @@ int PosixFS::read_from_file(const std::string& filename, off_t offset, void *buf
   char *pbuf = reinterpret_cast<char *>(buffer);
   int rc = TILEDB_FS_OK;
   do {
-    ssize_t bytes_read = pread(fd, reinterpret_cast<void *>(pbuf), (length - nbytes) > TILEDB_UT_MAX_WRITE_COUNT?TILEDB_UT_MAX_WRITE_COUNT : length-nbytes, offset + nbytes);
+    ssize_t bytes_read = pread(*fd, reinterpret_cast<void *>(pbuf), (length - nbytes) > TILEDB_UT_MAX_WRITE_COUNT?TILEDB_UT_MAX_WRITE_COUNT : length-nbytes, offset + nbytes);
     if (bytes_read < 0) {
       POSIX_ERROR("Cannot read from file; File reading error", filename);
+      // Do not hold on to a possibly stale descriptor, e.g. ESTALE with NFS
+      invalidate_read_fds(filename);
       rc = TILEDB_FS_ERR;
     } else if (bytes_read == 0) {
       POSIX_ERROR("EOF reached; File reading error", filename);
@@ -396,14 +479,96 @@ int PosixFS::read_from_file(const std::string& filename, off_t offset, void *buf
       pbuf += bytes_read;
     }
   } while (nbytes < length && rc == TILEDB_FS_OK);
-  
-  // Close file
-  if (close(fd)) {
-    POSIX_ERROR("Cannot read from file; File closing error", filename);
+
+  return rc;
+}
+
+// Reads into all of iov, resuming after short reads. Returns the number of bytes
+// read, which is less than requested only at EOF, or -1 on error.
+static ssize_t preadv_kernel(int fd, struct iovec *iov, int iovcnt, off_t offset) {
+  ssize_t nbytes = 0;
+  while (iovcnt > 0) {
+    ssize_t bytes_read = preadv(fd, iov, std::min(iovcnt, IOV_MAX), offset + nbytes);
+    if (bytes_read <= 0) {
+      return bytes_read?bytes_read:nbytes;
+    }
+    nbytes += bytes_read;
+    while (iovcnt > 0 && static_cast<size_t>(bytes_read) >= iov->iov_len) {
+      bytes_read -= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+    if (bytes_read) {
+      iov->iov_base = reinterpret_cast<char *>(iov->iov_base) + bytes_read;
+      iov->iov_len -= bytes_read;
+    }
+  }
+  return nbytes;
+}
+
+int PosixFS::read_from_file_v(const std::string& filename, const std::vector<read_range_t>& ranges) {
+  reset_errno();
+
+  std::vector<const read_range_t *> sorted;
+  for (auto& range : ranges) {
+    if (range.length > 0) {
+      sorted.push_back(&range);
+    }
+  }
+  if (sorted.empty()) {
+    return TILEDB_FS_OK;
+  }
+
+  // Not supporting simultaneous read/writes.
+  if (keep_write_file_handles_open() && get_fd(filename, write_map_, write_map_mtx_) >= 0) {
+    POSIX_ERROR("Cannot open simultaneously for reads/writes", filename);
     return TILEDB_FS_ERR;
   }
 
-  return rc;
+  std::shared_ptr<int> fd = get_read_fd(filename);
+  if (!fd) {
+    POSIX_ERROR("Cannot read from file; File opening error", filename);
+    return TILEDB_FS_ERR;
+  }
+
+  std::unique_ptr<IoUring> io_uring = use_io_uring()?acquire_io_uring():NULL;
+  if (io_uring) {
+    int rc = io_uring->read(*fd, ranges);
+    release_io_uring(std::move(io_uring));
+    if (rc == TILEDB_FS_OK) {
+      return TILEDB_FS_OK;
+    }
+    // Any failure, including of the ring itself, is retried with preadv() below, which
+    // also reports read errors and EOF
+    reset_errno();
+  }
+
+  std::sort(sorted.begin(), sorted.end(), [](const read_range_t *a, const read_range_t *b) {
+    return a->offset < b->offset;
+  });
+
+  std::vector<struct iovec> iov;
+  for (auto i=0ul; i<sorted.size();) {
+    off_t offset = sorted[i]->offset;
+    off_t end = offset;
+    iov.clear();
+    for (; i<sorted.size() && sorted[i]->offset == end; i++) {
+      iov.push_back({sorted[i]->buffer, sorted[i]->length});
+      end += sorted[i]->length;
+    }
+    ssize_t bytes_read = preadv_kernel(*fd, iov.data(), iov.size(), offset);
+    if (bytes_read < 0) {
+      POSIX_ERROR("Cannot read from file; File reading error", filename);
+      // Do not hold on to a possibly stale descriptor, e.g. ESTALE with NFS
+      invalidate_read_fds(filename);
+      return TILEDB_FS_ERR;
+    } else if (bytes_read < end - offset) {
+      POSIX_ERROR("EOF reached; File reading error", filename);
+      return TILEDB_FS_ERR;
+    }
+  }
+
+  return TILEDB_FS_OK;
 }
 
 static int write_to_file_kernel(int fd, const void *buffer, size_t buffer_size) {
@@ -481,6 +646,9 @@ int PosixFS::write_to_file(const std::string& filename, const void *buffer, size
 
 int PosixFS::move_path(const std::string& old_path, const std::string& new_path) {
   reset_errno();
+
+  invalidate_read_fds(old_path);
+  invalidate_read_fds(new_path);
   
   if(rename(old_path.c_str(), new_path.c_str())) {
     POSIX_ERROR("Cannot rename path", old_path);
@@ -539,6 +707,8 @@ int PosixFS::sync_path(const std::string& filename) {
 }
 
 int PosixFS::close_file(const std::string& filename) {
+  invalidate_read_fds(filename);
+
   if (keep_write_file_handles_open()) {
     int fd = get_fd(filename, write_map_, write_map_mtx_);
     if (fd >= 0) {
@@ -586,3 +756,61 @@ bool PosixFS::disable_file_locking() {
   is_disable_file_locking_set = true;
   return disable_file_locking_;
 }
+
+void PosixFS::set_read_file_handles_cache_size(const size_t val) {
+  read_file_handles_cache_size_ = val;
+  read_file_handles_cache_size_set_ = true;
+  evict_read_fds(val);
+}
+
+size_t PosixFS::read_file_handles_cache_size() {
+  if (read_file_handles_cache_size_set_) {
+    return read_file_handles_cache_size_;
+  }
+  auto env_var = getenv("TILEDB_READ_FILE_HANDLES_CACHE_SIZE");
+  if (env_var) {
+    read_file_handles_cache_size_ = std::stoull(env_var);
+  }
+  read_file_handles_cache_size_set_ = true;
+  return read_file_handles_cache_size_;
+}
+
+void PosixFS::set_use_io_uring(const bool val) {
+  use_io_uring_ = val;
+}
+
+bool PosixFS::use_io_uring() {
+  return use_io_uring_;
+}
+
+#define IO_URING_QUEUE_DEPTH 64
+
+std::unique_ptr<IoUring> PosixFS::acquire_io_uring() {
+  {
+    std::lock_guard<std::mutex> lock(io_uring_mtx_);
+    if (io_uring_unsupported_) {
+      return NULL;
+    }
+    if (!io_uring_pool_.empty()) {
+      std::unique_ptr<IoUring> io_uring = std::move(io_uring_pool_.back());
+      io_uring_pool_.pop_back();
+      return io_uring;
+    }
+  }
+
+  std::unique_ptr<IoUring> io_uring(new IoUring(IO_URING_QUEUE_DEPTH));
+  if (!io_uring->is_valid()) {
+    // Not supported or not permitted, do not try again
+    std::lock_guard<std::mutex> lock(io_uring_mtx_);
+    io_uring_unsupported_ = true;
+    return NULL;
+  }
+  return io_uring;
+}
+
+void PosixFS::release_io_uring(std::unique_ptr<IoUring> io_uring) {
+  if (io_uring->is_valid()) {
+    std::lock_guard<std::mutex> lock(io_uring_mtx_);
+    io_uring_pool_.push_back(std::move(io_uring));
+  }
+}
@@ -35,6 +35,8 @@
 #include "uri.h"
 #include "utils.h"
 
+#include <algorithm>
+
 #include <aws/core/client/DefaultRetryStrategy.h>
 #include <aws/s3/model/Bucket.h>
 #include <aws/s3/model/AbortMultipartUploadRequest.h>
@@ -115,6 +117,23 @@ S3::S3(const std::string& home) {
   // see https://docs.aws.amazon.com/AmazonS3/latest/API/mpUploadUploadPart.html
   download_buffer_size_ = 5*1024*1024; // 5M
   upload_buffer_size_ = 5*1024*1024; // 5M
+
+  auto max_inflight_uploads = getenv("TILEDB_MAX_INFLIGHT_UPLOADS");
+  if (max_inflight_uploads) {
+    max_inflight_uploads_ = std::stoul(max_inflight_uploads);
+    if (!max_inflight_uploads_) max_inflight_uploads_ = 1;
+  }
+
+  auto num_threads = getenv("TILEDB_NUM_THREADS");
+  if (num_threads) {
+    num_threads_ = std::string(num_threads)=="0"?1:std::stoi(num_threads);
+    if (!num_threads_) num_threads_ = 1;
+  }
+  auto parallel_read_threshold = getenv("TILEDB_PARALLEL_READ_THRESHOLD");
+  if (parallel_read_threshold) {
+    parallel_read_threshold_ = std::stoull(parallel_read_threshold);
+    if (!parallel_read_threshold_) parallel_read_threshold_ = 1;
+  }
 }
 
 S3::~S3() {
@@ -349,28 +368,81 @@ int S3::read_from_file(const std::string& filename, off_t offset, void *buffer,
     return TILEDB_FS_OK; // Nothing to read
   }
 
-  Aws::S3::Model::GetObjectRequest request;
-  request.SetBucket(bucket_name_);
-  request.SetKey(to_aws_string(get_path(filename)));
-  request.SetRange(to_aws_string("bytes=" + std::to_string(offset) + "-" + std::to_string(offset+length-1)));
+  // Split large reads into concurrent ranged GETs, each streaming directly into its slice of buffer
+  size_t num_ranges = 1;
+  if (num_threads_ > 1 && length > parallel_read_threshold_) {
+    num_ranges = std::min((size_t)num_threads_, (length+parallel_read_threshold_-1)/parallel_read_threshold_);
+  }
+  size_t range_size = (length+num_ranges-1)/num_ranges;
+
+  auto aws_filename = to_aws_string(get_path(filename));
+  std::vector<std::pair<size_t, Aws::S3::Model::GetObjectOutcomeCallable>> outcomes;
+  for (size_t range_offset = 0; range_offset < length; range_offset += range_size) {
+    size_t range_length = std::min(range_size, length-range_offset);
+    unsigned char* buf = reinterpret_cast<unsigned char*>(buffer)+range_offset;
+
+    Aws::S3::Model::GetObjectRequest request;
+    request.SetBucket(bucket_name_);
+    request.SetKey(aws_filename);
+    request.SetRange(to_aws_string("bytes=" + std::to_string(offset+range_offset) + "-"
+                                   + std::to_string(offset+range_offset+range_length-1)));
+    request.SetResponseStreamFactory([buf, range_length]() {
+      return Aws::New<PreallocatedIOStream>(CLASS_TAG, buf, range_length);
+    });
+
+    if (num_ranges == 1) {
+      outcomes.emplace_back(range_length, std::async(std::launch::deferred, [this, request]() {
+        return client_->GetObject(request);
+      }));
+    } else {
+      outcomes.emplace_back(range_length, client_->GetObjectCallable(request));
+    }
+  }
+
+  // Wait for all the ranges to complete before returning as they write into buffer
+  int rc = TILEDB_FS_OK;
+  for (auto& range_outcome : outcomes) {
+    auto outcome = range_outcome.second.get();
+    if (rc) continue;
+    if (!outcome.IsSuccess()) {
+      S3_ERROR1("Failed to get object", outcome, filename);
+      rc = TILEDB_FS_ERR;
+      continue;
+    }
+    auto content_length = outcome.GetResult().GetContentLength();
+    if (content_length < 0 || (size_t)content_length < range_outcome.first) {
+      S3_ERROR("Could not read the file for bytes of length=" + std::to_string(length) + " from offset=" + std::to_string(offset), filename);
+      rc = TILEDB_FS_ERR;
+    }
+  }
+
+  return rc;
+}
 
-  request.SetResponseStreamFactory([buffer, length]() {
-    unsigned char* buf = reinterpret_cast<unsigned char*>(const_cast<void*>(buffer));
-    return Aws::New<PreallocatedIOStream>(CLASS_TAG, buf, length);
-  });
+int S3::wait_for_part(const std::string& filename, multipart_upload_info_t& upload_info) {
+  assert(!upload_info.inflight_parts_.empty());
+  auto part = std::move(upload_info.inflight_parts_.front());
+  upload_info.inflight_parts_.pop_front();
 
-  auto outcome = client_->GetObject(request);
+  auto outcome = part.outcome_.get();
   if (!outcome.IsSuccess()) {
-    S3_ERROR1("Failed to get object", outcome, filename);
+    S3_ERROR1("Could not upload part=" + std::to_string(part.part_number_), outcome, filename);
+    upload_info.abort_upload_ = true;
     return TILEDB_FS_ERR;
   }
-
-  auto content_length = outcome.GetResult().GetContentLength();
-  if (content_length < 0 || (size_t)content_length < length) {
-    S3_ERROR("Could not read the file for bytes of length=" + std::to_string(length) + " from offset=" + std::to_string(offset), filename);
+  auto etag = outcome.GetResult().GetETag();
+  if (etag.empty()) {
+    S3_ERROR("UploadPartCallable not successful as etag is empty", filename);
+    upload_info.abort_upload_ = true;
     return TILEDB_FS_ERR;
   }
 
+  // Add to list of uploaded parts
+  Aws::S3::Model::CompletedPart completed_part;
+  completed_part.SetPartNumber(part.part_number_);
+  completed_part.SetETag(etag);
+  upload_info.completed_parts_.emplace_back(std::move(completed_part));
+
   return TILEDB_FS_OK;
 }
 
@@ -382,9 +454,7 @@ int S3::write_to_file(const std::string& filename, const void *buffer, size_t bu
   // Initialize upload
   std::string filepath = get_path(filename);
   auto aws_filename = to_aws_string(filepath);
-  std::string upload_id;
-  size_t part_number = 0;
-  std::shared_ptr<Aws::S3::Model::CompletedMultipartUpload> completed_parts;
+  std::shared_ptr<multipart_upload_info_t> upload_info;
   {
     const std::lock_guard<std::mutex> lock(write_map_mtx_);
 
@@ -398,55 +468,55 @@ int S3::write_to_file(const std::string& filename, const void *buffer, size_t bu
       auto createMultipartUploadOutcome = client_->CreateMultipartUpload(create_request);
       std::string upload_id = createMultipartUploadOutcome.GetResult().GetUploadId();
 
-      auto update_info = multipart_upload_info_t(upload_id);
-      write_map_.insert({filepath, std::move(update_info)});
-    }
-    auto found = write_map_.find(filepath);
-    assert(found != write_map_.end());
-    found->second.part_number_++;
-    upload_id = found->second.upload_id_;
-    part_number = found->second.part_number_;
-    completed_parts = found->second.completed_parts_;
-    // Verify that the previous uploaded part was at least 5M - see https://docs.aws.amazon.com/AmazonS3/latest/API/mpUploadUploadPart.html
-    // S3 throws error only when committing, so it is better to check in write_to_file and abort here. Note that cleanup occurs
-    // in commit_file that is called from the destructor if there was an issue.
-    auto last_uploaded_size = found->second.last_uploaded_size_;
-    if (found->second.abort_upload_ || (last_uploaded_size != 0 && last_uploaded_size < 5*1024*1024)) {
-      S3_ERROR("Only the last of the uploadable parts can be less than 5MB", filepath);
-      found->second.abort_upload_ = true;
-      return TILEDB_FS_ERR;
-    } else {
-      found->second.last_uploaded_size_ = buffer_size;
+      search = write_map_.insert({filepath, std::make_shared<multipart_upload_info_t>(upload_id)}).first;
     }
+    upload_info = search->second;
+  }
+
+  // Parts for the same file are numbered and uploaded in the order of the writes
+  const std::lock_guard<std::mutex> lock(upload_info->mtx_);
+  upload_info->part_number_++;
+  std::string upload_id = upload_info->upload_id_;
+  size_t part_number = upload_info->part_number_;
+  // Verify that the previous uploaded part was at least 5M - see https://docs.aws.amazon.com/AmazonS3/latest/API/mpUploadUploadPart.html
+  // S3 throws error only when committing, so it is better to check in write_to_file and abort here. Note that cleanup occurs
+  // in commit_file that is called from the destructor if there was an issue. Errors from parts that were uploading
+  // asynchronously are also reported here.
+  auto last_uploaded_size = upload_info->last_uploaded_size_;
+  if (upload_info->abort_upload_ || (last_uploaded_size != 0 && last_uploaded_size < 5*1024*1024)) {
+    S3_ERROR("Only the last of the uploadable parts can be less than 5MB", filepath);
+    upload_info->abort_upload_ = true;
+    return TILEDB_FS_ERR;
+  } else {
+    upload_info->last_uploaded_size_ = buffer_size;
   }
 
   assert(!upload_id.empty());
   assert(part_number > 0);
 
-  // Start upload
+  // Bound the number of parts uploading at the same time
+  while (upload_info->inflight_parts_.size() >= max_inflight_uploads_) {
+    if (wait_for_part(filename, *upload_info)) {
+      return TILEDB_FS_ERR;
+    }
+  }
+
+  // Start upload. The buffer is copied, so the caller can reuse it while the part is uploading
+  inflight_part_t part;
+  part.part_number_ = part_number;
+  part.buffer_ = std::make_shared<std::vector<unsigned char>>(reinterpret_cast<const unsigned char *>(buffer),
+                                                              reinterpret_cast<const unsigned char *>(buffer)+buffer_size);
+
   Aws::S3::Model::UploadPartRequest request;
   request.SetBucket(bucket_name_);
   request.SetKey(aws_filename);
   request.SetPartNumber(part_number);
   request.SetUploadId(to_aws_string(upload_id));
-
-  unsigned char* buf = reinterpret_cast<unsigned char*>(const_cast<void*>(buffer));
-  request.SetBody(Aws::MakeShared<PreallocatedIOStream>(CLASS_TAG, buf, buffer_size));
+  request.SetBody(Aws::MakeShared<PreallocatedIOStream>(CLASS_TAG, part.buffer_->data(), buffer_size));
   request.SetContentLength(buffer_size);
 
-  auto outcome = client_->UploadPartCallable(request);
-  auto etag = outcome.get().GetResult().GetETag();
-  if (etag.empty()) {
-    S3_ERROR("UploadPartCallable not successful as etag is empty", filename);
-    return TILEDB_FS_ERR;
-  }
-  
-  // Add to list of uploaded parts
-  Aws::S3::Model::CompletedPart completed_part;
-  completed_part.SetPartNumber(part_number);
-  completed_part.SetETag(etag);
-
-  completed_parts->AddParts(std::move(completed_part));
+  part.outcome_ = client_->UploadPartCallable(request);
+  upload_info->inflight_parts_.emplace_back(std::move(part));
 
   return TILEDB_FS_OK;
 }
@@ -454,50 +524,63 @@ int S3::write_to_file(const std::string& filename, const void *buffer, size_t bu
 int S3::commit_file(const std::string& filename) {
   std::string filepath = get_path(filename);
   auto aws_filename = to_aws_string(filepath);
-  std::string upload_id;
-  std::shared_ptr<Aws::S3::Model::CompletedMultipartUpload> completed_parts;
-  bool abort_upload = false;
-
-  int rc = TILEDB_FS_OK;
+  std::shared_ptr<multipart_upload_info_t> upload_info;
   {
     const std::lock_guard<std::mutex> lock(write_map_mtx_);
     auto found = write_map_.find(filepath);
-    if (found != write_map_.end()) {
-      auto multipart_update_info = found->second;
-      upload_id = multipart_update_info.upload_id_;
-      completed_parts = multipart_update_info.completed_parts_;
-      abort_upload = multipart_update_info.abort_upload_;
-      write_map_.erase(filepath);
+    if (found == write_map_.end()) {
+      return TILEDB_FS_OK;
     }
+    upload_info = found->second;
+    write_map_.erase(found);
   }
 
-  if (!upload_id.empty()) {
-    if (!abort_upload) {
-      Aws::S3::Model::CompleteMultipartUploadRequest finish_upload_request;
-      finish_upload_request.SetBucket(bucket_name_);
-      finish_upload_request.SetKey(aws_filename);
-      finish_upload_request.SetUploadId(to_aws_string(upload_id));
-      finish_upload_request.WithMultipartUpload(*completed_parts);
-      auto finish_upload_outcome = client_->CompleteMultipartUpload(finish_upload_request);
-      if (!finish_upload_outcome.IsSuccess()) {
-        std::string msg = "Could not upload successfully for upload_id=" + upload_id;
-        S3_ERROR1(msg, finish_upload_outcome, filename);
-        abort_upload = true;
-        rc = TILEDB_FS_ERR;
-      }
+  const std::lock_guard<std::mutex> lock(upload_info->mtx_);
+  std::string upload_id = upload_info->upload_id_;
+  if (upload_id.empty()) {
+    return TILEDB_FS_OK;
+  }
+
+  // Wait for all the outstanding parts to finish uploading
+  int rc = TILEDB_FS_OK;
+  while (!upload_info->inflight_parts_.empty()) {
+    rc = wait_for_part(filename, *upload_info) || rc;
+  }
+  bool abort_upload = upload_info->abort_upload_;
+
+  if (!abort_upload) {
+    // Parts have to be listed in ascending order of part numbers
+    std::sort(upload_info->completed_parts_.begin(), upload_info->completed_parts_.end(),
+              [](const Aws::S3::Model::CompletedPart& a, const Aws::S3::Model::CompletedPart& b) {
+                return a.GetPartNumber() < b.GetPartNumber();
+              });
+    Aws::S3::Model::CompletedMultipartUpload completed_upload;
+    completed_upload.SetParts(upload_info->completed_parts_);
+
+    Aws::S3::Model::CompleteMultipartUploadRequest finish_upload_request;
+    finish_upload_request.SetBucket(bucket_name_);
+    finish_upload_request.SetKey(aws_filename);
+    finish_upload_request.SetUploadId(to_aws_string(upload_id));
+    finish_upload_request.WithMultipartUpload(completed_upload);
+    auto finish_upload_outcome = client_->CompleteMultipartUpload(finish_upload_request);
+    if (!finish_upload_outcome.IsSuccess()) {
+      std::string msg = "Could not upload successfully for upload_id=" + upload_id;
+      S3_ERROR1(msg, finish_upload_outcome, filename);
+      abort_upload = true;
+      rc = TILEDB_FS_ERR;
     }
+  }
 
-    if (abort_upload) {
-      Aws::S3::Model::AbortMultipartUploadRequest abort_upload_request;
-      abort_upload_request.SetBucket(bucket_name_);
-      abort_upload_request.SetKey(aws_filename);
-      abort_upload_request.SetUploadId(to_aws_string(upload_id));
-      auto abort_upload_outcome = client_->AbortMultipartUpload(abort_upload_request);
-      if (!abort_upload_outcome.IsSuccess()) {
-        S3_ERROR1("Could not abort upload successfullt", abort_upload_outcome, filename);
-        rc = TILEDB_FS_ERR;
-      }
+  if (abort_upload) {
+    Aws::S3::Model::AbortMultipartUploadRequest abort_upload_request;
+    abort_upload_request.SetBucket(bucket_name_);
+    abort_upload_request.SetKey(aws_filename);
+    abort_upload_request.SetUploadId(to_aws_string(upload_id));
+    auto abort_upload_outcome = client_->AbortMultipartUpload(abort_upload_request);
+    if (!abort_upload_outcome.IsSuccess()) {
+      S3_ERROR1("Could not abort upload successfullt", abort_upload_outcome, filename);
     }
+    rc = TILEDB_FS_ERR;
   }
 
   return rc;
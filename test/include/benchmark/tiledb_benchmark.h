@@ -443,6 +443,8 @@ std::string get_io_read_mode(int mode) {
       return "TILEDB_IO_MMAP";
     case 1:
       return "TILEDB_IO_READ";
+    case 3:
+      return "TILEDB_IO_URING";
     default:
       std::cerr << "TILEDB_IO_MODE=" << std::to_string(mode) << "not recognized\n";
       return "";
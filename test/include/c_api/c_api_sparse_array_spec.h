@@ -36,6 +36,8 @@
 #include "catch.h"
 #include "tiledb.h"
 
+#include <vector>
+
 class SparseArrayTestFixture : TempDir {
  public:
   /* ********************************* */
@@ -113,6 +115,58 @@ class SparseArrayTestFixture : TempDir {
       const int read_mode,
       const ssize_t expected_num_cells = -1);
 
+  /**
+   * Creates a 16x16 2D sparse array with 4x4 tiles and writes fragments to it
+   * with each cell being equal to row_id*16+col_id.
+   *
+   * @param array_name The array name.
+   * @param fragment_num The number of fragments written.
+   * @param capacity The tile capacity.
+   * @param enable_compression If true, then GZIP compression is used.
+   * @param cell_order The cell order.
+   */
+  void create_sparse_array_16x16(
+      const char* array_name,
+      const int fragment_num = 1,
+      const int64_t capacity = 0,
+      const bool enable_compression = false,
+      const int cell_order = TILEDB_ROW_MAJOR);
+
+  /**
+   * Reads a subarray of an array created by create_sparse_array_16x16 in
+   * sorted row mode and checks that each cell is equal to row_id*16+col_id.
+   */
+  void check_sparse_array_16x16(
+      const int64_t domain_0_lo = 0,
+      const int64_t domain_0_hi = 15,
+      const int64_t domain_1_lo = 0,
+      const int64_t domain_1_hi = 15);
+
+  /**
+   * Writes the input cells in unsorted mode as a new fragment.
+   *
+   * @param a1 The attribute values.
+   * @param coords The coordinates of the cells, two per cell.
+   */
+  void write_sparse_array_cells_2D(
+      const std::vector<int>& a1,
+      const std::vector<int64_t>& coords);
+
+  /**
+   * Reads attributes of the whole array in the global cell order with buffers
+   * that may overflow several times.
+   *
+   * @param attributes The attributes to read.
+   * @param buffer_sizes The size of each buffer, two buffers for variable-sized
+   *     attributes.
+   * @param skip_counts The number of cells skipped for each buffer, or NULL.
+   * @return The bytes read into each buffer by all the reads.
+   */
+  std::vector<std::vector<char>> read_sparse_array_cells(
+      const std::vector<const char*>& attributes,
+      const std::vector<size_t>& buffer_sizes,
+      const size_t* skip_counts = NULL);
+
   /** Sets the array name for the current test. */
   void set_array_name(const char *);
 
@@ -139,6 +139,79 @@ class TempDir {
   }
 };
 
+/**
+ * Sets an environment variable for the scope of a test and restores its
+ * previous value on destruction, even when a REQUIRE aborts the test. When
+ * constructed with only a name, the variable is unset for the scope instead.
+ */
+class ScopedEnv {
+ public:
+  explicit ScopedEnv(const std::string& name) : name_(name) {
+    const char* previous_value = getenv(name.c_str());
+    if (previous_value != NULL) {
+      was_set_ = true;
+      previous_value_ = previous_value;
+    }
+    unset();
+  }
+
+  ScopedEnv(const std::string& name, const std::string& value) : ScopedEnv(name) {
+    set(value);
+  }
+
+  ScopedEnv(const ScopedEnv&) = delete;
+  ScopedEnv& operator=(const ScopedEnv&) = delete;
+
+  ~ScopedEnv() {
+    if (was_set_) {
+      setenv(name_.c_str(), previous_value_.c_str(), 1);
+    } else {
+      unsetenv(name_.c_str());
+    }
+  }
+
+  void set(const std::string& value) {
+    CHECK(setenv(name_.c_str(), value.c_str(), 1) == 0);
+  }
+
+  void unset() {
+    CHECK(unsetenv(name_.c_str()) == 0);
+  }
+
+ private:
+  std::string name_;
+  bool was_set_ = false;
+  std::string previous_value_;
+};
+
+/**
+ * Sets the size limit of a process-wide cache, e.g. TileCache, for the scope of
+ * a test and restores it on destruction. The caches read their limit from the
+ * environment only once per process.
+ */
+template<class Cache>
+class ScopedCacheSize {
+ public:
+  explicit ScopedCacheSize(size_t max_size = 0) : previous_max_size_(Cache::instance().max_size()) {
+    set(max_size);
+  }
+
+  ScopedCacheSize(const ScopedCacheSize&) = delete;
+  ScopedCacheSize& operator=(const ScopedCacheSize&) = delete;
+
+  ~ScopedCacheSize() {
+    Cache::instance().clear();
+    Cache::instance().set_max_size(previous_max_size_);
+  }
+
+  void set(size_t max_size) {
+    Cache::instance().set_max_size(max_size);
+  }
+
+ private:
+  size_t previous_max_size_;
+};
+
 const std::string get_test_dir() {
   return g_test_dir;
 }
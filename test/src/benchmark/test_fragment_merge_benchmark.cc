@@ -0,0 +1,117 @@
+/**
+ * @file   test_fragment_merge_benchmark.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2026 Omics Data Automation, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Benchmark the merge of the cell ranges of many unconsolidated fragments
+ * with interleaved cells
+ */
+
+#include "catch.h"
+
+#include "tiledb.h"
+#include "utils.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+TEST_CASE_METHOD(TempDir, "Benchmark merging fragment cell ranges", "[benchmark_fragment_merge]") {
+  if (!is_env_set("TILEDB_BENCHMARK")) {
+    return;
+  }
+
+  std::string workspace = get_temp_dir() + "/fragment_merge_workspace/";
+  std::string array_name = workspace + "fragment_merge";
+  TileDB_CTX* tiledb_ctx;
+  REQUIRE(tiledb_ctx_init(&tiledb_ctx, NULL) == TILEDB_OK);
+  REQUIRE(tiledb_workspace_create(tiledb_ctx, workspace.c_str()) == TILEDB_OK);
+
+  // 1000x1000 cells in 100x100 tiles
+  const char* attributes[] = { "ATTR_INT32" };
+  const char* dimensions[] = { "X", "Y" };
+  int64_t domain[] = { 0, 999, 0, 999 };
+  int64_t tile_extents[] = { 100, 100 };
+  const int types[] = { TILEDB_INT32, TILEDB_INT64 };
+  int compression[] = { TILEDB_NO_COMPRESSION, TILEDB_NO_COMPRESSION };
+  TileDB_ArraySchema array_schema;
+  REQUIRE(tiledb_array_set_schema(&array_schema, array_name.c_str(), attributes, 1, 1000, TILEDB_ROW_MAJOR, NULL,
+                                  compression, NULL, NULL, NULL, 0, dimensions, 2, domain, sizeof(domain),
+                                  tile_extents, sizeof(tile_extents), TILEDB_ROW_MAJOR, types) == TILEDB_OK);
+  REQUIRE(tiledb_array_create(tiledb_ctx, &array_schema) == TILEDB_OK);
+  REQUIRE(tiledb_array_free_schema(&array_schema) == TILEDB_OK);
+
+  // Each fragment holds every fragment_num-th column, so that all fragments
+  // overlap every tile without sharing cells
+  int fragment_num = 100;
+  Catch::Timer t;
+  t.start();
+  for (auto f = 0; f < fragment_num; f++) {
+    std::vector<int> a1;
+    std::vector<int64_t> coords;
+    for (int64_t i = 0; i < 1000; i++) {
+      for (int64_t j = f; j < 1000; j += fragment_num) {
+        a1.push_back(i*1000+j);
+        coords.insert(coords.end(), { i, j });
+      }
+    }
+    TileDB_Array* tiledb_array;
+    REQUIRE(tiledb_array_init(tiledb_ctx, &tiledb_array, array_name.c_str(), TILEDB_ARRAY_WRITE_UNSORTED,
+                              NULL, NULL, 0) == TILEDB_OK);
+    const void* buffers[] = { a1.data(), coords.data() };
+    size_t buffer_sizes[] = { a1.size()*sizeof(int), coords.size()*sizeof(int64_t) };
+    REQUIRE(tiledb_array_write(tiledb_array, buffers, buffer_sizes) == TILEDB_OK);
+    REQUIRE(tiledb_array_finalize(tiledb_array) == TILEDB_OK);
+  }
+  std::cout << "Write " << fragment_num << " fragments elapsed time = " << t.getElapsedMilliseconds() << "ms" << std::endl;
+
+  for (auto mode : { TILEDB_ARRAY_READ, TILEDB_ARRAY_READ_SORTED_ROW }) {
+    std::vector<int> a1(1000*1000);
+    t.start();
+    TileDB_Array* tiledb_array;
+    REQUIRE(tiledb_array_init(tiledb_ctx, &tiledb_array, array_name.c_str(), mode, domain, attributes, 1) == TILEDB_OK);
+    size_t cell_num = 0;
+    do {
+      void* buffers[] = { a1.data() + cell_num };
+      size_t buffer_sizes[] = { (a1.size() - cell_num)*sizeof(int) };
+      REQUIRE(tiledb_array_read(tiledb_array, buffers, buffer_sizes) == TILEDB_OK);
+      cell_num += buffer_sizes[0]/sizeof(int);
+    } while (tiledb_array_overflow(tiledb_array, 0));
+    REQUIRE(tiledb_array_finalize(tiledb_array) == TILEDB_OK);
+    std::cout << (mode == TILEDB_ARRAY_READ ? "Read" : "Sorted row read") << " of " << fragment_num
+              << " fragments elapsed time = " << t.getElapsedMilliseconds() << "ms" << std::endl;
+
+    CHECK(cell_num == a1.size());
+    if (mode == TILEDB_ARRAY_READ_SORTED_ROW) {
+      for (auto i = 0ul; i < a1.size(); i++) {
+        CHECK(a1[i] == int(i));
+      }
+    }
+  }
+
+  CHECK(tiledb_ctx_finalize(tiledb_ctx) == TILEDB_OK);
+}
@@ -0,0 +1,94 @@
+/**
+ * @file   test_mbr_index_benchmark.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2026 Omics Data Automation, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * @section DESCRIPTION
+ * @section DESCRIPTION
+ *
+ * Benchmark the lookup of tiles overlapping a subarray with MBRIndex against a
+ * scan of the MBRs
+ */
+
+#include "catch.h"
+
+#include "mbr_index.h"
+#include "tiledb_constants.h"
+#include "utils.h"
+
+#include <iostream>
+#include <vector>
+
+TEST_CASE("Benchmark MBR index lookups", "[benchmark_mbr_index]") {
+  if (!is_env_set("TILEDB_BENCHMARK")) {
+    return;
+  }
+
+  // Row-major tiles of a 1000x1000 grid with 1000x1000 cells each
+  int64_t mbr_num = 1000*1000;
+  std::vector<int64_t> mbrs;
+  mbrs.reserve(4*mbr_num);
+  for(int64_t i = 0; i < mbr_num; ++i) {
+    int64_t row = (i/1000)*1000;
+    int64_t col = (i%1000)*1000;
+    mbrs.insert(mbrs.end(), { row, row+999, col, col+999 });
+  }
+
+  Catch::Timer t;
+  t.start();
+  MBRIndex mbr_index(TILEDB_INT64, 2, mbrs.data(), mbr_num);
+  std::cout << "Build MBR index of " << mbr_num << " tiles elapsed time = " << t.getElapsedMicroseconds() << "us" << std::endl;
+  std::cout << "MBR index memory size = " << mbr_index.memory_size() << " bytes" << std::endl;
+
+  // Narrow column queries
+  int query_num = 100;
+  std::vector<std::vector<int64_t>> scan_tiles(query_num);
+  t.start();
+  for(int q = 0; q < query_num; ++q) {
+    int64_t col = q*9973;
+    int64_t subarray[] = { 0, 999999, col, col };
+    for(int64_t i = 0; i < mbr_num; ++i) {
+      const int64_t* mbr = &mbrs[4*i];
+      if(mbr[0] <= subarray[1] && mbr[1] >= subarray[0] && mbr[2] <= subarray[3] && mbr[3] >= subarray[2]) {
+        scan_tiles[q].push_back(i);
+      }
+    }
+  }
+  std::cout << "Scan " << query_num << " queries elapsed time = " << t.getElapsedMilliseconds() << "ms" << std::endl;
+
+  std::vector<std::vector<int64_t>> index_tiles(query_num);
+  t.start();
+  for(int q = 0; q < query_num; ++q) {
+    int64_t col = q*9973;
+    int64_t subarray[] = { 0, 999999, col, col };
+    mbr_index.query(subarray, 0, mbr_num-1, index_tiles[q]);
+  }
+  std::cout << "MBR index " << query_num << " queries elapsed time = " << t.getElapsedMilliseconds() << "ms" << std::endl;
+
+  for(int q = 0; q < query_num; ++q) {
+    CHECK(index_tiles[q].size() == 1000);
+    CHECK(index_tiles[q] == scan_tiles[q]);
+  }
+}
@@ -34,6 +34,7 @@
 #include "c_api_dense_array_spec.h"
 #include "progress_bar.h"
 #include "storage_posixfs.h"
+#include "tile_cache.h"
 #include <iostream>
 #include <time.h>
 #include <sys/time.h>
@@ -1057,3 +1058,75 @@ TEST_CASE_METHOD(DenseArrayTestFixture, " Test random updates in a 2D dense arra
   delete [] buffer_coords;
 }
 
+
+TEST_CASE_METHOD(DenseArrayTestFixture, "Test reading attributes of dense arrays concurrently", "[test_dense_read_threads]") {
+  ScopedCacheSize<TileCache> tile_cache_size;
+  SECTION("without tile cache") {
+  }
+  SECTION("with tile cache") {
+    tile_cache_size.set(1048576);
+  }
+
+  // Fixed and variable-sized attributes in compressed tiles
+  set_array_name("dense_test_read_threads");
+  const char* attributes[] = { "ATTR_INT32", "ATTR_CHAR" };
+  const char* dimensions[] = { "X", "Y" };
+  int64_t domain[] = { 0, 15, 0, 15 };
+  int64_t tile_extents[] = { 4, 4 };
+  int cell_val_num[] = { 1, TILEDB_VAR_NUM };
+  int compression[] = { TILEDB_GZIP, TILEDB_GZIP, TILEDB_NO_COMPRESSION };
+  const int types[] = { TILEDB_INT32, TILEDB_CHAR, TILEDB_INT64 };
+  TileDB_ArraySchema array_schema;
+  REQUIRE(tiledb_array_set_schema(&array_schema, array_name_.c_str(), attributes, 2, 0, TILEDB_ROW_MAJOR,
+                                  cell_val_num, compression, NULL, NULL, NULL, 1, dimensions, 2, domain,
+                                  sizeof(domain), tile_extents, sizeof(tile_extents), TILEDB_ROW_MAJOR,
+                                  types) == TILEDB_OK);
+  REQUIRE(tiledb_array_create(tiledb_ctx_, &array_schema) == TILEDB_OK);
+  REQUIRE(tiledb_array_free_schema(&array_schema) == TILEDB_OK);
+
+  std::vector<int> a1;
+  std::vector<size_t> a2_offsets;
+  std::string a2;
+  for(int64_t i = 0; i < 16*16; ++i) {
+    a1.push_back(i);
+    a2_offsets.push_back(a2.size());
+    a2.append(i%5+1, 'a'+i%26);
+  }
+  TileDB_Array* tiledb_array;
+  REQUIRE(tiledb_array_init(tiledb_ctx_, &tiledb_array, array_name_.c_str(), TILEDB_ARRAY_WRITE_SORTED_ROW,
+                            NULL, NULL, 0) == TILEDB_OK);
+  const void* write_buffers[] = { a1.data(), a2_offsets.data(), a2.data() };
+  size_t write_buffer_sizes[] = { a1.size()*sizeof(int), a2_offsets.size()*sizeof(size_t), a2.size() };
+  CHECK(tiledb_array_write(tiledb_array, write_buffers, write_buffer_sizes) == TILEDB_OK);
+  CHECK(tiledb_array_finalize(tiledb_array) == TILEDB_OK);
+
+  // Reads all the cells in the global order with buffers overflowing several times
+  auto read_all = [&]() {
+    std::vector<std::vector<char>> cells(3);
+    REQUIRE(tiledb_array_init(tiledb_ctx_, &tiledb_array, array_name_.c_str(), TILEDB_ARRAY_READ,
+                              NULL, attributes, 2) == TILEDB_OK);
+    int buffer_a1[7];
+    size_t buffer_a2_offsets[5];
+    char buffer_a2[16];
+    do {
+      void* buffers[] = { buffer_a1, buffer_a2_offsets, buffer_a2 };
+      size_t buffer_sizes[] = { sizeof(buffer_a1), sizeof(buffer_a2_offsets), sizeof(buffer_a2) };
+      REQUIRE(tiledb_array_read(tiledb_array, buffers, buffer_sizes) == TILEDB_OK);
+      for(int i = 0; i < 3; ++i)
+        cells[i].insert(cells[i].end(), (char*)buffers[i], (char*)buffers[i] + buffer_sizes[i]);
+    } while(tiledb_array_overflow(tiledb_array, 0) || tiledb_array_overflow(tiledb_array, 1));
+    CHECK(tiledb_array_finalize(tiledb_array) == TILEDB_OK);
+    return cells;
+  };
+
+  ScopedEnv read_threads("TILEDB_READ_THREADS", "1");
+  auto cells = read_all();
+  REQUIRE(cells[0].size() == 16*16*sizeof(int));
+  CHECK(cells[1].size() == 16*16*sizeof(size_t));
+  CHECK(cells[2].size() == a2.size());
+  // The first tile holds the first four cells of the first four rows
+  const int* cells_a1 = reinterpret_cast<const int*>(cells[0].data());
+  CHECK(cells_a1[4] == 16);
+  read_threads.set("4");
+  CHECK(read_all() == cells);
+}
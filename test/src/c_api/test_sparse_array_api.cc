@@ -33,15 +33,23 @@
 
 #include "catch.h"
 
+#include "book_keeping_cache.h"
 #include "c_api_sparse_array_spec.h"
+#include "consolidation_plan.h"
+#include "fragment_manifest.h"
+#include "mbr_index.h"
 #include "progress_bar.h"
 #include "storage_manager.h"
+#include "storage_memoryfs.h"
 #include "storage_posixfs.h"
+#include "tile_cache.h"
 #include "utils.h"
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <map>
+#include <queue>
 #include <time.h>
 #include <sys/time.h>
 #include <sstream>
@@ -479,6 +487,94 @@ int* SparseArrayTestFixture::read_sparse_array_2D(
   return buffer_a1;
 }
 
+void SparseArrayTestFixture::create_sparse_array_16x16(
+    const char* array_name,
+    const int fragment_num,
+    const int64_t capacity,
+    const bool enable_compression,
+    const int cell_order) {
+  set_array_name(array_name);
+  REQUIRE(create_sparse_array_2D(4, 4, 0, 15, 0, 15, capacity, enable_compression, cell_order, TILEDB_ROW_MAJOR) == TILEDB_OK);
+  for(int i = 0; i < fragment_num; ++i) {
+    REQUIRE(write_sparse_array_unsorted_2D(16, 16) == TILEDB_OK);
+  }
+}
+
+void SparseArrayTestFixture::check_sparse_array_16x16(
+    const int64_t domain_0_lo,
+    const int64_t domain_0_hi,
+    const int64_t domain_1_lo,
+    const int64_t domain_1_hi) {
+  int *buffer = read_sparse_array_2D(domain_0_lo, domain_0_hi, domain_1_lo, domain_1_hi, TILEDB_ARRAY_READ_SORTED_ROW);
+  REQUIRE(buffer != NULL);
+  for(int64_t i = domain_0_lo, k = 0; i <= domain_0_hi; ++i) {
+    for(int64_t j = domain_1_lo; j <= domain_1_hi; ++j, ++k) {
+      CHECK(buffer[k] == i*16 + j);
+    }
+  }
+  delete [] buffer;
+}
+
+void SparseArrayTestFixture::write_sparse_array_cells_2D(
+    const std::vector<int>& a1,
+    const std::vector<int64_t>& coords) {
+  TileDB_Array* tiledb_array;
+  REQUIRE(tiledb_array_init(tiledb_ctx_, &tiledb_array, array_name_.c_str(), TILEDB_ARRAY_WRITE_UNSORTED,
+                            NULL, NULL, 0) == TILEDB_OK);
+  const void* buffers[] = { a1.data(), coords.data() };
+  size_t buffer_sizes[] = { a1.size()*sizeof(int), coords.size()*sizeof(int64_t) };
+  CHECK(tiledb_array_write(tiledb_array, buffers, buffer_sizes) == TILEDB_OK);
+  CHECK(tiledb_array_finalize(tiledb_array) == TILEDB_OK);
+}
+
+std::vector<std::vector<char>> SparseArrayTestFixture::read_sparse_array_cells(
+    const std::vector<const char*>& attributes,
+    const std::vector<size_t>& buffer_sizes,
+    const size_t* skip_counts) {
+  size_t buffer_num = buffer_sizes.size();
+  std::vector<std::vector<char>> buffers(buffer_num), cells(buffer_num);
+  std::vector<void*> buffer_ptrs(buffer_num);
+  for(size_t i = 0; i < buffer_num; ++i) {
+    buffers[i].resize(buffer_sizes[i]);
+    buffer_ptrs[i] = buffers[i].data();
+  }
+  // Cells left to skip are counted down across the reads
+  std::vector<size_t> remaining_skip_counts(buffer_num, 0);
+  if(skip_counts != NULL)
+    remaining_skip_counts.assign(skip_counts, skip_counts + buffer_num);
+
+  TileDB_Array* tiledb_array;
+  REQUIRE(tiledb_array_init(tiledb_ctx_, &tiledb_array, array_name_.c_str(), TILEDB_ARRAY_READ,
+                            NULL, const_cast<const char**>(attributes.data()), attributes.size()) == TILEDB_OK);
+
+  // Overflows are looked up by the ids of the attributes in the schema
+  TileDB_ArraySchema array_schema = {};
+  REQUIRE(tiledb_array_get_schema(tiledb_array, &array_schema) == TILEDB_OK);
+  std::vector<int> attribute_ids;
+  for(auto attribute : attributes) {
+    int attribute_id = array_schema.attribute_num_;
+    for(int i = 0; i < array_schema.attribute_num_; ++i)
+      if(!strcmp(array_schema.attributes_[i], attribute))
+        attribute_id = i;
+    attribute_ids.push_back(attribute_id);
+  }
+  CHECK(tiledb_array_free_schema(&array_schema) == TILEDB_OK);
+
+  bool overflow;
+  do {
+    std::vector<size_t> read_sizes(buffer_sizes);
+    REQUIRE(tiledb_array_skip_and_read(tiledb_array, buffer_ptrs.data(), read_sizes.data(),
+                                       remaining_skip_counts.data()) == TILEDB_OK);
+    for(size_t i = 0; i < buffer_num; ++i)
+      cells[i].insert(cells[i].end(), buffers[i].begin(), buffers[i].begin() + read_sizes[i]);
+    overflow = false;
+    for(auto attribute_id : attribute_ids)
+      overflow = overflow || tiledb_array_overflow(tiledb_array, attribute_id);
+  } while(overflow);
+  CHECK(tiledb_array_finalize(tiledb_array) == TILEDB_OK);
+  return cells;
+}
+
 void SparseArrayTestFixture::set_array_name(const char *name) {
   array_name_ = WORKSPACE + name;
 }
@@ -637,6 +733,904 @@ TEST_CASE_METHOD(SparseArrayTestFixture, "Test random read subregions", "[test_r
   delete progress_bar;
 }
 
+/**
+ * Test is to read subregions of a compressed array with the overlapping tiles
+ * gathered into vectored reads and check the values set by row_id*dim1+col_id
+ */
+TEST_CASE_METHOD(SparseArrayTestFixture, "Test read subregions with gathered tiles", "[test_sparse_read_gathered_tiles]") {
+  // Tiles are gathered only with the TILEDB_IO_READ and TILEDB_IO_URING read methods
+  TileDB_Config tiledb_config;
+  ScopedEnv gather_size("TILEDB_READ_GATHER_SIZE");
+  SECTION("read") {
+    tiledb_config.read_method_ = TILEDB_IO_READ;
+    gather_size.set("4096");
+  }
+  SECTION("io_uring") {
+    tiledb_config.read_method_ = TILEDB_IO_URING;
+  }
+  SECTION("io_uring_gather_size") {
+    tiledb_config.read_method_ = TILEDB_IO_URING;
+    gather_size.set("4096");
+  }
+  ScopedEnv read_threads("TILEDB_READ_THREADS");
+  SECTION("read_threads") {
+    tiledb_config.read_method_ = TILEDB_IO_READ;
+    gather_size.set("4096");
+    read_threads.set("4");
+  }
+  CHECK_RC(tiledb_ctx_finalize(tiledb_ctx_), TILEDB_OK);
+  CHECK_RC(tiledb_ctx_init(&tiledb_ctx_, &tiledb_config), TILEDB_OK);
+
+  int64_t domain_size_0 = 100;
+  int64_t domain_size_1 = 100;
+  set_array_name("sparse_test_gathered_tiles");
+  CHECK_RC(create_sparse_array_2D(10, 10, 0, domain_size_0-1, 0, domain_size_1-1, 50, true, TILEDB_ROW_MAJOR, TILEDB_ROW_MAJOR), TILEDB_OK);
+  CHECK_RC(write_sparse_array_unsorted_2D(domain_size_0, domain_size_1), TILEDB_OK);
+
+  int64_t subarrays[][4] = { {0, 99, 0, 99}, {4, 60, 13, 27}, {95, 99, 0, 99}, {33, 33, 33, 33} };
+  for(auto subarray : subarrays) {
+    int *buffer = read_sparse_array_2D(subarray[0], subarray[1], subarray[2], subarray[3], TILEDB_ARRAY_READ_SORTED_ROW);
+    REQUIRE(buffer != NULL);
+    int64_t index = 0;
+    for(int64_t i = subarray[0]; i <= subarray[1]; ++i) {
+      for(int64_t j = subarray[2]; j <= subarray[3]; ++j) {
+        CHECK(buffer[index++] == i*domain_size_1+j);
+      }
+    }
+    delete [] buffer;
+  }
+}
+
+TEST_CASE_METHOD(SparseArrayTestFixture, "Test reading attributes concurrently", "[test_sparse_read_threads]") {
+  TileDB_Config tiledb_config;
+  SECTION("mmap") {
+    tiledb_config.read_method_ = TILEDB_IO_MMAP;
+  }
+  SECTION("read") {
+    tiledb_config.read_method_ = TILEDB_IO_READ;
+  }
+  CHECK_RC(tiledb_ctx_finalize(tiledb_ctx_), TILEDB_OK);
+  CHECK_RC(tiledb_ctx_init(&tiledb_ctx_, &tiledb_config), TILEDB_OK);
+
+  create_sparse_array_16x16("sparse_test_read_threads", 2, 8, true);
+
+  // Buffers overflowing several times
+  const std::vector<const char*> attributes = { "ATTR_INT32", TILEDB_COORDS };
+  const std::vector<size_t> buffer_sizes = { 7*sizeof(int), 2*5*sizeof(int64_t) };
+  auto cells = read_sparse_array_cells(attributes, buffer_sizes);
+  CHECK(cells[0].size() == 16*16*sizeof(int));
+  CHECK(cells[1].size() == 2*16*16*sizeof(int64_t));
+
+  ScopedEnv read_threads("TILEDB_READ_THREADS", "4");
+  CHECK(read_sparse_array_cells(attributes, buffer_sizes) == cells);
+  check_sparse_array_16x16();
+}
+
+TEST_CASE_METHOD(SparseArrayTestFixture, "Test reading variable-sized attributes concurrently", "[test_sparse_read_threads_var]") {
+  ScopedCacheSize<TileCache> tile_cache_size;
+  SECTION("without tile cache") {
+  }
+  SECTION("with tile cache") {
+    tile_cache_size.set(1048576);
+  }
+
+  // Fixed and variable-sized attributes in compressed tiles
+  set_array_name("sparse_test_read_threads_var");
+  const char* attributes[] = { "ATTR_INT32", "ATTR_CHAR" };
+  const char* dimensions[] = { "X", "Y" };
+  int64_t domain[] = { 0, 15, 0, 15 };
+  int64_t tile_extents[] = { 4, 4 };
+  int cell_val_num[] = { 1, TILEDB_VAR_NUM };
+  int compression[] = { TILEDB_GZIP, TILEDB_GZIP, TILEDB_GZIP };
+  const int types[] = { TILEDB_INT32, TILEDB_CHAR, TILEDB_INT64 };
+  REQUIRE(tiledb_array_set_schema(&array_schema_, array_name_.c_str(), attributes, 2, 8, TILEDB_ROW_MAJOR,
+                                  cell_val_num, compression, NULL, NULL, NULL, 0, dimensions, 2, domain,
+                                  sizeof(domain), tile_extents, sizeof(tile_extents), TILEDB_ROW_MAJOR,
+                                  types) == TILEDB_OK);
+  REQUIRE(tiledb_array_create(tiledb_ctx_, &array_schema_) == TILEDB_OK);
+  REQUIRE(tiledb_array_free_schema(&array_schema_) == TILEDB_OK);
+
+  // The second fragment overwrites rows 4 to 7 of the first
+  for(int f = 0; f < 2; ++f) {
+    std::vector<int> a1;
+    std::vector<size_t> a2_offsets;
+    std::string a2;
+    std::vector<int64_t> coords;
+    for(int64_t i = f ? 4 : 0; i < (f ? 8 : 16); ++i) {
+      for(int64_t j = 0; j < 16; ++j) {
+        a1.push_back(f*1000 + i*16+j);
+        a2_offsets.push_back(a2.size());
+        a2.append((i*16+j)%5+1, 'a'+f);
+        coords.insert(coords.end(), { i, j });
+      }
+    }
+    TileDB_Array* tiledb_array;
+    REQUIRE(tiledb_array_init(tiledb_ctx_, &tiledb_array, array_name_.c_str(), TILEDB_ARRAY_WRITE_UNSORTED,
+                              NULL, NULL, 0) == TILEDB_OK);
+    const void* buffers[] = { a1.data(), a2_offsets.data(), a2.data(), coords.data() };
+    size_t buffer_sizes[] = { a1.size()*sizeof(int), a2_offsets.size()*sizeof(size_t), a2.size(),
+                              coords.size()*sizeof(int64_t) };
+    CHECK(tiledb_array_write(tiledb_array, buffers, buffer_sizes) == TILEDB_OK);
+    CHECK(tiledb_array_finalize(tiledb_array) == TILEDB_OK);
+  }
+
+  // Buffers overflowing several times, with and without skipping cells
+  ScopedEnv read_threads("TILEDB_READ_THREADS");
+  const std::vector<const char*> read_attributes = { "ATTR_INT32", "ATTR_CHAR", TILEDB_COORDS };
+  const std::vector<size_t> buffer_sizes = { 7*sizeof(int), 5*sizeof(size_t), 16, 2*5*sizeof(int64_t) };
+  for(size_t skip_count : { 0, 5 }) {
+    std::vector<size_t> skip_counts(buffer_sizes.size(), skip_count);
+    read_threads.set("1");
+    auto cells = read_sparse_array_cells(read_attributes, buffer_sizes, skip_counts.data());
+    REQUIRE(cells[0].size() == (16*16-skip_count)*sizeof(int));
+    CHECK(cells[1].size() == (16*16-skip_count)*sizeof(size_t));
+    CHECK(cells[3].size() == 2*(16*16-skip_count)*sizeof(int64_t));
+    const int* a1 = reinterpret_cast<const int*>(cells[0].data());
+    CHECK(a1[4*16-skip_count] == 1000 + 4*16);
+    read_threads.set("4");
+    CHECK(read_sparse_array_cells(read_attributes, buffer_sizes, skip_counts.data()) == cells);
+  }
+}
+
+TEST_CASE_METHOD(SparseArrayTestFixture, "Test computing fragment cell ranges concurrently", "[test_sparse_fragment_threads]") {
+  create_sparse_array_16x16("sparse_test_fragment_threads", 2, 8, true);
+
+  ScopedEnv fragment_threads("TILEDB_FRAGMENT_THREADS");
+  for(auto threads : { "1", "4" }) {
+    fragment_threads.set(threads);
+    check_sparse_array_16x16();
+    check_sparse_array_16x16(3, 12, 5, 9);
+  }
+}
+
+TEST_CASE_METHOD(SparseArrayTestFixture, "Test merging fragment cell ranges with a tournament tree", "[test_sparse_merge_tree]") {
+  int cell_order = TILEDB_ROW_MAJOR;
+  SECTION("row major") {
+    cell_order = TILEDB_ROW_MAJOR;
+  }
+  SECTION("column major") {
+    cell_order = TILEDB_COL_MAJOR;
+  }
+
+  create_sparse_array_16x16("sparse_test_merge_tree", 2, 8, false, cell_order);
+
+  // The attribute and the coordinates in the global order
+  const std::vector<const char*> attributes = { "ATTR_INT32", TILEDB_COORDS };
+  const std::vector<size_t> buffer_sizes = { 16*16*sizeof(int), 2*16*16*sizeof(int64_t) };
+  ScopedEnv merge_tree_min_fragments("TILEDB_MERGE_TREE_MIN_FRAGMENTS", "1000");
+  auto cells_heap = read_sparse_array_cells(attributes, buffer_sizes);
+  CHECK(cells_heap[0].size() == 16*16*sizeof(int));
+  merge_tree_min_fragments.set("2");
+  CHECK(read_sparse_array_cells(attributes, buffer_sizes) == cells_heap);
+  check_sparse_array_16x16(2, 13, 1, 11);
+
+  // Many fragments interleaved within every tile, so that their cell ranges
+  // overlap and are split and queued again many more times than there are
+  // leaves in the tree
+  create_sparse_array_16x16("sparse_test_merge_tree_interleaved", 0, 8, false, cell_order);
+  int fragment_num = 12;
+  for(int f = 0; f < fragment_num; ++f) {
+    std::vector<int> a1;
+    std::vector<int64_t> coords;
+    for(int64_t i = 0; i < 16; ++i) {
+      for(int64_t j = 0; j < 16; ++j) {
+        if((i*16+j)%fragment_num == f) {
+          a1.push_back(i*16+j);
+          coords.insert(coords.end(), { i, j });
+        }
+      }
+    }
+    write_sparse_array_cells_2D(a1, coords);
+  }
+
+  merge_tree_min_fragments.set("1000");
+  cells_heap = read_sparse_array_cells(attributes, buffer_sizes);
+  CHECK(cells_heap[0].size() == 16*16*sizeof(int));
+  merge_tree_min_fragments.set("2");
+  CHECK(read_sparse_array_cells(attributes, buffer_sizes) == cells_heap);
+  check_sparse_array_16x16();
+  check_sparse_array_16x16(2, 13, 1, 11);
+}
+
+TEST_CASE_METHOD(SparseArrayTestFixture, "Test loading book-keeping of fragments concurrently", "[test_sparse_load_book_keeping]") {
+  create_sparse_array_16x16("sparse_test_load_book_keeping", 2);
+
+  PosixFS fs;
+  std::vector<std::string> fragment_names = get_fragment_dirs(&fs, array_name_);
+  REQUIRE(fragment_names.size() == 2);
+
+  ScopedEnv load_threads("TILEDB_BOOKKEEPING_LOAD_THREADS");
+  for(auto threads : { "1", "4", "16" }) {
+    load_threads.set(threads);
+    check_sparse_array_16x16();
+  }
+
+  // The error loading a missing book-keeping file is reported
+  std::string book_keeping_file = fragment_names[1] + "/" + TILEDB_BOOK_KEEPING_FILENAME + TILEDB_FILE_SUFFIX + TILEDB_GZIP_SUFFIX;
+  CHECK_RC(fs.delete_file(book_keeping_file), TILEDB_FS_OK);
+  load_threads.set("4");
+  CHECK(read_sparse_array_2D(0, 15, 0, 15, TILEDB_ARRAY_READ_SORTED_ROW) == NULL);
+  CHECK(std::string(tiledb_errmsg).find("Cannot load book-keeping") != std::string::npos);
+}
+
+TEST_CASE_METHOD(SparseArrayTestFixture, "Test consolidating attributes concurrently", "[test_sparse_consolidate_threads]") {
+  ScopedEnv consolidation_threads("TILEDB_CONSOLIDATION_THREADS", "4");
+  create_sparse_array_16x16("sparse_test_consolidate_threads", 2);
+  PosixFS fs;
+  CHECK_RC(tiledb_array_consolidate(tiledb_ctx_, array_name_.c_str()), TILEDB_OK);
+  CHECK(get_fragment_dirs(&fs, array_name_).size() == 1);
+  check_sparse_array_16x16();
+
+  // Small buffers overflow, and batches consolidate into the previous batch
+  for(int i = 0; i < 2; ++i) {
+    CHECK_RC(write_sparse_array_unsorted_2D(16, 16), TILEDB_OK);
+  }
+  CHECK_RC(tiledb_array_consolidate(tiledb_ctx_, array_name_.c_str(), 100, 2), TILEDB_OK);
+  CHECK(get_fragment_dirs(&fs, array_name_).size() == 1);
+  check_sparse_array_16x16();
+
+  // A memory budget for the buffers of a single attribute consolidates one attribute at a time
+  ScopedEnv memory_budget("TILEDB_CONSOLIDATION_MEMORY_BUDGET", "200");
+  CHECK_RC(write_sparse_array_unsorted_2D(16, 16), TILEDB_OK);
+  CHECK_RC(tiledb_array_consolidate(tiledb_ctx_, array_name_.c_str(), 100), TILEDB_OK);
+  CHECK(get_fragment_dirs(&fs, array_name_).size() == 1);
+  check_sparse_array_16x16();
+}
+
+TEST_CASE_METHOD(SparseArrayTestFixture, "Test consolidation plans", "[test_sparse_consolidation_plan]") {
+  // Read rounds beyond the memory size are spilled
+  ConsolidationPlan plan(2*sizeof(ArrayReadState::FragmentCellPosRange));
+  for(int i = 0; i < 3; ++i) {
+    auto fragment_cell_pos_ranges = new ArrayReadState::FragmentCellPosRanges();
+    for(int j = 0; j <= i; ++j) {
+      fragment_cell_pos_ranges->push_back({{j, i}, {i*10+j, i*10+j+1}});
+    }
+    REQUIRE(plan.append(fragment_cell_pos_ranges) == TILEDB_CP_OK);
+  }
+  CHECK(plan.spilled());
+  REQUIRE(plan.round_num() == 3);
+  for(int i = 2; i >= 0; --i) {
+    ArrayReadState::FragmentCellPosRanges fragment_cell_pos_ranges;
+    REQUIRE(plan.get(i, fragment_cell_pos_ranges) == TILEDB_CP_OK);
+    REQUIRE(fragment_cell_pos_ranges.size() == size_t(i+1));
+    for(int j = 0; j <= i; ++j) {
+      CHECK(fragment_cell_pos_ranges[j].first.first == j);
+      CHECK(fragment_cell_pos_ranges[j].first.second == i);
+      CHECK(fragment_cell_pos_ranges[j].second.first == i*10+j);
+      CHECK(fragment_cell_pos_ranges[j].second.second == i*10+j+1);
+    }
+  }
+
+  // Consolidation replays a plan spilled entirely to disk for every attribute
+  ScopedEnv plan_memory_size("TILEDB_CONSOLIDATION_PLAN_MEMORY_SIZE", "0");
+  create_sparse_array_16x16("sparse_test_consolidation_plan");
+  PosixFS fs;
+  ScopedEnv consolidation_threads("TILEDB_CONSOLIDATION_THREADS");
+  for(auto threads : {"1", "2"}) {
+    consolidation_threads.set(threads);
+    CHECK_RC(write_sparse_array_unsorted_2D(16, 16), TILEDB_OK);
+    CHECK_RC(tiledb_array_consolidate(tiledb_ctx_, array_name_.c_str(), 100), TILEDB_OK);
+    CHECK(get_fragment_dirs(&fs, array_name_).size() == 1);
+    check_sparse_array_16x16();
+  }
+}
+
+TEST_CASE_METHOD(SparseArrayTestFixture, "Test caching book-keeping across array opens", "[test_sparse_book_keeping_cache]") {
+  BookKeepingCache& cache = BookKeepingCache::instance();
+  create_sparse_array_16x16("sparse_test_book_keeping_cache");
+
+  // Disabled with a size limit of 0
+  ScopedCacheSize<BookKeepingCache> cache_size;
+  size_t hits = cache.hits();
+  size_t misses = cache.misses();
+  check_sparse_array_16x16();
+  CHECK(cache.max_size() == 0);
+  CHECK(cache.hits() == hits);
+  CHECK(cache.misses() == misses);
+
+  cache_size.set(1048576);
+  check_sparse_array_16x16();
+  CHECK(cache.misses() == misses+1);
+  CHECK(cache.size() > 0);
+  check_sparse_array_16x16();
+  CHECK(cache.hits() == hits+1);
+
+  // Shared with other contexts, only new fragments are loaded
+  CHECK_RC(tiledb_ctx_finalize(tiledb_ctx_), TILEDB_OK);
+  CHECK_RC(tiledb_ctx_init(&tiledb_ctx_, NULL), TILEDB_OK);
+  CHECK_RC(write_sparse_array_unsorted_2D(16, 16), TILEDB_OK);
+  check_sparse_array_16x16();
+  CHECK(cache.hits() == hits+2);
+  CHECK(cache.misses() == misses+2);
+
+  // Book-keeping larger than the cache is not cached
+  cache.clear();
+  cache_size.set(16);
+  check_sparse_array_16x16();
+  CHECK(cache.size() == 0);
+  CHECK(cache.misses() == misses+4);
+
+  // Dropped when the array is deleted
+  cache_size.set(1048576);
+  check_sparse_array_16x16();
+  CHECK(cache.size() > 0);
+  CHECK_RC(tiledb_delete(tiledb_ctx_, array_name_.c_str()), TILEDB_OK);
+  CHECK(cache.size() == 0);
+}
+
+TEST_CASE_METHOD(SparseArrayTestFixture, "Test caching decompressed tiles across queries", "[test_sparse_tile_cache]") {
+  TileCache& cache = TileCache::instance();
+  cache.clear();
+  create_sparse_array_16x16("sparse_test_tile_cache", 1, 16, true);
+
+  // Disabled with a size limit of 0
+  ScopedCacheSize<TileCache> cache_size;
+  size_t hits = cache.hits();
+  size_t misses = cache.misses();
+  check_sparse_array_16x16();
+  CHECK(cache.max_size() == 0);
+  CHECK(cache.hits() == hits);
+  CHECK(cache.misses() == misses);
+
+  // Tiles decompressed by the first query are reused by the next ones
+  cache_size.set(1048576);
+  check_sparse_array_16x16();
+  CHECK(cache.misses() > misses);
+  CHECK(cache.size() > 0);
+  hits = cache.hits();
+  misses = cache.misses();
+  check_sparse_array_16x16();
+  CHECK(cache.hits() > hits);
+  CHECK(cache.misses() == misses);
+
+  // Tiles larger than the cache shards are not cached
+  cache.clear();
+  cache_size.set(16);
+  check_sparse_array_16x16();
+  CHECK(cache.size() == 0);
+
+  // Dropped when the array is deleted
+  cache_size.set(1048576);
+  check_sparse_array_16x16();
+  CHECK(cache.size() > 0);
+  CHECK_RC(tiledb_delete(tiledb_ctx_, array_name_.c_str()), TILEDB_OK);
+  CHECK(cache.size() == 0);
+}
+
+static void load_array_schema(StorageFS* fs, const std::string& array_name, ArraySchema& array_schema) {
+  std::string schema_filename = array_name + "/" + TILEDB_ARRAY_SCHEMA_FILENAME;
+  std::vector<char> schema_buffer(fs->file_size(schema_filename));
+  REQUIRE(fs->read_from_file(schema_filename, 0, schema_buffer.data(), schema_buffer.size()) == TILEDB_FS_OK);
+  REQUIRE(array_schema.deserialize(schema_buffer.data(), schema_buffer.size()) == TILEDB_AS_OK);
+}
+
+TEST_CASE_METHOD(SparseArrayTestFixture, "Test tournament tree of fragment cell ranges against the heap", "[test_sparse_merge_tree_ranges]") {
+  int cell_order = TILEDB_ROW_MAJOR;
+  SECTION("row major") {
+    cell_order = TILEDB_ROW_MAJOR;
+  }
+  SECTION("column major") {
+    cell_order = TILEDB_COL_MAJOR;
+  }
+  SECTION("hilbert") {
+    cell_order = TILEDB_HILBERT;
+  }
+  set_array_name("sparse_test_merge_tree_ranges");
+  CHECK_RC(create_sparse_array_2D(4, 4, 0, 15, 0, 15, 8, false, cell_order, TILEDB_ROW_MAJOR), TILEDB_OK);
+  PosixFS fs;
+  ArraySchema array_schema(&fs);
+  load_array_schema(&fs, array_name_, array_schema);
+
+  // Random ranges with shared tiles and start coordinates, many more than the
+  // leaves sized for the fragments so that the tree grows several times
+  typedef ArrayReadState::PQFragmentCellRange<int64_t> Range;
+  int range_num = 500;
+  std::vector<int64_t> coords(4*range_num);
+  std::vector<Range> ranges(range_num, Range(&array_schema, NULL, NULL));
+  for(int i = 0; i < range_num; ++i) {
+    for(int d = 0; d < 4; ++d) {
+      coords[4*i+d] = std::rand()%16;
+    }
+    ranges[i].cell_range_ = &coords[4*i];
+    ranges[i].fragment_id_ = i;
+    ranges[i].tile_id_l_ = std::rand()%4;
+    ranges[i].tile_id_r_ = ranges[i].tile_id_l_;
+  }
+
+  // Pushes and pops interleaved as in the merge, the same range is on top of both
+  ArrayReadState::PQFragmentCellRangeTree<int64_t> tree(&array_schema, 3);
+  std::priority_queue<Range*, std::vector<Range*>, ArrayReadState::SmallerPQFragmentCellRange<int64_t>> heap(&array_schema);
+  for(int i = 0; i < range_num; ++i) {
+    tree.push(&ranges[i]);
+    heap.push(&ranges[i]);
+    if(i%3 == 2) {
+      REQUIRE(tree.top() == heap.top());
+      tree.pop();
+      heap.pop();
+    }
+  }
+  while(!heap.empty()) {
+    REQUIRE(!tree.empty());
+    REQUIRE(tree.top() == heap.top());
+    tree.pop();
+    heap.pop();
+  }
+  CHECK(tree.empty());
+}
+
+TEST_CASE_METHOD(SparseArrayTestFixture, "Test contiguous book-keeping MBRs and bounding coordinates", "[test_sparse_book_keeping_mbrs]") {
+  create_sparse_array_16x16("sparse_test_book_keeping_mbrs", 1, 10);
+
+  PosixFS fs;
+  ArraySchema array_schema(&fs);
+  load_array_schema(&fs, array_name_, array_schema);
+
+  std::vector<std::string> fragment_names = get_fragment_dirs(&fs, array_name_);
+  REQUIRE(fragment_names.size() == 1);
+  BookKeeping book_keeping(&array_schema, false, fragment_names[0], TILEDB_ARRAY_READ);
+  REQUIRE(book_keeping.load(&fs) == TILEDB_BK_OK);
+
+  // 256 cells with a capacity of 10 cells per tile
+  int64_t tile_num = book_keeping.tile_num();
+  CHECK(tile_num == 26);
+  CHECK(book_keeping.mbrs().size() == tile_num);
+  CHECK(book_keeping.bounding_coords().size() == tile_num);
+  CHECK(book_keeping.last_tile_cell_num() == 6);
+
+  const int64_t* mbrs_dim_major = static_cast<const int64_t*>(book_keeping.mbrs_dim_major());
+  for(int64_t i = 0; i < tile_num; ++i) {
+    const int64_t* mbr = static_cast<const int64_t*>(book_keeping.mbrs()[i]);
+    const int64_t* bounding_coords = static_cast<const int64_t*>(book_keeping.bounding_coords()[i]);
+    for(int j = 0; j < 4; ++j) {
+      CHECK(mbrs_dim_major[j*tile_num + i] == mbr[j]);
+    }
+    // The first and last coordinates of the tile are within its MBR
+    for(int d = 0; d < 2; ++d) {
+      CHECK(bounding_coords[d] >= mbr[2*d]);
+      CHECK(bounding_coords[d] <= mbr[2*d+1]);
+      CHECK(bounding_coords[2+d] >= mbr[2*d]);
+      CHECK(bounding_coords[2+d] <= mbr[2*d+1]);
+    }
+  }
+}
+
+TEST_CASE_METHOD(SparseArrayTestFixture, "Test uncompressed version 2 book-keeping", "[test_sparse_book_keeping_v2]") {
+  PosixFS fs;
+  std::vector<std::string> array_names;
+  for(auto v2 : { false, true }) {
+    ScopedEnv book_keeping_v2("TILEDB_BOOKKEEPING_V2");
+    if(v2) {
+      book_keeping_v2.set("1");
+    }
+    create_sparse_array_16x16(v2 ? "sparse_test_book_keeping_v2" : "sparse_test_book_keeping_v1", 1, 10, true);
+    array_names.push_back(array_name_);
+  }
+
+  // Only the uncompressed file is written with TILEDB_BOOKKEEPING_V2
+  std::vector<std::string> fragment_names_v1 = get_fragment_dirs(&fs, array_names[0]);
+  std::vector<std::string> fragment_names_v2 = get_fragment_dirs(&fs, array_names[1]);
+  REQUIRE(fragment_names_v1.size() == 1);
+  REQUIRE(fragment_names_v2.size() == 1);
+  std::string book_keeping_v2_file = fragment_names_v2[0] + "/" + TILEDB_BOOK_KEEPING_FILENAME + TILEDB_FILE_SUFFIX;
+  CHECK(fs.is_file(book_keeping_v2_file));
+  CHECK(!fs.is_file(book_keeping_v2_file + TILEDB_GZIP_SUFFIX));
+
+  ArraySchema array_schema(&fs);
+  load_array_schema(&fs, array_names[0], array_schema);
+  BookKeeping book_keeping_v1(&array_schema, false, fragment_names_v1[0], TILEDB_ARRAY_READ);
+  BookKeeping book_keeping_v2(&array_schema, false, fragment_names_v2[0], TILEDB_ARRAY_READ);
+  REQUIRE(book_keeping_v1.load(&fs) == TILEDB_BK_OK);
+  REQUIRE(book_keeping_v2.load(&fs) == TILEDB_BK_OK);
+  CHECK(!book_keeping_v1.v2());
+  CHECK(book_keeping_v2.v2());
+
+  // Both formats load the same book-keeping
+  int64_t tile_num = book_keeping_v1.tile_num();
+  REQUIRE(book_keeping_v2.tile_num() == tile_num);
+  CHECK(book_keeping_v2.last_tile_cell_num() == book_keeping_v1.last_tile_cell_num());
+  size_t coords_pair_size = 2*array_schema.coords_size();
+  CHECK(memcmp(book_keeping_v2.non_empty_domain(), book_keeping_v1.non_empty_domain(), coords_pair_size) == 0);
+  CHECK(memcmp(book_keeping_v2.domain(), book_keeping_v1.domain(), coords_pair_size) == 0);
+  CHECK(memcmp(book_keeping_v2.mbrs().data(), book_keeping_v1.mbrs().data(), tile_num*coords_pair_size) == 0);
+  CHECK(memcmp(book_keeping_v2.bounding_coords().data(), book_keeping_v1.bounding_coords().data(), tile_num*coords_pair_size) == 0);
+  for(int i = 0; i < array_schema.attribute_num()+1; ++i) {
+    REQUIRE(book_keeping_v2.tile_offsets(i).size() == tile_num);
+    CHECK(std::equal(book_keeping_v2.tile_offsets(i).begin(), book_keeping_v2.tile_offsets(i).end(),
+                     book_keeping_v1.tile_offsets(i).begin()));
+  }
+
+  // Arrays with version 2 book-keeping are read with every read method
+  TileDB_Config tiledb_config;
+  SECTION("mmap") {
+    tiledb_config.read_method_ = TILEDB_IO_MMAP;
+  }
+  SECTION("read") {
+    tiledb_config.read_method_ = TILEDB_IO_READ;
+  }
+  CHECK_RC(tiledb_ctx_finalize(tiledb_ctx_), TILEDB_OK);
+  CHECK_RC(tiledb_ctx_init(&tiledb_ctx_, &tiledb_config), TILEDB_OK);
+  check_sparse_array_16x16();
+
+  // Truncated files are rejected
+  std::vector<char> header(32);
+  REQUIRE(fs.read_from_file(book_keeping_v2_file, 0, header.data(), header.size()) == TILEDB_FS_OK);
+  REQUIRE(fs.delete_file(book_keeping_v2_file) == TILEDB_FS_OK);
+  REQUIRE(fs.write_to_file(book_keeping_v2_file, header.data(), header.size()) == TILEDB_FS_OK);
+  REQUIRE(fs.close_file(book_keeping_v2_file) == TILEDB_FS_OK);
+  BookKeeping book_keeping_truncated(&array_schema, false, fragment_names_v2[0], TILEDB_ARRAY_READ);
+  CHECK(book_keeping_truncated.load(&fs) == TILEDB_BK_ERR);
+  CHECK(tiledb_bk_errmsg.find("version 2") != std::string::npos);
+}
+
+TEST_CASE_METHOD(SparseArrayTestFixture, "Test loading book-keeping of attributes on demand", "[test_sparse_book_keeping_lazy]") {
+  PosixFS fs;
+  std::vector<std::string> array_names;
+  for(auto v2 : { false, true }) {
+    ScopedEnv book_keeping_v2("TILEDB_BOOKKEEPING_V2");
+    if(v2) {
+      book_keeping_v2.set("1");
+    }
+    create_sparse_array_16x16(v2 ? "sparse_test_book_keeping_lazy_v2" : "sparse_test_book_keeping_lazy", 1, 10, true);
+    array_names.push_back(array_name_);
+  }
+
+  ArraySchema array_schema(&fs);
+  load_array_schema(&fs, array_names[0], array_schema);
+  int coords_id = array_schema.attribute_num();
+
+  auto check_load_on_demand = [&](StorageFS* fs, const std::string& fragment_name, const BookKeeping& book_keeping_all) {
+    // Only the coordinates are loaded
+    BookKeeping book_keeping(&array_schema, false, fragment_name, TILEDB_ARRAY_READ);
+    REQUIRE(book_keeping.load(fs, {}) == TILEDB_BK_OK);
+    CHECK(book_keeping.tile_num() == book_keeping_all.tile_num());
+    CHECK(book_keeping.last_tile_cell_num() == book_keeping_all.last_tile_cell_num());
+    CHECK(book_keeping.tile_offsets(0).empty());
+    REQUIRE(book_keeping.tile_offsets(coords_id).size() == book_keeping_all.tile_num());
+    CHECK(std::equal(book_keeping.tile_offsets(coords_id).begin(), book_keeping.tile_offsets(coords_id).end(),
+                     book_keeping_all.tile_offsets(coords_id).begin()));
+    size_t memory_size = book_keeping.memory_size();
+
+    CHECK(book_keeping.load_attributes(fs, { 0, coords_id }) == TILEDB_BK_OK);
+    CHECK(book_keeping.load_attributes(fs, { 0 }) == TILEDB_BK_OK);
+    REQUIRE(book_keeping.tile_offsets(0).size() == book_keeping_all.tile_num());
+    CHECK(std::equal(book_keeping.tile_offsets(0).begin(), book_keeping.tile_offsets(0).end(),
+                     book_keeping_all.tile_offsets(0).begin()));
+    CHECK(book_keeping.memory_size() == memory_size + book_keeping_all.tile_num()*sizeof(off_t));
+  };
+
+  // Compressed book-keeping is decompressed again for the attributes loaded on demand
+  std::vector<std::string> fragment_names = get_fragment_dirs(&fs, array_names[0]);
+  REQUIRE(fragment_names.size() == 1);
+  BookKeeping book_keeping_all(&array_schema, false, fragment_names[0], TILEDB_ARRAY_READ);
+  REQUIRE(book_keeping_all.load(&fs) == TILEDB_BK_OK);
+  check_load_on_demand(&fs, fragment_names[0], book_keeping_all);
+
+  // Version 2 book-keeping not memory mapped is read by section
+  fragment_names = get_fragment_dirs(&fs, array_names[1]);
+  REQUIRE(fragment_names.size() == 1);
+  std::string book_keeping_file = fragment_names[0] + "/" + TILEDB_BOOK_KEEPING_FILENAME + TILEDB_FILE_SUFFIX;
+  std::vector<char> contents(fs.file_size(book_keeping_file));
+  REQUIRE(fs.read_from_file(book_keeping_file, 0, contents.data(), contents.size()) == TILEDB_FS_OK);
+  MemoryFS memory_fs("mem://test_sparse_book_keeping_lazy/");
+  REQUIRE(memory_fs.write_to_file(book_keeping_file, contents.data(), contents.size()) == TILEDB_FS_OK);
+  REQUIRE(memory_fs.close_file(book_keeping_file) == TILEDB_FS_OK);
+  check_load_on_demand(&memory_fs, fragment_names[0], book_keeping_all);
+  CHECK(memory_fs.delete_dir(fragment_names[0]) == TILEDB_FS_OK);
+
+  // Arrays opened for some of the attributes load the rest when reopened
+  array_name_ = array_names[0];
+  const char* coords_only[] = { TILEDB_COORDS };
+  TileDB_Array* tiledb_array;
+  {
+    ScopedCacheSize<BookKeepingCache> cache_size(1048576);
+    REQUIRE(tiledb_array_init(tiledb_ctx_, &tiledb_array, array_name_.c_str(), TILEDB_ARRAY_READ,
+                              NULL, coords_only, 1) == TILEDB_OK);
+    CHECK(tiledb_array_finalize(tiledb_array) == TILEDB_OK);
+    check_sparse_array_16x16();
+    BookKeepingCache::instance().clear();
+  }
+
+  // Arrays opened for some of the attributes load the rest when reset to them
+  REQUIRE(tiledb_array_init(tiledb_ctx_, &tiledb_array, array_name_.c_str(), TILEDB_ARRAY_READ_SORTED_ROW,
+                            NULL, coords_only, 1) == TILEDB_OK);
+  const char* attributes[] = { "ATTR_INT32" };
+  CHECK(tiledb_array_reset_attributes(tiledb_array, attributes, 1) == TILEDB_OK);
+  std::vector<int> values(16*16);
+  void* buffers[] = { values.data() };
+  size_t buffer_sizes[] = { values.size()*sizeof(int) };
+  CHECK(tiledb_array_read(tiledb_array, buffers, buffer_sizes) == TILEDB_OK);
+  CHECK(buffer_sizes[0] == values.size()*sizeof(int));
+  for(int i = 0; i < 16*16; ++i) {
+    CHECK(values[i] == i);
+  }
+  CHECK(tiledb_array_finalize(tiledb_array) == TILEDB_OK);
+}
+
+TEST_CASE_METHOD(SparseArrayTestFixture, "Test looking up overlapping tiles with the MBR index", "[test_sparse_mbr_index]") {
+  auto brute_force = [](const int64_t* mbrs, int64_t mbr_num, const int64_t* subarray, int64_t first, int64_t last) {
+    std::vector<int64_t> tiles;
+    for(int64_t i = std::max(first, (int64_t)0); i <= std::min(last, mbr_num-1); ++i) {
+      const int64_t* mbr = &mbrs[4*i];
+      if(mbr[0] <= subarray[1] && mbr[1] >= subarray[0] && mbr[2] <= subarray[3] && mbr[3] >= subarray[2]) {
+        tiles.push_back(i);
+      }
+    }
+    return tiles;
+  };
+
+  // Random MBRs, several levels deep
+  std::vector<int64_t> mbrs;
+  int64_t mbr_num = 5000;
+  for(int64_t i = 0; i < mbr_num; ++i) {
+    int64_t row = i/50;
+    int64_t col = (i%50)*20 + std::rand()%10;
+    mbrs.insert(mbrs.end(), { row, row + std::rand()%3, col, col + std::rand()%30 });
+  }
+  MBRIndex mbr_index(TILEDB_INT64, 2, mbrs.data(), mbr_num);
+  CHECK(mbr_index.memory_size() > 0);
+  for(int i = 0; i < 100; ++i) {
+    int64_t row = std::rand()%100;
+    int64_t col = std::rand()%1000;
+    int64_t subarray[] = { row, row + std::rand()%5, col, col + std::rand()%50 };
+    int64_t first = std::rand()%mbr_num;
+    int64_t last = first + std::rand()%mbr_num;
+    std::vector<int64_t> tiles;
+    mbr_index.query(subarray, first, last, tiles);
+    CHECK(tiles == brute_force(mbrs.data(), mbr_num, subarray, first, last));
+  }
+  std::vector<int64_t> tiles;
+  MBRIndex empty_index(TILEDB_INT64, 2, NULL, 0);
+  int64_t subarray[] = { 0, 10, 0, 10 };
+  empty_index.query(subarray, 0, 10, tiles);
+  CHECK(tiles.empty());
+
+  // Index over the MBRs of a fragment
+  create_sparse_array_16x16("sparse_test_mbr_index", 1, 10);
+  PosixFS fs;
+  ArraySchema array_schema(&fs);
+  load_array_schema(&fs, array_name_, array_schema);
+  std::vector<std::string> fragment_names = get_fragment_dirs(&fs, array_name_);
+  REQUIRE(fragment_names.size() == 1);
+  BookKeeping book_keeping(&array_schema, false, fragment_names[0], TILEDB_ARRAY_READ);
+  REQUIRE(book_keeping.load(&fs) == TILEDB_BK_OK);
+  const int64_t* fragment_mbrs = static_cast<const int64_t*>(book_keeping.mbrs().data());
+  size_t memory_size = book_keeping.memory_size();
+  int64_t column[] = { 0, 15, 5, 5 };
+  book_keeping.mbr_index()->query(column, 0, book_keeping.tile_num()-1, tiles);
+  CHECK(tiles == brute_force(fragment_mbrs, book_keeping.tile_num(), column, 0, book_keeping.tile_num()-1));
+  CHECK(book_keeping.mbr_index() == book_keeping.mbr_index());
+  CHECK(book_keeping.memory_size() == memory_size + book_keeping.mbr_index()->memory_size());
+
+  // Reads with and without the index return the same cells
+  ScopedEnv mbr_index_min_tiles("TILEDB_MBR_INDEX_MIN_TILES");
+  for(auto min_tiles : { "1", "1000000" }) {
+    mbr_index_min_tiles.set(min_tiles);
+    check_sparse_array_16x16(0, 15, 5, 5);
+    int *buffer = read_sparse_array_2D(3, 9, 2, 11, TILEDB_ARRAY_READ);
+    REQUIRE(buffer != NULL);
+    std::sort(buffer, buffer+7*10);
+    for(int64_t i = 0; i < 7*10; ++i) {
+      CHECK(buffer[i] == (3+i/10)*16+2+i%10);
+    }
+    delete [] buffer;
+  }
+
+  // The layouts built by the reads are charged to the cached book-keeping, lookups
+  // in the index do not build the dimension-major MBRs
+  BookKeepingCache& cache = BookKeepingCache::instance();
+  cache.clear();
+  ScopedCacheSize<BookKeepingCache> cache_size(1048576);
+  mbr_index_min_tiles.set("1");
+  check_sparse_array_16x16(0, 15, 5, 5);
+  std::shared_ptr<BookKeeping> cached_book_keeping = cache.get(fragment_names[0]);
+  REQUIRE(cached_book_keeping);
+  size_t index_size = cache.size();
+  CHECK(index_size == cached_book_keeping->memory_size());
+  mbr_index_min_tiles.set("1000000");
+  check_sparse_array_16x16(0, 15, 5, 5);
+  CHECK(cache.size() == index_size + book_keeping.tile_num()*4*sizeof(int64_t));
+  CHECK(cache.size() == cached_book_keeping->memory_size());
+  cached_book_keeping.reset();
+  cache.clear();
+}
+
+TEST_CASE_METHOD(SparseArrayTestFixture, "Test skipping fragments outside the subarray", "[test_sparse_fragment_pruning]") {
+  set_array_name("sparse_test_fragment_pruning");
+  CHECK_RC(create_sparse_array_2D(4, 4, 0, 15, 0, 15, 10, true, TILEDB_ROW_MAJOR, TILEDB_ROW_MAJOR), TILEDB_OK);
+
+  // Two fragments, rows 0-3 and rows 8-11
+  auto write_rows = [this](int64_t row_lo, int64_t row_hi) {
+    std::vector<int> buffer_a1;
+    std::vector<int64_t> buffer_coords;
+    for(int64_t i = row_lo; i <= row_hi; ++i) {
+      for(int64_t j = 0; j < 16; ++j) {
+        buffer_a1.push_back(i*16+j);
+        buffer_coords.insert(buffer_coords.end(), { i, j });
+      }
+    }
+    write_sparse_array_cells_2D(buffer_a1, buffer_coords);
+  };
+  write_rows(0, 3);
+  write_rows(8, 11);
+
+  auto check_read = [](TileDB_Array* tiledb_array, std::vector<int64_t> rows) {
+    std::vector<int> buffer(16*16);
+    void* buffers[] = { buffer.data() };
+    size_t buffer_sizes[] = { buffer.size()*sizeof(int) };
+    CHECK(tiledb_array_read(tiledb_array, buffers, buffer_sizes) == TILEDB_OK);
+    REQUIRE(buffer_sizes[0] == rows.size()*16*sizeof(int));
+    // Cells are returned in the global order
+    std::sort(buffer.begin(), buffer.begin()+rows.size()*16);
+    for(auto i = 0ul; i < rows.size(); ++i) {
+      for(int64_t j = 0; j < 16; ++j) {
+        CHECK(buffer[i*16+j] == rows[i]*16+j);
+      }
+    }
+  };
+
+  // Cache the book-keeping of the coordinates only, to see which fragments load the tile
+  // offsets of the compressed attribute
+  ScopedCacheSize<BookKeepingCache> cache_size(1048576);
+  const char* coords_only[] = { TILEDB_COORDS };
+  TileDB_Array* tiledb_array;
+  REQUIRE(tiledb_array_init(tiledb_ctx_, &tiledb_array, array_name_.c_str(), TILEDB_ARRAY_READ,
+                            NULL, coords_only, 1) == TILEDB_OK);
+  CHECK(tiledb_array_finalize(tiledb_array) == TILEDB_OK);
+
+  PosixFS fs;
+  std::vector<std::string> fragment_names = get_fragment_dirs(&fs, array_name_);
+  REQUIRE(fragment_names.size() == 2);
+  std::vector<std::shared_ptr<BookKeeping>> book_keeping;
+  for(auto& fragment_name : fragment_names) {
+    book_keeping.push_back(BookKeepingCache::instance().get(fragment_name));
+    REQUIRE(book_keeping.back());
+    CHECK(book_keeping.back()->tile_offsets(0).empty());
+  }
+  auto loaded_num = [&book_keeping]() {
+    return std::count_if(book_keeping.begin(), book_keeping.end(),
+                         [](std::shared_ptr<BookKeeping>& bk) { return !bk->tile_offsets(0).empty(); });
+  };
+
+  const char* attributes[] = { "ATTR_INT32" };
+  int64_t subarray[] = { 0, 5, 0, 15 };
+  REQUIRE(tiledb_array_init(tiledb_ctx_, &tiledb_array, array_name_.c_str(), TILEDB_ARRAY_READ,
+                            subarray, attributes, 1) == TILEDB_OK);
+  check_read(tiledb_array, { 0, 1, 2, 3 });
+  CHECK(loaded_num() == 1);
+
+  // Fragments are skipped with the bounding box of their MBRs
+  std::vector<std::vector<int64_t>> bounds;
+  for(auto& bk : book_keeping) {
+    const int64_t* mbrs_bounds = static_cast<const int64_t*>(bk->mbrs_bounds());
+    REQUIRE(mbrs_bounds != NULL);
+    bounds.emplace_back(mbrs_bounds, mbrs_bounds+4);
+  }
+  std::sort(bounds.begin(), bounds.end());
+  CHECK(bounds[0] == std::vector<int64_t>({ 0, 3, 0, 15 }));
+  CHECK(bounds[1] == std::vector<int64_t>({ 8, 11, 0, 15 }));
+
+  // Fragments skipped earlier are opened when the subarray is reset
+  int64_t subarray_1[] = { 9, 15, 0, 15 };
+  CHECK(tiledb_array_reset_subarray(tiledb_array, subarray_1) == TILEDB_OK);
+  check_read(tiledb_array, { 9, 10, 11 });
+  CHECK(loaded_num() == 2);
+  int64_t subarray_2[] = { 3, 8, 0, 15 };
+  CHECK(tiledb_array_reset_subarray(tiledb_array, subarray_2) == TILEDB_OK);
+  check_read(tiledb_array, { 3, 8 });
+  int64_t subarray_3[] = { 4, 7, 0, 15 };
+  CHECK(tiledb_array_reset_subarray(tiledb_array, subarray_3) == TILEDB_OK);
+  check_read(tiledb_array, { });
+  CHECK(tiledb_array_reset_subarray(tiledb_array, subarray) == TILEDB_OK);
+  check_read(tiledb_array, { 0, 1, 2, 3 });
+  CHECK(tiledb_array_finalize(tiledb_array) == TILEDB_OK);
+
+  int *buffer = read_sparse_array_2D(2, 9, 0, 15, TILEDB_ARRAY_READ_SORTED_ROW, 4*16);
+  REQUIRE(buffer != NULL);
+  for(int64_t i = 0; i < 4*16; ++i) {
+    CHECK(buffer[i] == (i < 32 ? 32+i : 128+i-32));
+  }
+  delete [] buffer;
+
+  book_keeping.clear();
+  BookKeepingCache::instance().clear();
+}
+
+TEST_CASE_METHOD(SparseArrayTestFixture, "Test opening arrays from the fragment manifest", "[test_sparse_fragment_manifest]") {
+  // Disabled by default
+  ScopedEnv fragment_manifest("TILEDB_FRAGMENT_MANIFEST");
+  create_sparse_array_16x16("sparse_test_fragment_manifest");
+  PosixFS fs;
+  std::string array_real = real_dir(&fs, array_name_);
+  FragmentManifest manifest(&fs, array_real);
+  auto check_names = [&]() {
+    std::vector<std::string> fragment_names = get_fragment_dirs(&fs, array_real);
+    REQUIRE(manifest.entries().size() == fragment_names.size());
+    for(auto const& entry : manifest.entries()) {
+      CHECK(std::find(fragment_names.begin(), fragment_names.end(), array_real + "/" + entry.name_) != fragment_names.end());
+      CHECK(!entry.dense_);
+    }
+  };
+
+  CHECK(!manifest.load());
+  CHECK(!fs.is_file(array_real + "/" + TILEDB_FM_LOCK_FILENAME));
+
+  // Fragments committed before the manifest is created are found in the array directory
+  fragment_manifest.set("1");
+  CHECK_RC(write_sparse_array_unsorted_2D(16, 16), TILEDB_OK);
+  REQUIRE(manifest.load());
+  REQUIRE(manifest.entries().size() == 2);
+  check_names();
+  CHECK(manifest.entries()[0].timestamp_ <= manifest.entries()[1].timestamp_);
+  CHECK(manifest.entries()[0].non_empty_domain_.empty());
+  REQUIRE(manifest.entries()[1].non_empty_domain_.size() == 4*sizeof(int64_t));
+  const int64_t* non_empty_domain = reinterpret_cast<const int64_t*>(manifest.entries()[1].non_empty_domain_.data());
+  CHECK(non_empty_domain[0] == 0);
+  CHECK(non_empty_domain[3] == 15);
+
+  // Maintained once it exists, consolidation replaces the consolidated fragments
+  fragment_manifest.unset();
+  CHECK_RC(tiledb_array_consolidate(tiledb_ctx_, array_name_.c_str()), TILEDB_OK);
+  REQUIRE(manifest.load());
+  CHECK(manifest.entries().size() == 1);
+  check_names();
+  CHECK_RC(write_sparse_array_unsorted_2D(16, 16), TILEDB_OK);
+  REQUIRE(manifest.load());
+  CHECK(manifest.entries().size() == 2);
+  check_names();
+  check_sparse_array_16x16();
+
+  // Updates are serialized across processes with a file lock
+  CHECK(fs.is_file(array_real + "/" + TILEDB_FM_LOCK_FILENAME));
+
+  // Fragments missing from the manifest, e.g. after an update lost to a concurrent commit,
+  // are found in the array directory and are added back by the next update
+  std::vector<std::string> fragment_dirs = get_fragment_dirs(&fs, array_real);
+  REQUIRE(fragment_dirs.size() == 2);
+  REQUIRE(FragmentManifest::remove_fragments(&fs, array_real, { fragment_dirs[0] }) == TILEDB_FM_OK);
+  REQUIRE(manifest.load());
+  CHECK(manifest.entries().size() == 1);
+  check_sparse_array_16x16();
+  manifest.reconcile();
+  check_names();
+  REQUIRE(manifest.load());
+  CHECK(manifest.entries().size() == 1);
+  REQUIRE(FragmentManifest::add_fragment(&fs, fragment_dirs[1], false, NULL, 0) == TILEDB_FM_OK);
+  REQUIRE(manifest.load());
+  check_names();
+
+  // Directories that are not committed fragments are skipped
+  std::string uncommitted_fragment = array_real + "/__uncommitted_1";
+  REQUIRE(fs.create_dir(uncommitted_fragment) == TILEDB_FS_OK);
+  manifest.reconcile();
+  check_names();
+  REQUIRE(fs.delete_dir(uncommitted_fragment) == TILEDB_FS_OK);
+
+  CHECK_RC(tiledb_array_consolidate(tiledb_ctx_, array_name_.c_str()), TILEDB_OK);
+  REQUIRE(manifest.load());
+  CHECK(manifest.entries().size() == 1);
+  check_names();
+  check_sparse_array_16x16();
+
+  // Arrays with a truncated manifest are opened by listing the array directory
+  std::string manifest_filename = array_real + "/" + TILEDB_FRAGMENT_MANIFEST_FILENAME;
+  std::vector<char> contents(fs.file_size(manifest_filename));
+  REQUIRE(fs.read_from_file(manifest_filename, 0, contents.data(), contents.size()) == TILEDB_FS_OK);
+  REQUIRE(fs.delete_file(manifest_filename) == TILEDB_FS_OK);
+  REQUIRE(fs.write_to_file(manifest_filename, contents.data(), contents.size()-1) == TILEDB_FS_OK);
+  REQUIRE(fs.close_file(manifest_filename) == TILEDB_FS_OK);
+  CHECK(!manifest.load());
+  check_sparse_array_16x16();
+
+  // Clearing the array removes the manifest
+  REQUIRE(fs.delete_file(manifest_filename) == TILEDB_FS_OK);
+  REQUIRE(fs.write_to_file(manifest_filename, contents.data(), contents.size()) == TILEDB_FS_OK);
+  REQUIRE(fs.close_file(manifest_filename) == TILEDB_FS_OK);
+  CHECK(manifest.load());
+  CHECK_RC(tiledb_clear(tiledb_ctx_, array_name_.c_str()), TILEDB_OK);
+  CHECK(!manifest.load());
+  CHECK(get_fragment_dirs(&fs, array_real).empty());
+}
+
 class SparseArrayEnvTestFixture : SparseArrayTestFixture {
   public:
   SparseArrayTestFixture *test_fixture;
@@ -38,8 +38,10 @@
 
 #include "catch.h"
 #include "storage_posixfs.h"
+#include "thread_pool.h"
 #include "utils.h"
 
+#include <algorithm>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -610,3 +612,50 @@ TEST_CASE("Test storage URIs", "[storage_uris]") {
   CHECK(is_supported_cloud_path("abfss://ddd/d"));
   CHECK(is_supported_cloud_path("adl://ddd/d"));
 }
+
+TEST_CASE("Test parallel_for", "[parallel_for]") {
+  for (auto num_threads : {1, 4}) {
+    std::vector<int> invoked(100);
+    CHECK(parallel_for(num_threads, invoked.size(), [&invoked](size_t i) {
+          invoked[i]++;
+          return 0;
+        }) == TILEDB_UT_OK);
+    CHECK(std::count(invoked.begin(), invoked.end(), 1) == 100);
+
+    // Invocations are started in order and stop after a failure
+    std::fill(invoked.begin(), invoked.end(), 0);
+    CHECK(parallel_for(num_threads, invoked.size(), [&invoked](size_t i) {
+          invoked[i]++;
+          return i == 10 ? -1 : 0;
+        }) == TILEDB_UT_ERR);
+    CHECK(std::count(invoked.begin(), invoked.begin()+11, 1) == 11);
+    CHECK(std::count(invoked.begin()+11, invoked.end(), 1) < num_threads);
+  }
+  CHECK(parallel_for(4, 0, [](size_t i) { return -1; }) == TILEDB_UT_OK);
+}
+
+TEST_CASE("Test ThreadPool", "[thread_pool]") {
+  for (auto num_threads : {1, 4}) {
+    ThreadPool thread_pool(num_threads);
+    CHECK(thread_pool.num_threads() == num_threads);
+
+    // The same workers run many loops
+    for (auto loop = 0; loop < 1000; loop++) {
+      std::vector<int> invoked(loop%10);
+      CHECK(thread_pool.parallel_for(invoked.size(), [&invoked](size_t i) {
+            invoked[i]++;
+            return 0;
+          }) == TILEDB_UT_OK);
+      CHECK(std::count(invoked.begin(), invoked.end(), 1) == (long)invoked.size());
+    }
+
+    // Invocations are started in order and stop after a failure
+    std::vector<int> invoked(100);
+    CHECK(thread_pool.parallel_for(invoked.size(), [&invoked](size_t i) {
+          invoked[i]++;
+          return i == 10 ? -1 : 0;
+        }) == TILEDB_UT_ERR);
+    CHECK(std::count(invoked.begin(), invoked.begin()+11, 1) == 11);
+    CHECK(std::count(invoked.begin()+11, invoked.end(), 1) < num_threads);
+  }
+}
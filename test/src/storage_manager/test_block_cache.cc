@@ -0,0 +1,228 @@
+/**
+ * @file   test_block_cache.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2026 Omics Data Automation, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Tests for the BlockCacheFS class
+ */
+
+#include "catch.h"
+
+#include "storage_block_cache.h"
+#include "storage_posixfs.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+class BlockCacheTestFixture : public TempDir {
+ protected:
+  PosixFS fs;
+  std::string filename;
+  std::string cache_dir;
+  std::vector<char> buffer;
+  ScopedEnv block_size{"TILEDB_BLOCK_CACHE_BLOCK_SIZE", "16"};
+  ScopedEnv cache_size{"TILEDB_BLOCK_CACHE_SIZE", "64"};
+
+  BlockCacheTestFixture() {
+    // Only files in fragment directories are cached
+    REQUIRE(fs.create_dir(get_temp_dir() + "/__fragment") == TILEDB_FS_OK);
+    filename = get_temp_dir() + "/__fragment/test-file";
+    cache_dir = get_temp_dir() + "/block_cache";
+    buffer.resize(100);
+    std::generate(buffer.begin(), buffer.end(), std::rand);
+  }
+};
+
+TEST_CASE_METHOD(BlockCacheTestFixture, "Test block cache reads", "[block-cache]") {
+  if (get_temp_dir().find("://") != std::string::npos) {
+    return;
+  }
+  REQUIRE(fs.write_to_file(filename, buffer.data(), buffer.size()) == TILEDB_FS_OK);
+
+  BlockCacheFS cache(new PosixFS(), "", cache_dir);
+  CHECK(cache.block_size() == 16);
+  CHECK(cache.max_cache_size() == 64);
+  CHECK(cache.is_file(filename));
+  CHECK(cache.file_size(filename) == 100);
+
+  // Bytes 10-49 span blocks 0-3
+  std::vector<char> read_buffer(100);
+  CHECK(cache.read_from_file(filename, 10, read_buffer.data(), 40) == TILEDB_FS_OK);
+  CHECK(memcmp(read_buffer.data(), buffer.data()+10, 40) == 0);
+  CHECK(cache.block_cache_misses() == 4);
+  CHECK(cache.block_cache_hits() == 0);
+  CHECK(cache.cache_size() == 64);
+
+  CHECK(cache.read_from_file(filename, 20, read_buffer.data(), 20) == TILEDB_FS_OK);
+  CHECK(memcmp(read_buffer.data(), buffer.data()+20, 20) == 0);
+  CHECK(cache.block_cache_misses() == 4);
+  CHECK(cache.block_cache_hits() == 2);
+
+  // Blocks 4-6 are not cached, least recently used blocks are evicted
+  CHECK(cache.read_from_file(filename, 60, read_buffer.data(), 40) == TILEDB_FS_OK);
+  CHECK(memcmp(read_buffer.data(), buffer.data()+60, 40) == 0);
+  CHECK(cache.block_cache_misses() == 7);
+  CHECK(cache.block_cache_hits() == 3);
+  CHECK(cache.cache_size() <= 64);
+
+  CHECK(cache.read_from_file(filename, 0, read_buffer.data(), 100) == TILEDB_FS_OK);
+  CHECK(memcmp(read_buffer.data(), buffer.data(), 100) == 0);
+
+  // Reads past the end of file are reported by the wrapped filesystem
+  CHECK(cache.read_from_file(filename, 90, read_buffer.data(), 20) == TILEDB_FS_ERR);
+  CHECK(cache.read_from_file(filename+".not-exists", 0, read_buffer.data(), 20) == TILEDB_FS_ERR);
+}
+
+TEST_CASE_METHOD(BlockCacheTestFixture, "Test block cache skips mutable files", "[block-cache-mutable]") {
+  if (get_temp_dir().find("://") != std::string::npos) {
+    return;
+  }
+  // Files outside fragment directories, e.g. array schemas and fragment manifests, may be
+  // rewritten in place with the same size
+  std::string mutable_file = get_temp_dir() + "/__array_schema.tdb";
+  REQUIRE(fs.write_to_file(mutable_file, buffer.data(), 50) == TILEDB_FS_OK);
+  REQUIRE(fs.close_file(mutable_file) == TILEDB_FS_OK);
+
+  BlockCacheFS cache(new PosixFS(), "", cache_dir);
+  std::vector<char> read_buffer(50);
+  CHECK(cache.file_size(mutable_file) == 50);
+  CHECK(cache.read_from_file(mutable_file, 0, read_buffer.data(), 50) == TILEDB_FS_OK);
+  CHECK(memcmp(read_buffer.data(), buffer.data(), 50) == 0);
+  REQUIRE(cache.close_file(mutable_file) == TILEDB_FS_OK);
+
+  REQUIRE(fs.delete_file(mutable_file) == TILEDB_FS_OK);
+  REQUIRE(fs.write_to_file(mutable_file, buffer.data()+50, 50) == TILEDB_FS_OK);
+  REQUIRE(fs.close_file(mutable_file) == TILEDB_FS_OK);
+  CHECK(cache.read_from_file(mutable_file, 0, read_buffer.data(), 50) == TILEDB_FS_OK);
+  CHECK(memcmp(read_buffer.data(), buffer.data()+50, 50) == 0);
+
+  CHECK(cache.block_cache_hits() == 0);
+  CHECK(cache.block_cache_misses() == 0);
+  CHECK(cache.cache_size() == 0);
+}
+
+TEST_CASE_METHOD(BlockCacheTestFixture, "Test block cache persists across instances", "[block-cache-persist]") {
+  if (get_temp_dir().find("://") != std::string::npos) {
+    return;
+  }
+  REQUIRE(fs.write_to_file(filename, buffer.data(), buffer.size()) == TILEDB_FS_OK);
+
+  std::vector<char> read_buffer(100);
+  {
+    BlockCacheFS cache(new PosixFS(), "", cache_dir);
+    CHECK(cache.read_from_file(filename, 0, read_buffer.data(), 32) == TILEDB_FS_OK);
+    CHECK(cache.block_cache_misses() == 2);
+    CHECK(cache.cache_size() == 32);
+  }
+
+  // Leftovers from an interrupted write and blocks that do not match the block size are removed
+  std::string partial_block = cache_dir + "/0123456789abcdef-100-16";
+  std::string unaligned_block = cache_dir + "/0123456789abcdef-100-8";
+  std::string tmp_block = cache_dir + "/0123456789abcdef-100-32.tmp.1.1";
+  REQUIRE(fs.write_to_file(partial_block, buffer.data(), 10) == TILEDB_FS_OK);
+  REQUIRE(fs.write_to_file(unaligned_block, buffer.data(), 16) == TILEDB_FS_OK);
+  REQUIRE(fs.write_to_file(tmp_block, buffer.data(), 16) == TILEDB_FS_OK);
+
+  BlockCacheFS cache(new PosixFS(), "", cache_dir);
+  CHECK(cache.cache_size() == 32);
+  CHECK(!fs.is_file(partial_block));
+  CHECK(!fs.is_file(unaligned_block));
+  CHECK(fs.is_file(tmp_block)); // Not stale yet
+
+  CHECK(cache.read_from_file(filename, 0, read_buffer.data(), 32) == TILEDB_FS_OK);
+  CHECK(memcmp(read_buffer.data(), buffer.data(), 32) == 0);
+  CHECK(cache.block_cache_hits() == 2);
+  CHECK(cache.block_cache_misses() == 0);
+}
+
+TEST_CASE_METHOD(BlockCacheTestFixture, "Test block cache invalidation", "[block-cache-invalidate]") {
+  if (get_temp_dir().find("://") != std::string::npos) {
+    return;
+  }
+  BlockCacheFS cache(new PosixFS(), "", cache_dir);
+  REQUIRE(cache.write_to_file(filename, buffer.data(), 50) == TILEDB_FS_OK);
+  REQUIRE(cache.close_file(filename) == TILEDB_FS_OK);
+
+  std::vector<char> read_buffer(100);
+  CHECK(cache.read_from_file(filename, 0, read_buffer.data(), 50) == TILEDB_FS_OK);
+  CHECK(memcmp(read_buffer.data(), buffer.data(), 50) == 0);
+  CHECK(cache.cache_size() == 50);
+
+  // Blocks of a file are dropped when it is written to
+  REQUIRE(cache.write_to_file(filename, buffer.data()+50, 50) == TILEDB_FS_OK);
+  REQUIRE(cache.close_file(filename) == TILEDB_FS_OK);
+  CHECK(cache.cache_size() == 0);
+  CHECK(cache.file_size(filename) == 100);
+  CHECK(cache.read_from_file(filename, 40, read_buffer.data(), 20) == TILEDB_FS_OK);
+  CHECK(memcmp(read_buffer.data(), buffer.data()+40, 20) == 0);
+
+  // Files rewritten by others with a different size do not match cached blocks
+  REQUIRE(fs.delete_file(filename) == TILEDB_FS_OK);
+  REQUIRE(fs.write_to_file(filename, buffer.data()+1, 99) == TILEDB_FS_OK);
+  REQUIRE(cache.close_file(filename) == TILEDB_FS_OK);
+  CHECK(cache.read_from_file(filename, 40, read_buffer.data(), 20) == TILEDB_FS_OK);
+  CHECK(memcmp(read_buffer.data(), buffer.data()+41, 20) == 0);
+
+  REQUIRE(cache.delete_file(filename) == TILEDB_FS_OK);
+  CHECK(cache.cache_size() == 0);
+  CHECK(!cache.is_file(filename));
+  CHECK(cache.read_from_file(filename, 0, read_buffer.data(), 10) == TILEDB_FS_ERR);
+}
+
+TEST_CASE_METHOD(BlockCacheTestFixture, "Test block cache vectored reads", "[block-cache-vectored]") {
+  if (get_temp_dir().find("://") != std::string::npos) {
+    return;
+  }
+  REQUIRE(fs.write_to_file(filename, buffer.data(), buffer.size()) == TILEDB_FS_OK);
+  std::vector<char> read_buffer(20);
+  std::vector<read_range_t> ranges = { {40, read_buffer.data()+10, 10}, {0, read_buffer.data(), 10} };
+
+  // Ranges further apart than the coalesce gap are read separately, blocks 0, 2 and 3
+  ScopedEnv coalesce_gap("TILEDB_READ_COALESCE_GAP", "0");
+  {
+    BlockCacheFS cache(new PosixFS(), "", cache_dir);
+    CHECK(cache.read_from_file_v(filename, ranges) == TILEDB_FS_OK);
+    CHECK(memcmp(read_buffer.data(), buffer.data(), 10) == 0);
+    CHECK(memcmp(read_buffer.data()+10, buffer.data()+40, 10) == 0);
+    CHECK(cache.block_cache_misses() == 3);
+  }
+
+  // Coalesced into one read of bytes 0-49, blocks 0-3
+  REQUIRE(fs.delete_dir(cache_dir) == TILEDB_FS_OK);
+  coalesce_gap.set("64");
+  std::fill(read_buffer.begin(), read_buffer.end(), 0);
+  {
+    BlockCacheFS cache(new PosixFS(), "", cache_dir);
+    CHECK(cache.read_from_file_v(filename, ranges) == TILEDB_FS_OK);
+    CHECK(memcmp(read_buffer.data(), buffer.data(), 10) == 0);
+    CHECK(memcmp(read_buffer.data()+10, buffer.data()+40, 10) == 0);
+    CHECK(cache.block_cache_misses() == 4);
+    CHECK(cache.read_from_file_v(filename, {{95, read_buffer.data(), 10}}) == TILEDB_FS_ERR);
+  }
+}
@@ -0,0 +1,234 @@
+/**
+ * @file   test_memoryfs.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2026 Omics Data Automation, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Tests for the MemoryFS class
+ */
+
+#include "catch.h"
+#include "storage_memoryfs.h"
+#include "tiledb_utils.h"
+#include "utils.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+class MemoryFSTestFixture {
+ protected:
+  MemoryFS *fs = NULL;
+
+  MemoryFSTestFixture() {
+    fs = new MemoryFS("mem://test_memoryfs/home");
+  }
+
+  ~MemoryFSTestFixture() {
+    fs->delete_dir("/home");
+    delete fs;
+  }
+};
+
+TEST_CASE("Test MemoryFS constructor", "[constr]") {
+  CHECK_THROWS(new MemoryFS("memx://my_namespace/path"));
+  CHECK_THROWS(new MemoryFS("s3://my_bucket/path"));
+  MemoryFS fs("mem://my_namespace/path");
+  CHECK(fs.current_dir() == "path");
+  CHECK(!fs.locking_support());
+}
+
+TEST_CASE_METHOD(MemoryFSTestFixture, "Test MemoryFS cwd", "[cwd]") {
+  REQUIRE(fs->current_dir() == "home");
+  REQUIRE(fs->create_dir(fs->current_dir()) == TILEDB_FS_OK);
+  REQUIRE(fs->is_dir(fs->current_dir()));
+  REQUIRE(!fs->is_file(fs->current_dir()));
+  REQUIRE(fs->set_working_dir("mem://test_memoryfs/home/cwd") == TILEDB_FS_OK);
+  REQUIRE(fs->current_dir() == "home/cwd");
+}
+
+TEST_CASE_METHOD(MemoryFSTestFixture, "Test MemoryFS real_dir", "[real_dir]") {
+  CHECK(fs->real_dir("").compare(fs->current_dir()) == 0);
+  CHECK(fs->real_dir("xxx").compare(fs->current_dir()+"/xxx") == 0);
+  CHECK(fs->real_dir("xxx/yyy").compare(fs->current_dir()+"/xxx/yyy") == 0);
+  CHECK(fs->real_dir("/xxx/yyy").compare("xxx/yyy") == 0);
+  CHECK(fs->real_dir("mem://test_memoryfs/xxx/yyy").compare("xxx/yyy") == 0);
+  CHECK_THROWS(fs->real_dir("mem://another_namespace/xxx"));
+  CHECK_THROWS(fs->real_dir("xxx://yyy"));
+}
+
+TEST_CASE_METHOD(MemoryFSTestFixture, "Test MemoryFS dir", "[dir]") {
+  CHECK(!fs->is_dir("non-existent-dir"));
+  CHECK(!fs->is_dir("non-existent-parent-dir/dir"));
+
+  std::string test_dir("dir");
+  CHECK_RC(fs->create_dir(test_dir), TILEDB_FS_OK);
+  CHECK(fs->is_dir(test_dir));
+  CHECK(fs->is_dir(test_dir+"/"));
+  CHECK(!fs->is_file(test_dir));
+  CHECK_RC(fs->create_dir(test_dir), TILEDB_FS_ERR); // Dir already exists
+  CHECK_RC(fs->create_file(test_dir, 0, 0), TILEDB_FS_ERR);
+  CHECK_RC(fs->create_file(fs->real_dir(test_dir), 0, 0), TILEDB_FS_ERR);
+  CHECK(fs->file_size(test_dir) == TILEDB_FS_ERR);
+  CHECK(fs->get_dirs(test_dir).size() == 0);
+  CHECK(fs->get_files(test_dir).size() == 0);
+  CHECK(fs->get_dirs("non-existent-dir").size() == 0);
+  CHECK(fs->get_files("non-existent-dir").size() == 0);
+
+  CHECK_RC(fs->create_dir(test_dir+"/subdir1"), TILEDB_FS_OK);
+  CHECK_RC(fs->write_to_file(test_dir+"/subdir2/foo", "hello", 5), TILEDB_FS_OK);
+  CHECK_RC(fs->write_to_file(test_dir+"/foo", "hello", 5), TILEDB_FS_OK);
+  CHECK(fs->is_dir(test_dir+"/subdir2")); // Implied by its contents
+  auto dirs = fs->get_dirs(test_dir);
+  REQUIRE(dirs.size() == 2);
+  CHECK(dirs[0] == fs->real_dir(test_dir+"/subdir1"));
+  CHECK(dirs[1] == fs->real_dir(test_dir+"/subdir2"));
+  auto files = fs->get_files(test_dir);
+  REQUIRE(files.size() == 1);
+  CHECK(files[0] == fs->real_dir(test_dir+"/foo"));
+
+  std::string new_dir = test_dir+"-new";
+  CHECK_RC(fs->move_path(test_dir, new_dir), TILEDB_FS_OK);
+  CHECK(!fs->is_dir(test_dir));
+  CHECK(!fs->is_dir(test_dir+"/subdir1"));
+  CHECK(fs->is_dir(new_dir));
+  CHECK(fs->is_dir(new_dir+"/subdir1"));
+  CHECK(fs->is_file(new_dir+"/subdir2/foo"));
+  CHECK(fs->file_size(new_dir+"/foo") == 5);
+  CHECK_RC(fs->move_path(test_dir, new_dir), TILEDB_FS_ERR);
+  CHECK_RC(fs->move_path(new_dir, new_dir+"/subdir1/new"), TILEDB_FS_ERR);
+
+  CHECK_RC(fs->sync_path(new_dir), TILEDB_FS_OK);
+  CHECK_RC(fs->sync_path("non-existent-dir"), TILEDB_FS_OK);
+
+  CHECK_RC(fs->delete_dir(new_dir+"/foo"), TILEDB_FS_ERR);
+  CHECK_RC(fs->delete_dir(new_dir), TILEDB_FS_OK);
+  CHECK_RC(fs->delete_dir("non-existent-dir"), TILEDB_FS_ERR);
+  CHECK(!fs->is_dir(new_dir));
+  CHECK(!fs->is_dir(new_dir+"/subdir1"));
+  CHECK(!fs->is_file(new_dir+"/foo"));
+}
+
+TEST_CASE_METHOD(MemoryFSTestFixture, "Test MemoryFS file", "[file]") {
+  std::string test_dir("file");
+  CHECK_RC(fs->create_dir(test_dir), 0);
+  REQUIRE(fs->is_dir(test_dir));
+  CHECK_RC(fs->create_file(test_dir+"/foo", O_WRONLY|O_CREAT,  S_IRWXU), TILEDB_FS_OK);
+  CHECK(fs->is_file(test_dir+"/foo"));
+  CHECK(!fs->is_dir(test_dir+"/foo"));
+  CHECK(fs->file_size(test_dir+"/foo") == 0);
+  CHECK(fs->file_size(test_dir+"/foo1") == TILEDB_FS_ERR);
+  CHECK_RC(fs->create_file(test_dir+"/foo", O_WRONLY|O_CREAT|O_EXCL,  S_IRWXU), TILEDB_FS_ERR);
+
+  CHECK(fs->get_files(test_dir).size() == 1);
+  CHECK_RC(fs->create_file(test_dir+"/foo1", O_WRONLY|O_CREAT,  S_IRWXU), TILEDB_FS_OK);
+  CHECK(fs->get_files(test_dir).size() == 2);
+
+  CHECK_RC(fs->move_path(test_dir+"/foo1", test_dir+"/foo2"), TILEDB_FS_OK);
+  CHECK(!fs->is_file(test_dir+"/foo1"));
+  CHECK(fs->is_file(test_dir+"/foo2"));
+  CHECK_RC(fs->move_path(test_dir+"/foo2", test_dir), TILEDB_FS_ERR);
+
+  CHECK_RC(fs->delete_file(test_dir+"/foo"), TILEDB_FS_OK);
+  CHECK_RC(fs->delete_file(test_dir+"/foo2"), TILEDB_FS_OK);
+  CHECK_RC(fs->delete_file(test_dir+"/foo3"), TILEDB_FS_ERR);
+  CHECK(!fs->is_file(test_dir+"/foo2"));
+  CHECK(fs->get_files(test_dir).size() == 0);
+}
+
+TEST_CASE_METHOD(MemoryFSTestFixture, "Test MemoryFS read/write file", "[read-write]") {
+  std::string test_dir("read_write");
+  CHECK_RC(fs->create_dir(test_dir), TILEDB_FS_OK);
+  CHECK_RC(fs->write_to_file(test_dir+"/foo", "hello", 5), TILEDB_FS_OK);
+  CHECK_RC(fs->close_file(test_dir+"/foo"), TILEDB_FS_OK);
+  CHECK(fs->file_size(test_dir+"/foo") == 5);
+
+  char buffer[20];
+  memset(buffer, 'X', 20);
+  CHECK_RC(fs->read_from_file(test_dir+"/foo", 0, buffer, 0), TILEDB_FS_OK);
+  CHECK_RC(fs->read_from_file(test_dir+"/foo", 0, buffer, 2), TILEDB_FS_OK);
+  CHECK(buffer[0] == 'h');
+  CHECK(buffer[1] == 'e');
+  CHECK_RC(fs->read_from_file(test_dir+"/foo", 0, buffer, 5), TILEDB_FS_OK);
+  CHECK(buffer[4] == 'o');
+  CHECK_RC(fs->read_from_file(test_dir+"/foo", 0, buffer, 6), TILEDB_FS_ERR);
+
+  // Writes append
+  CHECK_RC(fs->write_to_file(test_dir+"/foo", " there", 6), TILEDB_FS_OK);
+  CHECK(fs->file_size(test_dir+"/foo") == 11);
+  CHECK_RC(fs->read_from_file(test_dir+"/foo", 3, buffer, 8), TILEDB_FS_OK);
+  CHECK(memcmp(buffer, "lo there", 8) == 0);
+
+  // Files are shared by instances for the same namespace
+  MemoryFS fs1("mem://test_memoryfs/home");
+  CHECK(fs1.file_size(test_dir+"/foo") == 11);
+  MemoryFS fs2("mem://another_namespace/home");
+  CHECK(!fs2.is_file(test_dir+"/foo"));
+
+  CHECK_RC(fs->read_from_file(test_dir+"/non-existent-file", 0, buffer, 5), TILEDB_FS_ERR);
+  CHECK_RC(fs->read_from_file("non-existent-dir/foo", 0, buffer, 5), TILEDB_FS_ERR);
+  CHECK_RC(fs->write_to_file(test_dir, "hello", 5), TILEDB_FS_ERR);
+}
+
+TEST_CASE_METHOD(MemoryFSTestFixture, "Test MemoryFS operations", "[parallel]") {
+  std::string test_dir("parallel");
+  REQUIRE(fs->create_dir(test_dir) == TILEDB_FS_OK);
+
+  int iterations = 8;
+  size_t size = 1024*1024;
+  std::vector<char> buffer(size, 'X');
+
+  #pragma omp parallel for
+  for (int i=0; i<iterations; i++) {
+    std::string filename = test_dir+"/foo"+std::to_string(i%2);
+    CHECK_RC(fs->write_to_file(filename, buffer.data(), size), TILEDB_FS_OK);
+    std::vector<char> read_buffer(size);
+    CHECK_RC(fs->read_from_file(filename, 0, read_buffer.data(), size), TILEDB_FS_OK);
+    CHECK(read_buffer == buffer);
+  }
+
+  for (int i=0; i<2; i++) {
+    CHECK((size_t)fs->file_size(test_dir+"/foo"+std::to_string(i)) == size*iterations/2);
+  }
+  CHECK_RC(fs->delete_dir(test_dir), TILEDB_FS_OK);
+}
+
+TEST_CASE("Test MemoryFS with TileDBUtils", "[tiledb-utils]") {
+  std::string workspace = "mem://test_memoryfs_utils/workspace";
+  TileDB_CTX *tiledb_ctx;
+  CHECK(TileDBUtils::initialize_workspace(&tiledb_ctx, workspace) == 0);
+  CHECK(tiledb_ctx_finalize(tiledb_ctx) == TILEDB_OK);
+  CHECK(TileDBUtils::workspace_exists(workspace));
+  CHECK(TileDBUtils::is_dir(workspace));
+
+  std::string filename = workspace + "/foo";
+  CHECK(TileDBUtils::write_file(filename, "hello", 5) == TILEDB_OK);
+  CHECK(TileDBUtils::is_file(filename));
+  CHECK(TileDBUtils::file_size(filename) == 5);
+  CHECK(TileDBUtils::delete_dir(workspace) == TILEDB_OK);
+  CHECK(!TileDBUtils::is_dir(workspace));
+}
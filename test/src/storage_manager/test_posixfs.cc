@@ -187,6 +187,133 @@ TEST_CASE_METHOD(PosixFSTestFixture, "Test PosixFS read/write file", "[read-writ
   free(buffer);
 }
 
+TEST_CASE_METHOD(PosixFSTestFixture, "Test PosixFS cached read file handles", "[read-file-handles-cache]") {
+  test_dir += "read_cache";
+  CHECK_RC(fs.create_dir(test_dir), TILEDB_FS_OK);
+  REQUIRE(fs.is_dir(test_dir));
+  fs.set_read_file_handles_cache_size(2);
+  CHECK(fs.read_file_handles_cache_size() == 2);
+
+  for (auto i=0; i<3; i++) {
+    CHECK_RC(fs.write_to_file(test_dir+"/foo"+std::to_string(i), "hello", 5), TILEDB_FS_OK);
+  }
+
+  char buffer[20];
+  CHECK_RC(fs.read_from_file(test_dir+"/foo0", 0, buffer, 2), TILEDB_FS_OK);
+  CHECK(fs.read_file_handles_cache_misses() == 1);
+  CHECK_RC(fs.read_from_file(test_dir+"/foo0", 2, buffer, 3), TILEDB_FS_OK);
+  CHECK(fs.read_file_handles_cache_hits() == 1);
+  CHECK(strncmp(buffer, "llo", 3) == 0);
+
+  // Appends are visible through the cached file handle
+  CHECK_RC(fs.write_to_file(test_dir+"/foo0", "world", 5), TILEDB_FS_OK);
+  CHECK_RC(fs.read_from_file(test_dir+"/foo0", 5, buffer, 5), TILEDB_FS_OK);
+  CHECK(strncmp(buffer, "world", 5) == 0);
+  CHECK(fs.read_file_handles_cache_hits() == 2);
+
+  // foo0 is evicted as the least recently used
+  CHECK_RC(fs.read_from_file(test_dir+"/foo1", 0, buffer, 5), TILEDB_FS_OK);
+  CHECK_RC(fs.read_from_file(test_dir+"/foo2", 0, buffer, 5), TILEDB_FS_OK);
+  CHECK_RC(fs.read_from_file(test_dir+"/foo0", 0, buffer, 5), TILEDB_FS_OK);
+  CHECK(fs.read_file_handles_cache_hits() == 2);
+  CHECK(fs.read_file_handles_cache_misses() == 4);
+
+  // Invalidated with close_file
+  CHECK_RC(fs.close_file(test_dir+"/foo0"), TILEDB_FS_OK);
+  CHECK_RC(fs.read_from_file(test_dir+"/foo0", 0, buffer, 5), TILEDB_FS_OK);
+  CHECK(fs.read_file_handles_cache_misses() == 5);
+
+  // Invalidated with delete_file and recreated
+  CHECK_RC(fs.delete_file(test_dir+"/foo0"), TILEDB_FS_OK);
+  CHECK_RC(fs.read_from_file(test_dir+"/foo0", 0, buffer, 5), TILEDB_FS_ERR);
+  CHECK_RC(fs.write_to_file(test_dir+"/foo0", "HELLO", 5), TILEDB_FS_OK);
+  CHECK_RC(fs.read_from_file(test_dir+"/foo0", 0, buffer, 5), TILEDB_FS_OK);
+  CHECK(strncmp(buffer, "HELLO", 5) == 0);
+
+  // Invalidated with move_path
+  CHECK_RC(fs.move_path(test_dir, test_dir+"new"), TILEDB_FS_OK);
+  CHECK_RC(fs.read_from_file(test_dir+"/foo0", 0, buffer, 5), TILEDB_FS_ERR);
+  CHECK_RC(fs.read_from_file(test_dir+"new/foo0", 0, buffer, 5), TILEDB_FS_OK);
+  CHECK(strncmp(buffer, "HELLO", 5) == 0);
+
+  // Invalidated with delete_dir
+  CHECK_RC(fs.delete_dir(test_dir+"new"), TILEDB_FS_OK);
+  CHECK_RC(fs.read_from_file(test_dir+"new/foo0", 0, buffer, 5), TILEDB_FS_ERR);
+
+  // Disable caching
+  fs.set_read_file_handles_cache_size(0);
+  size_t hits = fs.read_file_handles_cache_hits();
+  size_t misses = fs.read_file_handles_cache_misses();
+  CHECK_RC(fs.create_dir(test_dir), TILEDB_FS_OK);
+  CHECK_RC(fs.write_to_file(test_dir+"/bar", "hello", 5), TILEDB_FS_OK);
+  CHECK_RC(fs.read_from_file(test_dir+"/bar", 0, buffer, 5), TILEDB_FS_OK);
+  CHECK_RC(fs.read_from_file(test_dir+"/bar", 0, buffer, 5), TILEDB_FS_OK);
+  CHECK(fs.read_file_handles_cache_hits() == hits);
+  CHECK(fs.read_file_handles_cache_misses() == misses);
+}
+
+TEST_CASE_METHOD(PosixFSTestFixture, "Test PosixFS vectored reads", "[read-vectored]") {
+  test_dir += "read_vectored";
+  CHECK_RC(fs.create_dir(test_dir), TILEDB_FS_OK);
+  CHECK_RC(fs.write_to_file(test_dir+"/foo", "hello world!", 12), TILEDB_FS_OK);
+
+  char buffer[12];
+  memset(buffer, 0, 12);
+  // Unordered, adjacent, overlapping and empty ranges
+  std::vector<read_range_t> ranges = {
+    {6, buffer+6, 5}, {0, buffer, 2}, {2, buffer+2, 3}, {5, buffer+5, 1}, {11, buffer+11, 0}, {8, buffer+11, 1} };
+  CHECK_RC(fs.read_from_file_v(test_dir+"/foo", ranges), TILEDB_FS_OK);
+  CHECK(strncmp(buffer, "hello world", 11) == 0);
+  CHECK(buffer[11] == 'r');
+
+  // Also with io_uring, which falls back to preadv when not available
+  memset(buffer, 0, 12);
+  fs.set_use_io_uring(true);
+  CHECK(fs.use_io_uring());
+  CHECK_RC(fs.read_from_file_v(test_dir+"/foo", ranges), TILEDB_FS_OK);
+  CHECK(strncmp(buffer, "hello world", 11) == 0);
+  CHECK(buffer[11] == 'r');
+
+  // More ranges than the io_uring queue depth
+  std::vector<char> data(1000);
+  for (auto i=0u; i<data.size(); i++) {
+    data[i] = i%128;
+  }
+  CHECK_RC(fs.write_to_file(test_dir+"/bar", data.data(), data.size()), TILEDB_FS_OK);
+  std::vector<char> every_third(data.size()/3);
+  std::vector<read_range_t> many_ranges;
+  for (auto i=0u; i<every_third.size(); i++) {
+    many_ranges.push_back({i*3, every_third.data()+i, 1});
+  }
+  CHECK_RC(fs.read_from_file_v(test_dir+"/bar", many_ranges), TILEDB_FS_OK);
+  for (auto i=0u; i<every_third.size(); i++) {
+    CHECK(every_third[i] == data[i*3]);
+  }
+
+  // Concurrent readers each use a ring of their own
+  std::vector<std::vector<char>> thread_buffers(4, std::vector<char>(data.size()/3));
+  std::vector<int> thread_rcs(thread_buffers.size());
+  std::vector<std::thread> threads;
+  for (auto t=0u; t<thread_buffers.size(); t++) {
+    threads.emplace_back([&, t]() {
+      std::vector<read_range_t> thread_ranges;
+      for (auto i=0u; i<thread_buffers[t].size(); i++) {
+        thread_ranges.push_back({i*3, thread_buffers[t].data()+i, 1});
+      }
+      thread_rcs[t] = fs.read_from_file_v(test_dir+"/bar", thread_ranges);
+    });
+  }
+  for (auto t=0u; t<threads.size(); t++) {
+    threads[t].join();
+    CHECK(thread_rcs[t] == TILEDB_FS_OK);
+    CHECK(thread_buffers[t] == every_third);
+  }
+
+  CHECK_RC(fs.read_from_file_v(test_dir+"/foo", {}), TILEDB_FS_OK);
+  CHECK_RC(fs.read_from_file_v(test_dir+"/foo", {{0, buffer, 5}, {10, buffer+5, 5}}), TILEDB_FS_ERR);
+  CHECK_RC(fs.read_from_file_v(test_dir+"/non-existent", {{0, buffer, 5}}), TILEDB_FS_ERR);
+}
+
 TEST_CASE_METHOD(PosixFSTestFixture, "Test PosixFS large read/write file", "[read-write-large]") {
   if (!is_env_set("TILEDB_TEST_POSIXFS_LARGE")) {
     return;
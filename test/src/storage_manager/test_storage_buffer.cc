@@ -35,6 +35,7 @@
 #include "storage_azure_blob.h"
 #include "storage_buffer.h"
 #include "storage_gcs.h"
+#include "storage_memoryfs.h"
 #include "storage_posixfs.h"
 #include "storage_s3.h"
 #include "utils.h"
@@ -190,6 +191,8 @@ TEST_CASE_METHOD(TestBufferedWrite, "Test Storage Buffer with buffered reading/w
     fs = std::make_shared<AzureBlob>(filename);
   } else if (is_s3_storage_path(filename)) {
     fs = std::make_shared<S3>(filename);
+  } else if (is_memory_path(filename)) {
+    fs = std::make_shared<MemoryFS>(filename);
   } else {
     fs = std::make_shared<PosixFS>();
     is_posix = true;
@@ -252,3 +255,163 @@ TEST_CASE_METHOD(TestBufferedWrite, "Test Storage Buffer with buffered reading/w
 }
 
 
+
+TEST_CASE_METHOD(TestBufferedWrite, "Test Storage Buffer with read-ahead", "[read-ahead]") {
+  if (get_temp_dir().find("://") != std::string::npos) {
+    return;
+  }
+
+  size_t size = 1024*1024 + 100;
+  std::vector<char> buffer(size);
+  std::generate(buffer.begin(), buffer.end(), std::rand);
+
+  PosixFS fs;
+  std::string filename = get_temp_dir()+"/read_ahead_file";
+  CHECK_RC(fs.write_to_file(filename, buffer.data(), size), TILEDB_FS_OK);
+  CHECK_RC(fs.close_file(filename), TILEDB_FS_OK);
+
+  ScopedEnv read_ahead("TILEDB_READ_AHEAD", "1");
+  size_t chunk_size = 64*1024;
+
+  // Sequential reads are served from the prefetched chunks
+  std::vector<char> read_buffer(size);
+  StorageBuffer sequential_buffer(&fs, filename, chunk_size, /*is_read*/true);
+  read(filename, &sequential_buffer, read_buffer.data(), size);
+  CHECK(memcmp(buffer.data(), read_buffer.data(), size) == 0);
+
+  // Reads straddling chunks and larger than chunks
+  memset(read_buffer.data(), 0, size);
+  StorageBuffer large_reads_buffer(&fs, filename, chunk_size, /*is_read*/true);
+  CHECK_RC(large_reads_buffer.read_buffer(0, read_buffer.data(), 100), TILEDB_BF_OK);
+  CHECK_RC(large_reads_buffer.read_buffer(100, read_buffer.data()+100, chunk_size), TILEDB_BF_OK);
+  CHECK_RC(large_reads_buffer.read_buffer(100+chunk_size, read_buffer.data()+100+chunk_size, 3*chunk_size), TILEDB_BF_OK);
+  CHECK_RC(large_reads_buffer.read_buffer(100+4*chunk_size, read_buffer.data()+100+4*chunk_size, size-100-4*chunk_size),
+           TILEDB_BF_OK);
+  CHECK(memcmp(buffer.data(), read_buffer.data(), size) == 0);
+  CHECK_RC(large_reads_buffer.read_buffer(size-10, read_buffer.data(), 20), TILEDB_BF_ERR); // Reading past file
+  CHECK_RC(large_reads_buffer.finalize(), TILEDB_BF_OK);
+
+  // Random access still works with read-ahead
+  StorageBuffer random_buffer(&fs, filename, chunk_size, /*is_read*/true);
+  for (auto i=0; i<100; i++) {
+    size_t offset = std::rand()%(size-1024);
+    size_t length = std::rand()%1024+1;
+    std::vector<char> segment(length);
+    CHECK_RC(random_buffer.read_buffer(offset, segment.data(), length), TILEDB_BF_OK);
+    CHECK(memcmp(buffer.data()+offset, segment.data(), length) == 0);
+  }
+  CHECK_RC(random_buffer.finalize(), TILEDB_BF_OK);
+
+  // Destroying the buffer with an outstanding prefetch
+  {
+    StorageBuffer abandoned_buffer(&fs, filename, chunk_size, /*is_read*/true);
+    CHECK_RC(abandoned_buffer.read_buffer(0, read_buffer.data(), 10), TILEDB_BF_OK);
+  }
+
+}
+
+TEST_CASE_METHOD(TestBufferedWrite, "Test Storage Buffer with write-behind", "[write-behind]") {
+  if (get_temp_dir().find("://") != std::string::npos) {
+    return;
+  }
+
+  size_t size = 1024*1024 + 100;
+  std::vector<char> buffer(size);
+  std::generate(buffer.begin(), buffer.end(), std::rand);
+
+  PosixFS fs;
+  size_t chunk_size = 64*1024;
+  std::vector<char> read_buffer(size);
+
+  // Full chunks are written out in the background
+  std::string filename = get_temp_dir()+"/write_behind_file";
+  StorageBuffer storage_buffer(&fs, filename, chunk_size);
+  storage_buffer.set_write_behind(true);
+  write(filename, &storage_buffer, buffer.data(), size);
+  CHECK((size_t)fs.file_size(filename) == size);
+  CHECK_RC(fs.read_from_file(filename, 0, read_buffer.data(), size), TILEDB_FS_OK);
+  CHECK(memcmp(buffer.data(), read_buffer.data(), size) == 0);
+
+  // Compressed chunks are written out in the background
+  filename += ".compress";
+  CompressedStorageBuffer compressed_buffer(&fs, filename, chunk_size, false, TILEDB_GZIP, TILEDB_COMPRESSION_LEVEL_GZIP);
+  compressed_buffer.set_write_behind(true);
+  write(filename, &compressed_buffer, buffer.data(), size);
+  CompressedStorageBuffer read_compressed_buffer(&fs, filename, chunk_size, true, TILEDB_GZIP);
+  memset(read_buffer.data(), 0, size);
+  read_with_implicit_offset(filename, &read_compressed_buffer, read_buffer.data(), size);
+  CHECK(memcmp(buffer.data(), read_buffer.data(), size) == 0);
+
+  // Errors from background writes are returned at the latest by finalize
+  std::string bad_filename = get_temp_dir()+"/non-existent-dir/write_behind_file";
+  StorageBuffer bad_buffer(&fs, bad_filename, chunk_size);
+  bad_buffer.set_write_behind(true);
+  int rc = TILEDB_BF_OK;
+  for (auto i=0u; i<4 && !rc; i++) {
+    rc = bad_buffer.append_buffer(buffer.data()+i*chunk_size, chunk_size);
+  }
+  rc = bad_buffer.finalize() || rc;
+  CHECK(rc);
+  // with the cause of the failure on the background thread
+  CHECK_THAT(tiledb_fs_errmsg, Contains("Cannot write bytes in the background; " + TILEDB_FS_ERRMSG));
+}
+
+TEST_CASE_METHOD(TestBufferedWrite, "Test Storage Buffer with multi-threaded compression", "[compression-threads]") {
+  if (get_temp_dir().find("://") != std::string::npos) {
+    return;
+  }
+
+  size_t size = 10*1024*1024 + 100;
+  std::vector<char> buffer(size);
+  std::generate(buffer.begin(), buffer.end(), []() { return 'a' + std::rand()%4; });
+
+  PosixFS fs;
+  size_t chunk_size = 4*1024*1024;
+  std::vector<char> read_buffer(size);
+
+  std::string filename = get_temp_dir()+"/serial_compressed_file";
+  CompressedStorageBuffer serial_buffer(&fs, filename, chunk_size, false, TILEDB_GZIP, TILEDB_COMPRESSION_LEVEL_GZIP);
+  write(filename, &serial_buffer, buffer.data(), size);
+
+  ScopedEnv compression_threads("TILEDB_COMPRESSION_THREADS", "4");
+
+  // Files compressed serially are decompressed serially
+  CompressedStorageBuffer read_serial_buffer(&fs, filename, chunk_size, true, TILEDB_GZIP);
+  read_with_implicit_offset(filename, &read_serial_buffer, read_buffer.data(), size);
+  CHECK(memcmp(buffer.data(), read_buffer.data(), size) == 0);
+
+  // Files compressed in parallel are decompressed in parallel
+  filename = get_temp_dir()+"/parallel_compressed_file";
+  CompressedStorageBuffer parallel_buffer(&fs, filename, chunk_size, false, TILEDB_GZIP, TILEDB_COMPRESSION_LEVEL_GZIP);
+  write(filename, &parallel_buffer, buffer.data(), size);
+  CHECK((size_t)fs.file_size(filename) < size);
+
+  memset(read_buffer.data(), 0, size);
+  CompressedStorageBuffer read_parallel_buffer(&fs, filename, chunk_size, true, TILEDB_GZIP);
+  read_with_implicit_offset(filename, &read_parallel_buffer, read_buffer.data(), size);
+  CHECK(memcmp(buffer.data(), read_buffer.data(), size) == 0);
+
+  // Files compressed in parallel are still readable with a single gzip stream
+  compression_threads.unset();
+  memset(read_buffer.data(), 0, size);
+  CompressedStorageBuffer read_parallel_buffer_serially(&fs, filename, 1024*1024, true, TILEDB_GZIP);
+  read_with_implicit_offset(filename, &read_parallel_buffer_serially, read_buffer.data(), size);
+  CHECK(memcmp(buffer.data(), read_buffer.data(), size) == 0);
+
+#ifdef ENABLE_ZSTD
+  filename = get_temp_dir()+"/zstd_compressed_file";
+  CompressedStorageBuffer zstd_buffer(&fs, filename, chunk_size, false, TILEDB_ZSTD, TILEDB_COMPRESSION_LEVEL_ZSTD);
+  write(filename, &zstd_buffer, buffer.data(), size);
+
+  memset(read_buffer.data(), 0, size);
+  CompressedStorageBuffer read_zstd_buffer(&fs, filename, chunk_size, true, TILEDB_ZSTD);
+  read_with_implicit_offset(filename, &read_zstd_buffer, read_buffer.data(), size);
+  CHECK(memcmp(buffer.data(), read_buffer.data(), size) == 0);
+
+  // zstd files are recognized when reading with gzip
+  memset(read_buffer.data(), 0, size);
+  CompressedStorageBuffer read_zstd_as_gzip_buffer(&fs, filename, chunk_size, true, TILEDB_GZIP);
+  read_with_implicit_offset(filename, &read_zstd_as_gzip_buffer, read_buffer.data(), size);
+  CHECK(memcmp(buffer.data(), read_buffer.data(), size) == 0);
+#endif
+}